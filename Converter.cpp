@@ -1,12 +1,36 @@
 #include "Converter.h"
 
+#include "DSPGain.h"
+#include "EncoderMP3.h"
+#include "EncoderOpus.h"
+#include "EncoderPCM.h"
+#include "Equaliser.h"
+#include "Limiter.h"
+#include "LookAheadDecoder.h"
+#include "Resampler.h"
+#include "SampleQueue.h"
 #include "resource.h"
 #include "Utility.h"
 
 #include "ebur128.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iomanip>
+#include <list>
+#include <mmreg.h>
 #include <sstream>
+#include <thread>
+
+#undef min
+#undef max
+#undef GetObject
+
+#include "document.h"
+#include "stringbuffer.h"
+#include "prettywriter.h"
 
 // Timer ID.
 static const long s_TimerID = 1212;
@@ -14,6 +38,143 @@ static const long s_TimerID = 1212;
 // Timer interval in milliseconds.
 static const long s_TimerInterval = 250;
 
+// Number of sample blocks passed between the stages of the conversion pipeline.
+static const size_t s_PipelineBlocks = 8;
+
+// Number of samples in each sample block.
+static const long s_PipelineBlockSize = 16384;
+
+// Number of threads used by each worker when converting tracks in parallel (the worker itself runs the encode stage, alongside the decode & analysis pipeline threads).
+static const size_t s_ThreadsPerWorker = 3;
+
+// Number of tracks to decode ahead when joining tracks (including the track currently being converted).
+static const size_t s_JoinLookAheadTracks = 3;
+
+// Number of sample blocks to decode ahead for each track, when joining tracks.
+static const size_t s_JoinLookAheadBlocks = 32;
+
+// Nominal bitrates, in kbps, of the LAME VBR quality settings (0-9).
+static const long s_MP3Bitrates[ 10 ] = { 245, 225, 190, 175, 165, 130, 115, 100, 85, 65 };
+
+// Maximum relative difference between the bitrate of a lossy source file and the requested bitrate, for the file to be copied rather than re-encoded.
+static const float s_CopyBitrateTolerance = 0.15f;
+
+// Returns whether the 'sourceBitrate' is close enough to the 'requestedBitrate' for the source file to be copied.
+static bool IsCopyBitrate( const long sourceBitrate, const long requestedBitrate )
+{
+	const bool copyBitrate = ( sourceBitrate > 0 ) && ( requestedBitrate > 0 ) && ( std::abs( sourceBitrate - requestedBitrate ) <= s_CopyBitrateTolerance * requestedBitrate );
+	return copyBitrate;
+}
+
+// Reads the sample format from the format chunk of the WAV file 'filename'.
+// 'isFloat' - out, whether the sample data is floating point.
+// 'bitsPerSample' - out, bits per sample.
+// 'channels' - out, channel count.
+// Returns whether the sample format was read, and is either integer or floating point PCM.
+static bool GetWaveFormat( const std::wstring& filename, bool& isFloat, long& bitsPerSample, long& channels )
+{
+	bool success = false;
+	FILE* f = _wfsopen( filename.c_str(), L"rb", _SH_DENYWR );
+	if ( nullptr != f ) {
+		BYTE header[ 12 ] = {};
+		if ( ( sizeof( header ) == fread( header, 1, sizeof( header ), f ) ) && ( ( 0 == memcmp( header, "RIFF", 4 ) ) || ( 0 == memcmp( header, "RF64", 4 ) ) ) && ( 0 == memcmp( header + 8, "WAVE", 4 ) ) ) {
+			BYTE chunkHeader[ 8 ] = {};
+			while ( sizeof( chunkHeader ) == fread( chunkHeader, 1, sizeof( chunkHeader ), f ) ) {
+				const DWORD chunkSize = *reinterpret_cast<const DWORD*>( chunkHeader + 4 );
+				if ( 0 == memcmp( chunkHeader, "fmt ", 4 ) ) {
+					// The format tag of an extensible format is held in the first two bytes of the sub-format GUID.
+					BYTE format[ 40 ] = {};
+					const size_t formatSize = fread( format, 1, (std::min)( sizeof( format ), static_cast<size_t>( chunkSize ) ), f );
+					if ( formatSize >= 16 ) {
+						WORD formatTag = *reinterpret_cast<const WORD*>( format );
+						if ( ( WAVE_FORMAT_EXTENSIBLE == formatTag ) && ( formatSize >= 26 ) ) {
+							formatTag = *reinterpret_cast<const WORD*>( format + 24 );
+						}
+						channels = *reinterpret_cast<const WORD*>( format + 2 );
+						bitsPerSample = *reinterpret_cast<const WORD*>( format + 14 );
+						isFloat = ( WAVE_FORMAT_IEEE_FLOAT == formatTag );
+						success = isFloat || ( WAVE_FORMAT_PCM == formatTag );
+					}
+					break;
+				}
+				if ( 0 != _fseeki64( f, chunkSize + ( chunkSize & 1 ), SEEK_CUR ) ) {
+					break;
+				}
+			}
+		}
+		fclose( f );
+	}
+	return success;
+}
+
+// Returns the number of nanoseconds elapsed since 'startTime'.
+static long long GetElapsed( const std::chrono::steady_clock::time_point& startTime )
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+// Returns a JSON object for the 'stage' statistics.
+// 'duration' - duration of the tracks processed by the stage, in seconds.
+// 'tracks' - number of tracks processed by the stage.
+// 'elapsed' - total conversion time, in seconds, or zero if the stage load is not required.
+// 'allocator' - JSON allocator.
+static rapidjson::Value StageToJSON( const Converter::StageStatistics& stage, const double duration, const long tracks, const double elapsed, rapidjson::Document::AllocatorType& allocator )
+{
+	rapidjson::Value stageObject( rapidjson::kObjectType );
+	const double time = stage.Time * 1e-9;
+	stageObject.AddMember( "Time", time, allocator );
+	if ( tracks > 0 ) {
+		stageObject.AddMember( "AverageTime", time / tracks, allocator );
+	}
+	if ( elapsed > 0 ) {
+		stageObject.AddMember( "Load", time / elapsed, allocator );
+	}
+	stageObject.AddMember( "Samples", stage.Samples, allocator );
+	if ( stage.Bytes > 0 ) {
+		stageObject.AddMember( "Bytes", stage.Bytes, allocator );
+	}
+	if ( time > 0 ) {
+		stageObject.AddMember( "SamplesPerSecond", stage.Samples / time, allocator );
+		if ( stage.Bytes > 0 ) {
+			stageObject.AddMember( "BytesPerSecond", stage.Bytes / time, allocator );
+		}
+		stageObject.AddMember( "Realtime", duration / time, allocator );
+	}
+	return stageObject;
+}
+
+// Returns a JSON object for the track 'statistics'.
+// 'elapsed' - total conversion time, in seconds, or zero if stage loads are not required.
+// 'allocator' - JSON allocator.
+static rapidjson::Value TrackStatisticsToJSON( const Converter::TrackStatistics& statistics, const double elapsed, rapidjson::Document::AllocatorType& allocator )
+{
+	const std::list<std::pair<const char*, const Converter::StageStatistics*>> stages = {
+		{ "Decode", &statistics.Decode },
+		{ "Analysis", &statistics.Analysis },
+		{ "Encode", &statistics.Encode },
+		{ "Write", &statistics.Write }
+	};
+
+	rapidjson::Value statisticsObject( rapidjson::kObjectType );
+	statisticsObject.AddMember( "Tracks", static_cast<int>( statistics.Tracks ), allocator );
+	statisticsObject.AddMember( "Duration", statistics.Duration, allocator );
+	rapidjson::Value stagesObject( rapidjson::kObjectType );
+	const char* slowestStage = nullptr;
+	long long slowestTime = 0;
+	for ( const auto& [ name, stage ] : stages ) {
+		stagesObject.AddMember( rapidjson::StringRef( name ), StageToJSON( *stage, statistics.Duration, statistics.Tracks, elapsed, allocator ), allocator );
+		if ( stage->Time > slowestTime ) {
+			slowestTime = stage->Time;
+			slowestStage = name;
+		}
+	}
+	statisticsObject.AddMember( "Stages", stagesObject, allocator );
+	if ( nullptr != slowestStage ) {
+		statisticsObject.AddMember( "SlowestStage", rapidjson::StringRef( slowestStage ), allocator );
+	}
+	return statisticsObject;
+}
+
 // Message ID sent when the conversion has finished.
 // 'wParam' - boolean to indicate whether conversion was successful.
 // 'lParam' - unused.
@@ -86,7 +247,7 @@ DWORD WINAPI Converter::EncodeThreadProc( LPVOID lpParam )
 	return 0;
 }
 
-Converter::Converter( const HINSTANCE instance, const HWND parent, Library& library, Settings& settings, Handlers& handlers, const Playlist::ItemList& tracks, const Handler::Ptr encoderHandler, const std::wstring& joinFilename ) :
+Converter::Converter( const HINSTANCE instance, const HWND parent, Library& library, Settings& settings, Handlers& handlers, const Playlist::ItemList& tracks, const Handler::Ptr encoderHandler, const std::wstring& joinFilename, const std::wstring& reportFilename ) :
 	m_hInst( instance ),
 	m_hWnd( nullptr ),
 	m_Library( library ),
@@ -97,14 +258,29 @@ Converter::Converter( const HINSTANCE instance, const HWND parent, Library& libr
 	m_EncodeThread( nullptr ),
 	m_StatusTrack( 1 ),
 	m_ProgressTrack( 0 ),
+	m_StatusParallel( false ),
+	m_CompletedTracks( 0 ),
 	m_ProgressTotal( 0 ),
+	m_TotalDuration( 0 ),
+	m_EncodedDuration( 0 ),
+	m_StartTime( std::chrono::steady_clock::now() ),
+	m_DecodeTime( 0 ),
+	m_AnalysisTime( 0 ),
+	m_EncodeTime( 0 ),
+	m_WriteTime( 0 ),
+	m_Statistics( {} ),
+	m_StatisticsMutex(),
+	m_DisplayedTotalStatus(),
 	m_ProgressRange( 100 ),
-	m_DisplayedTrack( 0 ),
+	m_DisplayedTrack( -1 ),
 	m_TrackCount( static_cast<long>( tracks.size() ) ),
 	m_EncoderHandler( encoderHandler ),
 	m_Encoder( encoderHandler ? encoderHandler->OpenEncoder() : nullptr ),
 	m_EncoderSettings( m_Encoder ? m_Settings.GetEncoderSettings( encoderHandler->GetDescription() ) : std::string() ),
-	m_JoinFilename( joinFilename )
+	m_JoinFilename( joinFilename ),
+	m_ReportFilename( reportFilename ),
+	m_OutputFilenames(),
+	m_OutputFilenamesMutex()
 {
 	DialogBoxParam( instance, MAKEINTRESOURCE( IDD_CONVERT_PROGRESS ), parent, DialogProc, reinterpret_cast<LPARAM>( this ) );
 }
@@ -140,6 +316,7 @@ void Converter::OnInitDialog( const HWND hwnd )
 
 	UpdateStatus();
 	
+	m_StartTime = std::chrono::steady_clock::now();
 	m_EncodeThread = CreateThread( NULL /*attributes*/, 0 /*stackSize*/, EncodeThreadProc, this /*param*/, 0 /*flags*/, NULL /*threadId*/ );
 
 	SetTimer( m_hWnd, s_TimerID, s_TimerInterval, NULL /*timerProc*/ );
@@ -167,9 +344,20 @@ void Converter::Error()
 	const int bufferSize = 64;
 	WCHAR buffer[ bufferSize ] = {};
 	LoadString( m_hInst, IDS_CONVERT_ERROR, buffer, bufferSize );
-	SetDlgItemText( m_hWnd, IDC_EXTRACT_STATE_READ, buffer );
 	SetDlgItemText( m_hWnd, IDC_EXTRACT_STATE_ENCODER, buffer );
 
+	// Show how many tracks were skipped, if the other tracks were converted.
+	const long failedTracks = GetStatistics().FailedTracks;
+	if ( failedTracks > 0 ) {
+		LoadString( m_hInst, IDS_CONVERT_STATUS_FAILED, buffer, bufferSize );
+		std::wstring failedStatus( buffer );
+		WideStringReplace( failedStatus, L"%1", std::to_wstring( failedTracks ) );
+		WideStringReplace( failedStatus, L"%2", std::to_wstring( m_TrackCount ) );
+		SetDlgItemText( m_hWnd, IDC_EXTRACT_STATE_READ, failedStatus.c_str() );
+	} else {
+		SetDlgItemText( m_hWnd, IDC_EXTRACT_STATE_READ, buffer );
+	}
+
 	const HWND progressTrack = GetDlgItem( m_hWnd, IDC_EXTRACT_PROGRESS_TRACK );
 	if ( nullptr != progressTrack ) {
 		SendMessage( progressTrack, PBM_SETPOS, m_ProgressRange, 0 );			
@@ -192,14 +380,14 @@ bool Converter::Cancelled() const
 
 void Converter::EncodeHandler()
 {
+	const auto startTime = std::chrono::steady_clock::now();
 	bool conversionOK = m_Encoder && !m_Tracks.empty();
 	if ( conversionOK ) {
-		float totalDuration = 0;
+		m_TotalDuration = 0;
 		for ( const auto& track : m_Tracks ) {
-			totalDuration += track.Info.GetDuration();
+			m_TotalDuration += track.Info.GetDuration();
 		}
-		float totalEncodedDuration = 0;
-		MediaInfo::List encodedMediaList;
+		m_EncodedDuration.store( 0 );
 
 		std::wstring extractFolder;
 		std::wstring extractFilename;
@@ -207,91 +395,231 @@ void Converter::EncodeHandler()
 		bool extractJoin = false;
 		m_Settings.GetExtractSettings( extractFolder, extractFilename, extractToLibrary, extractJoin );
 
-		std::vector<ebur128_state*> r128States;
-		if ( !extractJoin ) {
-			r128States.reserve( m_Tracks.size() );
-		}
-		ebur128_state* r128State = nullptr;
-
-		long joinChannels = 0;
-		long joinSampleRate = 0;
-		if ( extractJoin ) {
-			const Decoder::Ptr decoder = OpenDecoder( m_Tracks.front() );
-			if ( decoder ) {
-				joinChannels = decoder->GetChannels();
-				joinSampleRate = decoder->GetSampleRate();
-				conversionOK = m_Encoder->Open( m_JoinFilename, joinSampleRate, joinChannels, decoder->GetBPS(), m_EncoderSettings );
-				r128State = ebur128_init( static_cast<unsigned int>( joinChannels ), static_cast<unsigned int>( joinSampleRate ), EBUR128_MODE_I );
-				if ( nullptr != r128State ) {
-					r128States.push_back( r128State );
-				}
-			} else {
-				conversionOK = false;
-			}
+		conversionOK = extractJoin ? EncodeJoined( extractToLibrary ) : EncodeIndividual( extractToLibrary );
+	}
+	{
+		std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+		m_Statistics.Elapsed = static_cast<float>( GetElapsed( startTime ) * 1e-9 );
+	}
+
+	if ( !Cancelled() ) {
+		if ( !m_ReportFilename.empty() ) {
+			WriteReport( m_ReportFilename );
+		}
+		PostMessage( m_hWnd, MSG_CONVERTERFINISHED, conversionOK, 0 );
+	}
+}
+
+bool Converter::EncodeJoined( const bool addToLibrary )
+{
+	// Tracks are converted to a common output format, which is either chosen by the user, or is the highest sample rate & channel count of the tracks being joined.
+	// Audio CD tracks all share the same format (and the output format cannot be chosen for them), so any stored output format is ignored.
+	long joinSampleRate = 0;
+	long joinChannels = 0;
+	const bool cdda = !m_Tracks.empty() && ( MediaInfo::Source::CDDA == m_Tracks.front().Info.GetSource() );
+	if ( !cdda ) {
+		m_Settings.GetConvertJoinFormat( joinSampleRate, joinChannels );
+	}
+	const bool automaticSampleRate = ( 0 == joinSampleRate );
+	const bool automaticChannels = ( 0 == joinChannels );
+	long joinBPS = 0;
+	for ( const auto& track : m_Tracks ) {
+		if ( automaticSampleRate ) {
+			joinSampleRate = (std::max)( joinSampleRate, track.Info.GetSampleRate() );
 		}
+		if ( automaticChannels ) {
+			joinChannels = (std::max)( joinChannels, track.Info.GetChannels() );
+		}
+		joinBPS = (std::max)( joinBPS, track.Info.GetBitsPerSample() );
+	}
 
+	bool conversionOK = false;
+	Decoder::Ptr firstDecoder = OpenDecoder( m_Tracks.front() );
+	if ( firstDecoder ) {
+		if ( 0 == joinSampleRate ) {
+			joinSampleRate = firstDecoder->GetSampleRate();
+		}
+		if ( 0 == joinChannels ) {
+			joinChannels = firstDecoder->GetChannels();
+		}
+		if ( 0 == joinBPS ) {
+			joinBPS = firstDecoder->GetBPS();
+		}
+		conversionOK = m_Encoder->Open( m_JoinFilename, joinSampleRate, joinChannels, joinBPS, m_EncoderSettings );
 		if ( conversionOK ) {
+			ebur128_state* r128State = ebur128_init( static_cast<unsigned int>( joinChannels ), static_cast<unsigned int>( joinSampleRate ), EBUR128_MODE_I );
+
+			// Any delay introduced by the DSP chain is compensated for by skipping its initial output, and flushing it at the end of the output file.
+			const DSPChain::Ptr dspChain = CreateDSPChain( joinSampleRate, joinChannels );
+			long dspSkip = dspChain ? dspChain->GetLatency() : 0;
+
+			// Opens a decoder for the track 'item' (reusing the decoder already opened for the first track), which is resampled and/or remixed to the output format as necessary.
+			// Each decoder reads ahead on its own thread, so that upcoming tracks are decoded & converted in parallel with the encoding of the current track.
+			const auto openJoinDecoder = [ &firstDecoder, joinSampleRate, joinChannels, this ] ( const Playlist::Item& item ) -> Decoder::Ptr
+			{
+				Decoder::Ptr decoder = firstDecoder ? firstDecoder : OpenDecoder( item );
+				firstDecoder.reset();
+				if ( decoder && ( ( decoder->GetSampleRate() != joinSampleRate ) || ( decoder->GetChannels() != joinChannels ) ) ) {
+					try {
+						decoder = std::make_shared<Resampler>( decoder, joinSampleRate, joinChannels );
+					} catch ( const std::runtime_error& ) {
+						decoder.reset();
+					}
+				}
+				if ( decoder ) {
+					decoder = std::make_shared<LookAheadDecoder>( decoder, s_JoinLookAheadBlocks, s_PipelineBlockSize );
+				}
+				return decoder;
+			};
+			// Audio CD tracks are only decoded ahead within the current track, as reading several tracks at once would have the drive seeking between them.
+			const size_t lookAheadTracks = cdda ? 1 : s_JoinLookAheadTracks;
+			std::list<Decoder::Ptr> lookAheadDecoders;
+			auto lookAheadTrack = m_Tracks.begin();
+
+			// The pipeline threads are reused for each track.
+			PipelineThread decodeThread;
+			PipelineThread analysisThread;
+
+			// The time spent flushing the output file is attributed to the source format of the final track.
+			std::wstring codec;
 			long currentTrack = 0;
 			auto track = m_Tracks.begin();
 			while ( conversionOK && !Cancelled() && ( m_Tracks.end() != track ) ) {
-				MediaInfo mediaInfo( track->Info );
 				m_ProgressTrack.store( 0 );
 				m_StatusTrack.store( ++currentTrack );
-				std::wstring filename = extractJoin ? m_JoinFilename : GetOutputFilename( track->Info );
-				conversionOK = !filename.empty();
+				while ( ( lookAheadDecoders.size() < lookAheadTracks ) && ( m_Tracks.end() != lookAheadTrack ) ) {
+					lookAheadDecoders.push_back( openJoinDecoder( *lookAheadTrack ) );
+					++lookAheadTrack;
+				}
+				const Decoder::Ptr trackDecoder = lookAheadDecoders.front();
+				lookAheadDecoders.pop_front();
+				conversionOK = static_cast<bool>( trackDecoder );
 				if ( conversionOK ) {
-					const Decoder::Ptr decoder = OpenDecoder( *track );
-					if ( extractJoin ) {
-						conversionOK = static_cast<bool>( decoder );
-					}
-					if ( decoder ) {
-						const long sampleRate = decoder->GetSampleRate();
-						const long channels = decoder->GetChannels();
-						const long bps = decoder->GetBPS();
+					const bool flushDSP = ( m_Tracks.end() == std::next( track ) );
+					TrackStatistics statistics = {};
+					statistics.Tracks = 1;
+					statistics.Decode.Bytes = track->Info.GetFilesize();
+					conversionOK = EncodeTrack( decodeThread, analysisThread, trackDecoder, m_Encoder, dspChain, dspSkip, flushDSP, r128State, currentTrack, track->Info.GetDuration(), statistics );
+					codec = GetFileExtension( track->Info.GetFilename() );
+					AddStatistics( codec, statistics );
+				}
+				++track;
+			}
+			lookAheadDecoders.clear();
 
-						conversionOK = extractJoin ? ( ( sampleRate == joinSampleRate ) && ( channels == joinChannels ) ) :
-							m_Encoder->Open( filename, sampleRate, channels, bps, m_EncoderSettings );
+			TrackStatistics closeStatistics = {};
+			CloseEncoder( m_Encoder, closeStatistics );
+			AddStatistics( codec, closeStatistics );
 
-						if ( conversionOK ) {
-							const long long trackSamplesTotal = static_cast<long long>( track->Info.GetDuration() * sampleRate );
-							long long trackSamplesRead = 0;
+			if ( conversionOK ) {
+				MediaInfo joinedMediaInfo;
 
-							const long sampleCount = 65536;
-							std::vector<float> sampleBuffer( sampleCount * channels );
+				MediaInfo::List mediaList;
+				for ( const auto& item : m_Tracks ) {
+					mediaList.push_back( item.Info );
+				}
 
-							if ( !extractJoin ) {
-								r128State = ebur128_init( static_cast<unsigned int>( channels ), static_cast<unsigned int>( sampleRate ), EBUR128_MODE_I );
-								if ( nullptr != r128State ) {
-									r128States.push_back( r128State );
-								}
-							}
+				MediaInfo::GetCommonInfo( mediaList, joinedMediaInfo );
+				joinedMediaInfo.SetFilename( m_JoinFilename );
 
-							int r128Error = EBUR128_SUCCESS;
-							bool continueEncoding = true;
-							while ( !Cancelled() && continueEncoding ) {
-								const long samplesRead = decoder->Read( &sampleBuffer[ 0 ], sampleCount );
-								if ( samplesRead > 0 ) {
-									if ( ( nullptr != r128State ) && ( EBUR128_SUCCESS == r128Error ) ) {
-										r128Error = ebur128_add_frames_float( r128State, &sampleBuffer[ 0 ], static_cast<size_t>( samplesRead ) );
-									}
-									continueEncoding = m_Encoder->Write( &sampleBuffer[ 0 ], samplesRead );
+				if ( nullptr != r128State ) {
+					double loudness = 0;
+					if ( EBUR128_SUCCESS == ebur128_loudness_global( r128State, &loudness ) ) {
+						const float trackGain = LOUDNESS_REFERENCE - static_cast<float>( loudness );
+						joinedMediaInfo.SetGainTrack( trackGain );
+					}
+				}
 
-									trackSamplesRead += samplesRead;
-									if ( 0 != trackSamplesTotal ) {
-										m_ProgressTrack.store( static_cast<float>( trackSamplesRead ) / trackSamplesTotal );
-									}
+				WriteTrackTags( joinedMediaInfo.GetFilename(), joinedMediaInfo );
+				if ( addToLibrary || m_Library.GetMediaInfo( joinedMediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
+					m_Library.GetMediaInfo( joinedMediaInfo );
+				}
+			}
 
-									totalEncodedDuration += static_cast<float>( samplesRead ) / sampleRate;
-									if ( 0 != totalDuration ) {
-										m_ProgressTotal.store( static_cast<float>( totalEncodedDuration ) / totalDuration );
-									}
-								} else {
-									continueEncoding = false;
-								}
-							}
+			if ( nullptr != r128State ) {
+				ebur128_destroy( &r128State );
+			}
+		}
+	}
+	return conversionOK;
+}
 
-							if ( !extractJoin ) {
-								m_Encoder->Close();
+bool Converter::EncodeIndividual( const bool addToLibrary )
+{
+	const std::vector<Playlist::Item> tracks( m_Tracks.begin(), m_Tracks.end() );
+
+	// Media information for each output file (with an empty filename if the track was not converted), and the corresponding loudness states.
+	std::vector<MediaInfo> encodedTracks( tracks.size() );
+	std::vector<ebur128_state*> encodedStates( tracks.size(), nullptr );
+
+	std::atomic<size_t> nextTrack( 0 );
+
+	const bool passthrough = m_Settings.GetConvertPassthrough() && !IsProcessingRequired();
+
+	// Each worker thread has its own encoder, and takes the next unconverted track until there are none left.
+	// Tracks which cannot be converted are skipped (and counted as failed), so that the remaining tracks are still converted.
+	// The workers and their pipeline threads share the available hardware threads, so each encoder is limited to a single thread when converting in parallel.
+	const size_t threadCount = m_Settings.GetConvertParallel() ? (std::min)( tracks.size(), (std::max)( size_t( 1 ), static_cast<size_t>( std::thread::hardware_concurrency() ) / s_ThreadsPerWorker ) ) : 1;
+	// When converting in parallel, the track progress bar shows the fraction of tracks completed, rather than the progress of any one track.
+	const bool parallel = ( threadCount > 1 );
+	if ( parallel ) {
+		m_CompletedTracks.store( 0 );
+		m_StatusTrack.store( 0 );
+		m_StatusParallel.store( true );
+	}
+
+	std::list<std::thread> threads;
+	for ( size_t threadIndex = 0; threadIndex < threadCount; threadIndex++ ) {
+		const Encoder::Ptr encoder = ( 0 == threadIndex ) ? m_Encoder : m_EncoderHandler->OpenEncoder();
+		if ( !encoder ) {
+			break;
+		}
+		encoder->SetMaxThreads( parallel ? 1 : 0 );
+		threads.push_back( std::thread( [ &tracks, &encodedTracks, &encodedStates, &nextTrack, encoder, addToLibrary, passthrough, parallel, this ]()
+		{
+			CoInitializeEx( NULL /*reserved*/, COINIT_APARTMENTTHREADED );
+			PipelineThread decodeThread;
+			PipelineThread analysisThread;
+			size_t trackIndex = nextTrack++;
+			while ( !Cancelled() && ( trackIndex < tracks.size() ) ) {
+				const Playlist::Item& track = tracks[ trackIndex ];
+				const long trackNumber = static_cast<long>( 1 + trackIndex );
+				if ( !parallel ) {
+					m_ProgressTrack.store( 0 );
+					m_StatusTrack.store( trackNumber );
+				}
+
+				bool trackOK = false;
+				std::wstring filename = ReserveOutputFilename( GetOutputFilename( track.Info ) );
+				if ( !filename.empty() ) {
+					MediaInfo mediaInfo( track.Info );
+					std::wstring outputFilename = passthrough ? CopyTrack( track, filename ) : std::wstring();
+					if ( !outputFilename.empty() ) {
+						// The track gain of the source (if known) is carried over to the copied file.
+						if ( !parallel ) {
+							m_ProgressTrack.store( 1.0f );
+						}
+						AddEncodedDuration( track.Info.GetDuration() );
+						std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+						++m_Statistics.CopiedTracks;
+					} else {
+						const Decoder::Ptr decoder = OpenDecoder( track );
+						if ( decoder ) {
+							const long sampleRate = decoder->GetSampleRate();
+							const long channels = decoder->GetChannels();
+							const long bps = decoder->GetBPS();
+							if ( encoder->Open( filename, sampleRate, channels, bps, m_EncoderSettings ) ) {
+								ebur128_state* r128State = ebur128_init( static_cast<unsigned int>( channels ), static_cast<unsigned int>( sampleRate ), EBUR128_MODE_I );
+								encodedStates[ trackIndex ] = r128State;
+
+								const DSPChain::Ptr dspChain = CreateDSPChain( sampleRate, channels );
+								long dspSkip = dspChain ? dspChain->GetLatency() : 0;
+								TrackStatistics statistics = {};
+								statistics.Tracks = 1;
+								statistics.Decode.Bytes = track.Info.GetFilesize();
+								const bool encodedOK = EncodeTrack( decodeThread, analysisThread, decoder, encoder, dspChain, dspSkip, true /*flushDSP*/, r128State, trackNumber, track.Info.GetDuration(), statistics );
+								CloseEncoder( encoder, statistics );
+								AddStatistics( GetFileExtension( track.Info.GetFilename() ), statistics );
 
 								if ( nullptr != r128State ) {
 									double loudness = 0;
@@ -300,90 +628,330 @@ void Converter::EncodeHandler()
 										mediaInfo.SetGainTrack( trackGain );
 									}
 								}
+								if ( encodedOK ) {
+									outputFilename = filename;
+								} else {
+									DeleteFile( filename.c_str() );
+								}
+							}
+						}
+					}
 
-								mediaInfo.SetFilename( filename );
-								encodedMediaList.push_back( mediaInfo );
+					if ( !outputFilename.empty() ) {
+						trackOK = true;
+						mediaInfo.SetFilename( outputFilename );
+						encodedTracks[ trackIndex ] = mediaInfo;
 
-								WriteTrackTags( filename, mediaInfo );
-								if ( extractToLibrary || m_Library.GetMediaInfo( mediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
-									MediaInfo extractedMediaInfo( filename );
-									m_Library.GetMediaInfo( extractedMediaInfo );
-								}			
-							}
+						WriteTrackTags( outputFilename, mediaInfo );
+						if ( addToLibrary || m_Library.GetMediaInfo( mediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
+							MediaInfo extractedMediaInfo( outputFilename );
+							m_Library.GetMediaInfo( extractedMediaInfo );
 						}
 					}
 				}
-				++track;
+				if ( !trackOK && !Cancelled() ) {
+					std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+					++m_Statistics.FailedTracks;
+				}
+				if ( parallel ) {
+					++m_CompletedTracks;
+				}
+				trackIndex = nextTrack++;
 			}
+			CoUninitialize();
+		} ) );
+	}
+	for ( auto& thread : threads ) {
+		thread.join();
+	}
+	bool conversionOK = !threads.empty();
+	if ( conversionOK ) {
+		std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+		conversionOK = ( 0 == m_Statistics.FailedTracks );
+	}
 
-			if ( extractJoin ) {
-				m_Encoder->Close();
+	// Album gain is only calculated once all tracks have been converted, and only if they are all from the same album.
+	MediaInfo::List encodedMediaList;
+	std::vector<ebur128_state*> r128States;
+	for ( size_t trackIndex = 0; trackIndex < tracks.size(); trackIndex++ ) {
+		if ( !encodedTracks[ trackIndex ].GetFilename().empty() ) {
+			encodedMediaList.push_back( encodedTracks[ trackIndex ] );
+		}
+		if ( nullptr != encodedStates[ trackIndex ] ) {
+			r128States.push_back( encodedStates[ trackIndex ] );
+		}
+	}
 
-				if ( conversionOK ) {
-					MediaInfo joinedMediaInfo;
+	if ( conversionOK && !Cancelled() && !encodedMediaList.empty() ) {
+		const std::wstring album = encodedMediaList.front().GetAlbum();
+		bool writeAlbumGain = !album.empty();
+		auto encodedMediaIter = encodedMediaList.begin();
+		while ( writeAlbumGain && ( encodedMediaList.end() != ++encodedMediaIter ) ) {
+			writeAlbumGain = ( encodedMediaIter->GetAlbum() == album );
+		}
 
-					MediaInfo::List mediaList;
-					for ( const auto& item : m_Tracks ) {
-						mediaList.push_back( item.Info );
+		if ( writeAlbumGain ) {
+			float albumGain = NAN;
+			if ( r128States.size() == encodedMediaList.size() ) {
+				double loudness = 0;
+				if ( EBUR128_SUCCESS == ebur128_loudness_global_multiple( &r128States[ 0 ], r128States.size(), &loudness ) ) {
+					albumGain = LOUDNESS_REFERENCE - static_cast<float>( loudness );
+				}
+			} else {
+				// Some tracks were copied rather than re-encoded, so use the album gain of the source tracks, if known and consistent.
+				albumGain = encodedMediaList.front().GetGainAlbum();
+				for ( const auto& encodedMedia : encodedMediaList ) {
+					if ( encodedMedia.GetGainAlbum() != albumGain ) {
+						albumGain = NAN;
+						break;
 					}
+				}
+			}
 
-					MediaInfo::GetCommonInfo( mediaList, joinedMediaInfo );
-					joinedMediaInfo.SetFilename( m_JoinFilename );
+			if ( !std::isnan( albumGain ) ) {
+				for ( auto& encodedMedia : encodedMediaList ) {
+					encodedMedia.SetGainAlbum( albumGain );
+					WriteAlbumTags( encodedMedia.GetFilename(), encodedMedia );
+					MediaInfo info( encodedMedia.GetFilename() );
+					if ( addToLibrary || m_Library.GetMediaInfo( info, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
+						m_Library.GetMediaInfo( info );
+					}						
+				}
+			}
+		}
+	}
 
-					if ( nullptr != r128State ) {
-						double loudness = 0;
-						if ( EBUR128_SUCCESS == ebur128_loudness_global( r128State, &loudness ) ) {
-							const float trackGain = LOUDNESS_REFERENCE - static_cast<float>( loudness );
-							joinedMediaInfo.SetGainTrack( trackGain );
-						}
-					}
+	for ( const auto& iter : r128States ) {
+		ebur128_state* state = iter;
+		ebur128_destroy( &state );
+	}
 
-					WriteTrackTags( joinedMediaInfo.GetFilename(), joinedMediaInfo );
-					if ( extractToLibrary || m_Library.GetMediaInfo( joinedMediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
-						m_Library.GetMediaInfo( joinedMediaInfo );
-					}
-				}
-			} else {
-				if ( conversionOK && !Cancelled() && !encodedMediaList.empty() ) {
-					const std::wstring album = encodedMediaList.front().GetAlbum();
-					bool writeAlbumGain = !album.empty();
-					auto encodedMediaIter = encodedMediaList.begin();
-					while ( writeAlbumGain && ( encodedMediaList.end() != ++encodedMediaIter ) ) {
-						writeAlbumGain = ( encodedMediaIter->GetAlbum() == album );
-					}
+	return conversionOK;
+}
 
-					if ( writeAlbumGain ) {
-						float albumGain = NAN;
-						if ( !r128States.empty() ) {
-							double loudness = 0;
-							if ( EBUR128_SUCCESS == ebur128_loudness_global_multiple( &r128States[ 0 ], r128States.size(), &loudness ) ) {
-								albumGain = LOUDNESS_REFERENCE - static_cast<float>( loudness );
-							}
-						}
+bool Converter::EncodeTrack( PipelineThread& decodeThread, PipelineThread& analysisThread, const Decoder::Ptr decoder, const Encoder::Ptr encoder, const DSPChain::Ptr dspChain, long& dspSkip, const bool flushDSP, ebur128_state* r128State, const long trackNumber, const float trackDuration, TrackStatistics& statistics )
+{
+	const long sampleRate = decoder->GetSampleRate();
+	const long channels = decoder->GetChannels();
+
+	// Sample blocks are passed from the decode stage to the analysis stage to the encode stage, then recycled back to the decode stage.
+	std::vector<SampleQueue::Block> blocks( s_PipelineBlocks );
+	SampleQueue freeQueue( s_PipelineBlocks );
+	SampleQueue decodedQueue( s_PipelineBlocks );
+	SampleQueue analysedQueue( s_PipelineBlocks );
+	for ( auto& block : blocks ) {
+		block.Samples.resize( s_PipelineBlockSize * channels );
+		freeQueue.Push( &block );
+	}
 
-						if ( !std::isnan( albumGain ) ) {
-							for ( auto& encodedMedia : encodedMediaList ) {
-								encodedMedia.SetGainAlbum( albumGain );
-								WriteAlbumTags( encodedMedia.GetFilename(), encodedMedia );
-								MediaInfo info( encodedMedia.GetFilename() );
-								if ( extractToLibrary || m_Library.GetMediaInfo( info, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
-									m_Library.GetMediaInfo( info );
-								}						
-							}
-						}
-					}
+	const auto cancelPipeline = [ &freeQueue, &decodedQueue, &analysedQueue ] ()
+	{
+		freeQueue.Cancel();
+		decodedQueue.Cancel();
+		analysedQueue.Cancel();
+	};
+
+	// Each stage only updates its own statistics, which are read once all the stages have finished.
+	// Stage times are also accumulated across tracks as the conversion progresses, for status reporting.
+	decodeThread.Start( [ &freeQueue, &decodedQueue, &dspSkip, &cancelPipeline, &statistics, decoder, dspChain, flushDSP, channels, sampleRate, trackNumber, trackDuration, this ] ()
+	{
+		const long long trackSamplesTotal = static_cast<long long>( trackDuration * sampleRate );
+		long long trackSamplesRead = 0;
+		bool flushedDSP = false;
+		SampleQueue::Block* block = freeQueue.Pop();
+		while ( nullptr != block ) {
+			if ( Cancelled() ) {
+				cancelPipeline();
+				break;
+			}
+
+			const auto startTime = std::chrono::steady_clock::now();
+			float* samples = &block->Samples[ 0 ];
+			const long samplesRead = decoder->Read( samples, s_PipelineBlockSize );
+			long samplesToProcess = samplesRead;
+			if ( ( samplesRead <= 0 ) && dspChain && flushDSP && !flushedDSP ) {
+				// Flush the delayed output from the DSP chain at the end of the output file.
+				flushedDSP = true;
+				samplesToProcess = (std::min)( dspChain->GetLatency(), s_PipelineBlockSize );
+				std::fill( samples, samples + samplesToProcess * channels, 0.0f );
+			}
+			if ( samplesToProcess <= 0 ) {
+				break;
+			}
+
+			block->Offset = 0;
+			block->Count = samplesToProcess;
+			if ( dspChain ) {
+				dspChain->Process( samples, samplesToProcess );
+				block->Offset = (std::min)( dspSkip, samplesToProcess );
+				dspSkip -= block->Offset;
+			}
+			const long long decodeTime = GetElapsed( startTime );
+			m_DecodeTime += decodeTime;
+			statistics.Decode.Time += decodeTime;
+			statistics.Decode.Samples += samplesToProcess;
+
+			if ( samplesRead > 0 ) {
+				trackSamplesRead += samplesRead;
+				if ( ( 0 != trackSamplesTotal ) && ( trackNumber == m_StatusTrack.load() ) ) {
+					m_ProgressTrack.store( static_cast<float>( trackSamplesRead ) / trackSamplesTotal );
 				}
+				AddEncodedDuration( static_cast<float>( samplesRead ) / sampleRate );
 			}
+
+			block = decodedQueue.Push( block ) ? freeQueue.Pop() : nullptr;
+		}
+		statistics.Duration += static_cast<double>( trackSamplesRead ) / sampleRate;
+		decodedQueue.Close();
+	} );
+
+	analysisThread.Start( [ &decodedQueue, &analysedQueue, &statistics, r128State, channels, this ] ()
+	{
+		int r128Error = EBUR128_SUCCESS;
+		SampleQueue::Block* block = decodedQueue.Pop();
+		while ( nullptr != block ) {
+			const long count = block->Count - block->Offset;
+			if ( ( nullptr != r128State ) && ( EBUR128_SUCCESS == r128Error ) && ( count > 0 ) ) {
+				const auto startTime = std::chrono::steady_clock::now();
+				r128Error = ebur128_add_frames_float( r128State, &block->Samples[ block->Offset * channels ], static_cast<size_t>( count ) );
+				const long long analysisTime = GetElapsed( startTime );
+				m_AnalysisTime += analysisTime;
+				statistics.Analysis.Time += analysisTime;
+				statistics.Analysis.Samples += count;
+			}
+			block = analysedQueue.Push( block ) ? decodedQueue.Pop() : nullptr;
+		}
+		analysedQueue.Close();
+	} );
+
+	// Time spent writing to the output file is separated out from the time spent encoding.
+	bool writeOK = true;
+	const long long initialBytesWritten = encoder->GetBytesWritten();
+	SampleQueue::Block* block = analysedQueue.Pop();
+	while ( nullptr != block ) {
+		const long count = block->Count - block->Offset;
+		if ( count > 0 ) {
+			const long long initialWriteTime = encoder->GetWriteTime();
+			const auto startTime = std::chrono::steady_clock::now();
+			writeOK = encoder->Write( &block->Samples[ block->Offset * channels ], count );
+			const long long elapsedTime = GetElapsed( startTime );
+			const long long writeTime = encoder->GetWriteTime() - initialWriteTime;
+			m_EncodeTime += elapsedTime - writeTime;
+			m_WriteTime += writeTime;
+			statistics.Encode.Time += elapsedTime - writeTime;
+			statistics.Encode.Samples += count;
+			statistics.Write.Time += writeTime;
+			statistics.Write.Samples += count;
 		}
-		
-		for ( const auto& iter : r128States ) {
-			ebur128_state* state = iter;
-			ebur128_destroy( &state );
+		if ( writeOK && freeQueue.Push( block ) ) {
+			block = analysedQueue.Pop();
+		} else {
+			cancelPipeline();
+			block = nullptr;
 		}
 	}
 
-	if ( !Cancelled() ) {
-		PostMessage( m_hWnd, MSG_CONVERTERFINISHED, conversionOK, 0 );
+	decodeThread.Wait();
+	analysisThread.Wait();
+	statistics.Write.Bytes += encoder->GetBytesWritten() - initialBytesWritten;
+	return writeOK;
+}
+
+void Converter::CloseEncoder( const Encoder::Ptr encoder, TrackStatistics& statistics )
+{
+	const long long initialWriteTime = encoder->GetWriteTime();
+	const long long initialBytesWritten = encoder->GetBytesWritten();
+	const auto startTime = std::chrono::steady_clock::now();
+	encoder->Close();
+	const long long elapsedTime = GetElapsed( startTime );
+	const long long writeTime = encoder->GetWriteTime() - initialWriteTime;
+	m_EncodeTime += elapsedTime - writeTime;
+	m_WriteTime += writeTime;
+	statistics.Encode.Time += elapsedTime - writeTime;
+	statistics.Write.Time += writeTime;
+	statistics.Write.Bytes += encoder->GetBytesWritten() - initialBytesWritten;
+}
+
+void Converter::AddStatistics( const std::wstring& codec, const TrackStatistics& statistics )
+{
+	const auto addStatistics = [ &statistics ] ( TrackStatistics& total )
+	{
+		const auto addStage = [] ( StageStatistics& totalStage, const StageStatistics& stage )
+		{
+			totalStage.Time += stage.Time;
+			totalStage.Samples += stage.Samples;
+			totalStage.Bytes += stage.Bytes;
+		};
+		total.Tracks += statistics.Tracks;
+		total.Duration += statistics.Duration;
+		addStage( total.Decode, statistics.Decode );
+		addStage( total.Analysis, statistics.Analysis );
+		addStage( total.Encode, statistics.Encode );
+		addStage( total.Write, statistics.Write );
+	};
+
+	std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+	addStatistics( m_Statistics.Total );
+	if ( !codec.empty() ) {
+		addStatistics( m_Statistics.Codecs.insert( std::make_pair( codec, TrackStatistics() ) ).first->second );
+	}
+}
+
+void Converter::AddEncodedDuration( const float duration )
+{
+	float encodedDuration = m_EncodedDuration.load();
+	while ( !m_EncodedDuration.compare_exchange_weak( encodedDuration, encodedDuration + duration ) ) {
+	}
+	if ( 0 != m_TotalDuration ) {
+		m_ProgressTotal.store( ( encodedDuration + duration ) / m_TotalDuration );
+	}
+}
+
+Converter::Statistics Converter::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock( m_StatisticsMutex );
+	const Statistics statistics = m_Statistics;
+	return statistics;
+}
+
+void Converter::WriteReport( const std::wstring& filename ) const
+{
+	const Statistics statistics = GetStatistics();
+
+	rapidjson::Document document;
+	document.SetObject();
+	auto& allocator = document.GetAllocator();
+
+	const std::string encoder = WideStringToUTF8( m_EncoderHandler->GetDescription() );
+	document.AddMember( "Encoder", rapidjson::Value( encoder.c_str(), static_cast<rapidjson::SizeType>( encoder.size() ), allocator ), allocator );
+	document.AddMember( "EncoderSettings", rapidjson::Value( m_EncoderSettings.c_str(), static_cast<rapidjson::SizeType>( m_EncoderSettings.size() ), allocator ), allocator );
+	document.AddMember( "Elapsed", static_cast<double>( statistics.Elapsed ), allocator );
+	if ( statistics.Elapsed > 0 ) {
+		document.AddMember( "Realtime", statistics.Total.Duration / statistics.Elapsed, allocator );
+	}
+	document.AddMember( "CopiedTracks", static_cast<int>( statistics.CopiedTracks ), allocator );
+	document.AddMember( "FailedTracks", static_cast<int>( statistics.FailedTracks ), allocator );
+	document.AddMember( "Total", TrackStatisticsToJSON( statistics.Total, statistics.Elapsed, allocator ), allocator );
+
+	rapidjson::Value codecsObject( rapidjson::kObjectType );
+	for ( const auto& [ codec, codecStatistics ] : statistics.Codecs ) {
+		const std::string name = WideStringToUTF8( codec );
+		codecsObject.AddMember( rapidjson::Value( name.c_str(), static_cast<rapidjson::SizeType>( name.size() ), allocator ), TrackStatisticsToJSON( codecStatistics, 0 /*elapsed*/, allocator ), allocator );
+	}
+	document.AddMember( "Codecs", codecsObject, allocator );
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer( buffer );
+	document.Accept( writer );
+
+	try {
+		std::ofstream fileStream;
+		fileStream.open( filename, std::ios::out | std::ios::trunc );
+		if ( fileStream.is_open() ) {
+			fileStream << buffer.GetString();
+			fileStream.close();
+		}
+	} catch ( ... ) {
 	}
 }
 
@@ -492,14 +1060,28 @@ std::wstring Converter::GetOutputFilename( const MediaInfo& mediaInfo ) const
 	return outputFilename;
 }
 
+std::wstring Converter::ReserveOutputFilename( const std::wstring& filename )
+{
+	std::wstring outputFilename = filename;
+	if ( !outputFilename.empty() ) {
+		std::lock_guard<std::mutex> lock( m_OutputFilenamesMutex );
+		long suffix = 1;
+		while ( !m_OutputFilenames.insert( WideStringToLower( outputFilename ) ).second ) {
+			outputFilename = filename + L" (" + std::to_wstring( ++suffix ) + L")";
+		}
+	}
+	return outputFilename;
+}
+
 void Converter::UpdateStatus()
 {
-	const long currentTrack = m_StatusTrack.load();
+	const bool parallel = m_StatusParallel.load();
+	const long currentTrack = parallel ? m_CompletedTracks.load() : m_StatusTrack.load();
 	if ( currentTrack != m_DisplayedTrack ) {
 		m_DisplayedTrack = currentTrack;
 		const int bufSize = 128;
 		WCHAR buffer[ bufSize ];
-		LoadString( m_hInst, IDS_CONVERT_STATUS_TRACK, buffer, bufSize );
+		LoadString( m_hInst, parallel ? IDS_CONVERT_STATUS_COMPLETED : IDS_CONVERT_STATUS_TRACK, buffer, bufSize );
 		std::wstring trackStatus( buffer );
 		trackStatus += L":";
 		WideStringReplace( trackStatus, L"%1", std::to_wstring( m_DisplayedTrack ) );
@@ -510,7 +1092,8 @@ void Converter::UpdateStatus()
 	const HWND progressTrack = GetDlgItem( m_hWnd, IDC_EXTRACT_PROGRESS_TRACK );
 	if ( nullptr != progressTrack ) {
 		const long displayPosition = static_cast<long>( SendMessage( progressTrack, PBM_GETPOS, 0, 0 ) );
-		const long currentPosition = static_cast<long>( m_ProgressTrack * m_ProgressRange );
+		const float progress = parallel ? ( ( m_TrackCount > 0 ) ? ( static_cast<float>( currentTrack ) / m_TrackCount ) : 0 ) : m_ProgressTrack.load();
+		const long currentPosition = static_cast<long>( progress * m_ProgressRange );
 		if ( currentPosition != displayPosition ) {
 			SendMessage( progressTrack, PBM_SETPOS, currentPosition, 0 );
 		}
@@ -524,6 +1107,34 @@ void Converter::UpdateStatus()
 			SendMessage( progressTotal, PBM_SETPOS, currentPosition, 0 );
 		}
 	}
+
+	// Once the conversion is under way, show the overall conversion speed, and the pipeline stage which is taking the most time.
+	const float elapsed = static_cast<float>( GetElapsed( m_StartTime ) * 1e-9 );
+	if ( elapsed >= 1.0f ) {
+		const std::list<std::pair<long long,UINT>> stages = {
+			{ m_DecodeTime.load(), IDS_CONVERT_STAGE_DECODE },
+			{ m_AnalysisTime.load(), IDS_CONVERT_STAGE_ANALYSIS },
+			{ m_EncodeTime.load(), IDS_CONVERT_STAGE_ENCODE },
+			{ m_WriteTime.load(), IDS_CONVERT_STAGE_WRITE }
+		};
+		const auto slowestStage = std::max_element( stages.begin(), stages.end() );
+		if ( slowestStage->first > 0 ) {
+			const int bufSize = 128;
+			WCHAR buffer[ bufSize ] = {};
+			LoadString( m_hInst, slowestStage->second, buffer, bufSize );
+			const std::wstring stage( buffer );
+			LoadString( m_hInst, IDS_CONVERT_STATUS_TOTAL, buffer, bufSize );
+			std::wstring totalStatus( buffer );
+			std::wstringstream ss;
+			ss << std::fixed << std::setprecision( 1 ) << ( m_EncodedDuration / elapsed );
+			WideStringReplace( totalStatus, L"%1", ss.str() );
+			WideStringReplace( totalStatus, L"%2", stage );
+			if ( totalStatus != m_DisplayedTotalStatus ) {
+				m_DisplayedTotalStatus = totalStatus;
+				SetDlgItemText( m_hWnd, IDC_EXTRACT_STATE_ENCODER, m_DisplayedTotalStatus.c_str() );
+			}
+		}
+	}
 }
 
 void Converter::WriteTrackTags( const std::wstring& filename, const MediaInfo& mediaInfo )
@@ -587,13 +1198,134 @@ void Converter::WriteAlbumTags( const std::wstring& filename, const MediaInfo& m
 
 Decoder::Ptr Converter::OpenDecoder( const Playlist::Item& item ) const
 {
-	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename() );
+	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename(), Decoder::Context::Input );
 	if ( !decoder ) {
 		auto duplicate = item.Duplicates.begin();
 		while ( !decoder && ( item.Duplicates.end() != duplicate ) ) {
-			decoder = m_Handlers.OpenDecoder( *duplicate );
+			decoder = m_Handlers.OpenDecoder( *duplicate, Decoder::Context::Input );
 			++duplicate;
 		}
 	}
 	return decoder;
 }
+
+DSPChain::Ptr Converter::CreateDSPChain( const long sampleRate, const long channels ) const
+{
+	DSPChain::Ptr dspChain;
+	const bool applyEQ = IsEQRequired();
+	const bool applyLimiter = IsLimiterEnabled();
+	if ( applyEQ || applyLimiter ) {
+		dspChain = std::make_shared<DSPChain>( channels );
+
+		if ( applyEQ ) {
+			const Settings::EQ eq = m_Settings.GetEQSettings();
+			const Equaliser::Ptr equaliser = std::make_shared<Equaliser>( sampleRate, channels );
+			equaliser->SetEQ( eq );
+			dspChain->AddNode( equaliser );
+
+			if ( 0 != eq.Preamp ) {
+				dspChain->AddNode( std::make_shared<DSPGain>( channels, eq.Preamp ) );
+			}
+		}
+
+		if ( applyLimiter ) {
+			dspChain->AddNode( std::make_shared<Limiter>( sampleRate, channels, m_Settings.GetLimiterRelease() / 1000.0f ) );
+		}
+	}
+	return dspChain;
+}
+
+bool Converter::IsProcessingRequired() const
+{
+	const bool processingRequired = IsEQRequired() || IsLimiterEnabled();
+	return processingRequired;
+}
+
+bool Converter::IsEQRequired() const
+{
+	const Settings::EQ eq = m_Settings.GetEQSettings();
+	const bool eqRequired = eq.Enabled && m_Settings.GetConvertApplyEQ();
+	return eqRequired;
+}
+
+bool Converter::IsLimiterEnabled() const
+{
+	// The limiter is part of the loudness normalisation settings, and is only offered when loudness normalisation is enabled.
+	Settings::GainMode gainMode = Settings::GainMode::Disabled;
+	Settings::LimitMode limitMode = Settings::LimitMode::None;
+	float gainPreamp = 0;
+	m_Settings.GetGainSettings( gainMode, limitMode, gainPreamp );
+	const bool limiterEnabled = ( Settings::GainMode::Disabled != gainMode ) && ( Settings::LimitMode::TruePeak == limitMode );
+	return limiterEnabled;
+}
+
+std::wstring Converter::CopyTrack( const Playlist::Item& item, const std::wstring& filename ) const
+{
+	std::wstring outputFilename;
+	const std::set<std::wstring> outputExtensions = m_EncoderHandler->GetSupportedFileExtensions();
+	std::list<std::wstring> sourceFilenames( item.Duplicates );
+	sourceFilenames.push_front( item.Info.GetFilename() );
+	for ( const auto& sourceFilename : sourceFilenames ) {
+		const std::wstring extension = GetFileExtension( sourceFilename );
+		if ( ( outputExtensions.end() != outputExtensions.find( extension ) ) && IsCopyEquivalent( sourceFilename, item.Info, extension ) ) {
+			const std::wstring copyFilename = filename + L"." + extension;
+			if ( CopyFile( sourceFilename.c_str(), copyFilename.c_str(), FALSE /*failIfExists*/ ) ) {
+				// Ensure the tags of the copied file can be rewritten.
+				const DWORD attributes = GetFileAttributes( copyFilename.c_str() );
+				if ( ( INVALID_FILE_ATTRIBUTES != attributes ) && ( FILE_ATTRIBUTE_READONLY & attributes ) ) {
+					SetFileAttributes( copyFilename.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY );
+				}
+				outputFilename = copyFilename;
+				break;
+			}
+		}
+	}
+	return outputFilename;
+}
+
+bool Converter::IsCopyEquivalent( const std::wstring& sourceFilename, const MediaInfo& mediaInfo, const std::wstring& extension ) const
+{
+	// Lossless sources are copied if the output would decode to the same sample data, and lossy sources if they are close to the requested bitrate.
+	bool equivalent = false;
+	if ( L"flac" == extension ) {
+		equivalent = ( mediaInfo.GetBitsPerSample() <= 24 );
+	} else if ( L"wav" == extension ) {
+		bool isFloat = false;
+		long bitsPerSample = 0;
+		long channels = 0;
+		if ( GetWaveFormat( sourceFilename, isFloat, bitsPerSample, channels ) && ( ( 1 == channels ) || ( 2 == channels ) ) ) {
+			switch ( EncoderPCM::GetFormat( m_EncoderSettings ) ) {
+				case EncoderPCM::Format::Source : {
+					equivalent = isFloat ? ( 32 == bitsPerSample ) : ( ( 8 == bitsPerSample ) || ( 16 == bitsPerSample ) || ( 24 == bitsPerSample ) );
+					break;
+				}
+				case EncoderPCM::Format::Unsigned8 : {
+					equivalent = !isFloat && ( 8 == bitsPerSample );
+					break;
+				}
+				case EncoderPCM::Format::Signed16 : {
+					equivalent = !isFloat && ( 16 == bitsPerSample );
+					break;
+				}
+				case EncoderPCM::Format::Signed24 : {
+					equivalent = !isFloat && ( 24 == bitsPerSample );
+					break;
+				}
+				case EncoderPCM::Format::Signed32 : {
+					equivalent = !isFloat && ( 32 == bitsPerSample );
+					break;
+				}
+				case EncoderPCM::Format::Float32 : {
+					equivalent = isFloat && ( 32 == bitsPerSample );
+					break;
+				}
+			}
+		}
+	} else if ( L"mp3" == extension ) {
+		const long channels = mediaInfo.GetChannels();
+		equivalent = ( ( 1 == channels ) || ( 2 == channels ) ) && IsCopyBitrate( mediaInfo.GetBitrate(), s_MP3Bitrates[ EncoderMP3::GetVBRQuality( m_EncoderSettings ) ] );
+	} else if ( L"opus" == extension ) {
+		equivalent = ( mediaInfo.GetChannels() > 0 ) && IsCopyBitrate( mediaInfo.GetBitrate(), EncoderOpus::GetBitrate( m_EncoderSettings ) );
+	}
+	return equivalent;
+}
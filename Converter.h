@@ -2,15 +2,50 @@
 
 #include "stdafx.h"
 
+#include "DSPChain.h"
 #include "Handlers.h"
+#include "PipelineThread.h"
 #include "Settings.h"
 
+#include "ebur128.h"
+
 #include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
 
 // Audio file converter.
+// Each track is converted by a pipeline of decode, loudness analysis and encode stages, running on separate threads.
 class Converter
 {
 public:
+	// Statistics for a conversion pipeline stage.
+	struct StageStatistics {
+		long long Time;				// Time spent in the stage, in nanoseconds.
+		long long Samples;		// Number of samples processed by the stage.
+		long long Bytes;			// Number of bytes read from the source files (decode stage), or written to the output files (write stage).
+	};
+
+	// Statistics for a set of converted tracks.
+	struct TrackStatistics {
+		long Tracks;							// Number of tracks.
+		double Duration;					// Duration of the tracks, in seconds.
+		StageStatistics Decode;		// Decode stage, including source file reads and any DSP.
+		StageStatistics Analysis;	// Loudness analysis stage.
+		StageStatistics Encode;		// Encode stage, excluding output file writes.
+		StageStatistics Write;		// Output file writes.
+	};
+
+	// Conversion statistics.
+	struct Statistics {
+		float Elapsed;														// Total conversion time, in seconds.
+		long CopiedTracks;												// Number of tracks copied rather than re-encoded (which are not included in the stage statistics).
+		long FailedTracks;												// Number of tracks which could not be converted, and were skipped.
+		TrackStatistics Total;										// Statistics for all converted tracks.
+		std::map<std::wstring,TrackStatistics> Codecs;	// Statistics for the converted tracks of each source format, keyed by file extension.
+	};
+
 	// 'instance' - module instance handle.
 	// 'hwnd' - application window handle.
 	// 'library' - media library.
@@ -19,10 +54,14 @@ public:
 	// 'tracks' - tracks to convert.
 	// 'encoderHandler' - encoder handler to use.
 	// 'joinFilename' - output filename, when joining tracks into a single file.
-	Converter( const HINSTANCE instance, const HWND hwnd, Library& library, Settings& settings, Handlers& handlers, const Playlist::ItemList& tracks, const Handler::Ptr encoderHandler, const std::wstring& joinFilename );
+	// 'reportFilename' - filename to which the conversion statistics are written, or an empty string if no report is to be written.
+	Converter( const HINSTANCE instance, const HWND hwnd, Library& library, Settings& settings, Handlers& handlers, const Playlist::ItemList& tracks, const Handler::Ptr encoderHandler, const std::wstring& joinFilename, const std::wstring& reportFilename );
 
 	virtual ~Converter();
 
+	// Returns the conversion statistics (stage times are summed over all worker threads, so can exceed the total conversion time when converting tracks in parallel).
+	Statistics GetStatistics() const;
+
 private:
 	// Dialog box procedure.
 	static INT_PTR CALLBACK DialogProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam );
@@ -43,13 +82,56 @@ private:
 	// Encode thread handler.
 	void EncodeHandler();
 
+	// Converts all tracks into a single output file, returning whether conversion was successful.
+	// Tracks which differ from the output sample rate or channel count are resampled and/or remixed, while being decoded ahead of the encoder.
+	// 'addToLibrary' - whether to add the output file to the media library.
+	bool EncodeJoined( const bool addToLibrary );
+
+	// Converts each track into a separate output file (using several worker threads, if enabled), returning whether all the tracks were converted.
+	// Tracks which cannot be converted are skipped, and counted in the conversion statistics.
+	// Tracks which are already in the output format can be copied, with only their tags being rewritten, rather than re-encoded.
+	// 'addToLibrary' - whether to add the output files to the media library.
+	bool EncodeIndividual( const bool addToLibrary );
+
+	// Decodes the sample data for a track, passes it through any DSP chain, then writes it to an encoder.
+	// The decode & analysis stages run on their own threads, connected to the encode stage by queues of recycled sample blocks.
+	// 'decodeThread' - thread on which to run the decode stage.
+	// 'analysisThread' - thread on which to run the analysis stage.
+	// 'decoder' - track decoder.
+	// 'encoder' - output encoder.
+	// 'dspChain' - DSP chain, or nullptr.
+	// 'dspSkip' - in/out, the number of delayed samples still to be skipped at the start of the DSP chain output.
+	// 'flushDSP' - whether to flush the delayed output from the DSP chain once the decoder has finished.
+	// 'r128State' - loudness state to update, or nullptr.
+	// 'trackNumber' - track number, for status reporting.
+	// 'trackDuration' - track duration, in seconds, for progress reporting.
+	// 'statistics' - in/out, track statistics to which the time spent & samples processed by each stage are added.
+	// Returns false if the encoder failed to write the sample data.
+	bool EncodeTrack( PipelineThread& decodeThread, PipelineThread& analysisThread, const Decoder::Ptr decoder, const Encoder::Ptr encoder, const DSPChain::Ptr dspChain, long& dspSkip, const bool flushDSP, ebur128_state* r128State, const long trackNumber, const float trackDuration, TrackStatistics& statistics );
+
+	// Closes the 'encoder', adding the time spent & bytes written when flushing the output file to the 'statistics'.
+	void CloseEncoder( const Encoder::Ptr encoder, TrackStatistics& statistics );
+
+	// Adds the track 'statistics' to the conversion statistics, for the source format 'codec'.
+	void AddStatistics( const std::wstring& codec, const TrackStatistics& statistics );
+
+	// Writes the conversion statistics as a JSON report to 'filename'.
+	void WriteReport( const std::wstring& filename ) const;
+
+	// Adds 'duration' seconds to the total encoded duration, and updates the total progress.
+	void AddEncodedDuration( const float duration );
+
 	// Returns whether conversion has been cancelled.
 	bool Cancelled() const;
 
 	// Returns the output filename for 'mediaInfo'.
 	std::wstring GetOutputFilename( const MediaInfo& mediaInfo ) const;
 
-	// Updates the status of the progress bars.
+	// Reserves an output 'filename' (without file extension) for the current conversion, so that no two tracks are written to the same file.
+	// Returns the 'filename', with a numbered suffix if it has already been reserved, or an empty string if 'filename' is empty.
+	std::wstring ReserveOutputFilename( const std::wstring& filename );
+
+	// Updates the status of the progress bars, and the overall conversion speed.
 	void UpdateStatus();
 
 	// Writes track tags to 'filename' based on the 'mediaInfo'.
@@ -61,6 +143,27 @@ private:
 	// Returns a decoder for the 'item', or nullptr if a decoder could not be opened.
 	Decoder::Ptr OpenDecoder( const Playlist::Item& item ) const;
 
+	// Returns a DSP chain for the 'sampleRate' & 'channels', or nullptr if no processing is to be applied when converting.
+	DSPChain::Ptr CreateDSPChain( const long sampleRate, const long channels ) const;
+
+	// Returns whether any processing is to be applied to the sample data when converting.
+	bool IsProcessingRequired() const;
+
+	// Returns whether the EQ is to be applied when converting.
+	bool IsEQRequired() const;
+
+	// Returns whether the true peak limiter is enabled in the loudness settings.
+	bool IsLimiterEnabled() const;
+
+	// Returns whether the 'sourceFilename', with 'mediaInfo' and a file 'extension' matching the output format, can be copied in place of being encoded with the current encoder settings.
+	// This is the case for lossless sources whose bit depth and channel count the encoder would keep, and for lossy sources close to the requested bitrate.
+	bool IsCopyEquivalent( const std::wstring& sourceFilename, const MediaInfo& mediaInfo, const std::wstring& extension ) const;
+
+	// Copies the source file for the 'item' unchanged, if it is already in the output format with equivalent settings.
+	// 'filename' - output file name, without file extension.
+	// Returns the output file name with file extension, or an empty string if the file was not copied.
+	std::wstring CopyTrack( const Playlist::Item& item, const std::wstring& filename ) const;
+
 	// Module instance handle.
 	HINSTANCE m_hInst;
 
@@ -85,19 +188,55 @@ private:
 	// Encode thread handle.
 	HANDLE m_EncodeThread;
 
-	// The current track being converted.
+	// The current track being converted (when converting one track at a time).
 	std::atomic<long> m_StatusTrack;
 
-	// Track progress, in the range 0.0 to 1.0.
+	// Track progress, in the range 0.0 to 1.0 (when converting one track at a time).
 	std::atomic<float> m_ProgressTrack;
 
+	// Whether tracks are being converted in parallel, in which case the number of completed tracks is shown in place of the current track.
+	std::atomic<bool> m_StatusParallel;
+
+	// Number of tracks completed so far, when converting tracks in parallel.
+	std::atomic<long> m_CompletedTracks;
+
 	// Total progress, in the range 0.0 to 1.0.
 	std::atomic<float> m_ProgressTotal;
 
+	// Total duration of the tracks to convert, in seconds.
+	float m_TotalDuration;
+
+	// Total duration of the sample data encoded so far, in seconds.
+	std::atomic<float> m_EncodedDuration;
+
+	// Conversion start time.
+	std::chrono::steady_clock::time_point m_StartTime;
+
+	// Time spent in the decode stage so far, in nanoseconds.
+	std::atomic<long long> m_DecodeTime;
+
+	// Time spent in the analysis stage so far, in nanoseconds.
+	std::atomic<long long> m_AnalysisTime;
+
+	// Time spent in the encode stage so far, in nanoseconds.
+	std::atomic<long long> m_EncodeTime;
+
+	// Time spent writing output files so far, in nanoseconds.
+	std::atomic<long long> m_WriteTime;
+
+	// Conversion statistics.
+	Statistics m_Statistics;
+
+	// Conversion statistics mutex.
+	mutable std::mutex m_StatisticsMutex;
+
+	// The currently displayed overall status.
+	std::wstring m_DisplayedTotalStatus;
+
 	// Progress bar range.
 	long m_ProgressRange;
 
-	// The currently displayed track status.
+	// The currently displayed track status (the current track, or the number of completed tracks when converting in parallel).
 	long m_DisplayedTrack;
 
 	// The total number of tracks to convert.
@@ -106,7 +245,7 @@ private:
 	// The encoder handler to use.
 	Handler::Ptr m_EncoderHandler;
 
-	// The encoder to use.
+	// The encoder to use (additional encoders are opened for each worker thread, when converting tracks in parallel).
 	Encoder::Ptr m_Encoder;
 
 	// The encoder settings to use.
@@ -114,4 +253,13 @@ private:
 
 	// The output filename, when joining tracks into a single file.
 	std::wstring m_JoinFilename;
+
+	// The conversion report filename, or an empty string if no report is to be written.
+	const std::wstring m_ReportFilename;
+
+	// Output filenames reserved so far (in lowercase, without file extensions).
+	std::set<std::wstring> m_OutputFilenames;
+
+	// Reserved output filenames mutex.
+	std::mutex m_OutputFilenamesMutex;
 };
@@ -0,0 +1,334 @@
+#include "Convolver.h"
+
+#include "Resampler.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+// Maximum filter length, in samples.
+static const long s_MaxTaps = 131072;
+
+// Number of samples read from the impulse response decoder in one go.
+static const long s_ChunkSize = 4096;
+
+// Returns the number of nanoseconds elapsed since 'startTime'.
+static long long GetElapsed( const std::chrono::steady_clock::time_point& startTime )
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+// Accumulates the complex product of 'count' bins of 'a' and 'b' into 'output' (real and imaginary parts stored separately, 'count' must be a multiple of 4).
+static void MultiplyAccumulate( const float* aReal, const float* aImag, const float* bReal, const float* bImag, float* outputReal, float* outputImag, const long count )
+{
+	for ( long index = 0; index < count; index += 4 ) {
+		const __m128 ar = _mm_loadu_ps( aReal + index );
+		const __m128 ai = _mm_loadu_ps( aImag + index );
+		const __m128 br = _mm_loadu_ps( bReal + index );
+		const __m128 bi = _mm_loadu_ps( bImag + index );
+		const __m128 real = _mm_sub_ps( _mm_mul_ps( ar, br ), _mm_mul_ps( ai, bi ) );
+		const __m128 imag = _mm_add_ps( _mm_mul_ps( ar, bi ), _mm_mul_ps( ai, br ) );
+		_mm_storeu_ps( outputReal + index, _mm_add_ps( _mm_loadu_ps( outputReal + index ), real ) );
+		_mm_storeu_ps( outputImag + index, _mm_add_ps( _mm_loadu_ps( outputImag + index ), imag ) );
+	}
+}
+
+DWORD WINAPI Convolver::WorkerThreadProc( LPVOID lpParam )
+{
+	Convolver* convolver = static_cast<Convolver*>( lpParam );
+	if ( nullptr != convolver ) {
+		convolver->WorkerHandler();
+	}
+	return 0;
+}
+
+Convolver::Convolver( const std::vector<float>& impulseResponse, const long impulseChannels, const long sampleRate, const long channels, const long partitionSize ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_PartitionSize( partitionSize ),
+	m_FFTSize( 2 * partitionSize ),
+	m_BinCount( 4 * ( ( partitionSize + 4 ) / 4 ) ),
+	m_Taps( 0 ),
+	m_Partitions( 0 ),
+	m_FilterChannels( (std::max)( 1l, impulseChannels ) ),
+	m_Twiddles( static_cast<size_t>( partitionSize ) ),
+	m_BitReverse( static_cast<size_t>( 2 * partitionSize ) ),
+	m_FilterReal(),
+	m_FilterImag(),
+	m_InputReal(),
+	m_InputImag(),
+	m_CurrentSlot( 0 ),
+	m_TailReal( static_cast<size_t>( channels * m_BinCount ) ),
+	m_TailImag( static_cast<size_t>( channels * m_BinCount ) ),
+	m_InputBlock( static_cast<size_t>( channels * 2 * partitionSize ) ),
+	m_OutputBlock( static_cast<size_t>( channels * partitionSize ) ),
+	m_BlockPosition( 0 ),
+	m_WorkBuffer( static_cast<size_t>( 2 * partitionSize ) ),
+	m_WorkerThread( nullptr ),
+	m_StopEvent( nullptr ),
+	m_TailRequestEvent( nullptr ),
+	m_TailReadyEvent( nullptr ),
+	m_ProcessingTime( 0 ),
+	m_ProcessedSamples( 0 )
+{
+	for ( long index = 0; index < partitionSize; index++ ) {
+		m_Twiddles[ index ] = std::polar( 1.0f, static_cast<float>( -2 * M_PI * index / m_FFTSize ) );
+	}
+	long bits = 0;
+	while ( ( 1l << bits ) < m_FFTSize ) {
+		++bits;
+	}
+	for ( long index = 0; index < m_FFTSize; index++ ) {
+		long reversed = 0;
+		for ( long bit = 0; bit < bits; bit++ ) {
+			if ( index & ( 1l << bit ) ) {
+				reversed |= 1l << ( bits - 1 - bit );
+			}
+		}
+		m_BitReverse[ index ] = reversed;
+	}
+
+	// Calculate the filter partition spectra, including the inverse FFT scaling.
+	m_Taps = (std::min)( static_cast<long>( impulseResponse.size() / m_FilterChannels ), s_MaxTaps );
+	m_Partitions = (std::max)( 1l, ( m_Taps + partitionSize - 1 ) / partitionSize );
+	m_FilterReal.resize( static_cast<size_t>( m_Partitions * m_FilterChannels * m_BinCount ), 0.0f );
+	m_FilterImag.resize( m_FilterReal.size(), 0.0f );
+	const float scale = 1.0f / m_FFTSize;
+	for ( long partition = 0; partition < m_Partitions; partition++ ) {
+		for ( long channel = 0; channel < m_FilterChannels; channel++ ) {
+			std::fill( m_WorkBuffer.begin(), m_WorkBuffer.end(), 0.0f );
+			for ( long index = 0; index < partitionSize; index++ ) {
+				const long tap = partition * partitionSize + index;
+				if ( tap < m_Taps ) {
+					m_WorkBuffer[ index ] = impulseResponse[ tap * m_FilterChannels + channel ] * scale;
+				}
+			}
+			FFT( m_WorkBuffer.data(), false /*inverse*/ );
+			const size_t offset = static_cast<size_t>( ( partition * m_FilterChannels + channel ) * m_BinCount );
+			for ( long bin = 0; bin <= partitionSize; bin++ ) {
+				m_FilterReal[ offset + bin ] = m_WorkBuffer[ bin ].real();
+				m_FilterImag[ offset + bin ] = m_WorkBuffer[ bin ].imag();
+			}
+		}
+	}
+	m_InputReal.resize( static_cast<size_t>( m_Partitions * m_Channels * m_BinCount ), 0.0f );
+	m_InputImag.resize( m_InputReal.size(), 0.0f );
+
+	if ( m_Partitions > 1 ) {
+		m_StopEvent = CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ );
+		m_TailRequestEvent = CreateEvent( NULL /*attributes*/, FALSE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ );
+		m_TailReadyEvent = CreateEvent( NULL /*attributes*/, FALSE /*manualReset*/, TRUE /*initialState*/, L"" /*name*/ );
+		m_WorkerThread = CreateThread( NULL /*attributes*/, 0 /*stackSize*/, WorkerThreadProc, reinterpret_cast<LPVOID>( this ), 0 /*flags*/, NULL /*threadId*/ );
+		if ( nullptr != m_WorkerThread ) {
+			SetThreadPriority( m_WorkerThread, THREAD_PRIORITY_HIGHEST );
+		}
+	}
+}
+
+Convolver::~Convolver()
+{
+	if ( nullptr != m_WorkerThread ) {
+		SetEvent( m_StopEvent );
+		WaitForSingleObject( m_WorkerThread, INFINITE );
+		CloseHandle( m_WorkerThread );
+	}
+	for ( const auto handle : { m_StopEvent, m_TailRequestEvent, m_TailReadyEvent } ) {
+		if ( nullptr != handle ) {
+			CloseHandle( handle );
+		}
+	}
+}
+
+long Convolver::GetChannels() const
+{
+	return m_Channels;
+}
+
+long Convolver::GetLatency() const
+{
+	return m_PartitionSize;
+}
+
+void Convolver::Process( float* buffer, const long sampleCount )
+{
+	long offset = 0;
+	while ( offset < sampleCount ) {
+		const long count = (std::min)( sampleCount - offset, m_PartitionSize - m_BlockPosition );
+		for ( long channel = 0; channel < m_Channels; channel++ ) {
+			float* samples = buffer + offset * m_Channels + channel;
+			float* input = m_InputBlock.data() + channel * m_FFTSize + m_PartitionSize + m_BlockPosition;
+			const float* output = m_OutputBlock.data() + channel * m_PartitionSize + m_BlockPosition;
+			for ( long index = 0; index < count; index++, samples += m_Channels ) {
+				input[ index ] = *samples;
+				*samples = output[ index ];
+			}
+		}
+		offset += count;
+		m_BlockPosition += count;
+		if ( m_PartitionSize == m_BlockPosition ) {
+			ProcessBlock();
+			m_BlockPosition = 0;
+		}
+	}
+	m_ProcessedSamples += sampleCount;
+}
+
+void Convolver::ProcessBlock()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Transform the previous and current input blocks into the delay line slot for the current block.
+	for ( long channel = 0; channel < m_Channels; channel++ ) {
+		float* input = m_InputBlock.data() + channel * m_FFTSize;
+		std::copy( input, input + m_FFTSize, m_WorkBuffer.begin() );
+		std::copy( input + m_PartitionSize, input + m_FFTSize, input );
+		FFT( m_WorkBuffer.data(), false /*inverse*/ );
+		const size_t offset = static_cast<size_t>( ( m_CurrentSlot * m_Channels + channel ) * m_BinCount );
+		for ( long bin = 0; bin <= m_PartitionSize; bin++ ) {
+			m_InputReal[ offset + bin ] = m_WorkBuffer[ bin ].real();
+			m_InputImag[ offset + bin ] = m_WorkBuffer[ bin ].imag();
+		}
+	}
+
+	// Wait for the worker thread to accumulate the contribution of the remaining partitions.
+	if ( nullptr != m_WorkerThread ) {
+		long long processingTime = GetElapsed( startTime );
+		WaitForSingleObject( m_TailReadyEvent, INFINITE );
+		startTime = std::chrono::steady_clock::now() - std::chrono::nanoseconds( processingTime );
+	}
+
+	for ( long channel = 0; channel < m_Channels; channel++ ) {
+		const long filterChannel = channel % m_FilterChannels;
+		float* tailReal = m_TailReal.data() + channel * m_BinCount;
+		float* tailImag = m_TailImag.data() + channel * m_BinCount;
+		const size_t inputOffset = static_cast<size_t>( ( m_CurrentSlot * m_Channels + channel ) * m_BinCount );
+		const size_t filterOffset = static_cast<size_t>( filterChannel * m_BinCount );
+		MultiplyAccumulate( m_InputReal.data() + inputOffset, m_InputImag.data() + inputOffset, m_FilterReal.data() + filterOffset, m_FilterImag.data() + filterOffset, tailReal, tailImag, m_BinCount );
+
+		// Reconstruct the full spectrum from its conjugate symmetry, and keep the last half of the inverse transform (overlap-save).
+		m_WorkBuffer[ 0 ] = std::complex<float>( tailReal[ 0 ], 0 );
+		m_WorkBuffer[ m_PartitionSize ] = std::complex<float>( tailReal[ m_PartitionSize ], 0 );
+		for ( long bin = 1; bin < m_PartitionSize; bin++ ) {
+			m_WorkBuffer[ bin ] = std::complex<float>( tailReal[ bin ], tailImag[ bin ] );
+			m_WorkBuffer[ m_FFTSize - bin ] = std::complex<float>( tailReal[ bin ], -tailImag[ bin ] );
+		}
+		FFT( m_WorkBuffer.data(), true /*inverse*/ );
+		float* output = m_OutputBlock.data() + channel * m_PartitionSize;
+		for ( long index = 0; index < m_PartitionSize; index++ ) {
+			output[ index ] = m_WorkBuffer[ m_PartitionSize + index ].real();
+		}
+
+		if ( nullptr == m_WorkerThread ) {
+			std::fill( tailReal, tailReal + m_BinCount, 0.0f );
+			std::fill( tailImag, tailImag + m_BinCount, 0.0f );
+		}
+	}
+
+	m_CurrentSlot = ( m_CurrentSlot + 1 ) % m_Partitions;
+	m_ProcessingTime += GetElapsed( startTime );
+
+	if ( nullptr != m_WorkerThread ) {
+		SetEvent( m_TailRequestEvent );
+	}
+}
+
+void Convolver::WorkerHandler()
+{
+	const HANDLE events[ 2 ] = { m_StopEvent, m_TailRequestEvent };
+	while ( ( WAIT_OBJECT_0 + 1 ) == WaitForMultipleObjects( 2 /*count*/, events, FALSE /*waitAll*/, INFINITE ) ) {
+		AccumulateTail();
+		SetEvent( m_TailReadyEvent );
+	}
+}
+
+void Convolver::AccumulateTail()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// The next block will use the current slot, so the previous blocks are in the slots before it.
+	std::fill( m_TailReal.begin(), m_TailReal.end(), 0.0f );
+	std::fill( m_TailImag.begin(), m_TailImag.end(), 0.0f );
+	for ( long partition = 1; partition < m_Partitions; partition++ ) {
+		const long slot = ( m_CurrentSlot + m_Partitions - partition ) % m_Partitions;
+		for ( long channel = 0; channel < m_Channels; channel++ ) {
+			const long filterChannel = channel % m_FilterChannels;
+			const size_t inputOffset = static_cast<size_t>( ( slot * m_Channels + channel ) * m_BinCount );
+			const size_t filterOffset = static_cast<size_t>( ( partition * m_FilterChannels + filterChannel ) * m_BinCount );
+			const size_t tailOffset = static_cast<size_t>( channel * m_BinCount );
+			MultiplyAccumulate( m_InputReal.data() + inputOffset, m_InputImag.data() + inputOffset, m_FilterReal.data() + filterOffset, m_FilterImag.data() + filterOffset,
+				m_TailReal.data() + tailOffset, m_TailImag.data() + tailOffset, m_BinCount );
+		}
+	}
+
+	m_ProcessingTime += GetElapsed( startTime );
+}
+
+void Convolver::FFT( std::complex<float>* data, const bool inverse ) const
+{
+	for ( long index = 0; index < m_FFTSize; index++ ) {
+		const long reversed = m_BitReverse[ index ];
+		if ( reversed > index ) {
+			std::swap( data[ index ], data[ reversed ] );
+		}
+	}
+	for ( long size = 2; size <= m_FFTSize; size *= 2 ) {
+		const long halfSize = size / 2;
+		const long twiddleStep = m_FFTSize / size;
+		for ( long start = 0; start < m_FFTSize; start += size ) {
+			for ( long index = 0; index < halfSize; index++ ) {
+				const std::complex<float>& twiddle = m_Twiddles[ index * twiddleStep ];
+				const std::complex<float> product = ( inverse ? std::conj( twiddle ) : twiddle ) * data[ start + halfSize + index ];
+				data[ start + halfSize + index ] = data[ start + index ] - product;
+				data[ start + index ] += product;
+			}
+		}
+	}
+}
+
+Convolver::Statistics Convolver::GetStatistics() const
+{
+	Statistics statistics = {};
+	statistics.Taps = m_Taps;
+	statistics.PartitionSize = m_PartitionSize;
+	statistics.Partitions = m_Partitions;
+	statistics.Latency = static_cast<float>( m_PartitionSize ) / m_SampleRate;
+	const long long processedSamples = m_ProcessedSamples;
+	if ( processedSamples > 0 ) {
+		statistics.Load = static_cast<float>( m_ProcessingTime * 1e-9 * m_SampleRate / processedSamples );
+	}
+	return statistics;
+}
+
+bool Convolver::LoadImpulseResponse( const Handlers& handlers, const std::wstring& filename, const long sampleRate, std::vector<float>& impulseResponse, long& impulseChannels )
+{
+	impulseResponse.clear();
+	impulseChannels = 0;
+	Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Temporary );
+	if ( decoder && ( decoder->GetSampleRate() != sampleRate ) ) {
+		try {
+			decoder = std::make_shared<Resampler>( decoder, sampleRate, decoder->GetChannels() );
+		} catch ( const std::runtime_error& ) {
+			decoder.reset();
+		}
+	}
+	if ( decoder ) {
+		impulseChannels = decoder->GetChannels();
+		if ( impulseChannels > 0 ) {
+			std::vector<float> buffer( static_cast<size_t>( s_ChunkSize * impulseChannels ) );
+			long taps = 0;
+			while ( taps < s_MaxTaps ) {
+				const long samplesRead = decoder->Read( buffer.data(), (std::min)( s_ChunkSize, s_MaxTaps - taps ) );
+				if ( samplesRead <= 0 ) {
+					break;
+				}
+				impulseResponse.insert( impulseResponse.end(), buffer.begin(), buffer.begin() + samplesRead * impulseChannels );
+				taps += samplesRead;
+			}
+		}
+	}
+	const bool loaded = !impulseResponse.empty();
+	return loaded;
+}
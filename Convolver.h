@@ -0,0 +1,153 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "DSPNode.h"
+#include "Handlers.h"
+
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+// Applies FIR filters (such as room correction or headphone filters) using uniformly partitioned FFT convolution.
+// Each block of input is convolved with the first filter partition on the calling thread, while the remaining partitions are
+// accumulated on a worker thread in advance of the next block, so that the added latency is a single partition.
+class Convolver : public DSPNode
+{
+public:
+	// Convolution statistics.
+	struct Statistics {
+		long Taps;						// Filter length, in samples.
+		long PartitionSize;		// Partition size, in samples.
+		long Partitions;			// Number of filter partitions.
+		float Latency;				// Added latency, in seconds.
+		float Load;						// Processing cost, as a fraction of the duration of the sample data processed (i.e. the proportion of one CPU core used).
+	};
+
+	// 'impulseResponse' - interleaved filter impulse response, at the output sample rate.
+	// 'impulseChannels' - impulse response channel count.
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	// 'partitionSize' - partition size, in samples (a power of two).
+	// Each channel is filtered by the impulse response channel with the same index, wrapping around if there are fewer impulse response channels (so a mono impulse response applies to all channels).
+	Convolver( const std::vector<float>& impulseResponse, const long impulseChannels, const long sampleRate, const long channels, const long partitionSize );
+
+	virtual ~Convolver();
+
+	// Convolver shared pointer type.
+	typedef std::shared_ptr<Convolver> Ptr;
+
+	// Returns the channel count.
+	long GetChannels() const override;
+
+	// Returns the number of samples by which the filtered output is delayed (the partition size).
+	long GetLatency() const override;
+
+	// Filters 'sampleCount' samples of interleaved sample data in 'buffer'.
+	void Process( float* buffer, const long sampleCount ) override;
+
+	// Returns the convolution statistics.
+	Statistics GetStatistics() const;
+
+	// Loads an impulse response.
+	// 'handlers' - audio format handlers.
+	// 'filename' - impulse response filename.
+	// 'sampleRate' - sample rate to convert the impulse response to.
+	// 'impulseResponse' - out, interleaved impulse response.
+	// 'impulseChannels' - out, impulse response channel count.
+	// Returns true if the impulse response was loaded.
+	static bool LoadImpulseResponse( const Handlers& handlers, const std::wstring& filename, const long sampleRate, std::vector<float>& impulseResponse, long& impulseChannels );
+
+private:
+	// Worker thread procedure.
+	static DWORD WINAPI WorkerThreadProc( LPVOID lpParam );
+
+	// Worker thread handler.
+	void WorkerHandler();
+
+	// Convolves the current input block, replacing the output block.
+	void ProcessBlock();
+
+	// Accumulates the contribution of all but the first filter partition to the next output block.
+	void AccumulateTail();
+
+	// Performs an in-place FFT of the 'data'.
+	// 'inverse' - whether to perform an (unscaled) inverse transform.
+	void FFT( std::complex<float>* data, const bool inverse ) const;
+
+	// Sample rate.
+	const long m_SampleRate;
+
+	// Channel count.
+	const long m_Channels;
+
+	// Partition size.
+	const long m_PartitionSize;
+
+	// FFT size (twice the partition size).
+	const long m_FFTSize;
+
+	// Number of spectrum bins used for filtering, rounded up to a multiple of 4.
+	const long m_BinCount;
+
+	// Filter length.
+	long m_Taps;
+
+	// Number of filter partitions.
+	long m_Partitions;
+
+	// Number of filter channels.
+	long m_FilterChannels;
+
+	// FFT twiddle factors.
+	std::vector<std::complex<float>> m_Twiddles;
+
+	// FFT bit reversal permutation.
+	std::vector<long> m_BitReverse;
+
+	// Filter partition spectra (real and imaginary parts stored separately), ordered by partition then filter channel.
+	std::vector<float> m_FilterReal;
+	std::vector<float> m_FilterImag;
+
+	// Frequency domain delay line of input block spectra, ordered by block then channel.
+	std::vector<float> m_InputReal;
+	std::vector<float> m_InputImag;
+
+	// Index of the delay line slot for the current input block.
+	long m_CurrentSlot;
+
+	// Accumulated tail spectra, for each channel.
+	std::vector<float> m_TailReal;
+	std::vector<float> m_TailImag;
+
+	// Time domain input for each channel, holding the previous and current input blocks.
+	std::vector<float> m_InputBlock;
+
+	// Output block for each channel.
+	std::vector<float> m_OutputBlock;
+
+	// Position within the current block.
+	long m_BlockPosition;
+
+	// FFT work buffer.
+	std::vector<std::complex<float>> m_WorkBuffer;
+
+	// Worker thread handle.
+	HANDLE m_WorkerThread;
+
+	// Event signalled when the worker thread should stop.
+	HANDLE m_StopEvent;
+
+	// Event signalled when the worker thread should accumulate the next tail.
+	HANDLE m_TailRequestEvent;
+
+	// Event signalled when the worker thread has accumulated the next tail.
+	HANDLE m_TailReadyEvent;
+
+	// Total processing time, in nanoseconds.
+	std::atomic<long long> m_ProcessingTime;
+
+	// Total number of samples processed.
+	std::atomic<long long> m_ProcessedSamples;
+};
@@ -0,0 +1,51 @@
+#include "DSPChain.h"
+
+#include <algorithm>
+
+DSPChain::DSPChain( const long channels, const long blockSize ) :
+	m_Channels( channels ),
+	m_BlockSize( std::max( 1l, blockSize ) ),
+	m_Nodes()
+{
+}
+
+DSPChain::~DSPChain()
+{
+}
+
+void DSPChain::AddNode( const DSPNode::Ptr node )
+{
+	if ( node && ( m_Channels == node->GetChannels() ) ) {
+		m_Nodes.push_back( node );
+	}
+}
+
+bool DSPChain::IsEmpty() const
+{
+	return m_Nodes.empty();
+}
+
+long DSPChain::GetChannels() const
+{
+	return m_Channels;
+}
+
+long DSPChain::GetLatency() const
+{
+	long latency = 0;
+	for ( const auto& node : m_Nodes ) {
+		latency += node->GetLatency();
+	}
+	return latency;
+}
+
+void DSPChain::Process( float* buffer, const long sampleCount )
+{
+	for ( long offset = 0; offset < sampleCount; offset += m_BlockSize ) {
+		const long count = std::min( m_BlockSize, sampleCount - offset );
+		float* block = buffer + offset * m_Channels;
+		for ( const auto& node : m_Nodes ) {
+			node->Process( block, count );
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "DSPNode.h"
+
+#include <vector>
+
+// A chain of DSP nodes, set up at the start of a track, through which sample data is passed in fixed size blocks.
+// Each block passes through every node in turn while it is still in the CPU cache.
+class DSPChain
+{
+public:
+	// 'channels' - channel count.
+	// 'blockSize' - maximum number of samples passed to each node at a time.
+	DSPChain( const long channels, const long blockSize = 1024 );
+
+	virtual ~DSPChain();
+
+	// DSP chain shared pointer type.
+	typedef std::shared_ptr<DSPChain> Ptr;
+
+	// Adds a 'node' to the end of the chain (nodes with a different channel count are ignored).
+	void AddNode( const DSPNode::Ptr node );
+
+	// Returns whether the chain has no nodes.
+	bool IsEmpty() const;
+
+	// Returns the channel count.
+	long GetChannels() const;
+
+	// Returns the total number of samples by which the chain delays its output.
+	long GetLatency() const;
+
+	// Processes 'sampleCount' samples of interleaved sample data in 'buffer', in place.
+	void Process( float* buffer, const long sampleCount );
+
+private:
+	// Channel count.
+	const long m_Channels;
+
+	// Block size.
+	const long m_BlockSize;
+
+	// DSP nodes.
+	std::vector<DSPNode::Ptr> m_Nodes;
+};
@@ -0,0 +1,45 @@
+#include "DSPGain.h"
+
+#include <cmath>
+
+DSPGain::DSPGain( const long channels, const float gain ) :
+	m_Channels( channels ),
+	m_TargetScale( powf( 10.0f, gain / 20.0f ) ),
+	m_Scale( m_TargetScale )
+{
+}
+
+DSPGain::~DSPGain()
+{
+}
+
+long DSPGain::GetChannels() const
+{
+	return m_Channels;
+}
+
+void DSPGain::SetGain( const float gain )
+{
+	m_TargetScale = powf( 10.0f, gain / 20.0f );
+}
+
+void DSPGain::Process( float* buffer, const long sampleCount )
+{
+	const float targetScale = m_TargetScale;
+	if ( ( targetScale != m_Scale ) && ( sampleCount > 0 ) ) {
+		// Ramp linearly to the new gain over the block.
+		const float step = ( targetScale - m_Scale ) / sampleCount;
+		for ( long sampleIndex = 0; sampleIndex < sampleCount; sampleIndex++ ) {
+			m_Scale += step;
+			for ( long channel = 0; channel < m_Channels; channel++ ) {
+				*buffer++ *= m_Scale;
+			}
+		}
+		m_Scale = targetScale;
+	} else if ( 1.0f != m_Scale ) {
+		const long totalSamples = sampleCount * m_Channels;
+		for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
+			buffer[ sampleIndex ] *= m_Scale;
+		}
+	}
+}
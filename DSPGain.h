@@ -0,0 +1,33 @@
+#pragma once
+
+#include "DSPNode.h"
+
+// Applies a gain adjustment, which ramps smoothly to a new value when changed.
+class DSPGain : public DSPNode
+{
+public:
+	// 'channels' - channel count.
+	// 'gain' - initial gain, in dB.
+	DSPGain( const long channels, const float gain );
+
+	virtual ~DSPGain();
+
+	// Returns the channel count.
+	long GetChannels() const override;
+
+	// Sets the 'gain', in dB.
+	void SetGain( const float gain );
+
+	// Applies the gain to 'sampleCount' samples of interleaved sample data in 'buffer'.
+	void Process( float* buffer, const long sampleCount ) override;
+
+private:
+	// Channel count.
+	const long m_Channels;
+
+	// Target gain, as a linear scale factor.
+	std::atomic<float> m_TargetScale;
+
+	// Current gain, as a linear scale factor.
+	float m_Scale;
+};
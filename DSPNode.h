@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// A sample processing stage in a DSP chain.
+// Nodes allocate everything they need up front, and process blocks of interleaved sample data in place.
+class DSPNode
+{
+public:
+	DSPNode()
+	{
+	}
+
+	virtual ~DSPNode()
+	{
+	}
+
+	// DSP node shared pointer type.
+	typedef std::shared_ptr<DSPNode> Ptr;
+
+	// Returns the channel count.
+	virtual long GetChannels() const = 0;
+
+	// Returns the number of samples by which the node delays its output.
+	virtual long GetLatency() const
+	{
+		return 0;
+	}
+
+	// Processes 'sampleCount' samples of interleaved sample data in 'buffer', in place.
+	virtual void Process( float* buffer, const long sampleCount ) = 0;
+};
+
+// Passes parameter updates from another thread (such as the UI thread) to the processing thread, without locking.
+// Only the most recent update is kept, if the processing thread has not yet picked up the previous one.
+// The processing thread never allocates or frees memory: values it replaces are handed back, and freed on the next update from the other thread.
+template <typename T>
+class DSPParameter
+{
+public:
+	DSPParameter() :
+		m_Pending( nullptr ),
+		m_Retired( nullptr )
+	{
+	}
+
+	virtual ~DSPParameter()
+	{
+		delete m_Pending.exchange( nullptr );
+		Reclaim();
+	}
+
+	DSPParameter( const DSPParameter& ) = delete;
+	DSPParameter& operator=( const DSPParameter& ) = delete;
+
+	// Sets the pending parameter 'value' (from the thread making updates).
+	void Set( const T& value )
+	{
+		Reclaim();
+		delete m_Pending.exchange( new Node{ value, nullptr } );
+	}
+
+	// Gets any pending parameter 'value' (from the processing thread), returning true if there was an update.
+	bool Get( T& value )
+	{
+		Node* pending = m_Pending.exchange( nullptr );
+		if ( nullptr != pending ) {
+			// Swap rather than assign, so that any memory held by the previous value is freed by the thread making updates.
+			std::swap( value, pending->Value );
+			pending->Next = m_Retired.load();
+			while ( !m_Retired.compare_exchange_weak( pending->Next, pending ) ) {
+			}
+		}
+		return ( nullptr != pending );
+	}
+
+	// Returns whether there is a pending update.
+	bool IsPending() const
+	{
+		return ( nullptr != m_Pending.load() );
+	}
+
+private:
+	// A parameter value, linked to the next retired value.
+	struct Node {
+		T Value;
+		Node* Next;
+	};
+
+	// Frees the values retired by the processing thread (from the thread making updates).
+	void Reclaim()
+	{
+		Node* node = m_Retired.exchange( nullptr );
+		while ( nullptr != node ) {
+			Node* next = node->Next;
+			delete node;
+			node = next;
+		}
+	}
+
+	// Pending parameter value, or null if there is no update.
+	std::atomic<Node*> m_Pending;
+
+	// Values retired by the processing thread, waiting to be freed.
+	std::atomic<Node*> m_Retired;
+};
@@ -1,11 +1,11 @@
 #include "Decoder.h"
 
-#include "Settings.h"
+#include "MediaInfo.h"
 
 #include "ebur128.h"
 
-#include <windows.h>
-
+#include <chrono>
+#include <cmath>
 #include <random>
 #include <string>
 
@@ -13,7 +13,8 @@ Decoder::Decoder() :
 	m_Duration( 0 ),
 	m_SampleRate( 0 ),
 	m_Channels( 0 ),
-	m_BPS( 0 )
+	m_BPS( 0 ),
+	m_InputSource()
 {
 }
 
@@ -66,9 +67,7 @@ float Decoder::CalculateTrackGain( const float secondsLimit )
 	float trackGain = NAN;
 	if ( ( m_SampleRate > 0 ) && ( m_Channels > 0 ) ) {
 
-		LARGE_INTEGER perfFreq, perfStart, perfEnd;
-		QueryPerformanceFrequency( &perfFreq );
-		QueryPerformanceCounter( &perfStart );
+		const auto startTime = std::chrono::steady_clock::now();
 
 		if ( secondsLimit > 0 ) {
 			Seek( m_Duration * 0.33f );
@@ -85,8 +84,7 @@ float Decoder::CalculateTrackGain( const float secondsLimit )
 				totalSamplesRead += samplesRead;
 				errorState = ebur128_add_frames_float( r128State, buffer, static_cast<size_t>( samplesRead ) );
 				if ( secondsLimit > 0 ) {
-					QueryPerformanceCounter( &perfEnd );
-					const float seconds = static_cast<float>( perfEnd.QuadPart - perfStart.QuadPart ) / perfFreq.QuadPart;
+					const float seconds = std::chrono::duration<float>( std::chrono::steady_clock::now() - startTime ).count();
 					if ( seconds >= secondsLimit ) {
 						break;
 					}
@@ -119,4 +117,13 @@ void Decoder::SkipSilence()
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+std::shared_ptr<InputSource> Decoder::GetInputSource() const
+{
+	return m_InputSource;
+}
+
+void Decoder::SetInputSource( const std::shared_ptr<InputSource> source )
+{
+	m_InputSource = source;
+}
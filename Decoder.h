@@ -3,6 +3,8 @@
 #include <memory>
 #include <stdexcept>
 
+class InputSource;
+
 // Decoder interface.
 class Decoder
 {
@@ -14,6 +16,15 @@ public:
 	// Decoder shared pointer type.
 	typedef std::shared_ptr<Decoder> Ptr;
 
+	// Context in which a decoder is used, which determines how the file is read.
+	enum class Context {
+		// Playback or conversion, where the whole stream is read (the file can be memory mapped, or read ahead in the background).
+		Input,
+
+		// Probing the file for information, or reading a small part of the stream (the file is read using plain block reads).
+		Temporary
+	};
+
 	// Reads sample data.
 	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
 	// 'sampleCount' - number of samples to read.
@@ -55,6 +66,13 @@ public:
 	// Skips any leading silence.
 	void SkipSilence();
 
+	// Returns the input source from which the decoder reads the file (or nullptr if the decoder does not use an input source).
+	std::shared_ptr<InputSource> GetInputSource() const;
+
+protected:
+	// Sets the input 'source' from which the decoder reads the file.
+	void SetInputSource( const std::shared_ptr<InputSource> source );
+
 private:
 	// Duration in seconds.
 	float m_Duration;
@@ -67,4 +85,7 @@ private:
 
 	// Bits per sample (if relevant).
 	long m_BPS;
+
+	// Input source.
+	std::shared_ptr<InputSource> m_InputSource;
 };
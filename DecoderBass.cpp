@@ -8,17 +8,60 @@ static const DWORD sDefaultPanSeparation = 35;
 // Fade out length, in seconds.
 static const float sFadeOutLength = 15.0f;
 
-DecoderBass::DecoderBass( const std::wstring& filename ) :
+// BASS file close callback.
+static void CALLBACK BassFileClose( void* /*user*/ )
+{
+	// The input source is owned by the decoder.
+}
+
+// BASS file length callback.
+static QWORD CALLBACK BassFileLength( void* user )
+{
+	InputSource* source = static_cast<InputSource*>( user );
+	return static_cast<QWORD>( source->GetSize() );
+}
+
+// BASS file read callback.
+static DWORD CALLBACK BassFileRead( void* buffer, DWORD length, void* user )
+{
+	InputSource* source = static_cast<InputSource*>( user );
+	return static_cast<DWORD>( source->Read( buffer, length ) );
+}
+
+// BASS file seek callback.
+static BOOL CALLBACK BassFileSeek( QWORD offset, void* user )
+{
+	InputSource* source = static_cast<InputSource*>( user );
+	return source->Seek( static_cast<long long>( offset ), SEEK_SET ) ? TRUE : FALSE;
+}
+
+// BASS file callbacks, reading from an input source.
+static BASS_FILEPROCS sBassFileProcs = { BassFileClose, BassFileLength, BassFileRead, BassFileSeek };
+
+DecoderBass::DecoderBass( const std::wstring& filename, const Decoder::Context context ) :
 	Decoder(),
+	m_Source( InputSource::Open( filename, InputSource::GetType( context ) ) ),
 	m_Handle( 0 ),
 	m_FadeStartPosition( 0 ),
 	m_FadeEndPosition( 0 ),
 	m_CurrentPosition( 0 )
 {
+	// MP3 encoder delay & padding (from LAME/Xing/VBRI/iTunes tags) is trimmed by BASS at sample precision, unless BASS_MP3_IGNOREDELAY is specified.
 	DWORD flags = BASS_UNICODE | BASS_SAMPLE_FLOAT | BASS_STREAM_DECODE;
 
-	// First try loading a stream.
-	m_Handle = BASS_StreamCreateFile( FALSE /*mem*/, filename.c_str(), 0 /*offset*/, 0 /*length*/, flags );
+	// First try loading a stream, reading via the input source.
+	if ( m_Source ) {
+		m_Handle = BASS_StreamCreateFileUser( STREAMFILE_NOBUFFER, flags & ~BASS_UNICODE, &sBassFileProcs, m_Source.get() );
+		if ( 0 == m_Handle ) {
+			m_Source.reset();
+		} else {
+			SetInputSource( m_Source );
+		}
+	}
+	if ( 0 == m_Handle ) {
+		// Let BASS open the file itself.
+		m_Handle = BASS_StreamCreateFile( FALSE /*mem*/, filename.c_str(), 0 /*offset*/, 0 /*length*/, flags );
+	}
 	if ( 0 == m_Handle ) {
 		// Try loading a music file.
 		flags = BASS_UNICODE | BASS_SAMPLE_FLOAT | BASS_MUSIC_DECODE | BASS_MUSIC_NOSAMPLE;
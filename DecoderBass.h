@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Decoder.h"
+#include "InputSource.h"
 
 #include "bass.h"
 
@@ -11,8 +12,9 @@ class DecoderBass : public Decoder
 {
 public:
 	// 'filename' - file name.
+	// 'context' - context in which the decoder is used.
 	// Throws a std::runtime_error exception if the file could not be loaded.
-	DecoderBass( const std::wstring& filename );
+	DecoderBass( const std::wstring& filename, const Decoder::Context context );
 
 	virtual ~DecoderBass();
 
@@ -27,6 +29,9 @@ public:
 	virtual float Seek( const float position );
 
 private:
+	// Input source (for streams).
+	InputSource::Ptr m_Source;
+
 	// Stream handle
 	DWORD m_Handle;
 
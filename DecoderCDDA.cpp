@@ -1,5 +1,6 @@
 #include "DecoderCDDA.h"
 
+#include "SampleConversion.h"
 #include "Utility.h"
 
 DecoderCDDA::DecoderCDDA( const CDDAMedia& cddaMedia, const long track ) :
@@ -30,12 +31,13 @@ DecoderCDDA::~DecoderCDDA()
 long DecoderCDDA::Read( float* buffer, const long sampleCount )
 {
 	long samplesRead = 0;
-	long outputBufPos = 0;
 	while ( samplesRead < sampleCount ) {
 		if ( m_CurrentBufPos < m_Buffer.size() ) {
-			buffer[ outputBufPos++ ] = static_cast<float>( m_Buffer[ m_CurrentBufPos++ ] ) / 32768.0f;
-			buffer[ outputBufPos++ ] = static_cast<float>( m_Buffer[ m_CurrentBufPos++ ] ) / 32768.0f;
-			++samplesRead;
+			// Convert as much of the current sector as possible (CD audio is always 16-bit stereo).
+			const long samplesToConvert = min( sampleCount - samplesRead, static_cast<long>( ( m_Buffer.size() - m_CurrentBufPos ) / 2 ) );
+			Convert16ToFloat( &m_Buffer[ m_CurrentBufPos ], buffer + samplesRead * 2, static_cast<size_t>( samplesToConvert ) * 2 );
+			m_CurrentBufPos += static_cast<size_t>( samplesToConvert ) * 2;
+			samplesRead += samplesToConvert;
 		} else {
 			if ( ( m_CurrentSector < m_SectorEnd ) && ( m_CDDAMedia.Read( m_Handle, m_CurrentSector++, true /*useCache*/, m_Buffer ) ) ) {
 				m_CurrentBufPos = 0;
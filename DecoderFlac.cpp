@@ -1,17 +1,23 @@
 #include "DecoderFlac.h"
 
-DecoderFlac::DecoderFlac( const std::wstring& filename ) :
+#include "SampleConversion.h"
+
+#include <algorithm>
+
+DecoderFlac::DecoderFlac( const std::wstring& filename, const Decoder::Context context ) :
 	Decoder(),
 	FLAC::Decoder::Stream(),
-	m_FileStream(),
+	m_Source(),
 	m_FLACFrame(),
-	m_FLACBuffer( nullptr ),
-	m_FLACFramePos( 0 ),
+	m_Buffer(),
+	m_BufferSamples( 0 ),
+	m_BufferPos( 0 ),
 	m_Valid( false )
 {
 	try {
-		m_FileStream.open( filename, std::ios::binary | std::ios::in );
-		if ( m_FileStream.is_open() ) {
+		m_Source = InputSource::Open( filename, InputSource::GetType( context ) );
+		if ( m_Source ) {
+			SetInputSource( m_Source );
 			if ( init() == FLAC__STREAM_DECODER_INIT_STATUS_OK )	{
 				process_until_end_of_metadata();
 			}
@@ -21,7 +27,6 @@ DecoderFlac::DecoderFlac( const std::wstring& filename ) :
 
 	if ( !m_Valid ) {
 		finish();
-		m_FileStream.close();
 		throw std::runtime_error( "DecoderFlac could not load file" );
 	}
 }
@@ -29,35 +34,33 @@ DecoderFlac::DecoderFlac( const std::wstring& filename ) :
 DecoderFlac::~DecoderFlac()
 {
 	finish();
-	m_FileStream.close();
 }
 
 long DecoderFlac::Read( float* buffer, const long sampleCount )
 {
 	long samplesRead = 0;
+	const long channels = static_cast<long>( GetChannels() );
 	while ( samplesRead < sampleCount ) {
-		if ( m_FLACFramePos >= m_FLACFrame.header.blocksize ) {
-			m_FLACFramePos = 0;
-			m_FLACFrame = {};
-			if ( !process_single() || ( 0 == m_FLACFrame.header.blocksize ) ) {
+		if ( m_BufferPos >= m_BufferSamples ) {
+			m_BufferPos = 0;
+			m_BufferSamples = 0;
+			if ( !process_single() || ( 0 == m_BufferSamples ) ) {
 				break;
 			}
 		}
-		for ( unsigned int channel = 0; channel < m_FLACFrame.header.channels; channel++ ) {
-			buffer[ samplesRead * m_FLACFrame.header.channels + channel ] = 
-					static_cast<float>( m_FLACBuffer[ channel ][ m_FLACFramePos ] ) / ( 1 << ( m_FLACFrame.header.bits_per_sample - 1 ) );
-		}
-		++samplesRead;
-		++m_FLACFramePos;
+		const long samplesToCopy = (std::min)( sampleCount - samplesRead, m_BufferSamples - m_BufferPos );
+		std::copy( m_Buffer.begin() + m_BufferPos * channels, m_Buffer.begin() + ( m_BufferPos + samplesToCopy ) * channels, buffer + samplesRead * channels );
+		samplesRead += samplesToCopy;
+		m_BufferPos += samplesToCopy;
 	}
-	
 	return samplesRead;
 }
 
 float DecoderFlac::Seek( const float position )
 {
 	float seekPosition = 0;
-	m_FLACFramePos = 0;
+	m_BufferPos = 0;
+	m_BufferSamples = 0;
 	if ( ( GetSampleRate() > 0 ) && seek_absolute( static_cast<FLAC__uint64>( position * GetSampleRate() ) ) ) {
 		process_single();
 		seekPosition = static_cast<float>( m_FLACFrame.header.number.sample_number ) / GetSampleRate();
@@ -71,12 +74,11 @@ float DecoderFlac::Seek( const float position )
 FLAC__StreamDecoderReadStatus DecoderFlac::read_callback( FLAC__byte buf[], size_t * size )
 {
 	FLAC__StreamDecoderReadStatus status = FLAC__STREAM_DECODER_READ_STATUS_ABORT;
-	if ( m_FileStream.eof() ) {
+	if ( m_Source->IsEOF() ) {
 		*size = 0;
 		status = FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
 	} else {
-		m_FileStream.read( reinterpret_cast<char*>( buf ), *size );
-		*size = static_cast<size_t>( m_FileStream.gcount() );
+		*size = m_Source->Read( buf, *size );
 		if ( *size > 0 ) {
 			status = FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
 		}
@@ -86,44 +88,44 @@ FLAC__StreamDecoderReadStatus DecoderFlac::read_callback( FLAC__byte buf[], size
 
 FLAC__StreamDecoderSeekStatus DecoderFlac::seek_callback( FLAC__uint64 pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	m_FileStream.seekg( pos, std::ios_base::beg );
-	return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+	const FLAC__StreamDecoderSeekStatus status = m_Source->Seek( static_cast<long long>( pos ), SEEK_SET ) ? FLAC__STREAM_DECODER_SEEK_STATUS_OK : FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+	return status;
 }
 
 FLAC__StreamDecoderTellStatus DecoderFlac::tell_callback( FLAC__uint64 * pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	*pos = m_FileStream.tellg();
+	*pos = static_cast<FLAC__uint64>( m_Source->Tell() );
 	return FLAC__STREAM_DECODER_TELL_STATUS_OK;
 }
 
 FLAC__StreamDecoderLengthStatus DecoderFlac::length_callback( FLAC__uint64 * pos )
 {
-	if ( !m_FileStream.good() ) {
-		m_FileStream.clear();
-	}
-	const std::streampos currentPos = m_FileStream.tellg();
-	m_FileStream.seekg( 0, std::ios_base::end );
-	*pos = m_FileStream.tellg();
-	m_FileStream.seekg( currentPos );
+	*pos = static_cast<FLAC__uint64>( m_Source->GetSize() );
 	return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
 }
 
 bool DecoderFlac::eof_callback()
 {
-	const bool eof = m_FileStream.eof();
+	const bool eof = m_Source->IsEOF();
 	return eof;
 }
 
 FLAC__StreamDecoderWriteStatus DecoderFlac::write_callback( const FLAC__Frame * frame, const FLAC__int32 *const buffer[] )
 {
 	m_FLACFrame = *frame;
-	m_FLACBuffer = const_cast<FLAC__int32**>( buffer );
+	const unsigned int channels = frame->header.channels;
+	const unsigned int blocksize = frame->header.blocksize;
+	const unsigned int bps = frame->header.bits_per_sample;
+	if ( ( channels == static_cast<unsigned int>( GetChannels() ) ) && ( bps > 0 ) && ( bps <= 32 ) ) {
+		// Convert the whole block, so that reads are a straight copy from the converted buffer.
+		const size_t requiredSize = static_cast<size_t>( blocksize ) * channels;
+		if ( m_Buffer.size() < requiredSize ) {
+			m_Buffer.resize( requiredSize );
+		}
+		ConvertPlanar32ToFloat( buffer, channels, blocksize, static_cast<int>( bps ), m_Buffer.data() );
+		m_BufferSamples = static_cast<long>( blocksize );
+		m_BufferPos = 0;
+	}
 	return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
 
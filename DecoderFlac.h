@@ -1,9 +1,9 @@
 #pragma once
 #include "Decoder.h"
+#include "InputSource.h"
 
 #include "FLAC++\all.h"
 
-#include <fstream>
 #include <vector>
 
 // FLAC decoder
@@ -11,8 +11,9 @@ class DecoderFlac : public Decoder, public FLAC::Decoder::Stream
 {
 public:
 	// 'filename' - file name.
+	// 'context' - context in which the decoder is used.
 	// Throws a std::runtime_error exception if the file could not be loaded.
-	DecoderFlac( const std::wstring& filename );
+	DecoderFlac( const std::wstring& filename, const Decoder::Context context );
 
 	virtual ~DecoderFlac();
 
@@ -38,17 +39,20 @@ protected:
 	virtual void error_callback( FLAC__StreamDecoderErrorStatus );
 
 private:
-	// Input file stream.
-	std::ifstream m_FileStream;
+	// Input source.
+	InputSource::Ptr m_Source;
 
 	// Current FLAC frame.
 	FLAC__Frame m_FLACFrame;
 
-	// Current FLAC buffer.
-	FLAC__int32** m_FLACBuffer;
+	// Current FLAC frame, converted to interleaved floating point samples.
+	std::vector<float> m_Buffer;
 
-	// Current FLAC frame position.
-	unsigned int m_FLACFramePos;
+	// Number of samples (per channel) in the converted frame buffer.
+	long m_BufferSamples;
+
+	// Position of the next sample (per channel) to read from the converted frame buffer.
+	long m_BufferPos;
 
 	// Indicates whether this is a valid FLAC stream.
 	bool m_Valid;
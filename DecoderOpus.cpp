@@ -1,14 +1,41 @@
 #include "DecoderOpus.h"
 
-#include "Utility.h"
+// Opus file read callback.
+static int OpusRead( void* stream, unsigned char* ptr, int nbytes )
+{
+	InputSource* source = static_cast<InputSource*>( stream );
+	const int bytesRead = ( nbytes > 0 ) ? static_cast<int>( source->Read( ptr, static_cast<size_t>( nbytes ) ) ) : 0;
+	return bytesRead;
+}
+
+// Opus file seek callback.
+static int OpusSeek( void* stream, opus_int64 offset, int whence )
+{
+	InputSource* source = static_cast<InputSource*>( stream );
+	const int result = source->Seek( offset, whence ) ? 0 : -1;
+	return result;
+}
 
-DecoderOpus::DecoderOpus( const std::wstring& filename ) :
+// Opus file tell callback.
+static opus_int64 OpusTell( void* stream )
+{
+	InputSource* source = static_cast<InputSource*>( stream );
+	return source->Tell();
+}
+
+// Opus file callbacks, reading from an input source.
+static const OpusFileCallbacks s_OpusFileCallbacks = { OpusRead, OpusSeek, OpusTell, nullptr /*close*/ };
+
+DecoderOpus::DecoderOpus( const std::wstring& filename, const Decoder::Context context ) :
 	Decoder(),
+	m_Source( InputSource::Open( filename, InputSource::GetType( context ) ) ),
 	m_OpusFile( nullptr )
 {
 	int error = 0;
-	const std::string filepath = WideStringToUTF8( filename );
-	m_OpusFile = op_open_file( filepath.c_str(), &error );
+	if ( m_Source ) {
+		SetInputSource( m_Source );
+		m_OpusFile = op_open_callbacks( m_Source.get(), &s_OpusFileCallbacks, nullptr /*initialData*/, 0 /*initialBytes*/, &error );
+	}
 	if ( nullptr != m_OpusFile ) {
 		const OpusHead* head = op_head( m_OpusFile, -1 /*link*/ );
 		if ( nullptr != head ) {
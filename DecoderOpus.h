@@ -1,5 +1,6 @@
 #pragma once
 #include "Decoder.h"
+#include "InputSource.h"
 
 #include <string>
 
@@ -10,8 +11,9 @@ class DecoderOpus : public Decoder
 {
 public:
 	// 'filename' - file name.
+	// 'context' - context in which the decoder is used.
 	// Throws a std::runtime_error exception if the file could not be loaded.
-	DecoderOpus( const std::wstring& filename );
+	DecoderOpus( const std::wstring& filename, const Decoder::Context context );
 
 	virtual ~DecoderOpus();
 
@@ -26,6 +28,9 @@ public:
 	virtual float Seek( const float position );
 
 private:
+	// Input source.
+	InputSource::Ptr m_Source;
+
 	// Opus file
 	OggOpusFile* m_OpusFile;
 };
@@ -1,15 +1,86 @@
 #include "DecoderWavpack.h"
 
-#include "Utility.h"
+#include "SampleConversion.h"
 
-DecoderWavpack::DecoderWavpack( const std::wstring& filename ) :
+// WavPack stream reader read callback.
+static int32_t WavpackReadBytes( void* id, void* data, int32_t bcount )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	const int32_t bytesRead = ( bcount > 0 ) ? static_cast<int32_t>( source->Read( data, static_cast<size_t>( bcount ) ) ) : 0;
+	return bytesRead;
+}
+
+// WavPack stream reader position callback.
+static int64_t WavpackGetPos( void* id )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	return source->Tell();
+}
+
+// WavPack stream reader absolute seek callback.
+static int WavpackSetPosAbs( void* id, int64_t pos )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	const int result = source->Seek( pos, SEEK_SET ) ? 0 : -1;
+	return result;
+}
+
+// WavPack stream reader relative seek callback.
+static int WavpackSetPosRel( void* id, int64_t delta, int mode )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	const int result = source->Seek( delta, mode ) ? 0 : -1;
+	return result;
+}
+
+// WavPack stream reader push back callback.
+static int WavpackPushBackByte( void* id, int c )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	const int result = source->Seek( -1, SEEK_CUR ) ? c : EOF;
+	return result;
+}
+
+// WavPack stream reader length callback.
+static int64_t WavpackGetLength( void* id )
+{
+	InputSource* source = static_cast<InputSource*>( id );
+	return source->GetSize();
+}
+
+// WavPack stream reader seekable callback.
+static int WavpackCanSeek( void* /*id*/ )
+{
+	return 1;
+}
+
+// WavPack stream reader, reading from an input source.
+static WavpackStreamReader64 s_StreamReader = {
+	WavpackReadBytes,
+	nullptr /*write_bytes*/,
+	WavpackGetPos,
+	WavpackSetPosAbs,
+	WavpackSetPosRel,
+	WavpackPushBackByte,
+	WavpackGetLength,
+	WavpackCanSeek,
+	nullptr /*truncate_here*/,
+	nullptr /*close*/
+};
+
+DecoderWavpack::DecoderWavpack( const std::wstring& filename, const Decoder::Context context ) :
 	Decoder(),
+	m_Source( InputSource::Open( filename, InputSource::GetType( context ) ) ),
+	m_CorrectionSource( InputSource::Open( filename + L"c", InputSource::GetType( context ) ) ),
 	m_Context( nullptr )
 {
-	char* error = nullptr;
-	const int flags = OPEN_WVC | OPEN_NORMALIZE | OPEN_DSD_AS_PCM | OPEN_FILE_UTF8;
+	char error[ 80 ] = {};
+	const int flags = OPEN_WVC | OPEN_NORMALIZE | OPEN_DSD_AS_PCM;
 	const int offset = 0;
-	m_Context = WavpackOpenFileInput( WideStringToUTF8( filename ).c_str(), error, flags, offset );
+	if ( m_Source ) {
+		SetInputSource( m_Source );
+		m_Context = WavpackOpenFileInputEx64( &s_StreamReader, m_Source.get(), m_CorrectionSource.get(), error, flags, offset );
+	}
 	if ( nullptr != m_Context ) {
 		SetBPS( static_cast<long>( WavpackGetBitsPerSample( m_Context ) ) );
 		SetChannels( static_cast<long>( WavpackGetNumChannels( m_Context ) ) );
@@ -31,12 +102,10 @@ long DecoderWavpack::Read( float* buffer, const long sampleCount )
 {
 	const long samplesRead = ( sampleCount > 0 ) ? static_cast<long>( WavpackUnpackSamples( m_Context, reinterpret_cast<int32_t*>( buffer ), sampleCount ) ) : 0;
 	if ( !( WavpackGetMode( m_Context ) & MODE_FLOAT ) ) {
-		int32_t* nativeBuffer = reinterpret_cast<int32_t*>( buffer );
+		const int32_t* nativeBuffer = reinterpret_cast<const int32_t*>( buffer );
 		const long bufferSize = samplesRead * GetChannels();
 		const int bitsPerSample = WavpackGetBytesPerSample( m_Context ) * 8;
-		for ( long index = 0; index < bufferSize; index++ ) {
-			buffer[ index ] = static_cast<float>( nativeBuffer[ index ] ) / ( 1 << ( bitsPerSample - 1 ) );
-		}
+		Convert32ToFloat( nativeBuffer, buffer, static_cast<size_t>( bufferSize ), bitsPerSample );
 	}
 	return samplesRead;
 }
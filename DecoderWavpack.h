@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Decoder.h"
+#include "InputSource.h"
 
 #include "wavpack.h"
 
@@ -10,8 +11,9 @@ class DecoderWavpack : public Decoder
 {
 public:
 	// 'filename' - file name.
+	// 'context' - context in which the decoder is used.
 	// Throws a std::runtime_error exception if the file could not be loaded.
-	DecoderWavpack( const std::wstring& filename );
+	DecoderWavpack( const std::wstring& filename, const Decoder::Context context );
 
 	virtual ~DecoderWavpack();
 
@@ -26,6 +28,12 @@ public:
 	virtual float Seek( const float position );
 
 private:
+	// Input source.
+	InputSource::Ptr m_Source;
+
+	// Input source for any correction file.
+	InputSource::Ptr m_CorrectionSource;
+
 	// WavPack context.
 	WavpackContext* m_Context;
 };
@@ -0,0 +1,9 @@
+#pragma once
+
+// Dither modes, for reducing sample data to an integer format of 24-bit resolution or lower.
+enum class DitherMode {
+	None = 0,							// Round to the nearest integer value, without dither.
+	Triangular,						// Add triangular (TPDF) dither.
+	NoiseShaped,					// Add triangular dither, with first order (high pass) noise shaping.
+	WeightedNoiseShaped		// Add triangular dither, with noise shaping weighted to the sensitivity of hearing.
+};
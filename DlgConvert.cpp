@@ -10,6 +10,12 @@
 // All tracks entry ID.
 static const long s_AllTracksID = 0;
 
+// Output sample rates available when joining tracks (in addition to automatic selection).
+static const std::list<long> s_JoinSampleRates = { 44100, 48000, 88200, 96000, 176400, 192000 };
+
+// Output channel counts available when joining tracks (in addition to automatic selection), paired with their string resource IDs.
+static const std::list<std::pair<long,int>> s_JoinChannels = { { 1, IDS_CONVERT_JOIN_MONO }, { 2, IDS_CONVERT_JOIN_STEREO } };
+
 INT_PTR CALLBACK DlgConvert::DialogProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
 {
 	switch ( message ) {
@@ -237,6 +243,9 @@ void DlgConvert::OnInitDialog( const HWND hwnd )
 			LoadString( m_hInst, IDS_EXTRACT_ADDTOLIBRARY, buffer, bufSize );
 			SetWindowText( addToLibraryWnd, buffer );
 		}
+
+		// EQ is only applied when converting tracks, not when extracting audio CD tracks.
+		ShowWindow( GetDlgItem( m_hWnd, IDC_CONVERT_APPLYEQ ), SW_HIDE );
 	}
 
 	std::wstring extractFolder;
@@ -245,6 +254,48 @@ void DlgConvert::OnInitDialog( const HWND hwnd )
 	bool extractJoin = false;
 	m_Settings.GetExtractSettings( extractFolder, extractFilename, extractToLibrary, extractJoin );
 	CheckDlgButton( m_hWnd, IDC_CONVERT_ADDTOLIBRARY, extractToLibrary ? BST_CHECKED : BST_UNCHECKED );
+	CheckDlgButton( m_hWnd, IDC_CONVERT_APPLYEQ, m_Settings.GetConvertApplyEQ() ? BST_CHECKED : BST_UNCHECKED );
+	CheckDlgButton( m_hWnd, IDC_CONVERT_PARALLEL, m_Settings.GetConvertParallel() ? BST_CHECKED : BST_UNCHECKED );
+	CheckDlgButton( m_hWnd, IDC_CONVERT_PASSTHROUGH, m_Settings.GetConvertPassthrough() ? BST_CHECKED : BST_UNCHECKED );
+
+	// Tracks of differing formats are converted to a common output format when joining them into a single file.
+	long joinSampleRate = 0;
+	long joinChannels = 0;
+	m_Settings.GetConvertJoinFormat( joinSampleRate, joinChannels );
+	const int bufSize = 64;
+	WCHAR buffer[ bufSize ] = {};
+	LoadString( m_hInst, IDS_CONVERT_JOIN_AUTOMATIC, buffer, bufSize );
+	const std::wstring automatic( buffer );
+	const HWND sampleRateWnd = GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_SAMPLERATE );
+	if ( nullptr != sampleRateWnd ) {
+		ComboBox_AddString( sampleRateWnd, automatic.c_str() );
+		ComboBox_SetItemData( sampleRateWnd, 0, 0 );
+		ComboBox_SetCurSel( sampleRateWnd, 0 );
+		LoadString( m_hInst, IDS_UNITS_HZ, buffer, bufSize );
+		const std::wstring units( buffer );
+		for ( const auto& sampleRate : s_JoinSampleRates ) {
+			const std::wstring str = std::to_wstring( sampleRate ) + L" " + units;
+			const int itemIndex = ComboBox_AddString( sampleRateWnd, str.c_str() );
+			ComboBox_SetItemData( sampleRateWnd, itemIndex, static_cast<LPARAM>( sampleRate ) );
+			if ( sampleRate == joinSampleRate ) {
+				ComboBox_SetCurSel( sampleRateWnd, itemIndex );
+			}
+		}
+	}
+	const HWND channelsWnd = GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_CHANNELS );
+	if ( nullptr != channelsWnd ) {
+		ComboBox_AddString( channelsWnd, automatic.c_str() );
+		ComboBox_SetItemData( channelsWnd, 0, 0 );
+		ComboBox_SetCurSel( channelsWnd, 0 );
+		for ( const auto& [ channels, stringID ] : s_JoinChannels ) {
+			LoadString( m_hInst, stringID, buffer, bufSize );
+			const int itemIndex = ComboBox_AddString( channelsWnd, buffer );
+			ComboBox_SetItemData( channelsWnd, itemIndex, static_cast<LPARAM>( channels ) );
+			if ( channels == joinChannels ) {
+				ComboBox_SetCurSel( channelsWnd, itemIndex );
+			}
+		}
+	}
 
 	const HWND okWnd = GetDlgItem( m_hWnd, IDOK );
 	EnableWindow( okWnd, m_SelectedTracks.empty() ? FALSE : TRUE );
@@ -381,21 +432,7 @@ void DlgConvert::UpdateDestinationControls()
 {
 	const Playlist::ItemList selectedTracks = GetSelectedTracks();
 	const bool enableIndividualTracks = !selectedTracks.empty();
-	bool enableJoinTracks = !selectedTracks.empty();
-	long commonChannels = 0;
-	long commonSampleRate = 0;
-	auto track = selectedTracks.begin();
-	if ( selectedTracks.end() != track ) {
-		commonChannels = track->Info.GetChannels();
-		commonSampleRate = track->Info.GetSampleRate();
-		++track;
-	}
-	while ( enableJoinTracks && ( selectedTracks.end() != track ) ) {
-		const long channels = track->Info.GetChannels();
-		const long sampleRate = track->Info.GetSampleRate();
-		enableJoinTracks = ( channels == commonChannels ) && ( sampleRate == commonSampleRate );
-		++track;
-	}
+	const bool enableJoinTracks = !selectedTracks.empty();
 
 	if ( enableJoinTracks != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN ) ) ? true : false ) ) {
 		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN ), enableJoinTracks );
@@ -412,6 +449,18 @@ void DlgConvert::UpdateDestinationControls()
 	const bool enableConvertFolder = enableIndividualTracks && ( BST_CHECKED == IsDlgButtonChecked( m_hWnd, IDC_CONVERT_INDIVIDUAL ) );
 	const bool enableConvertFilename = enableConvertFolder;
 	const bool enableConvertBrowse = enableConvertFolder;
+	const bool enableConvertParallel = enableConvertFolder;
+	const bool enableConvertPassthrough = enableConvertFolder;
+
+	// Audio CD tracks all share the same format, so can always be joined without conversion.
+	const bool cdda = !m_Tracks.empty() && ( MediaInfo::Source::CDDA == m_Tracks.begin()->Info.GetSource() );
+	const bool enableJoinFormat = !cdda && enableJoinTracks && ( BST_CHECKED == IsDlgButtonChecked( m_hWnd, IDC_CONVERT_JOIN ) );
+	if ( enableJoinFormat != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_SAMPLERATE ) ) ? true : false ) ) {
+		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_SAMPLERATE ), enableJoinFormat );
+	}
+	if ( enableJoinFormat != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_CHANNELS ) ) ? true : false ) ) {
+		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_CHANNELS ), enableJoinFormat );
+	}
 
 	if ( enableConvertFolder != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_FOLDER ) ) ? true : false ) ) {
 		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_FOLDER ), enableConvertFolder );
@@ -422,6 +471,12 @@ void DlgConvert::UpdateDestinationControls()
 	if ( enableConvertBrowse != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_BROWSE ) ) ? true : false ) ) {
 		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_BROWSE ), enableConvertBrowse );
 	}
+	if ( enableConvertParallel != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_PARALLEL ) ) ? true : false ) ) {
+		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_PARALLEL ), enableConvertParallel );
+	}
+	if ( enableConvertPassthrough != ( IsWindowEnabled( GetDlgItem( m_hWnd, IDC_CONVERT_PASSTHROUGH ) ) ? true : false ) ) {
+		EnableWindow( GetDlgItem( m_hWnd, IDC_CONVERT_PASSTHROUGH ), enableConvertPassthrough );
+	}
 }
 
 void DlgConvert::OnFilenameFormat()
@@ -467,6 +522,17 @@ bool DlgConvert::OnClose( const bool ok )
 		}
 
 		m_Settings.SetExtractSettings( extractFolder, extractFilename, extractToLibrary, extractJoin );
+		m_Settings.SetConvertApplyEQ( BST_CHECKED == IsDlgButtonChecked( m_hWnd, IDC_CONVERT_APPLYEQ ) );
+		m_Settings.SetConvertParallel( BST_CHECKED == IsDlgButtonChecked( m_hWnd, IDC_CONVERT_PARALLEL ) );
+		m_Settings.SetConvertPassthrough( BST_CHECKED == IsDlgButtonChecked( m_hWnd, IDC_CONVERT_PASSTHROUGH ) );
+
+		const HWND sampleRateWnd = GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_SAMPLERATE );
+		const HWND channelsWnd = GetDlgItem( m_hWnd, IDC_CONVERT_JOIN_CHANNELS );
+		const int sampleRateIndex = ComboBox_GetCurSel( sampleRateWnd );
+		const int channelsIndex = ComboBox_GetCurSel( channelsWnd );
+		const long joinSampleRate = ( -1 != sampleRateIndex ) ? static_cast<long>( ComboBox_GetItemData( sampleRateWnd, sampleRateIndex ) ) : 0;
+		const long joinChannels = ( -1 != channelsIndex ) ? static_cast<long>( ComboBox_GetItemData( channelsWnd, channelsIndex ) ) : 0;
+		m_Settings.SetConvertJoinFormat( joinSampleRate, joinChannels );
 	}
 	return canClose;
 }
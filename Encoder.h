@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstdio>
 #include <memory>
 #include <string>
 
@@ -7,7 +9,9 @@
 class Encoder
 {
 public:
-	Encoder()
+	Encoder() :
+		m_WriteTime( 0 ),
+		m_BytesWritten( 0 )
 	{
 	}
 
@@ -35,4 +39,48 @@ public:
 
 	// Closes the encoder.
 	virtual void Close() = 0;
+
+	// Limits the number of worker threads the encoder can use to 'maxThreads', or removes the limit if 'maxThreads' is zero.
+	// This should be called before the encoder is opened, and is ignored by encoders which do not use worker threads.
+	virtual void SetMaxThreads( const long /*maxThreads*/ )
+	{
+	}
+
+	// Returns the time spent writing to the output file since the encoder was opened, in nanoseconds.
+	long long GetWriteTime() const
+	{
+		return m_WriteTime;
+	}
+
+	// Returns the number of bytes written to the output file since the encoder was opened.
+	long long GetBytesWritten() const
+	{
+		return m_BytesWritten;
+	}
+
+protected:
+	// Resets the output file write statistics, when the encoder is opened.
+	void ResetWriteStatistics()
+	{
+		m_WriteTime = 0;
+		m_BytesWritten = 0;
+	}
+
+	// Writes 'size' bytes of 'data' to the output 'file', returning whether all the bytes were written.
+	// The time spent writing is accumulated separately, so that disk writes can be distinguished from encoding.
+	bool WriteOutput( FILE* file, const void* data, const size_t size )
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		const size_t bytesWritten = fwrite( data, 1 /*elementSize*/, size, file );
+		m_WriteTime += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - startTime ).count();
+		m_BytesWritten += static_cast<long long>( bytesWritten );
+		return ( size == bytesWritten );
+	}
+
+private:
+	// Time spent writing to the output file, in nanoseconds.
+	long long m_WriteTime;
+
+	// Number of bytes written to the output file.
+	long long m_BytesWritten;
 };
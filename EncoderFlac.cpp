@@ -1,50 +1,338 @@
 #include "EncoderFlac.h"
 
+#include "SampleConversion.h"
 #include "Utility.h"
 
-#include <vector>
+#include <algorithm>
 
-EncoderFlac::EncoderFlac() :
-	Encoder()
+// Default compression level.
+static const int s_DefaultCompressionLevel = 5;
+
+// Number of blocks in each chunk of sample data encoded by a worker thread, in multithreaded mode.
+static const long s_ChunkBlocks = 32;
+
+// Number of chunks per worker thread, which can be in the process of being encoded or waiting to be written out.
+static const long s_ChunksPerWorker = 2;
+
+// Size of the stream marker and metadata block header preceding the stream information block.
+static const long s_StreamInfoOffset = 8;
+
+// Size of the stream information block.
+static const long s_StreamInfoSize = 34;
+
+// Returns whether the 'compressionLevel' uses adaptive mid-side stereo, whose channel assignment depends on previous frames.
+static bool IsLooseMidSide( const int compressionLevel )
+{
+	return ( 1 == compressionLevel ) || ( 4 == compressionLevel );
+}
+
+// Returns the CRC-8 of 'count' bytes of 'data', as used for FLAC frame headers.
+static BYTE CalculateCRC8( const BYTE* data, const size_t count )
+{
+	BYTE crc = 0;
+	for ( size_t index = 0; index < count; index++ ) {
+		crc ^= data[ index ];
+		for ( int bit = 0; bit < 8; bit++ ) {
+			crc = ( crc & 0x80 ) ? static_cast<BYTE>( ( crc << 1 ) ^ 0x07 ) : static_cast<BYTE>( crc << 1 );
+		}
+	}
+	return crc;
+}
+
+// Returns the CRC-16 of 'count' bytes of 'data', as used for FLAC frames.
+static WORD CalculateCRC16( const BYTE* data, const size_t count )
+{
+	WORD crc = 0;
+	for ( size_t index = 0; index < count; index++ ) {
+		crc ^= static_cast<WORD>( data[ index ] << 8 );
+		for ( int bit = 0; bit < 8; bit++ ) {
+			crc = ( crc & 0x8000 ) ? static_cast<WORD>( ( crc << 1 ) ^ 0x8005 ) : static_cast<WORD>( crc << 1 );
+		}
+	}
+	return crc;
+}
+
+// Appends the UTF-8 style coding of a frame 'number' to 'output'.
+static void AppendFrameNumber( const long long number, std::vector<BYTE>& output )
+{
+	if ( number < 0x80 ) {
+		output.push_back( static_cast<BYTE>( number ) );
+	} else {
+		int extraBytes = ( number < 0x800 ) ? 1 : ( number < 0x10000 ) ? 2 : ( number < 0x200000 ) ? 3 : ( number < 0x4000000 ) ? 4 : 5;
+		const BYTE prefix = static_cast<BYTE>( 0xff00 >> ( 1 + extraBytes ) );
+		output.push_back( static_cast<BYTE>( prefix | ( number >> ( 6 * extraBytes ) ) ) );
+		while ( extraBytes-- > 0 ) {
+			output.push_back( static_cast<BYTE>( 0x80 | ( ( number >> ( 6 * extraBytes ) ) & 0x3f ) ) );
+		}
+	}
+}
+
+// Returns the size of the UTF-8 style coded frame number of a FLAC 'frame'.
+static size_t GetFrameNumberSize( const BYTE* frame )
+{
+	size_t numberSize = 1;
+	if ( frame[ 4 ] & 0x80 ) {
+		for ( BYTE mask = 0x40; ( frame[ 4 ] & mask ) && ( numberSize < 7 ); mask >>= 1 ) {
+			++numberSize;
+		}
+	}
+	return numberSize;
+}
+
+// Returns the size of a FLAC frame header (excluding the CRC-8), or zero if 'frame' does not hold a valid header.
+static size_t GetFrameHeaderSize( const BYTE* frame, const size_t frameSize )
+{
+	size_t headerSize = 0;
+	if ( frameSize > 6 ) {
+		const BYTE blockSizeCode = frame[ 2 ] >> 4;
+		const BYTE sampleRateCode = frame[ 2 ] & 0x0f;
+		headerSize = 4 + GetFrameNumberSize( frame );
+		if ( 6 == blockSizeCode ) {
+			headerSize += 1;
+		} else if ( 7 == blockSizeCode ) {
+			headerSize += 2;
+		}
+		if ( 12 == sampleRateCode ) {
+			headerSize += 1;
+		} else if ( ( 13 == sampleRateCode ) || ( 14 == sampleRateCode ) ) {
+			headerSize += 2;
+		}
+		if ( ( headerSize + 3 ) > frameSize ) {
+			headerSize = 0;
+		}
+	}
+	return headerSize;
+}
+
+// Encodes a chunk of sample data as a separate stream in memory.
+class FlacChunkEncoder : public FLAC::Encoder::Stream
+{
+public:
+	// 'metadata' - out, encoded stream header.
+	// 'frames' - out, encoded frames.
+	// 'frameSizes' - out, size of each encoded frame.
+	FlacChunkEncoder( std::vector<BYTE>& metadata, std::vector<BYTE>& frames, std::vector<size_t>& frameSizes ) :
+		FLAC::Encoder::Stream(),
+		m_Metadata( metadata ),
+		m_Frames( frames ),
+		m_FrameSizes( frameSizes )
+	{
+	}
+
+protected:
+	// Called by libFLAC with encoded data.
+	::FLAC__StreamEncoderWriteStatus write_callback( const FLAC__byte buffer[], size_t bytes, uint32_t samples, uint32_t /*current_frame*/ ) override
+	{
+		if ( 0 == samples ) {
+			m_Metadata.insert( m_Metadata.end(), buffer, buffer + bytes );
+		} else {
+			m_Frames.insert( m_Frames.end(), buffer, buffer + bytes );
+			m_FrameSizes.push_back( bytes );
+		}
+		return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+	}
+
+private:
+	// Encoded stream header.
+	std::vector<BYTE>& m_Metadata;
+
+	// Encoded frames.
+	std::vector<BYTE>& m_Frames;
+
+	// Encoded frame sizes.
+	std::vector<size_t>& m_FrameSizes;
+};
+
+EncoderFlac::EncoderFlac( const DitherMode ditherMode ) :
+	Encoder(),
+	m_Buffer(),
+	m_Multithreaded( false ),
+	m_MaxThreads( 0 ),
+	m_File( nullptr ),
+	m_SampleRate( 0 ),
+	m_Channels( 0 ),
+	m_BitsPerSample( 0 ),
+	m_CompressionLevel( s_DefaultCompressionLevel ),
+	m_Verify( true ),
+	m_DitherMode( ditherMode ),
+	m_Quantiser(),
+	m_BlockSize( 0 ),
+	m_ChunkSize( 0 ),
+	m_Chunks(),
+	m_SubmittedChunks( 0 ),
+	m_WrittenChunks( 0 ),
+	m_PendingChunks(),
+	m_Workers(),
+	m_Mutex(),
+	m_PendingCondition(),
+	m_EncodedCondition(),
+	m_StopWorkers( false ),
+	m_Success( true ),
+	m_StreamInfo(),
+	m_FrameCount( 0 ),
+	m_TotalSamples( 0 ),
+	m_MinFrameSize( 0 ),
+	m_MaxFrameSize( 0 ),
+	m_CryptProvider( 0 ),
+	m_MD5( 0 ),
+	m_MD5Buffer(),
+	m_FrameBuffer()
 {
 }
 
 EncoderFlac::~EncoderFlac()
 {
+	// The encoder must be finished before the base class is destroyed, as finishing calls back into this class.
+	if ( nullptr != m_File ) {
+		Close();
+	}
+}
+
+int EncoderFlac::GetCompressionLevel( const std::string& settings )
+{
+	int compressionLevel = s_DefaultCompressionLevel;
+	try {
+		compressionLevel = std::stoi( settings );
+		if ( ( compressionLevel < 0 ) || ( compressionLevel > 8 ) ) {
+			compressionLevel = s_DefaultCompressionLevel;
+		}
+	} catch ( ... ) {
+
+	}
+	return compressionLevel;
+}
+
+bool EncoderFlac::GetVerify( const std::string& settings )
+{
+	bool verify = true;
+	const size_t pos = settings.find( ',' );
+	if ( std::string::npos != pos ) {
+		try {
+			verify = ( 0 != std::stoi( settings.substr( 1 + pos ) ) );
+		} catch ( ... ) {
+
+		}
+	}
+	return verify;
 }
 
-bool EncoderFlac::Open( std::wstring& filename, const long sampleRate, const long channels, const long bitsPerSample, const std::string& /*settings*/ )
+bool EncoderFlac::GetMultithreaded( const std::string& settings )
+{
+	bool multithreaded = false;
+	const size_t pos = settings.find( ',', 1 + settings.find( ',' ) );
+	if ( std::string::npos != pos ) {
+		try {
+			multithreaded = ( 0 != std::stoi( settings.substr( 1 + pos ) ) );
+		} catch ( ... ) {
+
+		}
+	}
+	return multithreaded;
+}
+
+std::string EncoderFlac::GetSettings( const int compressionLevel, const bool verify, const bool multithreaded )
+{
+	const std::string settings = std::to_string( compressionLevel ) + "," + ( verify ? "1" : "0" ) + "," + ( multithreaded ? "1" : "0" );
+	return settings;
+}
+
+bool EncoderFlac::Open( std::wstring& filename, const long sampleRate, const long channels, const long bitsPerSample, const std::string& settings )
 {
 	bool success = false;
 	filename += L".flac";
-	FILE* f = _wfsopen( filename.c_str(), L"wb", _SH_DENYRW );;
-	if ( nullptr != f ) {
-		set_sample_rate( sampleRate );
-		set_channels( channels );
-		set_compression_level( 5 );
-		set_verify( true );
-		set_total_samples_estimate( 0 );
+	ResetWriteStatistics();
+	m_File = _wfsopen( filename.c_str(), L"wb", _SH_DENYRW );
+	if ( nullptr != m_File ) {
+		m_SampleRate = sampleRate;
+		m_Channels = channels;
+		m_CompressionLevel = GetCompressionLevel( settings );
+		m_Verify = GetVerify( settings );
 
 		switch ( bitsPerSample ) {
 			case 8 :
 			case 16 :
 			case 24 : {
-				set_bits_per_sample( bitsPerSample );
+				m_BitsPerSample = bitsPerSample;
 				break;
 			}
 			default : {
-				if ( bitsPerSample > 24 ) {
-					set_bits_per_sample( 24 );
-				} else {
-					set_bits_per_sample( 16 );
-				}
+				m_BitsPerSample = ( bitsPerSample > 24 ) ? 24 : 16;
 				break;
 			}
 		}
 
-		success = ( FLAC__STREAM_ENCODER_INIT_STATUS_OK == init( f ) );
-		if ( !success ) {
-			fclose( f );
+		m_Quantiser = Quantiser::IsRequired( m_BitsPerSample, m_DitherMode ) ? Quantiser::Ptr( new Quantiser( m_SampleRate, m_Channels, m_BitsPerSample, m_DitherMode ) ) : nullptr;
+
+		// Adaptive mid-side stereo is not frame independent, so multithreaded mode cannot be used without changing the output.
+		const long hardwareThreads = static_cast<long>( std::thread::hardware_concurrency() );
+		const long workerCount = ( m_MaxThreads > 0 ) ? (std::min)( m_MaxThreads, hardwareThreads ) : hardwareThreads;
+		m_Multithreaded = GetMultithreaded( settings ) && !IsLooseMidSide( m_CompressionLevel ) && ( workerCount > 1 ) &&
+			( FALSE != CryptAcquireContext( &m_CryptProvider, NULL /*container*/, NULL /*provider*/, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT ) );
+
+		if ( m_Multithreaded ) {
+			if ( FALSE == CryptCreateHash( m_CryptProvider, CALG_MD5, 0 /*key*/, 0 /*flags*/, &m_MD5 ) ) {
+				m_MD5 = 0;
+			}
+
+			// Use a temporary encoder to determine the block size for the compression level.
+			m_BlockSize = 0;
+			std::vector<BYTE> metadata;
+			std::vector<BYTE> frames;
+			std::vector<size_t> frameSizes;
+			FlacChunkEncoder encoder( metadata, frames, frameSizes );
+			encoder.set_sample_rate( m_SampleRate );
+			encoder.set_channels( m_Channels );
+			encoder.set_bits_per_sample( m_BitsPerSample );
+			encoder.set_compression_level( m_CompressionLevel );
+			if ( FLAC__STREAM_ENCODER_INIT_STATUS_OK == encoder.init() ) {
+				m_BlockSize = static_cast<long>( encoder.get_blocksize() );
+				encoder.finish();
+			}
+
+			success = ( 0 != m_MD5 ) && ( m_BlockSize > 0 );
+			if ( success ) {
+				m_ChunkSize = m_BlockSize * s_ChunkBlocks;
+				m_Chunks.resize( workerCount * s_ChunksPerWorker );
+				for ( auto& chunk : m_Chunks ) {
+					chunk.Samples.resize( m_ChunkSize * m_Channels );
+					chunk.SampleCount = 0;
+				}
+				m_SubmittedChunks = 0;
+				m_WrittenChunks = 0;
+				m_StopWorkers = false;
+				m_Success = true;
+				m_FrameCount = 0;
+				m_TotalSamples = 0;
+				m_MinFrameSize = ( 1u << FLAC__STREAM_METADATA_STREAMINFO_MIN_FRAME_SIZE_LEN ) - 1;
+				m_MaxFrameSize = 0;
+				for ( long worker = 0; worker < workerCount; worker++ ) {
+					m_Workers.push_back( std::thread( &EncoderFlac::WorkerHandler, this ) );
+				}
+			} else {
+				// Fall back to single threaded mode.
+				if ( 0 != m_MD5 ) {
+					CryptDestroyHash( m_MD5 );
+					m_MD5 = 0;
+				}
+				CryptReleaseContext( m_CryptProvider, 0 /*flags*/ );
+				m_CryptProvider = 0;
+				m_Multithreaded = false;
+			}
+		}
+
+		if ( !m_Multithreaded ) {
+			set_sample_rate( m_SampleRate );
+			set_channels( m_Channels );
+			set_bits_per_sample( m_BitsPerSample );
+			set_compression_level( m_CompressionLevel );
+			set_verify( m_Verify );
+			set_total_samples_estimate( 0 );
+
+			success = ( FLAC__STREAM_ENCODER_INIT_STATUS_OK == init() );
+			if ( !success ) {
+				fclose( m_File );
+				m_File = nullptr;
+			}
 		}
 	}
 	return success;
@@ -52,19 +340,256 @@ bool EncoderFlac::Open( std::wstring& filename, const long sampleRate, const lon
 
 bool EncoderFlac::Write( float* samples, const long sampleCount )
 {
-	const long channels = get_channels();
-	const long bps = get_bits_per_sample();
-	const long bufferSize = sampleCount * get_channels();
-	std::vector<FLAC__int32> buffer( bufferSize );
-	for ( long sampleIndex = 0; sampleIndex < bufferSize; sampleIndex++ ) {
-		buffer[ sampleIndex ] = static_cast<FLAC__int32>( 
-			( 16 == bps ) ? FloatTo16( samples[ sampleIndex ] ) : ( ( 24 == bps ) ? FloatTo24( samples[ sampleIndex ] ) : FloatToSigned8( samples[ sampleIndex ] ) ) );
+	bool success = false;
+	if ( m_Quantiser ) {
+		m_Quantiser->Process( samples, sampleCount );
+	}
+	if ( m_Multithreaded ) {
+		success = m_Success;
+		long samplesRemaining = sampleCount;
+		while ( success && ( samplesRemaining > 0 ) ) {
+			Chunk& chunk = m_Chunks[ m_SubmittedChunks % m_Chunks.size() ];
+			const long count = (std::min)( samplesRemaining, m_ChunkSize - chunk.SampleCount );
+			ConvertFloatTo32( samples, &chunk.Samples[ chunk.SampleCount * m_Channels ], static_cast<size_t>( count * m_Channels ), static_cast<int>( m_BitsPerSample ) );
+			chunk.SampleCount += count;
+			samples += count * m_Channels;
+			samplesRemaining -= count;
+			if ( m_ChunkSize == chunk.SampleCount ) {
+				success = SubmitChunk();
+			}
+		}
+	} else {
+		const long bps = get_bits_per_sample();
+		const long bufferSize = sampleCount * get_channels();
+		if ( m_Buffer.size() < static_cast<size_t>( bufferSize ) ) {
+			m_Buffer.resize( bufferSize );
+		}
+		ConvertFloatTo32( samples, m_Buffer.data(), static_cast<size_t>( bufferSize ), static_cast<int>( bps ) );
+		success = process_interleaved( m_Buffer.data(), sampleCount );
 	}
-	const bool success = process_interleaved( &buffer[ 0 ], sampleCount );
 	return success;
 }
 
 void EncoderFlac::Close()
 {
-	finish();
+	if ( m_Multithreaded ) {
+		// The stream header is written out with the first chunk, so an empty chunk is encoded if no samples have been written.
+		if ( ( m_Chunks[ m_SubmittedChunks % m_Chunks.size() ].SampleCount > 0 ) || ( 0 == m_SubmittedChunks ) ) {
+			SubmitChunk();
+		}
+		WriteChunks( m_SubmittedChunks );
+
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			m_StopWorkers = true;
+		}
+		m_PendingCondition.notify_all();
+		for ( auto& worker : m_Workers ) {
+			worker.join();
+		}
+		m_Workers.clear();
+		m_PendingChunks.clear();
+
+		WriteStreamInfo();
+		fclose( m_File );
+		m_File = nullptr;
+
+		CryptDestroyHash( m_MD5 );
+		m_MD5 = 0;
+		CryptReleaseContext( m_CryptProvider, 0 /*flags*/ );
+		m_CryptProvider = 0;
+
+		m_Chunks.clear();
+		m_Multithreaded = false;
+	} else if ( nullptr != m_File ) {
+		finish();
+		fclose( m_File );
+		m_File = nullptr;
+	}
+	m_Quantiser.reset();
+}
+
+void EncoderFlac::SetMaxThreads( const long maxThreads )
+{
+	m_MaxThreads = (std::max)( 0l, maxThreads );
+}
+
+::FLAC__StreamEncoderWriteStatus EncoderFlac::write_callback( const FLAC__byte buffer[], size_t bytes, uint32_t /*samples*/, uint32_t /*current_frame*/ )
+{
+	const ::FLAC__StreamEncoderWriteStatus status = WriteOutput( m_File, buffer, bytes ) ? FLAC__STREAM_ENCODER_WRITE_STATUS_OK : FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+	return status;
+}
+
+::FLAC__StreamEncoderSeekStatus EncoderFlac::seek_callback( FLAC__uint64 absolute_byte_offset )
+{
+	const ::FLAC__StreamEncoderSeekStatus status = ( 0 == _fseeki64( m_File, static_cast<long long>( absolute_byte_offset ), SEEK_SET ) ) ? FLAC__STREAM_ENCODER_SEEK_STATUS_OK : FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+	return status;
+}
+
+::FLAC__StreamEncoderTellStatus EncoderFlac::tell_callback( FLAC__uint64* absolute_byte_offset )
+{
+	::FLAC__StreamEncoderTellStatus status = FLAC__STREAM_ENCODER_TELL_STATUS_ERROR;
+	const long long position = _ftelli64( m_File );
+	if ( position >= 0 ) {
+		*absolute_byte_offset = static_cast<FLAC__uint64>( position );
+		status = FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+	}
+	return status;
+}
+
+void EncoderFlac::WorkerHandler()
+{
+	std::vector<BYTE> metadata;
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	while ( !m_StopWorkers ) {
+		if ( m_PendingChunks.empty() ) {
+			m_PendingCondition.wait( lock );
+		} else {
+			Chunk* chunk = m_PendingChunks.front();
+			m_PendingChunks.pop_front();
+			lock.unlock();
+
+			// Each chunk is encoded as a separate stream, with only the stream header from the first chunk being written out.
+			metadata.clear();
+			chunk->Frames.clear();
+			chunk->FrameSizes.clear();
+			FlacChunkEncoder encoder( metadata, chunk->Frames, chunk->FrameSizes );
+			encoder.set_sample_rate( m_SampleRate );
+			encoder.set_channels( m_Channels );
+			encoder.set_bits_per_sample( m_BitsPerSample );
+			encoder.set_compression_level( m_CompressionLevel );
+			encoder.set_verify( m_Verify );
+			encoder.set_total_samples_estimate( 0 );
+			bool success = ( FLAC__STREAM_ENCODER_INIT_STATUS_OK == encoder.init() );
+			if ( success ) {
+				success = encoder.process_interleaved( chunk->Samples.data(), chunk->SampleCount );
+				success = encoder.finish() && success;
+			}
+			chunk->Metadata.swap( metadata );
+
+			lock.lock();
+			chunk->Success = success;
+			chunk->Encoded = true;
+			m_EncodedCondition.notify_all();
+		}
+	}
+}
+
+bool EncoderFlac::SubmitChunk()
+{
+	Chunk& chunk = m_Chunks[ m_SubmittedChunks % m_Chunks.size() ];
+	UpdateMD5( chunk );
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		chunk.Encoded = false;
+		chunk.Success = false;
+		m_PendingChunks.push_back( &chunk );
+	}
+	m_PendingCondition.notify_one();
+	++m_SubmittedChunks;
+
+	// Wait for the oldest chunk to be written out, if it is needed for the next block of sample data.
+	const long long waitCount = m_SubmittedChunks + 1 - static_cast<long long>( m_Chunks.size() );
+	const bool success = WriteChunks( waitCount );
+	m_Chunks[ m_SubmittedChunks % m_Chunks.size() ].SampleCount = 0;
+	return success;
+}
+
+bool EncoderFlac::WriteChunks( const long long waitCount )
+{
+	bool writeChunk = ( m_WrittenChunks < m_SubmittedChunks );
+	while ( writeChunk ) {
+		Chunk& chunk = m_Chunks[ m_WrittenChunks % m_Chunks.size() ];
+		{
+			std::unique_lock<std::mutex> lock( m_Mutex );
+			if ( m_WrittenChunks < waitCount ) {
+				m_EncodedCondition.wait( lock, [ &chunk ] () { return chunk.Encoded; } );
+			}
+			writeChunk = chunk.Encoded;
+		}
+		if ( writeChunk ) {
+			m_Success = m_Success && chunk.Success && WriteFrames( chunk );
+			++m_WrittenChunks;
+			writeChunk = ( m_WrittenChunks < m_SubmittedChunks );
+		}
+	}
+	return m_Success;
+}
+
+bool EncoderFlac::WriteFrames( const Chunk& chunk )
+{
+	bool success = true;
+	if ( 0 == m_WrittenChunks ) {
+		// The stream marker and stream information block should be at the start of the stream header.
+		success = ( chunk.Metadata.size() >= static_cast<size_t>( s_StreamInfoOffset + s_StreamInfoSize ) ) && ( 0 == memcmp( chunk.Metadata.data(), "fLaC", 4 ) ) && ( 0 == ( chunk.Metadata[ 4 ] & 0x7f ) );
+		if ( success ) {
+			m_StreamInfo.assign( chunk.Metadata.begin() + s_StreamInfoOffset, chunk.Metadata.begin() + s_StreamInfoOffset + s_StreamInfoSize );
+			success = WriteOutput( m_File, chunk.Metadata.data(), chunk.Metadata.size() );
+		}
+	}
+
+	// Frames are numbered from zero within each chunk, so renumber them according to their position in the output stream.
+	const BYTE* frame = chunk.Frames.data();
+	for ( auto frameSize = chunk.FrameSizes.begin(); success && ( chunk.FrameSizes.end() != frameSize ); frame += *frameSize, frameSize++ ) {
+		const size_t headerSize = GetFrameHeaderSize( frame, *frameSize );
+		success = ( headerSize > 0 );
+		if ( success ) {
+			m_FrameBuffer.assign( frame, frame + 4 );
+			AppendFrameNumber( m_FrameCount, m_FrameBuffer );
+			m_FrameBuffer.insert( m_FrameBuffer.end(), frame + 4 + GetFrameNumberSize( frame ), frame + headerSize );
+			m_FrameBuffer.push_back( CalculateCRC8( m_FrameBuffer.data(), m_FrameBuffer.size() ) );
+			m_FrameBuffer.insert( m_FrameBuffer.end(), frame + headerSize + 1, frame + *frameSize - 2 );
+			const WORD crc = CalculateCRC16( m_FrameBuffer.data(), m_FrameBuffer.size() );
+			m_FrameBuffer.push_back( static_cast<BYTE>( crc >> 8 ) );
+			m_FrameBuffer.push_back( static_cast<BYTE>( crc & 0xff ) );
+
+			success = WriteOutput( m_File, m_FrameBuffer.data(), m_FrameBuffer.size() );
+			m_MinFrameSize = (std::min)( m_MinFrameSize, m_FrameBuffer.size() );
+			m_MaxFrameSize = (std::max)( m_MaxFrameSize, m_FrameBuffer.size() );
+			++m_FrameCount;
+		}
+	}
+	m_TotalSamples += chunk.SampleCount;
+	return success;
+}
+
+void EncoderFlac::WriteStreamInfo()
+{
+	if ( s_StreamInfoSize == static_cast<long>( m_StreamInfo.size() ) ) {
+		m_StreamInfo[ 4 ] = static_cast<BYTE>( m_MinFrameSize >> 16 );
+		m_StreamInfo[ 5 ] = static_cast<BYTE>( m_MinFrameSize >> 8 );
+		m_StreamInfo[ 6 ] = static_cast<BYTE>( m_MinFrameSize );
+		m_StreamInfo[ 7 ] = static_cast<BYTE>( m_MaxFrameSize >> 16 );
+		m_StreamInfo[ 8 ] = static_cast<BYTE>( m_MaxFrameSize >> 8 );
+		m_StreamInfo[ 9 ] = static_cast<BYTE>( m_MaxFrameSize );
+		m_StreamInfo[ 13 ] = static_cast<BYTE>( ( m_StreamInfo[ 13 ] & 0xf0 ) | ( ( m_TotalSamples >> 32 ) & 0x0f ) );
+		m_StreamInfo[ 14 ] = static_cast<BYTE>( m_TotalSamples >> 24 );
+		m_StreamInfo[ 15 ] = static_cast<BYTE>( m_TotalSamples >> 16 );
+		m_StreamInfo[ 16 ] = static_cast<BYTE>( m_TotalSamples >> 8 );
+		m_StreamInfo[ 17 ] = static_cast<BYTE>( m_TotalSamples );
+		DWORD md5Size = 16;
+		CryptGetHashParam( m_MD5, HP_HASHVAL, &m_StreamInfo[ 18 ], &md5Size, 0 /*flags*/ );
+
+		if ( 0 == fseek( m_File, s_StreamInfoOffset, SEEK_SET ) ) {
+			WriteOutput( m_File, m_StreamInfo.data(), m_StreamInfo.size() );
+		}
+	}
+}
+
+void EncoderFlac::UpdateMD5( const Chunk& chunk )
+{
+	// The signature is calculated from the samples as little endian values, using the minimum number of bytes for the bit depth.
+	const long bytesPerSample = ( m_BitsPerSample + 7 ) / 8;
+	const long sampleCount = chunk.SampleCount * m_Channels;
+	m_MD5Buffer.resize( sampleCount * bytesPerSample );
+	BYTE* output = m_MD5Buffer.data();
+	for ( long index = 0; index < sampleCount; index++ ) {
+		const FLAC__int32 sample = chunk.Samples[ index ];
+		for ( long byte = 0; byte < bytesPerSample; byte++ ) {
+			*output++ = static_cast<BYTE>( sample >> ( 8 * byte ) );
+		}
+	}
+	if ( !m_MD5Buffer.empty() ) {
+		CryptHashData( m_MD5, m_MD5Buffer.data(), static_cast<DWORD>( m_MD5Buffer.size() ), 0 /*flags*/ );
+	}
 }
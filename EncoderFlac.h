@@ -1,17 +1,43 @@
 #pragma once
 
+#include "stdafx.h"
+
 #include "Encoder.h"
+#include "Quantiser.h"
 
 #include "FLAC++/all.h"
 
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 // FLAC encoder
-class EncoderFlac : public Encoder, public FLAC::Encoder::File
+// In multithreaded mode, the sample data is split into chunks of whole blocks, which are encoded independently on a pool of worker threads.
+// The encoded frames are then renumbered and written out in order, with the stream information updated on closing,
+// so that the output is identical to that of a single threaded encoder.
+// In single threaded mode, libFLAC passes the encoded data back to the encoder, so that all output goes through the write statistics.
+class EncoderFlac : public Encoder, public FLAC::Encoder::Stream
 {
 public:
-	EncoderFlac();
+	// 'ditherMode' - dither mode, used when reducing the sample data to the output resolution.
+	EncoderFlac( const DitherMode ditherMode );
 
 	virtual ~EncoderFlac();
 
+	// Returns the compression level from the encoder 'settings'.
+	static int GetCompressionLevel( const std::string& settings );
+
+	// Returns whether to verify the encoded output, from the encoder 'settings'.
+	static bool GetVerify( const std::string& settings );
+
+	// Returns whether to encode using multiple threads, from the encoder 'settings'.
+	static bool GetMultithreaded( const std::string& settings );
+
+	// Returns the encoder settings for a 'compressionLevel', whether to 'verify' the encoded output, and whether to encode using 'multithreaded' mode.
+	static std::string GetSettings( const int compressionLevel, const bool verify, const bool multithreaded );
+
 	// Opens the encoder.
 	// 'filename' - (in) output file name without file extension, (out) output file name with file extension.
 	// 'sampleRate' - sample rate.
@@ -29,4 +55,146 @@ public:
 
 	// Closes the encoder.
 	void Close() override;
+
+	// Limits the size of the worker thread pool used in multithreaded mode to 'maxThreads', or removes the limit if 'maxThreads' is zero.
+	// Multithreaded mode is not used when the limit is a single thread.
+	void SetMaxThreads( const long maxThreads ) override;
+
+protected:
+	// Called by libFLAC with encoded data, in single threaded mode.
+	::FLAC__StreamEncoderWriteStatus write_callback( const FLAC__byte buffer[], size_t bytes, uint32_t samples, uint32_t current_frame ) override;
+
+	// Called by libFLAC to seek to an 'absolute_byte_offset' in the output file, in single threaded mode.
+	::FLAC__StreamEncoderSeekStatus seek_callback( FLAC__uint64 absolute_byte_offset ) override;
+
+	// Called by libFLAC to get the current position in the output file, in single threaded mode.
+	::FLAC__StreamEncoderTellStatus tell_callback( FLAC__uint64* absolute_byte_offset ) override;
+
+private:
+	// A chunk of sample data, encoded on a worker thread.
+	struct Chunk {
+		std::vector<FLAC__int32> Samples;		// Interleaved sample data.
+		long SampleCount;										// Number of samples in the chunk.
+		std::vector<BYTE> Metadata;					// Encoded stream header.
+		std::vector<BYTE> Frames;						// Encoded frames.
+		std::vector<size_t> FrameSizes;			// Size of each encoded frame, in bytes.
+		bool Encoded;												// Whether the chunk has been encoded.
+		bool Success;												// Whether the chunk was encoded successfully.
+	};
+
+	// Worker thread handler, which encodes pending chunks.
+	void WorkerHandler();
+
+	// Passes the current chunk to the worker threads, then waits (if necessary) until the next chunk is available to be filled.
+	// Returns whether all chunks have so far been encoded and written successfully.
+	bool SubmitChunk();
+
+	// Writes out encoded chunks in order, returning whether they were written successfully.
+	// 'waitCount' - the number of chunks which must have been written out before returning.
+	bool WriteChunks( const long long waitCount );
+
+	// Writes out the frames of an encoded 'chunk', returning whether the frames were written successfully.
+	bool WriteFrames( const Chunk& chunk );
+
+	// Rewrites the stream information at the start of the output file.
+	void WriteStreamInfo();
+
+	// Adds the samples in 'chunk' to the MD5 signature of the unencoded audio data.
+	void UpdateMD5( const Chunk& chunk );
+
+	// Buffer holding converted sample data in single threaded mode.
+	std::vector<FLAC__int32> m_Buffer;
+
+	// Whether multithreaded mode is in use.
+	bool m_Multithreaded;
+
+	// Maximum number of worker threads, or zero for no limit.
+	long m_MaxThreads;
+
+	// Output file.
+	FILE* m_File;
+
+	// Sample rate.
+	long m_SampleRate;
+
+	// Channel count.
+	long m_Channels;
+
+	// Bits per sample.
+	long m_BitsPerSample;
+
+	// Compression level.
+	int m_CompressionLevel;
+
+	// Whether to verify the encoded output.
+	bool m_Verify;
+
+	// Dither mode.
+	const DitherMode m_DitherMode;
+
+	// Quantiser, or null if no dither is applied.
+	Quantiser::Ptr m_Quantiser;
+
+	// Block size, in samples.
+	long m_BlockSize;
+
+	// Chunk size, in samples.
+	long m_ChunkSize;
+
+	// Chunk pool.
+	std::vector<Chunk> m_Chunks;
+
+	// Number of chunks passed to the worker threads.
+	long long m_SubmittedChunks;
+
+	// Number of chunks written out.
+	long long m_WrittenChunks;
+
+	// Chunks waiting to be encoded.
+	std::list<Chunk*> m_PendingChunks;
+
+	// Worker threads.
+	std::list<std::thread> m_Workers;
+
+	// Mutex protecting the pending chunks and chunk encoded state.
+	std::mutex m_Mutex;
+
+	// Signalled when chunks are pending, or the worker threads should stop.
+	std::condition_variable m_PendingCondition;
+
+	// Signalled when a chunk has been encoded.
+	std::condition_variable m_EncodedCondition;
+
+	// Indicates that the worker threads should stop.
+	bool m_StopWorkers;
+
+	// Whether all chunks have so far been encoded and written successfully.
+	bool m_Success;
+
+	// Stream information block from the start of the output file.
+	std::vector<BYTE> m_StreamInfo;
+
+	// Number of frames written out.
+	long long m_FrameCount;
+
+	// Total number of samples written out.
+	long long m_TotalSamples;
+
+	// Minimum encoded frame size, in bytes.
+	size_t m_MinFrameSize;
+
+	// Maximum encoded frame size, in bytes.
+	size_t m_MaxFrameSize;
+
+	// Cryptographic service provider, for calculating the MD5 signature.
+	HCRYPTPROV m_CryptProvider;
+
+	// MD5 signature of the unencoded audio data.
+	HCRYPTHASH m_MD5;
+
+	// MD5 buffer, holding the samples of a chunk as little endian bytes.
+	std::vector<BYTE> m_MD5Buffer;
+
+	// Buffer for a renumbered frame.
+	std::vector<BYTE> m_FrameBuffer;
 };
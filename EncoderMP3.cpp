@@ -1,6 +1,13 @@
 #include "EncoderMP3.h"
 
-#include <vector>
+// Minimum output buffer size, in bytes.
+static const size_t s_MinBufferSize = 7200;
+
+// Returns the worst case output buffer size, in bytes, for encoding 'sampleCount' samples.
+static size_t GetBufferSize( const long sampleCount )
+{
+	return s_MinBufferSize + static_cast<size_t>( sampleCount ) * 5 / 4;
+}
 
 void null_report_function( const char* /*format*/, va_list /*ap*/ )
 {
@@ -10,7 +17,8 @@ void null_report_function( const char* /*format*/, va_list /*ap*/ )
 EncoderMP3::EncoderMP3() :
 	Encoder(),
 	m_flags( nullptr ),
-	m_file( nullptr )
+	m_file( nullptr ),
+	m_Buffer()
 {
 }
 
@@ -33,14 +41,19 @@ bool EncoderMP3::Open( std::wstring& filename, const long sampleRate, const long
 
 		lame_set_bWriteVbrTag( m_flags, 1 );
 
-		success = ( 0 == lame_set_num_channels( m_flags, static_cast<int>( channels ) ) );
+		success = ( 0 == lame_set_num_channels( m_flags, static_cast<int>( channels ) ) ) &&
 			( 0 == lame_set_in_samplerate( m_flags, static_cast<int>( sampleRate ) ) ) &&
 			( 0 == lame_init_params( m_flags ) );
 
 		if ( success ) {
 			filename += L".mp3";
+			ResetWriteStatistics();
 			m_file = _wfsopen( filename.c_str(), L"w+b", _SH_DENYRW );
 			success = ( nullptr != m_file );
+			if ( !success ) {
+				lame_close( m_flags );
+				m_flags = nullptr;
+			}
 		} else {
 			lame_close( m_flags );
 			m_flags = nullptr;
@@ -51,24 +64,38 @@ bool EncoderMP3::Open( std::wstring& filename, const long sampleRate, const long
 
 bool EncoderMP3::Write( float* samples, const long sampleCount )
 {
-	const int outputBufferSize = sampleCount * 2;
-	std::vector<unsigned char> outputBuffer( outputBufferSize );
-	const int bytesEncoded = lame_encode_buffer_interleaved_ieee_float( m_flags, samples, sampleCount, &outputBuffer[ 0 ], outputBufferSize );
-	const bool success = ( bytesEncoded > 0 ) && ( nullptr != m_file ) && ( static_cast<size_t>( bytesEncoded ) == fwrite( &outputBuffer[ 0 ], 1 /*elementSize*/, bytesEncoded, m_file ) );
+	const size_t bufferSize = GetBufferSize( sampleCount );
+	if ( m_Buffer.size() < bufferSize ) {
+		m_Buffer.resize( bufferSize );
+	}
+	// LAME buffers sample data internally, so no output is not an error.
+	const int bytesEncoded = lame_encode_buffer_interleaved_ieee_float( m_flags, samples, sampleCount, m_Buffer.data(), static_cast<int>( m_Buffer.size() ) );
+	const bool success = ( bytesEncoded >= 0 ) && ( nullptr != m_file ) && WriteOutput( m_file, m_Buffer.data(), static_cast<size_t>( bytesEncoded ) );
 	return success;
 }
 
 void EncoderMP3::Close()
 {
 	if ( nullptr != m_flags ) {
-		const int outputBufferSize = 65536;
-		std::vector<unsigned char> outputBuffer( outputBufferSize );
-		const int bytesEncoded = lame_encode_flush( m_flags, &outputBuffer[ 0 ], outputBufferSize );
+		if ( m_Buffer.size() < s_MinBufferSize ) {
+			m_Buffer.resize( s_MinBufferSize );
+		}
+		const int bytesEncoded = lame_encode_flush( m_flags, m_Buffer.data(), static_cast<int>( m_Buffer.size() ) );
 		if ( ( bytesEncoded > 0 ) && ( nullptr != m_file ) ) {
-			fwrite( &outputBuffer[ 0 ], 1 /*elementSize*/, bytesEncoded, m_file );
+			WriteOutput( m_file, m_Buffer.data(), static_cast<size_t>( bytesEncoded ) );
 		}
 
-		lame_mp3_tags_fid( m_flags, m_file );
+		// Replace the placeholder frame at the start of the file with the final LAME tag, which holds the encoder delay & padding (in samples) for gapless decoding.
+		if ( nullptr != m_file ) {
+			size_t tagSize = lame_get_lametag_frame( m_flags, m_Buffer.data(), m_Buffer.size() );
+			if ( tagSize > m_Buffer.size() ) {
+				m_Buffer.resize( tagSize );
+				tagSize = lame_get_lametag_frame( m_flags, m_Buffer.data(), m_Buffer.size() );
+			}
+			if ( ( tagSize > 0 ) && ( tagSize <= m_Buffer.size() ) && ( 0 == fseek( m_file, 0, SEEK_SET ) ) ) {
+				WriteOutput( m_file, m_Buffer.data(), tagSize );
+			}
+		}
 
 		lame_close( m_flags );
 		m_flags = nullptr;
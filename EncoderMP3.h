@@ -4,7 +4,10 @@
 
 #include "lame.h"
 
+#include <vector>
+
 // LAME MP3 encoder
+// A LAME tag is written at the start of the output file on closing, holding the encoder delay and padding, so that the output can be decoded gaplessly.
 class EncoderMP3 : public Encoder
 {
 public:
@@ -39,4 +42,7 @@ private:
 
 	// Output file.
 	FILE* m_file;
+
+	// Output buffer.
+	std::vector<unsigned char> m_Buffer;
 };
@@ -1,8 +1,5 @@
 #include "EncoderOpus.h"
 
-#include "Handler.h"
-#include "Utility.h"
-
 #include <vector>
 
 // Minimum/maximum/default bit rates.
@@ -14,7 +11,8 @@ EncoderOpus::EncoderOpus() :
 	Encoder(),
 	m_Channels( 0 ),
 	m_OpusEncoder( nullptr ),
-	m_Callbacks( {} )
+	m_Callbacks( {} ),
+	m_File( nullptr )
 {
 }
 
@@ -24,18 +22,19 @@ EncoderOpus::~EncoderOpus()
 
 int EncoderOpus::WriteCallback( void *user_data, const unsigned char *ptr, opus_int32 len )
 {
-	FILE* f = reinterpret_cast<FILE*>( user_data );
-	if ( ( nullptr != f ) && ( nullptr != ptr ) && ( len > 0 ) ) {
-		fwrite( ptr, 1, len, f );
+	EncoderOpus* encoder = reinterpret_cast<EncoderOpus*>( user_data );
+	if ( ( nullptr != encoder ) && ( nullptr != encoder->m_File ) && ( nullptr != ptr ) && ( len > 0 ) ) {
+		encoder->WriteOutput( encoder->m_File, ptr, static_cast<size_t>( len ) );
 	}
 	return 0;
 }
 
 int EncoderOpus::CloseCallback( void *user_data )
 {
-	FILE* f = reinterpret_cast<FILE*>( user_data );
-	if ( nullptr != f ) {
-		fclose( f );
+	EncoderOpus* encoder = reinterpret_cast<EncoderOpus*>( user_data );
+	if ( ( nullptr != encoder ) && ( nullptr != encoder->m_File ) ) {
+		fclose( encoder->m_File );
+		encoder->m_File = nullptr;
 	}
 	return 0;
 }
@@ -48,15 +47,19 @@ bool EncoderOpus::Open( std::wstring& filename, const long sampleRate, const lon
 	if ( nullptr != opusComments ) {
 		filename += L".opus";
 
-		FILE* f = _wfsopen( filename.c_str(), L"wb", _SH_DENYRW );
-		if ( nullptr != f ) {
+		ResetWriteStatistics();
+		m_File = _wfsopen( filename.c_str(), L"wb", _SH_DENYRW );
+		if ( nullptr != m_File ) {
 			m_Callbacks.write = WriteCallback;
 			m_Callbacks.close = CloseCallback;
 
-			m_OpusEncoder = ope_encoder_create_callbacks( &m_Callbacks, f /*userData*/, opusComments, sampleRate, channels, 0 /*family*/, nullptr /*error*/ );
+			m_OpusEncoder = ope_encoder_create_callbacks( &m_Callbacks, this /*userData*/, opusComments, sampleRate, channels, 0 /*family*/, nullptr /*error*/ );
 			if ( nullptr != m_OpusEncoder ) {
 				const int bitrate = 1000 * GetBitrate( settings );
 				ope_encoder_ctl( m_OpusEncoder, OPUS_SET_BITRATE( bitrate ) );
+			} else {
+				fclose( m_File );
+				m_File = nullptr;
 			}
 		}
 		ope_comments_destroy( opusComments );
@@ -151,6 +154,7 @@ void EncoderOpus::Close()
 	if ( nullptr != m_OpusEncoder ) {
 		ope_encoder_drain( m_OpusEncoder );
 		ope_encoder_destroy( m_OpusEncoder );
+		m_OpusEncoder = nullptr;
 	}
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "stdafx.h"
+
 #include "Encoder.h"
 
 #include "opusenc.h"
@@ -60,4 +62,7 @@ private:
 
 	// Opus encoder callbacks.
 	OpusEncCallbacks m_Callbacks;
+
+	// Output file.
+	FILE* m_File;
 };
@@ -1,18 +1,27 @@
 #include "EncoderPCM.h"
 
-#include "Utility.h"
+#include "SampleConversion.h"
 
+#ifdef _WIN32
 #include <mmreg.h>
+#endif
 
-#include <vector>
+// Write buffer size, in bytes.
+static const size_t s_BufferSize = 0x400000;
 
-// Maximum number of bytes that can be written.
+// Maximum number of bytes that can be represented by the 32-bit RIFF chunk sizes.
 static const long long s_MaxBytes = UINT_MAX;
 
-EncoderPCM::EncoderPCM() :
+EncoderPCM::EncoderPCM( const DitherMode ditherMode ) :
 	Encoder(),
 	m_header( {} ),
-	m_file( nullptr )
+	m_file( nullptr ),
+	m_Format( Format::Signed16 ),
+	m_DitherMode( ditherMode ),
+	m_Quantiser(),
+	m_Buffer(),
+	m_BufferPosition( 0 ),
+	m_DataBytes( 0 )
 {
 }
 
@@ -20,28 +29,107 @@ EncoderPCM::~EncoderPCM()
 {
 }
 
-bool EncoderPCM::Open( std::wstring& filename, const long sampleRate, const long channels, const long bitsPerSample, const std::string& /*settings*/ )
+EncoderPCM::Format EncoderPCM::GetFormat( const std::string& settings )
+{
+	Format format = Format::Source;
+	try {
+		const int value = std::stoi( settings );
+		if ( ( value >= static_cast<int>( Format::Source ) ) && ( value <= static_cast<int>( Format::Float32 ) ) ) {
+			format = static_cast<Format>( value );
+		}
+	} catch ( ... ) {
+
+	}
+	return format;
+}
+
+std::string EncoderPCM::GetSettings( const Format format )
+{
+	const std::string settings = std::to_string( static_cast<int>( format ) );
+	return settings;
+}
+
+bool EncoderPCM::Open( std::wstring& filename, const long sampleRate, const long channels, const long bitsPerSample, const std::string& settings )
 {
 	bool success = false;
 	if ( ( 1 == channels ) || ( 2 == channels ) ) {
-		memcpy( m_header.hdrRIFF, "RIFF" ,4 );
+		m_Format = GetFormat( settings );
+		if ( Format::Source == m_Format ) {
+			switch ( bitsPerSample ) {
+				case 8 : {
+					m_Format = Format::Unsigned8;
+					break;
+				}
+				case 24 : {
+					m_Format = Format::Signed24;
+					break;
+				}
+				case 32 : {
+					m_Format = Format::Float32;
+					break;
+				}
+				default : {
+					m_Format = Format::Signed16;
+					break;
+				}
+			}
+		}
+
+		WORD outputBits = 16;
+		switch ( m_Format ) {
+			case Format::Unsigned8 : {
+				outputBits = 8;
+				break;
+			}
+			case Format::Signed24 : {
+				outputBits = 24;
+				break;
+			}
+			case Format::Signed32 :
+			case Format::Float32 : {
+				outputBits = 32;
+				break;
+			}
+			default : {
+				break;
+			}
+		}
+
+		// The reserved chunk is large enough to hold a 'ds64' chunk (with an empty table), should the file need to be promoted to RF64.
+		m_header = {};
+		memcpy( m_header.hdrRIFF, "RIFF", 4 );
+		memcpy( m_header.hdrWAVE, "WAVE", 4 );
+		memcpy( m_header.hdrDS64, "JUNK", 4 );
 		memcpy( m_header.hdrFMT, "fmt ", 4 );
+		memcpy( m_header.hdrFACT, "fact", 4 );
 		memcpy( m_header.hdrDATA, "data", 4 );
-		memcpy( m_header.hdrWAVE, "WAVE", 4 );
-		m_header.nFmtLength = 16;
+		m_header.nDS64Length = 28;
+		m_header.nFmtLength = 18;
+		m_header.nFactLength = 4;
 
-		m_header.wFormatTag = WAVE_FORMAT_PCM;
+		m_header.wFormatTag = ( Format::Float32 == m_Format ) ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
 		m_header.nChannels = static_cast<WORD>( channels );
 		m_header.nSamplesPerSec = static_cast<DWORD>( sampleRate );
-		m_header.wBitsPerSample = ( 8 == bitsPerSample ) ? 8 : 16;
+		m_header.wBitsPerSample = outputBits;
 		m_header.nBlockAlign = m_header.nChannels * m_header.wBitsPerSample / 8;
 		m_header.nAvgBytesPerSec = m_header.nSamplesPerSec * m_header.nBlockAlign;
 		filename += L".wav";
 
+		// Hold a whole number of sample frames in the write buffer.
+		m_Buffer.resize( s_BufferSize - ( s_BufferSize % m_header.nBlockAlign ) );
+		m_BufferPosition = 0;
+		m_DataBytes = 0;
+
+		// 32-bit integer output has more resolution than the floating point sample data, so only lower resolution formats are dithered.
+		const bool dither = ( Format::Signed32 != m_Format ) && ( Format::Float32 != m_Format ) && Quantiser::IsRequired( outputBits, m_DitherMode );
+		m_Quantiser = dither ? Quantiser::Ptr( new Quantiser( sampleRate, channels, outputBits, m_DitherMode ) ) : nullptr;
+
+		ResetWriteStatistics();
 		m_file = _wfsopen( filename.c_str(), L"wb", _SH_DENYRW );
 		if ( nullptr != m_file ) {
-			const int headerSize = sizeof( WaveFileHeader );
-			success = ( 1 == fwrite( &m_header, sizeof( WaveFileHeader ), 1, m_file ) );
+			// Sample data is buffered by the encoder, so the file stream does not need its own buffer.
+			setvbuf( m_file, nullptr, _IONBF, 0 );
+			success = WriteOutput( m_file, &m_header, sizeof( WaveFileHeader ) );
 			if ( !success ) {
 				fclose( m_file );
 				m_file = nullptr;
@@ -53,44 +141,59 @@ bool EncoderPCM::Open( std::wstring& filename, const long sampleRate, const long
 
 bool EncoderPCM::Write( float* samples, const long sampleCount )
 {
-	bool success = false;
-	const long outputBufferSize = m_header.nChannels * sampleCount;
-	const long long filePosition = _ftelli64( m_file );
-	if ( 8 == m_header.wBitsPerSample ) {
-		std::vector<unsigned char> outputBuffer( outputBufferSize );
-		for ( long sampleIndex = 0; sampleIndex < outputBufferSize; sampleIndex++ ) {
-			outputBuffer[ sampleIndex ] = FloatToUnsigned8( samples[ sampleIndex ] );
-		}
-
-		size_t elementCount = static_cast<size_t>( outputBufferSize );
-		if ( ( filePosition + outputBufferSize ) > s_MaxBytes ) {
-			if ( filePosition < s_MaxBytes ) {
-				elementCount = static_cast<size_t>( s_MaxBytes - filePosition );
-				elementCount -= ( elementCount % m_header.nBlockAlign );
-			} else {
-				elementCount = 0;
+	bool success = ( nullptr != m_file );
+	if ( success && m_Quantiser ) {
+		m_Quantiser->Process( samples, sampleCount );
+	}
+	const size_t channels = static_cast<size_t>( m_header.nChannels );
+	const size_t blockAlign = static_cast<size_t>( m_header.nBlockAlign );
+	size_t samplesRemaining = static_cast<size_t>( sampleCount );
+	while ( success && ( samplesRemaining > 0 ) ) {
+		const size_t samplesToConvert = ( std::min )( samplesRemaining, ( m_Buffer.size() - m_BufferPosition ) / blockAlign );
+		const size_t count = samplesToConvert * channels;
+		BYTE* output = m_Buffer.data() + m_BufferPosition;
+		switch ( m_Format ) {
+			case Format::Unsigned8 : {
+				ConvertFloatToUnsigned8( samples, output, count );
+				break;
 			}
-		}
-
-		success = ( static_cast<size_t>( outputBufferSize ) == fwrite( &outputBuffer[ 0 ], 1 /*elementSize*/, elementCount, m_file ) );
-	} else if ( 16 == m_header.wBitsPerSample ) {
-		std::vector<short> outputBuffer( outputBufferSize );
-		for ( long sampleIndex = 0; sampleIndex < outputBufferSize; sampleIndex++ ) {
-			outputBuffer[ sampleIndex ] = FloatTo16( samples[ sampleIndex ] );
-		}
-
-		size_t elementCount = static_cast<size_t>( outputBufferSize );
-		if ( ( filePosition + ( outputBufferSize * 2 ) ) > s_MaxBytes ) {
-			if ( filePosition < s_MaxBytes ) {
-				elementCount = static_cast<size_t>( s_MaxBytes - filePosition );
-				elementCount -= ( elementCount % m_header.nBlockAlign );
-				elementCount /= 2;
-			} else {
-				elementCount = 0;
+			case Format::Signed16 : {
+				ConvertFloatTo16( samples, reinterpret_cast<int16_t*>( output ), count );
+				break;
+			}
+			case Format::Signed24 : {
+				ConvertFloatToPacked24( samples, output, count );
+				break;
+			}
+			case Format::Signed32 : {
+				ConvertFloatTo32( samples, reinterpret_cast<int32_t*>( output ), count, 32 );
+				break;
 			}
+			case Format::Float32 : {
+				memcpy( output, samples, count * sizeof( float ) );
+				break;
+			}
+			default : {
+				break;
+			}
+		}
+		samples += count;
+		samplesRemaining -= samplesToConvert;
+		m_BufferPosition += samplesToConvert * blockAlign;
+		if ( m_BufferPosition == m_Buffer.size() ) {
+			success = Flush();
 		}
+	}
+	return success;
+}
 
-		success = ( static_cast<size_t>( outputBufferSize ) == fwrite( &outputBuffer[ 0 ], 2 /*elementSize*/, elementCount, m_file ) );
+bool EncoderPCM::Flush()
+{
+	bool success = true;
+	if ( m_BufferPosition > 0 ) {
+		success = WriteOutput( m_file, m_Buffer.data(), m_BufferPosition );
+		m_DataBytes += static_cast<long long>( m_BufferPosition );
+		m_BufferPosition = 0;
 	}
 	return success;
 }
@@ -98,15 +201,39 @@ bool EncoderPCM::Write( float* samples, const long sampleCount )
 void EncoderPCM::Close()
 {
 	if ( nullptr != m_file ) {
-		const long long bytesWritten = _ftelli64( m_file );
-		m_header.dwTotalLength = static_cast<DWORD>( bytesWritten - 8 );
-		m_header.nDataLength = static_cast<DWORD>( bytesWritten - sizeof( WaveFileHeader ) );
+		Flush();
+
+		// Pad the data chunk to an even length.
+		long long riffSize = static_cast<long long>( sizeof( WaveFileHeader ) ) - 8 + m_DataBytes;
+		if ( 0 != ( m_DataBytes % 2 ) ) {
+			const BYTE padding = 0;
+			WriteOutput( m_file, &padding, 1 );
+			++riffSize;
+		}
+
+		const long long sampleCount = m_DataBytes / m_header.nBlockAlign;
+		if ( riffSize > s_MaxBytes ) {
+			// Promote to RF64, with the chunk sizes held in the 'ds64' chunk.
+			memcpy( m_header.hdrRIFF, "RF64", 4 );
+			memcpy( m_header.hdrDS64, "ds64", 4 );
+			m_header.dwTotalLength = UINT_MAX;
+			m_header.qwRIFFSize = static_cast<ULONGLONG>( riffSize );
+			m_header.qwDataSize = static_cast<ULONGLONG>( m_DataBytes );
+			m_header.qwSampleCount = static_cast<ULONGLONG>( sampleCount );
+			m_header.dwSampleLength = UINT_MAX;
+			m_header.nDataLength = UINT_MAX;
+		} else {
+			m_header.dwTotalLength = static_cast<DWORD>( riffSize );
+			m_header.dwSampleLength = static_cast<DWORD>( sampleCount );
+			m_header.nDataLength = static_cast<DWORD>( m_DataBytes );
+		}
 
 		if ( 0 == fseek( m_file, 0, SEEK_SET ) ) {
-			fwrite( &m_header, sizeof( WaveFileHeader ), 1, m_file );
+			WriteOutput( m_file, &m_header, sizeof( WaveFileHeader ) );
 		}
 
 		fclose( m_file );
 		m_file = nullptr;
 	}
+	m_Quantiser.reset();
 }
@@ -3,15 +3,37 @@
 #include "stdafx.h"
 
 #include "Encoder.h"
+#include "Quantiser.h"
+
+#include <vector>
 
 // PCM encoder
+// Sample data is converted into a large write buffer, which is written out whenever it fills.
+// The file starts with a reserved chunk, which is replaced by a 'ds64' chunk on closing if the output is promoted to RF64 (once the data exceeds 4GB).
 class EncoderPCM : public Encoder
 {
 public:
-	EncoderPCM();
+	// 'ditherMode' - dither mode, used when writing integer sample data of 24-bit resolution or lower.
+	EncoderPCM( const DitherMode ditherMode );
 
 	virtual ~EncoderPCM();
 
+	// Output sample format.
+	enum class Format {
+		Source,					// Match the bit depth of the source (16-bit if not applicable).
+		Unsigned8,			// 8-bit unsigned integer.
+		Signed16,				// 16-bit signed integer.
+		Signed24,				// 24-bit signed integer.
+		Signed32,				// 32-bit signed integer.
+		Float32					// 32-bit floating point.
+	};
+
+	// Returns the output sample format from the encoder 'settings'.
+	static Format GetFormat( const std::string& settings );
+
+	// Returns the encoder settings for an output sample 'format'.
+	static std::string GetSettings( const Format format );
+
 	// Opens the encoder.
 	// 'filename' - (in) output file name without file extension, (out) output file name with file extension.
 	// 'sampleRate' - sample rate.
@@ -31,27 +53,60 @@ public:
 	void Close() override;
 
 private:
+#pragma pack( push, 1 )
 	// RIFF header.
-	struct WaveFileHeader 
+	struct WaveFileHeader
 	{
 		BYTE hdrRIFF[ 4 ];
 		DWORD dwTotalLength;
 		BYTE hdrWAVE[ 4 ];
+		BYTE hdrDS64[ 4 ];
+		DWORD nDS64Length;
+		ULONGLONG qwRIFFSize;
+		ULONGLONG qwDataSize;
+		ULONGLONG qwSampleCount;
+		DWORD dwTableLength;
 		BYTE hdrFMT[ 4 ];
 		DWORD nFmtLength;
-		WORD wFormatTag; 
-		WORD nChannels; 
-		DWORD nSamplesPerSec; 
-		DWORD nAvgBytesPerSec; 
-		WORD nBlockAlign; 
+		WORD wFormatTag;
+		WORD nChannels;
+		DWORD nSamplesPerSec;
+		DWORD nAvgBytesPerSec;
+		WORD nBlockAlign;
 		WORD wBitsPerSample;
+		WORD cbSize;
+		BYTE hdrFACT[ 4 ];
+		DWORD nFactLength;
+		DWORD dwSampleLength;
 		BYTE hdrDATA[ 4 ];
 		DWORD nDataLength;
 	};
+#pragma pack( pop )
+
+	// Writes out the contents of the write buffer, returning whether the data was written successfully.
+	bool Flush();
 
 	// Wave file header.
 	WaveFileHeader m_header;
 
 	// Output file.
 	FILE* m_file;
+
+	// Output sample format.
+	Format m_Format;
+
+	// Dither mode.
+	const DitherMode m_DitherMode;
+
+	// Quantiser, or null if the output sample format does not require dither.
+	Quantiser::Ptr m_Quantiser;
+
+	// Write buffer.
+	std::vector<BYTE> m_Buffer;
+
+	// Number of bytes held in the write buffer.
+	size_t m_BufferPosition;
+
+	// Total number of sample data bytes written.
+	long long m_DataBytes;
 };
@@ -0,0 +1,179 @@
+#include "Equaliser.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Number of samples processed between gain updates.
+static const long s_BlockSize = 32;
+
+// Fraction of the remaining gain difference applied at each gain update.
+static const float s_GainSmoothing = 0.05f;
+
+// Gain difference, in dB, below which the target gain is applied directly.
+static const float s_GainThreshold = 0.001f;
+
+// Maximum centre frequency, as a fraction of the sample rate.
+static const float s_MaxFrequency = 0.45f;
+
+Equaliser::Equaliser( const long sampleRate, const long channels ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_ChannelGroups( ( channels + 3 ) / 4 ),
+	m_Bands(),
+	m_Bandwidth( 0 ),
+	m_State(),
+	m_PendingEQ()
+{
+}
+
+Equaliser::~Equaliser()
+{
+}
+
+long Equaliser::GetChannels() const
+{
+	return m_Channels;
+}
+
+void Equaliser::SetEQ( const Settings::EQ& eq )
+{
+	m_PendingEQ.Set( eq );
+}
+
+void Equaliser::UpdateSettings()
+{
+	Settings::EQ eq;
+	if ( m_PendingEQ.Get( eq ) ) {
+		bool bandsChanged = ( eq.Gains.size() != m_Bands.size() );
+		if ( !bandsChanged ) {
+			auto band = m_Bands.begin();
+			for ( const auto& gain : eq.Gains ) {
+				if ( static_cast<float>( gain.first ) != band->Frequency ) {
+					bandsChanged = true;
+					break;
+				}
+				++band;
+			}
+		}
+
+		const bool bandwidthChanged = ( eq.Bandwidth != m_Bandwidth );
+		m_Bandwidth = eq.Bandwidth;
+
+		if ( bandsChanged ) {
+			m_Bands.clear();
+			for ( const auto& gain : eq.Gains ) {
+				m_Bands.push_back( { static_cast<float>( gain.first ), 0 /*gain*/, 0 /*targetGain*/, 1 /*b0*/, 0 /*b1*/, 0 /*b2*/, 0 /*a1*/, 0 /*a2*/ } );
+			}
+			m_State.assign( m_Bands.size() * m_ChannelGroups * 8, 0.0f );
+		}
+
+		// Gain changes are smoothed, except for the initial settings.
+		auto band = m_Bands.begin();
+		for ( const auto& gain : eq.Gains ) {
+			band->TargetGain = eq.Enabled ? gain.second : 0;
+			if ( bandsChanged ) {
+				band->Gain = band->TargetGain;
+			}
+			if ( bandsChanged || bandwidthChanged ) {
+				CalculateCoefficients( *band );
+			}
+			++band;
+		}
+	}
+}
+
+void Equaliser::CalculateCoefficients( Band& band ) const
+{
+	// Peaking filter, from the Audio EQ Cookbook (Robert Bristow-Johnson).
+	const double frequency = (std::min)( static_cast<double>( band.Frequency ), static_cast<double>( s_MaxFrequency ) * m_SampleRate );
+	const double w0 = 2 * M_PI * frequency / m_SampleRate;
+	const double sinW0 = std::sin( w0 );
+	const double cosW0 = std::cos( w0 );
+	const double octaves = m_Bandwidth / 12.0;
+	const double alpha = sinW0 * std::sinh( std::log( 2.0 ) / 2 * octaves * w0 / sinW0 );
+	const double a = std::pow( 10.0, band.Gain / 40.0 );
+
+	const double a0 = 1 + alpha / a;
+	band.B0 = static_cast<float>( ( 1 + alpha * a ) / a0 );
+	band.B1 = static_cast<float>( -2 * cosW0 / a0 );
+	band.B2 = static_cast<float>( ( 1 - alpha * a ) / a0 );
+	band.A1 = band.B1;
+	band.A2 = static_cast<float>( ( 1 - alpha / a ) / a0 );
+}
+
+void Equaliser::Process( float* buffer, const long sampleCount )
+{
+	if ( m_PendingEQ.IsPending() ) {
+		UpdateSettings();
+	}
+
+	// Flush denormals to zero while filtering, as the filter state decays into the denormal range during silence (which is very slow to process).
+	const unsigned int controlStatus = _mm_getcsr();
+	_mm_setcsr( controlStatus | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON );
+
+	alignas( 16 ) float block[ s_BlockSize * 4 ] = {};
+	for ( long offset = 0; offset < sampleCount; offset += s_BlockSize ) {
+		// Move each band's gain towards its target gain.
+		bool bypass = true;
+		for ( auto& band : m_Bands ) {
+			if ( band.Gain != band.TargetGain ) {
+				band.Gain += ( band.TargetGain - band.Gain ) * s_GainSmoothing;
+				if ( std::fabs( band.TargetGain - band.Gain ) < s_GainThreshold ) {
+					band.Gain = band.TargetGain;
+				}
+				CalculateCoefficients( band );
+			}
+			if ( 0 != band.Gain ) {
+				bypass = false;
+			}
+		}
+		if ( bypass ) {
+			std::fill( m_State.begin(), m_State.end(), 0.0f );
+			continue;
+		}
+
+		const long blockSize = (std::min)( s_BlockSize, sampleCount - offset );
+		float* samples = buffer + offset * m_Channels;
+		for ( long group = 0; group < m_ChannelGroups; group++ ) {
+			const long firstChannel = group * 4;
+			const long groupChannels = (std::min)( 4l, m_Channels - firstChannel );
+			for ( long index = 0; index < blockSize; index++ ) {
+				for ( long channel = 0; channel < groupChannels; channel++ ) {
+					block[ index * 4 + channel ] = samples[ index * m_Channels + firstChannel + channel ];
+				}
+			}
+
+			// Transposed direct form II, applying each band in turn to the whole block.
+			float* state = m_State.data() + group * 8;
+			for ( const auto& band : m_Bands ) {
+				const __m128 b0 = _mm_set1_ps( band.B0 );
+				const __m128 b1 = _mm_set1_ps( band.B1 );
+				const __m128 b2 = _mm_set1_ps( band.B2 );
+				const __m128 a1 = _mm_set1_ps( band.A1 );
+				const __m128 a2 = _mm_set1_ps( band.A2 );
+				__m128 z1 = _mm_loadu_ps( state );
+				__m128 z2 = _mm_loadu_ps( state + 4 );
+				for ( long index = 0; index < blockSize; index++ ) {
+					const __m128 x = _mm_load_ps( block + index * 4 );
+					const __m128 y = _mm_add_ps( _mm_mul_ps( b0, x ), z1 );
+					z1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( b1, x ), _mm_mul_ps( a1, y ) ), z2 );
+					z2 = _mm_sub_ps( _mm_mul_ps( b2, x ), _mm_mul_ps( a2, y ) );
+					_mm_store_ps( block + index * 4, y );
+				}
+				_mm_storeu_ps( state, z1 );
+				_mm_storeu_ps( state + 4, z2 );
+				state += m_ChannelGroups * 8;
+			}
+
+			for ( long index = 0; index < blockSize; index++ ) {
+				for ( long channel = 0; channel < groupChannels; channel++ ) {
+					samples[ index * m_Channels + firstChannel + channel ] = block[ index * 4 + channel ];
+				}
+			}
+		}
+	}
+
+	_mm_setcsr( controlStatus );
+}
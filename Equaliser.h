@@ -0,0 +1,72 @@
+#pragma once
+
+#include "DSPNode.h"
+#include "Settings.h"
+
+#include <memory>
+#include <vector>
+
+// Graphic equaliser, implemented as a cascade of peaking biquad filters (one per band).
+// All bands are applied in a single pass over the sample data, with up to four channels processed at a time using SIMD instructions.
+// Gain changes take effect gradually, so that adjusting the EQ does not cause zipper noise.
+class Equaliser : public DSPNode
+{
+public:
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	Equaliser( const long sampleRate, const long channels );
+
+	virtual ~Equaliser();
+
+	// Equaliser shared pointer type.
+	typedef std::shared_ptr<Equaliser> Ptr;
+
+	// Returns the channel count.
+	long GetChannels() const override;
+
+	// Sets the 'eq' settings (the preamp is not applied by the equaliser).
+	void SetEQ( const Settings::EQ& eq );
+
+	// Applies the EQ to 'sampleCount' samples of interleaved sample data in 'buffer'.
+	void Process( float* buffer, const long sampleCount ) override;
+
+private:
+	// An EQ band.
+	struct Band {
+		float Frequency;			// Centre frequency, in Hz.
+		float Gain;						// Current gain, in dB.
+		float TargetGain;			// Target gain, in dB.
+		float B0;							// Normalised filter coefficients.
+		float B1;
+		float B2;
+		float A1;
+		float A2;
+	};
+
+	// Applies any pending settings changes.
+	void UpdateSettings();
+
+	// Calculates the filter coefficients for the 'band'.
+	void CalculateCoefficients( Band& band ) const;
+
+	// Sample rate.
+	const long m_SampleRate;
+
+	// Channel count.
+	const long m_Channels;
+
+	// Number of groups of four channels.
+	const long m_ChannelGroups;
+
+	// EQ bands.
+	std::vector<Band> m_Bands;
+
+	// Bandwidth, in semitones.
+	float m_Bandwidth;
+
+	// Filter state, two values for each channel of each band.
+	std::vector<float> m_State;
+
+	// Pending settings.
+	DSPParameter<Settings::EQ> m_PendingEQ;
+};
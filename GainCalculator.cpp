@@ -225,11 +225,11 @@ int GainCalculator::GetPendingCount() const
 
 Decoder::Ptr GainCalculator::OpenDecoder( const Playlist::Item& item ) const
 {
-	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename() );
+	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename(), Decoder::Context::Input );
 	if ( !decoder ) {
 		auto duplicate = item.Duplicates.begin();
 		while ( !decoder && ( item.Duplicates.end() != duplicate ) ) {
-			decoder = m_Handlers.OpenDecoder( *duplicate );
+			decoder = m_Handlers.OpenDecoder( *duplicate, Decoder::Context::Input );
 			++duplicate;
 		}
 	}
@@ -240,7 +240,7 @@ float GainCalculator::CalculateTrackGain( const std::wstring& filename, const Ha
 {
 	float gain = NAN;
 	if ( nullptr != canContinue ) {
-		const Decoder::Ptr decoder = handlers.OpenDecoder( filename );
+		const Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Input );
 		if ( decoder ) {
 			const unsigned int channels = static_cast<unsigned int>( decoder->GetChannels() );
 			const unsigned long samplerate = static_cast<unsigned long>( decoder->GetSampleRate() );
@@ -44,7 +44,8 @@ public:
 	virtual bool SetTags( const std::wstring& filename, const Tags& tags ) const = 0;
 
 	// Returns a decoder for 'filename', or nullptr if a decoder cannot be created.
-	virtual Decoder::Ptr OpenDecoder( const std::wstring& filename ) const = 0;
+	// 'context' - context in which the decoder is used.
+	virtual Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const = 0;
 
 	// Returns an encoder, or nullptr if an encoder cannot be created.
 	virtual Encoder::Ptr OpenEncoder() const = 0;
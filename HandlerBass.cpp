@@ -126,7 +126,7 @@ bool HandlerBass::SetTags( const std::wstring& filename, const Tags& tags ) cons
 	return success;
 }
 
-Decoder::Ptr HandlerBass::OpenDecoder( const std::wstring& filename ) const
+Decoder::Ptr HandlerBass::OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const
 {
 	DecoderBass* streamBass = nullptr;
 	try {
@@ -143,7 +143,7 @@ Decoder::Ptr HandlerBass::OpenDecoder( const std::wstring& filename ) const
 			}
 		}
 		if ( !ignoreFile ) {
-			streamBass = new DecoderBass( filename );
+			streamBass = new DecoderBass( filename, context );
 		}
 	} catch ( const std::runtime_error& ) {
 
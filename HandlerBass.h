@@ -27,7 +27,8 @@ public:
 	bool SetTags( const std::wstring& filename, const Tags& tags ) const override;
 
 	// Returns a decoder for 'filename', or nullptr if a decoder cannot be created.
-	Decoder::Ptr OpenDecoder( const std::wstring& filename ) const override;
+	// 'context' - context in which the decoder is used.
+	Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const override;
 
 	// Returns an encoder, or nullptr if an encoder cannot be created.
 	Encoder::Ptr OpenEncoder() const override;
@@ -5,13 +5,15 @@
 
 #include <share/windows_unicode_filenames.h>
 
+#include "resource.h"
 #include "Utility.h"
 
 // Amount of padding to add when writing out FLAC files that don't contain any padding.
 static const unsigned int s_PaddingSize = 1024;
 
 HandlerFlac::HandlerFlac() :
-	Handler()
+	Handler(),
+	m_DitherMode( Settings::DitherMode::Triangular )
 {
 }
 
@@ -312,11 +314,11 @@ bool HandlerFlac::SetTags( const std::wstring& filename, const Tags& tags ) cons
 	return success;
 }
 
-Decoder::Ptr HandlerFlac::OpenDecoder( const std::wstring& filename ) const
+Decoder::Ptr HandlerFlac::OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const
 {
 	DecoderFlac* streamFlac = nullptr;
 	try {
-		streamFlac = new DecoderFlac( filename );
+		streamFlac = new DecoderFlac( filename, context );
 	} catch ( const std::runtime_error& ) {
 
 	}
@@ -326,7 +328,7 @@ Decoder::Ptr HandlerFlac::OpenDecoder( const std::wstring& filename ) const
 
 Encoder::Ptr HandlerFlac::OpenEncoder() const
 {
-	Encoder::Ptr encoder( new EncoderFlac() );
+	Encoder::Ptr encoder( new EncoderFlac( m_DitherMode ) );
 	return encoder;
 }
 
@@ -342,14 +344,126 @@ bool HandlerFlac::IsEncoder() const
 
 bool HandlerFlac::CanConfigureEncoder() const
 {
-	return false;
+	return true;
+}
+
+INT_PTR CALLBACK HandlerFlac::DialogProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
+{
+	switch ( message ) {
+		case WM_INITDIALOG : {
+			ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( lParam );
+			if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+				SetWindowLongPtr( hwnd, DWLP_USER, reinterpret_cast<LPARAM>( config ) );
+				config->m_Handler->OnConfigureInit( hwnd, config->m_Settings );
+			}
+			break;
+		}
+		case WM_DESTROY : {
+			SetWindowLongPtr( hwnd, DWLP_USER, 0 );
+			break;
+		}
+		case WM_COMMAND : {
+			switch ( LOWORD( wParam ) ) {
+				case IDCANCEL : 
+				case IDOK : {
+					ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( GetWindowLongPtr( hwnd, DWLP_USER ) );
+					if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+						config->m_Handler->OnConfigureClose( hwnd, config->m_Settings );
+					}
+					EndDialog( hwnd, IDOK == LOWORD( wParam ) );
+					return TRUE;
+				}
+				case IDC_ENCODER_FLAC_DEFAULT : {
+					ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( GetWindowLongPtr( hwnd, DWLP_USER ) );
+					if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+						config->m_Handler->OnConfigureDefault( hwnd, config->m_Settings );
+					}
+					break;
+				}
+				default : {
+					break;
+				}
+			}
+			break;
+		}
+		case WM_NOTIFY : {
+			LPNMHDR nmhdr = reinterpret_cast<LPNMHDR>( lParam );
+			if ( ( nullptr != nmhdr ) && ( nmhdr->code == TTN_GETDISPINFO ) ) {
+				ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( GetWindowLongPtr( hwnd, DWLP_USER ) );
+				if ( nullptr != config ) {
+					const HWND sliderWnd = reinterpret_cast<HWND>( nmhdr->idFrom );
+					const std::wstring tooltip = config->m_Handler->GetTooltip( config->m_hInst, sliderWnd );
+					LPNMTTDISPINFO info = reinterpret_cast<LPNMTTDISPINFO>( lParam );
+					wcscpy_s( info->szText, tooltip.c_str() );			
+				}
+			}
+			break;
+		}
+		default : {
+			break;
+		}
+	}
+	return FALSE;
+}
+
+bool HandlerFlac::ConfigureEncoder( const HINSTANCE instance, const HWND parent, std::string& settings ) const
+{
+	ConfigurationInfo* config = new ConfigurationInfo( { settings, this, instance } );
+	const bool configured = DialogBoxParam( instance, MAKEINTRESOURCE( IDD_ENCODER_FLAC ), parent, DialogProc, reinterpret_cast<LPARAM>( config ) );
+	delete config;
+	return configured;
+}
+
+void HandlerFlac::OnConfigureInit( const HWND hwnd, const std::string& settings ) const
+{
+	CentreDialog( hwnd );
+	const HWND sliderWnd = GetDlgItem( hwnd, IDC_ENCODER_FLAC_LEVEL );
+	if ( nullptr != sliderWnd ) {
+		SendMessage( sliderWnd, TBM_SETRANGEMIN, TRUE /*redraw*/, 0 );
+		SendMessage( sliderWnd, TBM_SETRANGEMAX, TRUE /*redraw*/, 8 );
+		SendMessage( sliderWnd, TBM_SETTICFREQ, 1, 0 );
+	}
+	UpdateConfigureControls( hwnd, settings );
+}
+
+void HandlerFlac::OnConfigureDefault( const HWND hwnd, std::string& settings ) const
+{
+	settings.clear();
+	UpdateConfigureControls( hwnd, settings );
+}
+
+void HandlerFlac::OnConfigureClose( const HWND hwnd, std::string& settings ) const
+{
+	const HWND sliderWnd = GetDlgItem( hwnd, IDC_ENCODER_FLAC_LEVEL );
+	if ( nullptr != sliderWnd ) {
+		const int compressionLevel = static_cast<int>( SendMessage( sliderWnd, TBM_GETPOS, 0, 0 ) );
+		const bool verify = ( BST_CHECKED == IsDlgButtonChecked( hwnd, IDC_ENCODER_FLAC_VERIFY ) );
+		const bool multithreaded = ( BST_CHECKED == IsDlgButtonChecked( hwnd, IDC_ENCODER_FLAC_MULTITHREADED ) );
+		settings = EncoderFlac::GetSettings( compressionLevel, verify, multithreaded );
+	}
+}
+
+void HandlerFlac::UpdateConfigureControls( const HWND hwnd, const std::string& settings ) const
+{
+	const HWND sliderWnd = GetDlgItem( hwnd, IDC_ENCODER_FLAC_LEVEL );
+	if ( nullptr != sliderWnd ) {
+		SendMessage( sliderWnd, TBM_SETPOS, TRUE /*redraw*/, EncoderFlac::GetCompressionLevel( settings ) );
+	}
+	CheckDlgButton( hwnd, IDC_ENCODER_FLAC_VERIFY, EncoderFlac::GetVerify( settings ) ? BST_CHECKED : BST_UNCHECKED );
+	CheckDlgButton( hwnd, IDC_ENCODER_FLAC_MULTITHREADED, EncoderFlac::GetMultithreaded( settings ) ? BST_CHECKED : BST_UNCHECKED );
 }
 
-bool HandlerFlac::ConfigureEncoder( const HINSTANCE /*instance*/, const HWND /*parent*/, std::string& /*settings*/ ) const
+std::wstring HandlerFlac::GetTooltip( const HINSTANCE instance, const HWND slider ) const
 {
-	return false;
+	const int compressionLevel = static_cast<int>( SendMessage( slider, TBM_GETPOS, 0, 0 ) );
+	const int bufSize = 32;
+	WCHAR buffer[ bufSize ] = {};
+	LoadString( instance, IDS_COMPRESSION_LEVEL, buffer, bufSize );
+	const std::wstring tooltip = std::wstring( buffer ) + L": " + std::to_wstring( compressionLevel );
+	return tooltip;
 }
 
-void HandlerFlac::SettingsChanged( Settings& /*settings*/ )
+void HandlerFlac::SettingsChanged( Settings& settings )
 {
+	m_DitherMode = settings.GetDitherMode();
 }
@@ -1,8 +1,12 @@
 #pragma once
 #include "Handler.h"
 
+#include "Settings.h"
+
 #include "FLAC++\all.h"
 
+#include <atomic>
+
 // FLAC handler
 class HandlerFlac :	public Handler
 {
@@ -24,7 +28,8 @@ public:
 	bool SetTags( const std::wstring& filename, const Tags& tags ) const override;
 
 	// Returns a decoder for 'filename', or nullptr if a decoder cannot be created.
-	Decoder::Ptr OpenDecoder( const std::wstring& filename ) const override;
+	// 'context' - context in which the decoder is used.
+	Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const override;
 
 	// Returns an encoder, or nullptr if an encoder cannot be created.
 	Encoder::Ptr OpenEncoder() const override;
@@ -47,4 +52,45 @@ public:
 
 	// Called when the application 'settings' have changed.
 	void SettingsChanged( Settings& settings ) override;
+
+private:
+	// Configuration dialog initialisation information.
+	struct ConfigurationInfo {
+		// Configuration settings.
+		std::string& m_Settings;
+
+		// Handler object.
+		const HandlerFlac* m_Handler;
+
+		// Application instance handle.
+		HINSTANCE m_hInst;
+	};
+
+	// Encoder configuration dialog box procedure.
+	static INT_PTR CALLBACK DialogProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam );
+
+	// Called when the encoder configuration dialog is initialised.
+	// 'hwnd' - dialog window handle.
+	// 'settings' - configuration settings.
+	void OnConfigureInit( const HWND hwnd, const std::string& settings ) const;
+
+	// Called when the default button is pressed on the encoder configuration dialog.
+	// 'hwnd' - dialog window handle.
+	// 'settings' - out, configuration settings.
+	void OnConfigureDefault( const HWND hwnd, std::string& settings ) const;
+
+	// Called when the encoder configuration dialog is closed.
+	// 'hwnd' - dialog window handle.
+	// 'settings' - out, configuration settings.
+	void OnConfigureClose( const HWND hwnd, std::string& settings ) const;
+
+	// Updates the encoder configuration dialog controls from the 'settings'.
+	// 'hwnd' - dialog window handle.
+	void UpdateConfigureControls( const HWND hwnd, const std::string& settings ) const;
+
+	// Returns the tooltip for the compression level slider control.
+	std::wstring GetTooltip( const HINSTANCE instance, const HWND slider ) const;
+
+	// Dither mode, passed to encoders.
+	std::atomic<Settings::DitherMode> m_DitherMode;
 };
@@ -2,8 +2,24 @@
 
 #include "EncoderPCM.h"
 
+#include "resource.h"
+#include "Utility.h"
+
+#include "windowsx.h"
+
+// Output sample formats, and their descriptions, in the order listed by the encoder configuration dialog.
+static const std::list<std::pair<EncoderPCM::Format,int>> s_Formats = {
+	{ EncoderPCM::Format::Source, IDS_PCM_FORMAT_SOURCE },
+	{ EncoderPCM::Format::Unsigned8, IDS_PCM_FORMAT_8BIT },
+	{ EncoderPCM::Format::Signed16, IDS_PCM_FORMAT_16BIT },
+	{ EncoderPCM::Format::Signed24, IDS_PCM_FORMAT_24BIT },
+	{ EncoderPCM::Format::Signed32, IDS_PCM_FORMAT_32BIT },
+	{ EncoderPCM::Format::Float32, IDS_PCM_FORMAT_FLOAT }
+};
+
 HandlerPCM::HandlerPCM() :
-	Handler()
+	Handler(),
+	m_DitherMode( Settings::DitherMode::Triangular )
 {
 }
 
@@ -33,14 +49,14 @@ bool HandlerPCM::SetTags( const std::wstring& /*filename*/, const Tags& /*tags*/
 	return false;
 }
 
-Decoder::Ptr HandlerPCM::OpenDecoder( const std::wstring& /*filename*/ ) const
+Decoder::Ptr HandlerPCM::OpenDecoder( const std::wstring& /*filename*/, const Decoder::Context /*context*/ ) const
 {
 	return nullptr;
 }
 
 Encoder::Ptr HandlerPCM::OpenEncoder() const
 {
-	Encoder::Ptr encoder( new EncoderPCM() );
+	Encoder::Ptr encoder( new EncoderPCM( m_DitherMode ) );
 	return encoder;
 }
 
@@ -56,14 +72,116 @@ bool HandlerPCM::IsEncoder() const
 
 bool HandlerPCM::CanConfigureEncoder() const
 {
-	return false;
+	return true;
 }
 
-bool HandlerPCM::ConfigureEncoder( const HINSTANCE /*instance*/, const HWND /*parent*/, std::string& /*settings*/ ) const
+INT_PTR CALLBACK HandlerPCM::DialogProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
 {
-	return false;
+	switch ( message ) {
+		case WM_INITDIALOG : {
+			ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( lParam );
+			if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+				SetWindowLongPtr( hwnd, DWLP_USER, reinterpret_cast<LPARAM>( config ) );
+				config->m_Handler->OnConfigureInit( hwnd, config->m_hInst, config->m_Settings );
+			}
+			break;
+		}
+		case WM_DESTROY : {
+			SetWindowLongPtr( hwnd, DWLP_USER, 0 );
+			break;
+		}
+		case WM_COMMAND : {
+			switch ( LOWORD( wParam ) ) {
+				case IDCANCEL : 
+				case IDOK : {
+					ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( GetWindowLongPtr( hwnd, DWLP_USER ) );
+					if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+						config->m_Handler->OnConfigureClose( hwnd, config->m_Settings );
+					}
+					EndDialog( hwnd, IDOK == LOWORD( wParam ) );
+					return TRUE;
+				}
+				case IDC_ENCODER_PCM_DEFAULT : {
+					ConfigurationInfo* config = reinterpret_cast<ConfigurationInfo*>( GetWindowLongPtr( hwnd, DWLP_USER ) );
+					if ( ( nullptr != config ) && ( nullptr != config->m_Handler ) ) {
+						config->m_Handler->OnConfigureDefault( hwnd, config->m_Settings );
+					}
+					break;
+				}
+				default : {
+					break;
+				}
+			}
+			break;
+		}
+		default : {
+			break;
+		}
+	}
+	return FALSE;
+}
+
+bool HandlerPCM::ConfigureEncoder( const HINSTANCE instance, const HWND parent, std::string& settings ) const
+{
+	ConfigurationInfo* config = new ConfigurationInfo( { settings, this, instance } );
+	const bool configured = DialogBoxParam( instance, MAKEINTRESOURCE( IDD_ENCODER_PCM ), parent, DialogProc, reinterpret_cast<LPARAM>( config ) );
+	delete config;
+	return configured;
+}
+
+void HandlerPCM::OnConfigureInit( const HWND hwnd, const HINSTANCE instance, const std::string& settings ) const
+{
+	CentreDialog( hwnd );
+	const HWND comboWnd = GetDlgItem( hwnd, IDC_ENCODER_PCM_FORMAT );
+	if ( nullptr != comboWnd ) {
+		const int bufSize = 64;
+		WCHAR buffer[ bufSize ] = {};
+		for ( const auto& format : s_Formats ) {
+			LoadString( instance, format.second, buffer, bufSize );
+			ComboBox_AddString( comboWnd, buffer );
+		}
+	}
+	UpdateConfigureControls( hwnd, settings );
+}
+
+void HandlerPCM::OnConfigureDefault( const HWND hwnd, std::string& settings ) const
+{
+	settings.clear();
+	UpdateConfigureControls( hwnd, settings );
+}
+
+void HandlerPCM::OnConfigureClose( const HWND hwnd, std::string& settings ) const
+{
+	const HWND comboWnd = GetDlgItem( hwnd, IDC_ENCODER_PCM_FORMAT );
+	if ( nullptr != comboWnd ) {
+		const int selectedIndex = ComboBox_GetCurSel( comboWnd );
+		int index = 0;
+		for ( const auto& format : s_Formats ) {
+			if ( selectedIndex == index++ ) {
+				settings = EncoderPCM::GetSettings( format.first );
+				break;
+			}
+		}
+	}
+}
+
+void HandlerPCM::UpdateConfigureControls( const HWND hwnd, const std::string& settings ) const
+{
+	const HWND comboWnd = GetDlgItem( hwnd, IDC_ENCODER_PCM_FORMAT );
+	if ( nullptr != comboWnd ) {
+		const EncoderPCM::Format selectedFormat = EncoderPCM::GetFormat( settings );
+		int index = 0;
+		for ( const auto& format : s_Formats ) {
+			if ( selectedFormat == format.first ) {
+				ComboBox_SetCurSel( comboWnd, index );
+				break;
+			}
+			++index;
+		}
+	}
 }
 
-void HandlerPCM::SettingsChanged( Settings& /*settings*/ )
+void HandlerPCM::SettingsChanged( Settings& settings )
 {
+	m_DitherMode = settings.GetDitherMode();
 }
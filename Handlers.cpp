@@ -7,6 +7,7 @@
 #include "HandlerPCM.h"
 #include "HandlerWavpack.h"
 
+#include "InputSource.h"
 #include "ShellMetadata.h"
 #include "Utility.h"
 
@@ -50,17 +51,17 @@ Handler::Ptr Handlers::FindDecoderHandler( const std::wstring& filename ) const
 	return handler;
 }
 
-Decoder::Ptr Handlers::OpenDecoder( const std::wstring& filename ) const
+Decoder::Ptr Handlers::OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const
 {
 	Decoder::Ptr decoder;
 	Handler::Ptr handler = FindDecoderHandler( filename );
 	if ( handler ) {
-		decoder = handler->OpenDecoder( filename );
+		decoder = handler->OpenDecoder( filename, context );
 	}
 	if ( !decoder ) {
 		// Try any handler.
 		for ( auto handlerIter = m_Decoders.begin(); !decoder && ( handlerIter != m_Decoders.end() ); handlerIter++ ) {
-			decoder = handlerIter->get()->OpenDecoder( filename );
+			decoder = handlerIter->get()->OpenDecoder( filename, context );
 		}
 	}
 	return decoder;
@@ -88,6 +89,9 @@ bool Handlers::GetTags( const std::wstring& filename, Tags& tags ) const
 
 bool Handlers::SetTags( const std::wstring& filename, const Tags& tags ) const
 {
+	// A mapped file cannot be resized, so any decoder reading the file switches to plain reads before the tags are written.
+	InputSource::ReleaseMappings( filename );
+
 	bool success = false;
 	Handler::Ptr handler = FindDecoderHandler( filename );
 	if ( handler ) {
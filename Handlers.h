@@ -14,8 +14,9 @@ public:
 
 	// Opens a decoder.
 	// 'filename' - file to open.
+	// 'context' - context in which the decoder is used.
 	// Returns the decoder, or nullptr if the stream could not be opened.
-	Decoder::Ptr OpenDecoder( const std::wstring& filename ) const;
+	Decoder::Ptr OpenDecoder( const std::wstring& filename, const Decoder::Context context ) const;
 
 	// Reads 'tags' from 'filename', returning true if the tags were read.
 	bool GetTags( const std::wstring& filename, Tags& tags ) const;
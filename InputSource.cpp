@@ -0,0 +1,533 @@
+#include "InputSource.h"
+
+#include "Prefetcher.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Block size used by the buffered and read ahead input sources.
+static const size_t s_BlockSize = 0x100000;
+
+// Block alignment used by the buffered and read ahead input sources.
+static const long long s_BlockAlignment = 0x1000;
+
+// Maximum size of file to memory map (limited for 32-bit builds, to avoid exhausting the address space).
+static const long long s_MaxMappedSize = ( sizeof( void* ) > 4 ) ? 0x7fffffffffffffffll : 0x10000000ll;
+
+std::set<const InputSource*> InputSource::s_Sources;
+InputSource::Counters InputSource::s_ClosedCounters = {};
+std::mutex InputSource::s_SourcesMutex;
+
+// Memory mapped input source.
+class MemoryMappedInputSource : public InputSource
+{
+public:
+	// 'filename' - file name.
+	// 'handle' - file handle (ownership is transferred).
+	// 'mapping' - file mapping handle (ownership is transferred).
+	// 'view' - mapped view of the whole file.
+	// 'size' - file size.
+	MemoryMappedInputSource( const std::wstring& filename, const HANDLE handle, const HANDLE mapping, const void* view, const long long size ) :
+		InputSource( size ),
+		m_Filename( filename ),
+		m_Handle( handle ),
+		m_Mapping( mapping ),
+		m_View( static_cast<const BYTE*>( view ) ),
+		m_ViewMutex()
+	{
+		std::lock_guard<std::mutex> lock( s_MappedSourcesMutex );
+		s_MappedSources.insert( this );
+	}
+
+	virtual ~MemoryMappedInputSource()
+	{
+		{
+			std::lock_guard<std::mutex> lock( s_MappedSourcesMutex );
+			s_MappedSources.erase( this );
+		}
+		ReleaseMapping();
+		CloseHandle( m_Handle );
+	}
+
+	// Reads up to 'size' bytes from the current position into 'buffer', returning the number of bytes read.
+	size_t ReadSource( void* buffer, const size_t size ) override
+	{
+		size_t bytesRead = static_cast<size_t>( (std::min)( static_cast<long long>( size ), GetSize() - m_Position ) );
+		if ( bytesRead > 0 ) {
+			std::lock_guard<std::mutex> lock( m_ViewMutex );
+			if ( nullptr != m_View ) {
+				if ( CopyFromView( m_View + m_Position, buffer, bytesRead ) ) {
+					AddBytesRead( bytesRead );
+				} else {
+					bytesRead = 0;
+				}
+			} else {
+				bytesRead = ReadAt( m_Handle, m_Position, buffer, bytesRead );
+			}
+			m_Position += bytesRead;
+		}
+		return bytesRead;
+	}
+
+	// Releases the memory mapping of any open input sources for 'filename'.
+	static void ReleaseMappings( const std::wstring& filename )
+	{
+		std::lock_guard<std::mutex> lock( s_MappedSourcesMutex );
+		for ( const auto& source : s_MappedSources ) {
+			if ( 0 == _wcsicmp( source->m_Filename.c_str(), filename.c_str() ) ) {
+				source->ReleaseMapping();
+			}
+		}
+	}
+
+private:
+	// Copies 'size' bytes from the mapped 'view' into 'buffer'.
+	// Returns false if the file has become unavailable (e.g. a network share has been disconnected).
+	static bool CopyFromView( const BYTE* view, void* buffer, const size_t size )
+	{
+		__try {
+			memcpy( buffer, view, size );
+		} __except ( ( EXCEPTION_IN_PAGE_ERROR == GetExceptionCode() ) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH ) {
+			return false;
+		}
+		return true;
+	}
+
+	// Unmaps the view & closes the file mapping, after which the file is read using the file handle.
+	void ReleaseMapping()
+	{
+		std::lock_guard<std::mutex> lock( m_ViewMutex );
+		if ( nullptr != m_View ) {
+			UnmapViewOfFile( m_View );
+			CloseHandle( m_Mapping );
+			m_View = nullptr;
+		}
+	}
+
+	// File name.
+	const std::wstring m_Filename;
+
+	// File handle.
+	const HANDLE m_Handle;
+
+	// File mapping handle.
+	const HANDLE m_Mapping;
+
+	// Mapped view of the whole file, or nullptr if the mapping has been released.
+	const BYTE* m_View;
+
+	// Guards the mapped view.
+	std::mutex m_ViewMutex;
+
+	// Memory mapped input sources which are currently open.
+	static std::set<MemoryMappedInputSource*> s_MappedSources;
+
+	// Guards the memory mapped input sources.
+	static std::mutex s_MappedSourcesMutex;
+};
+
+std::set<MemoryMappedInputSource*> MemoryMappedInputSource::s_MappedSources;
+std::mutex MemoryMappedInputSource::s_MappedSourcesMutex;
+
+// Buffered input source, which reads the file in large blocks.
+class BufferedInputSource : public InputSource
+{
+public:
+	// 'handle' - file handle (ownership is transferred).
+	// 'size' - file size.
+	BufferedInputSource( const HANDLE handle, const long long size ) :
+		InputSource( size ),
+		m_Handle( handle ),
+		m_Block( s_BlockSize ),
+		m_BlockOffset( 0 ),
+		m_BlockSize( 0 )
+	{
+	}
+
+	virtual ~BufferedInputSource()
+	{
+		CloseHandle( m_Handle );
+	}
+
+	// Reads up to 'size' bytes from the current position into 'buffer', returning the number of bytes read.
+	size_t ReadSource( void* buffer, const size_t size ) override
+	{
+		size_t bytesRead = 0;
+		BYTE* output = static_cast<BYTE*>( buffer );
+		while ( ( bytesRead < size ) && ( m_Position < GetSize() ) ) {
+			if ( ( m_Position >= m_BlockOffset ) && ( m_Position < ( m_BlockOffset + static_cast<long long>( m_BlockSize ) ) ) ) {
+				const size_t blockPos = static_cast<size_t>( m_Position - m_BlockOffset );
+				const size_t bytesToCopy = (std::min)( size - bytesRead, m_BlockSize - blockPos );
+				memcpy( output + bytesRead, m_Block.data() + blockPos, bytesToCopy );
+				bytesRead += bytesToCopy;
+				m_Position += bytesToCopy;
+			} else if ( ( size - bytesRead ) >= s_BlockSize ) {
+				// Large reads bypass the block buffer.
+				const size_t directBytes = ReadAt( m_Handle, m_Position, output + bytesRead, size - bytesRead );
+				if ( 0 == directBytes ) {
+					break;
+				}
+				bytesRead += directBytes;
+				m_Position += directBytes;
+			} else if ( !LoadBlock( m_Position - ( m_Position % s_BlockAlignment ) ) ) {
+				break;
+			}
+		}
+		return bytesRead;
+	}
+
+protected:
+	// Loads the block starting at 'offset'.
+	// Returns true if any data was loaded.
+	virtual bool LoadBlock( const long long offset )
+	{
+		m_BlockOffset = offset;
+		m_BlockSize = ReadAt( m_Handle, offset, m_Block.data(), m_Block.size() );
+		return ( m_BlockSize > 0 );
+	}
+
+	// File handle.
+	const HANDLE m_Handle;
+
+	// Current block.
+	std::vector<BYTE> m_Block;
+
+	// File offset of the current block.
+	long long m_BlockOffset;
+
+	// Number of valid bytes in the current block.
+	size_t m_BlockSize;
+};
+
+// Read ahead input source, which reads the next block on a background thread while the current block is consumed.
+class ReadAheadInputSource : public BufferedInputSource
+{
+public:
+	// 'handle' - file handle (ownership is transferred).
+	// 'size' - file size.
+	ReadAheadInputSource( const HANDLE handle, const long long size ) :
+		BufferedInputSource( handle, size ),
+		m_Thread(),
+		m_Mutex(),
+		m_Condition(),
+		m_Prefetch( s_BlockSize ),
+		m_PrefetchOffset( -1 ),
+		m_PrefetchSize( 0 ),
+		m_PrefetchPending( false ),
+		m_Stop( false )
+	{
+		m_Thread = std::thread( &ReadAheadInputSource::PrefetchHandler, this );
+	}
+
+	virtual ~ReadAheadInputSource()
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			m_Stop = true;
+		}
+		m_Condition.notify_all();
+		if ( m_Thread.joinable() ) {
+			m_Thread.join();
+		}
+	}
+
+protected:
+	// Loads the block starting at 'offset', using the prefetched block if possible, then starts prefetching the following block.
+	// Returns true if any data was loaded.
+	bool LoadBlock( const long long offset ) override
+	{
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		m_Condition.wait( lock, [ this ] () { return !m_PrefetchPending; } );
+		bool loaded = false;
+		if ( ( offset == m_PrefetchOffset ) && ( m_PrefetchSize > 0 ) ) {
+			m_Block.swap( m_Prefetch );
+			m_BlockOffset = m_PrefetchOffset;
+			m_BlockSize = m_PrefetchSize;
+			loaded = true;
+		} else {
+			loaded = BufferedInputSource::LoadBlock( offset );
+		}
+		m_PrefetchOffset = -1;
+		m_PrefetchSize = 0;
+		if ( loaded ) {
+			const long long nextOffset = m_BlockOffset + static_cast<long long>( m_BlockSize );
+			if ( nextOffset < GetSize() ) {
+				m_PrefetchOffset = nextOffset;
+				m_PrefetchPending = true;
+				lock.unlock();
+				m_Condition.notify_all();
+			}
+		}
+		return loaded;
+	}
+
+private:
+	// Prefetch thread handler.
+	void PrefetchHandler()
+	{
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		while ( !m_Stop ) {
+			m_Condition.wait( lock, [ this ] () { return m_Stop || m_PrefetchPending; } );
+			if ( m_PrefetchPending && !m_Stop ) {
+				const long long offset = m_PrefetchOffset;
+				lock.unlock();
+				const size_t bytesRead = ReadAt( m_Handle, offset, m_Prefetch.data(), m_Prefetch.size() );
+				lock.lock();
+				m_PrefetchSize = bytesRead;
+				m_PrefetchPending = false;
+				m_Condition.notify_all();
+			}
+		}
+	}
+
+	// Prefetch thread.
+	std::thread m_Thread;
+
+	// Prefetch mutex.
+	std::mutex m_Mutex;
+
+	// Prefetch condition.
+	std::condition_variable m_Condition;
+
+	// Prefetched block.
+	std::vector<BYTE> m_Prefetch;
+
+	// File offset of the prefetched block, or -1 if there is no prefetched block.
+	long long m_PrefetchOffset;
+
+	// Number of valid bytes in the prefetched block.
+	size_t m_PrefetchSize;
+
+	// Indicates whether the prefetch thread is reading a block.
+	bool m_PrefetchPending;
+
+	// Indicates whether the prefetch thread should stop.
+	bool m_Stop;
+};
+
+InputSource::Ptr InputSource::Open( const std::wstring& filename, const Type type )
+{
+	Type sourceType = type;
+	if ( Type::Automatic == sourceType ) {
+		sourceType = Type::MemoryMapped;
+		WCHAR volume[ MAX_PATH ] = {};
+		if ( FALSE != GetVolumePathName( filename.c_str(), volume, MAX_PATH ) ) {
+			switch ( GetDriveType( volume ) ) {
+				case DRIVE_REMOTE :
+				case DRIVE_REMOVABLE :
+				case DRIVE_CDROM : {
+					sourceType = Type::ReadAhead;
+					break;
+				}
+				default : {
+					break;
+				}
+			}
+		}
+	}
+
+	const DWORD flags = ( Type::MemoryMapped == sourceType ) ? FILE_ATTRIBUTE_NORMAL : FILE_FLAG_SEQUENTIAL_SCAN;
+	const HANDLE handle = CreateFile( filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL /*security*/, OPEN_EXISTING, flags, NULL /*template*/ );
+	if ( INVALID_HANDLE_VALUE == handle ) {
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize = {};
+	if ( FALSE == GetFileSizeEx( handle, &fileSize ) ) {
+		CloseHandle( handle );
+		return nullptr;
+	}
+	const long long size = fileSize.QuadPart;
+	FILETIME lastWriteTime = {};
+	const bool hasLastWriteTime = ( FALSE != GetFileTime( handle, NULL /*creationTime*/, NULL /*lastAccessTime*/, &lastWriteTime ) );
+
+	Ptr source;
+	if ( ( Type::MemoryMapped == sourceType ) && ( size > 0 ) && ( size <= s_MaxMappedSize ) ) {
+		const HANDLE mapping = CreateFileMapping( handle, NULL /*security*/, PAGE_READONLY, 0 /*maxSizeHigh*/, 0 /*maxSizeLow*/, NULL /*name*/ );
+		if ( NULL != mapping ) {
+			const void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0 /*offsetHigh*/, 0 /*offsetLow*/, 0 /*bytesToMap*/ );
+			if ( nullptr != view ) {
+				// The file handle is kept, so that reading can continue if the mapping is released.
+				source = std::make_shared<MemoryMappedInputSource>( filename, handle, mapping, view, size );
+				source->AddSystemCall();
+				source->AddSystemCall();
+			} else {
+				CloseHandle( mapping );
+			}
+		}
+		if ( !source ) {
+			// Fall back to large block reads if the file could not be mapped.
+			sourceType = Type::Buffered;
+		}
+	}
+
+	if ( !source ) {
+		if ( Type::ReadAhead == sourceType ) {
+			source = std::make_shared<ReadAheadInputSource>( handle, size );
+		} else {
+			source = std::make_shared<BufferedInputSource>( handle, size );
+		}
+	}
+	if ( source ) {
+		// Count opening the file & getting the file size & time.
+		source->AddSystemCall();
+		source->AddSystemCall();
+		source->AddSystemCall();
+
+		// Use any data prefetched from the start of the file, provided the file has not changed since.
+		if ( hasLastWriteTime ) {
+			const Prefetcher::Head head = Prefetcher::GetHead( filename, size, ( static_cast<long long>( lastWriteTime.dwHighDateTime ) << 32 ) + lastWriteTime.dwLowDateTime );
+			if ( head && ( static_cast<long long>( head->size() ) <= size ) ) {
+				source->m_Head = head;
+			}
+		}
+	}
+	return source;
+}
+
+InputSource::Type InputSource::GetType( const Decoder::Context context )
+{
+	const Type type = ( Decoder::Context::Input == context ) ? Type::Automatic : Type::Buffered;
+	return type;
+}
+
+void InputSource::ReleaseMappings( const std::wstring& filename )
+{
+	MemoryMappedInputSource::ReleaseMappings( filename );
+}
+
+InputSource::InputSource( const long long size ) :
+	m_Position( 0 ),
+	m_Size( size ),
+	m_Head(),
+	m_BytesRead( 0 ),
+	m_BytesCached( 0 ),
+	m_SystemCalls( 0 )
+{
+	std::lock_guard<std::mutex> lock( s_SourcesMutex );
+	s_Sources.insert( this );
+}
+
+InputSource::~InputSource()
+{
+	// Any read ahead thread has been stopped by the derived class, so the counters are final.
+	const Counters counters = GetCounters();
+	std::lock_guard<std::mutex> lock( s_SourcesMutex );
+	s_ClosedCounters.BytesRead += counters.BytesRead;
+	s_ClosedCounters.BytesCached += counters.BytesCached;
+	s_ClosedCounters.SystemCalls += counters.SystemCalls;
+	s_Sources.erase( this );
+}
+
+size_t InputSource::Read( void* buffer, const size_t size )
+{
+	size_t bytesRead = 0;
+	if ( m_Head && ( m_Position < static_cast<long long>( m_Head->size() ) ) ) {
+		bytesRead = (std::min)( size, m_Head->size() - static_cast<size_t>( m_Position ) );
+		memcpy( buffer, m_Head->data() + m_Position, bytesRead );
+		m_Position += bytesRead;
+		m_BytesCached += static_cast<long long>( bytesRead );
+	}
+	if ( bytesRead < size ) {
+		bytesRead += ReadSource( static_cast<BYTE*>( buffer ) + bytesRead, size - bytesRead );
+	}
+	return bytesRead;
+}
+
+bool InputSource::Seek( const long long offset, const int origin )
+{
+	long long position = -1;
+	switch ( origin ) {
+		case SEEK_SET : {
+			position = offset;
+			break;
+		}
+		case SEEK_CUR : {
+			position = m_Position + offset;
+			break;
+		}
+		case SEEK_END : {
+			position = m_Size + offset;
+			break;
+		}
+		default : {
+			break;
+		}
+	}
+	const bool success = ( position >= 0 ) && ( position <= m_Size );
+	if ( success ) {
+		m_Position = position;
+	}
+	return success;
+}
+
+long long InputSource::Tell() const
+{
+	return m_Position;
+}
+
+long long InputSource::GetSize() const
+{
+	return m_Size;
+}
+
+bool InputSource::IsEOF() const
+{
+	return ( m_Position >= m_Size );
+}
+
+InputSource::Counters InputSource::GetCounters() const
+{
+	Counters counters = {};
+	counters.BytesRead = m_BytesRead;
+	counters.BytesCached = m_BytesCached;
+	counters.SystemCalls = m_SystemCalls;
+	return counters;
+}
+
+InputSource::Counters InputSource::GetTotalCounters()
+{
+	std::lock_guard<std::mutex> lock( s_SourcesMutex );
+	Counters totals = s_ClosedCounters;
+	for ( const auto& source : s_Sources ) {
+		const Counters counters = source->GetCounters();
+		totals.BytesRead += counters.BytesRead;
+		totals.BytesCached += counters.BytesCached;
+		totals.SystemCalls += counters.SystemCalls;
+	}
+	return totals;
+}
+
+size_t InputSource::ReadAt( const HANDLE handle, const long long offset, void* buffer, const size_t size )
+{
+	size_t bytesRead = 0;
+	BYTE* output = static_cast<BYTE*>( buffer );
+	while ( bytesRead < size ) {
+		const long long position = offset + static_cast<long long>( bytesRead );
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>( position & 0xffffffff );
+		overlapped.OffsetHigh = static_cast<DWORD>( position >> 32 );
+		const DWORD bytesToRead = static_cast<DWORD>( (std::min)( size - bytesRead, static_cast<size_t>( 0x40000000 ) ) );
+		DWORD bytesReturned = 0;
+		const BOOL result = ReadFile( handle, output + bytesRead, bytesToRead, &bytesReturned, &overlapped );
+		AddSystemCall();
+		if ( ( FALSE == result ) || ( 0 == bytesReturned ) ) {
+			break;
+		}
+		bytesRead += bytesReturned;
+	}
+	AddBytesRead( bytesRead );
+	return bytesRead;
+}
+
+void InputSource::AddSystemCall()
+{
+	++m_SystemCalls;
+}
+
+void InputSource::AddBytesRead( const size_t bytes )
+{
+	m_BytesRead += static_cast<long long>( bytes );
+}
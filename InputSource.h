@@ -0,0 +1,125 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "Decoder.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Input source, providing decoders with read access to a media file.
+// Different implementations trade memory for fewer (and larger) reads, which matters most for files on network shares.
+class InputSource
+{
+public:
+	// Input source shared pointer type.
+	typedef std::shared_ptr<InputSource> Ptr;
+
+	// Input source type.
+	enum class Type {
+		// Maps the whole file into memory.
+		MemoryMapped,
+
+		// Reads the file in large blocks.
+		Buffered,
+
+		// Reads the file in large blocks, reading the next block in the background.
+		ReadAhead,
+
+		// Chooses the type based on the location of the file (memory mapped for local drives, read ahead for network & removable drives).
+		Automatic
+	};
+
+	// Input source counters.
+	struct Counters {
+		long long BytesRead;		// Number of bytes read from files.
+		long long BytesCached;	// Number of bytes read from data prefetched from the start of files.
+		long long SystemCalls;	// Number of system calls made to access files.
+	};
+
+	// Opens an input source.
+	// 'filename' - file name.
+	// 'type' - input source type.
+	// Returns the input source, or nullptr if the file could not be opened.
+	static Ptr Open( const std::wstring& filename, const Type type = Type::Automatic );
+
+	// Returns the input source type to use for a decoder 'context'.
+	static Type GetType( const Decoder::Context context );
+
+	// Releases any memory mapping of 'filename', so that the file can be modified (e.g. when writing tags).
+	// Input sources which had mapped the file continue reading from the file handle.
+	static void ReleaseMappings( const std::wstring& filename );
+
+	virtual ~InputSource();
+
+	// Reads up to 'size' bytes into 'buffer', returning the number of bytes read.
+	size_t Read( void* buffer, const size_t size );
+
+	// Seeks to an 'offset', relative to an 'origin' (SEEK_SET, SEEK_CUR or SEEK_END).
+	// Returns true if the position was set.
+	bool Seek( const long long offset, const int origin );
+
+	// Returns the current position.
+	long long Tell() const;
+
+	// Returns the file size.
+	long long GetSize() const;
+
+	// Returns whether the end of the file has been reached.
+	bool IsEOF() const;
+
+	// Returns the counters for this input source.
+	Counters GetCounters() const;
+
+	// Returns the counters, totalled over all the input sources opened so far.
+	static Counters GetTotalCounters();
+
+protected:
+	// 'size' - file size.
+	InputSource( const long long size );
+
+	// Reads up to 'size' bytes from the current position into 'buffer', returning the number of bytes read.
+	virtual size_t ReadSource( void* buffer, const size_t size ) = 0;
+
+	// Reads up to 'size' bytes from the file 'handle', at 'offset', into 'buffer' (this is safe to call from multiple threads).
+	// Returns the number of bytes read.
+	size_t ReadAt( const HANDLE handle, const long long offset, void* buffer, const size_t size );
+
+	// Counts a system call.
+	void AddSystemCall();
+
+	// Counts 'bytes' read from the file.
+	void AddBytesRead( const size_t bytes );
+
+	// Current position.
+	long long m_Position;
+
+private:
+	// File size.
+	const long long m_Size;
+
+	// Data prefetched from the start of the file, if available.
+	std::shared_ptr<const std::vector<BYTE>> m_Head;
+
+	// Number of bytes read from the file (this can be updated from a read ahead thread).
+	std::atomic<long long> m_BytesRead;
+
+	// Number of bytes read from data prefetched from the start of the file.
+	std::atomic<long long> m_BytesCached;
+
+	// Number of system calls made to access the file (this can be updated from a read ahead thread).
+	std::atomic<long long> m_SystemCalls;
+
+	// Input sources which are currently open.
+	static std::set<const InputSource*> s_Sources;
+
+	// Counters totalled over the input sources which have been closed.
+	static Counters s_ClosedCounters;
+
+	// Guards the open input sources & the closed counters.
+	static std::mutex s_SourcesMutex;
+};
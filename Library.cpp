@@ -1,5 +1,6 @@
 #include "Library.h"
 
+#include "MediaFilter.h"
 #include "Utility.h"
 #include "VUPlayer.h"
 
@@ -67,6 +68,7 @@ void Library::UpdateDatabase()
 	UpdateCDDATable();
 	UpdateArtworkTable();
 	CreateIndices();
+	UpdateStatisticsTable();
 }
 
 void Library::UpdateMediaTable()
@@ -212,6 +214,90 @@ void Library::CreateIndices()
 	}
 }
 
+void Library::UpdateStatisticsTable()
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		// Media entries are written using REPLACE, so recursive triggers are required for the delete trigger to fire when an entry is replaced.
+		sqlite3_exec( database, "PRAGMA recursive_triggers=ON;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+
+		const std::string createTableQuery = "CREATE TABLE IF NOT EXISTS MediaStatistics(Type,SampleRate,Count,Duration,Filesize,PRIMARY KEY(Type,SampleRate));";
+		sqlite3_exec( database, createTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+
+		// If the triggers are missing (new database, or the media table has been recreated), rebuild the statistics from the media table.
+		bool triggersExist = false;
+		const std::string triggerQuery = "SELECT COUNT(*) FROM sqlite_master WHERE type='trigger' AND tbl_name='Media' AND name LIKE 'MediaStatistics_%';";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, triggerQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				triggersExist = ( 3 == sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+
+		if ( !triggersExist ) {
+			// File type is the upper case filename extension, as per MediaInfo::GetType.
+			const auto typeExpression = [] ( const std::string& row ) -> std::string
+			{
+				const std::string filename = row + ".Filename";
+				return "CASE WHEN INSTR(" + filename + ",'.')>0 THEN UPPER(SUBSTR(" + filename + ",LENGTH(RTRIM(" + filename + ",REPLACE(" + filename + ",'.','')))+1)) ELSE '' END";
+			};
+			const auto addExpression = [ typeExpression ] ( const std::string& row ) -> std::string
+			{
+				const std::string key = "Type=" + typeExpression( row ) + " AND SampleRate=IFNULL(" + row + ".SampleRate,0)";
+				return
+					"INSERT OR IGNORE INTO MediaStatistics VALUES(" + typeExpression( row ) + ",IFNULL(" + row + ".SampleRate,0),0,0,0);"
+					"UPDATE MediaStatistics SET Count=Count+1,Duration=Duration+IFNULL(" + row + ".Duration,0),Filesize=Filesize+IFNULL(" + row + ".Filesize,0) WHERE " + key + ";";
+			};
+			const auto removeExpression = [ typeExpression ] ( const std::string& row ) -> std::string
+			{
+				const std::string key = "Type=" + typeExpression( row ) + " AND SampleRate=IFNULL(" + row + ".SampleRate,0)";
+				return
+					"UPDATE MediaStatistics SET Count=Count-1,Duration=Duration-IFNULL(" + row + ".Duration,0),Filesize=Filesize-IFNULL(" + row + ".Filesize,0) WHERE " + key + ";"
+					"DELETE FROM MediaStatistics WHERE Count<=0;";
+			};
+
+			const std::string rebuildQuery =
+				"BEGIN TRANSACTION;"
+				"DROP TRIGGER IF EXISTS MediaStatistics_Insert;"
+				"DROP TRIGGER IF EXISTS MediaStatistics_Delete;"
+				"DROP TRIGGER IF EXISTS MediaStatistics_Update;"
+				"DELETE FROM MediaStatistics;"
+				"INSERT INTO MediaStatistics SELECT " + typeExpression( "Media" ) + ",IFNULL(SampleRate,0),COUNT(*),TOTAL(Duration),IFNULL(SUM(Filesize),0) FROM Media GROUP BY 1,2;"
+				"CREATE TRIGGER MediaStatistics_Insert AFTER INSERT ON Media BEGIN " + addExpression( "NEW" ) + " END;"
+				"CREATE TRIGGER MediaStatistics_Delete AFTER DELETE ON Media BEGIN " + removeExpression( "OLD" ) + " END;"
+				"CREATE TRIGGER MediaStatistics_Update AFTER UPDATE OF Filename,SampleRate,Duration,Filesize ON Media BEGIN " + removeExpression( "OLD" ) + addExpression( "NEW" ) + " END;"
+				"END TRANSACTION;";
+			sqlite3_exec( database, rebuildQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+		}
+	}
+}
+
+Library::Statistics Library::GetStatistics()
+{
+	Statistics statistics = {};
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "SELECT Type,SampleRate,Count,Duration,Filesize FROM MediaStatistics;";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				const unsigned char* text = sqlite3_column_text( stmt, 0 /*columnIndex*/ );
+				const std::wstring type = ( nullptr != text ) ? UTF8ToWideString( reinterpret_cast<const char*>( text ) ) : std::wstring();
+				const long sampleRate = static_cast<long>( sqlite3_column_int( stmt, 1 /*columnIndex*/ ) );
+				const long count = static_cast<long>( sqlite3_column_int( stmt, 2 /*columnIndex*/ ) );
+				statistics.Count += count;
+				statistics.Duration += sqlite3_column_double( stmt, 3 /*columnIndex*/ );
+				statistics.Filesize += static_cast<long long>( sqlite3_column_int64( stmt, 4 /*columnIndex*/ ) );
+				statistics.Types[ type ] += count;
+				statistics.SampleRates[ sampleRate ] += count;
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return statistics;
+}
+
 bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool checkFileAttributes, const bool scanMedia, const bool sendNotification, const bool removeMissing )
 {
 	bool success = false;
@@ -272,6 +358,95 @@ bool Library::GetMediaInfo( MediaInfo& mediaInfo, const bool checkFileAttributes
 	return success;
 }
 
+bool Library::ScanMediaInfo( MediaInfo& mediaInfo, bool& scanned )
+{
+	const bool inLibrary = GetMediaInfo( mediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/, false /*sendNotification*/ );
+	return ScanMediaInfo( mediaInfo, inLibrary, scanned );
+}
+
+bool Library::ScanMediaInfo( MediaInfo& mediaInfo, const bool inLibrary, bool& scanned )
+{
+	scanned = false;
+	bool success = false;
+	if ( inLibrary ) {
+		long long filetime = 0;
+		long long filesize = 0;
+		GetFileInfo( mediaInfo.GetFilename(), filetime, filesize );
+		success = ( mediaInfo.GetFiletime() == filetime ) && ( mediaInfo.GetFilesize() == filesize );
+	}
+	if ( !success && ( MediaInfo::Source::File == mediaInfo.GetSource() ) ) {
+		MediaInfo info( mediaInfo.GetFilename() );
+		success = GetDecoderInfo( info );
+		if ( success ) {
+			Tags pendingTags;
+			if ( GetPendingTags( info.GetFilename(), pendingTags ) ) {
+				UpdateMediaInfoFromTags( info, pendingTags );
+			}
+			mediaInfo = info;
+			scanned = true;
+		}
+	}
+	return success;
+}
+
+std::map<std::wstring,MediaInfo> Library::GetMediaInfo( const std::vector<std::wstring>& filenames )
+{
+	std::map<std::wstring,MediaInfo> mediaMap;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		// Keep within the default limit on the number of query parameters.
+		const size_t maxParams = 500;
+		for ( size_t first = 0; first < filenames.size(); first += maxParams ) {
+			const size_t count = min( maxParams, filenames.size() - first );
+			std::string query = "SELECT * FROM Media WHERE Filename IN (";
+			for ( size_t param = 1; param <= count; param++ ) {
+				query += "?" + std::to_string( param ) + ",";
+			}
+			query.back() = ')';
+			query += ";";
+			sqlite3_stmt* stmt = nullptr;
+			if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+				bool bound = true;
+				for ( size_t index = 0; bound && ( index < count ); index++ ) {
+					bound = ( SQLITE_OK == sqlite3_bind_text( stmt, static_cast<int>( 1 + index ) /*param*/, WideStringToUTF8( filenames[ first + index ] ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) );
+				}
+				if ( bound ) {
+					while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+						MediaInfo mediaInfo;
+						ExtractMediaInfo( stmt, mediaInfo );
+						mediaMap.insert( std::map<std::wstring,MediaInfo>::value_type( mediaInfo.GetFilename(), mediaInfo ) );
+					}
+				}
+				sqlite3_finalize( stmt );
+			}
+		}
+	}
+	return mediaMap;
+}
+
+void Library::AddToLibrary( const MediaInfo::List& mediaList )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( ( nullptr != database ) && !mediaList.empty() ) {
+		MediaInfo::List updatedMedia;
+		// The database connection is shared with other threads, so use a savepoint (rather than a transaction) in case a transaction is already open.
+		sqlite3_exec( database, "SAVEPOINT AddToLibrary;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+		for ( const auto& mediaInfo : mediaList ) {
+			if ( UpdateMediaLibrary( mediaInfo ) ) {
+				updatedMedia.push_back( mediaInfo );
+			}
+		}
+		sqlite3_exec( database, "RELEASE AddToLibrary;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+
+		VUPlayer* vuplayer = VUPlayer::Get();
+		if ( nullptr != vuplayer ) {
+			for ( const auto& mediaInfo : updatedMedia ) {
+				vuplayer->OnMediaUpdated( MediaInfo( mediaInfo.GetFilename() ) /*previousInfo*/, mediaInfo /*updatedInfo*/ );
+			}
+		}
+	}
+}
+
 bool Library::GetFileInfo( const std::wstring& filename, long long& lastModified, long long& fileSize ) const
 {
 	bool success = false;
@@ -297,7 +472,7 @@ bool Library::GetFileInfo( const std::wstring& filename, long long& lastModified
 bool Library::GetDecoderInfo( MediaInfo& mediaInfo )
 {
 	bool success = false;
-	Decoder::Ptr stream = m_Handlers.OpenDecoder( mediaInfo.GetFilename() );
+	Decoder::Ptr stream = m_Handlers.OpenDecoder( mediaInfo.GetFilename(), Decoder::Context::Temporary );
 	if ( stream ) {
 		mediaInfo.SetBitsPerSample( stream->GetBPS() );
 		mediaInfo.SetChannels( stream->GetChannels() );
@@ -1005,6 +1180,28 @@ MediaInfo::List Library::GetAllMedia()
 	return mediaList;
 }
 
+MediaInfo::List Library::GetMediaByFilter( const MediaFilter& filter )
+{
+	MediaInfo::List mediaList;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "SELECT * FROM Media WHERE " + filter.GetSQL() + " ORDER BY Filename;";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( filter.Bind( stmt ) ) {
+				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+					MediaInfo mediaInfo;
+					ExtractMediaInfo( stmt, mediaInfo );
+					mediaList.push_back( mediaInfo );
+				}
+			}
+			sqlite3_finalize( stmt );
+			stmt = nullptr;
+		}
+	}
+	return mediaList;
+}
+
 bool Library::GetArtistExists( const std::wstring& artist )
 {
 	bool exists = false;
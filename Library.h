@@ -6,6 +6,8 @@
 
 #include <vector>
 
+class MediaFilter;
+
 // Media library
 class Library
 {
@@ -43,6 +45,15 @@ public:
 		_Undefined
 	};
 
+	// Aggregate media statistics.
+	struct Statistics {
+		long Count;															// Number of items.
+		double Duration;												// Total duration, in seconds.
+		long long Filesize;											// Total file size, in bytes.
+		std::map<std::wstring,long> Types;			// Number of items by file type (extension).
+		std::map<long,long> SampleRates;				// Number of items by sample rate.
+	};
+
 	// Gets media information.
 	// 'mediaInfo' - in/out, media information containing the filename to query.
 	// 'checkFileAttributes' - whether to check if the time/size of the file matches any existing entry.
@@ -52,6 +63,30 @@ public:
 	// Returns true if media information was returned.
 	bool GetMediaInfo( MediaInfo& mediaInfo, const bool checkFileAttributes = true, const bool scanMedia = true, const bool sendNotification = true, const bool removeMissing = false );
 
+	// Gets media information, scanning the file if necessary, but without writing to the media library.
+	// 'mediaInfo' - in/out, media information containing the filename to query.
+	// 'scanned' - out, whether the file was scanned (in which case the media information should be passed to AddToLibrary).
+	// Returns true if media information was returned.
+	// This function can be called concurrently from multiple threads.
+	bool ScanMediaInfo( MediaInfo& mediaInfo, bool& scanned );
+
+	// Gets media information for a file which has already been looked up in the media library, scanning the file if necessary, but without writing to the media library.
+	// 'mediaInfo' - in/out, media information from the media library, or containing just the filename if the file was not found in the media library.
+	// 'inLibrary' - whether the 'mediaInfo' was found in the media library (in which case the file attributes are checked against the file).
+	// 'scanned' - out, whether the file was scanned (in which case the media information should be passed to AddToLibrary).
+	// Returns true if media information was returned.
+	// This function can be called concurrently from multiple threads.
+	bool ScanMediaInfo( MediaInfo& mediaInfo, const bool inLibrary, bool& scanned );
+
+	// Gets media information for multiple files from the media library, using as few queries as possible (files are neither checked nor scanned).
+	// 'filenames' - files to query.
+	// Returns the media information for each of the 'filenames' found in the media library, keyed by filename.
+	std::map<std::wstring,MediaInfo> GetMediaInfo( const std::vector<std::wstring>& filenames );
+
+	// Adds scanned media information to the media library in a single transaction, and notifies the main app of each update.
+	// 'mediaList' - scanned media information.
+	void AddToLibrary( const MediaInfo::List& mediaList );
+
 	// Updates media information and writes out tag information to file.
 	// 'previousMediaInfo' - previous media information.
 	// 'updatedMediaInfo' - updated media information.
@@ -100,6 +135,12 @@ public:
 	// Returns all media information contained in the media library.
 	MediaInfo::List GetAllMedia();
 
+	// Returns the media information matching the 'filter' contained in the media library.
+	MediaInfo::List GetMediaByFilter( const MediaFilter& filter );
+
+	// Returns the statistics for the whole media library, maintained by the database as media is added, updated & removed.
+	Statistics GetStatistics();
+
 	// Returns whether the 'artist' exists in the media library.
 	bool GetArtistExists( const std::wstring& artist );
 
@@ -150,6 +191,9 @@ private:
 	// Creates indices if necessary.
 	void CreateIndices();
 
+	// Updates the media statistics table, and the triggers which maintain it, if necessary.
+	void UpdateStatisticsTable();
+
 	// Gets the 'lastModified' time and 'fileSize' of 'filename', returning true if the file could be opened.
 	bool GetFileInfo( const std::wstring& filename, long long& lastModified, long long& fileSize ) const;
 
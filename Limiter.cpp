@@ -0,0 +1,212 @@
+#include "Limiter.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Maximum true peak level of the output (-1 dBTP).
+// This leaves a margin for the residual error of the 4x oversampled peak detection, and for the intersample peaks created by the gain changes themselves, so that full-band material (e.g. white noise) also stays below 0 dBTP.
+static const float s_Ceiling = 0.891f;
+
+// Look-ahead period, in seconds.
+static const float s_LookAhead = 0.0015f;
+
+// Number of interpolation filter taps for each oversampled phase (a multiple of 4).
+static const long s_Taps = 64;
+
+// Number of samples between the newest sample in the interpolation filter and the first oversampled phase.
+static const long s_FilterDelay = 32;
+
+// Kaiser window beta parameter for the interpolation filter (keeping the interpolation error within 0.01dB up to 0.45 of the sample rate).
+static const double s_KaiserBeta = 8.0;
+
+// Number of samples processed in one go (a multiple of 4).
+static const long s_BlockSize = 64;
+
+// Number of oversampled phases for each sample, the first of which is the sample itself.
+static const long s_Phases = 4;
+
+// Size of the interpolation filter input history for each channel (allowing four samples to be interpolated at once).
+static const long s_HistorySize = s_Taps - 1 + s_BlockSize + 3;
+
+// Returns the zeroth order modified Bessel function of the first kind, for 'x'.
+static double BesselI0( const double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	const double halfX = x / 2;
+	for ( int k = 1; k < 50; k++ ) {
+		term *= ( halfX / k ) * ( halfX / k );
+		sum += term;
+		if ( term < ( sum * 1e-12 ) ) {
+			break;
+		}
+	}
+	return sum;
+}
+
+Limiter::Limiter( const long sampleRate, const long channels, const float release ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_LookAhead( std::max( 1l, static_cast<long>( s_LookAhead * sampleRate ) ) ),
+	m_Latency( m_LookAhead - 1 + s_FilterDelay ),
+	m_ReleaseCoefficient( GetReleaseCoefficient( release ) ),
+	m_PendingRelease(),
+	m_Coefficients( ( s_Phases - 1 ) * s_Taps * 4 ),
+	m_History( static_cast<size_t>( channels * s_HistorySize ) ),
+	m_Peaks( s_BlockSize ),
+	m_Delay( static_cast<size_t>( channels * m_Latency ) ),
+	m_DelayPosition( 0 ),
+	m_HoldQueue( static_cast<size_t>( m_LookAhead + 1 ) ),
+	m_HoldFront( 0 ),
+	m_HoldCount( 0 ),
+	m_SmoothingValues( static_cast<size_t>( m_LookAhead ), 1.0f ),
+	m_SmoothingPosition( 0 ),
+	m_SmoothingSum( m_LookAhead ),
+	m_Gain( 1.0f ),
+	m_SamplePosition( 0 )
+{
+	// Kaiser windowed sinc interpolation for the oversampled phases between the samples (the first phase being the sample itself).
+	// Each coefficient is repeated four times, so that four consecutive samples can be interpolated at once.
+	const long centre = s_Taps - s_FilterDelay - 1;
+	const double halfWidth = s_Taps / 2.0;
+	const double besselBeta = BesselI0( s_KaiserBeta );
+	std::vector<double> coefficients( s_Taps );
+	for ( long phase = 1; phase < s_Phases; phase++ ) {
+		double total = 0;
+		for ( long tap = 0; tap < s_Taps; tap++ ) {
+			const double x = tap - centre - static_cast<double>( phase ) / s_Phases;
+			const double sinc = std::sin( M_PI * x ) / ( M_PI * x );
+			const double windowPos = x / halfWidth;
+			const double window = ( std::fabs( windowPos ) < 1.0 ) ? ( BesselI0( s_KaiserBeta * std::sqrt( 1.0 - windowPos * windowPos ) ) / besselBeta ) : 0.0;
+			coefficients[ tap ] = sinc * window;
+			total += coefficients[ tap ];
+		}
+		float* phaseCoefficients = m_Coefficients.data() + ( phase - 1 ) * s_Taps * 4;
+		for ( long tap = 0; tap < s_Taps; tap++ ) {
+			std::fill( phaseCoefficients + tap * 4, phaseCoefficients + tap * 4 + 4, static_cast<float>( coefficients[ tap ] / total ) );
+		}
+	}
+}
+
+Limiter::~Limiter()
+{
+}
+
+long Limiter::GetChannels() const
+{
+	return m_Channels;
+}
+
+long Limiter::GetLatency() const
+{
+	return m_Latency;
+}
+
+void Limiter::SetRelease( const float release )
+{
+	m_PendingRelease.Set( GetReleaseCoefficient( release ) );
+}
+
+float Limiter::GetReleaseCoefficient( const float release ) const
+{
+	const float coefficient = ( release > 0 ) ? static_cast<float>( 1.0 - std::exp( -1.0 / ( release * m_SampleRate ) ) ) : 1.0f;
+	return coefficient;
+}
+
+void Limiter::Process( float* buffer, const long sampleCount )
+{
+	m_PendingRelease.Get( m_ReleaseCoefficient );
+	const float releaseCoefficient = m_ReleaseCoefficient;
+	for ( long offset = 0; offset < sampleCount; offset += s_BlockSize ) {
+		const long count = std::min( s_BlockSize, sampleCount - offset );
+		float* samples = buffer + offset * m_Channels;
+		DetectPeaks( samples, count );
+		for ( long index = 0; index < count; index++ ) {
+			const float gain = GetGain( m_Peaks[ index ], releaseCoefficient );
+			float* delay = m_Delay.data() + m_DelayPosition * m_Channels;
+			for ( long channel = 0; channel < m_Channels; channel++ ) {
+				const float input = samples[ channel ];
+				samples[ channel ] = delay[ channel ] * gain;
+				delay[ channel ] = input;
+			}
+			if ( ++m_DelayPosition == m_Latency ) {
+				m_DelayPosition = 0;
+			}
+			samples += m_Channels;
+		}
+	}
+}
+
+void Limiter::DetectPeaks( const float* buffer, const long count )
+{
+	std::fill( m_Peaks.begin(), m_Peaks.end(), 0.0f );
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+	const long centre = s_Taps - s_FilterDelay - 1;
+	for ( long channel = 0; channel < m_Channels; channel++ ) {
+		float* history = m_History.data() + channel * s_HistorySize;
+		for ( long index = 0; index < count; index++ ) {
+			history[ s_Taps - 1 + index ] = buffer[ index * m_Channels + channel ];
+		}
+
+		// Four consecutive samples are interpolated at once for each phase, with separate sums to avoid a long dependency chain.
+		// Any samples beyond the end of the block are interpolated from stale history, and ignored.
+		for ( long index = 0; index < count; index += 4 ) {
+			const float* input = history + index;
+			__m128 peak = _mm_and_ps( _mm_loadu_ps( input + centre ), absMask );
+			for ( long phase = 1; phase < s_Phases; phase++ ) {
+				const float* coefficients = m_Coefficients.data() + ( phase - 1 ) * s_Taps * 4;
+				__m128 sum0 = _mm_setzero_ps();
+				__m128 sum1 = _mm_setzero_ps();
+				__m128 sum2 = _mm_setzero_ps();
+				__m128 sum3 = _mm_setzero_ps();
+				for ( long tap = 0; tap < s_Taps; tap += 4 ) {
+					sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( input + tap ), _mm_loadu_ps( coefficients + tap * 4 ) ) );
+					sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( input + tap + 1 ), _mm_loadu_ps( coefficients + tap * 4 + 4 ) ) );
+					sum2 = _mm_add_ps( sum2, _mm_mul_ps( _mm_loadu_ps( input + tap + 2 ), _mm_loadu_ps( coefficients + tap * 4 + 8 ) ) );
+					sum3 = _mm_add_ps( sum3, _mm_mul_ps( _mm_loadu_ps( input + tap + 3 ), _mm_loadu_ps( coefficients + tap * 4 + 12 ) ) );
+				}
+				const __m128 sum = _mm_add_ps( _mm_add_ps( sum0, sum1 ), _mm_add_ps( sum2, sum3 ) );
+				peak = _mm_max_ps( peak, _mm_and_ps( sum, absMask ) );
+			}
+			float* peaks = m_Peaks.data() + index;
+			_mm_storeu_ps( peaks, _mm_max_ps( _mm_loadu_ps( peaks ), peak ) );
+		}
+
+		std::copy( history + count, history + count + s_Taps - 1, history );
+	}
+}
+
+float Limiter::GetGain( const float peak, const float releaseCoefficient )
+{
+	// Hold the minimum required gain over the look-ahead period (plus one sample, as each peak lies between two samples).
+	const float required = ( peak > s_Ceiling ) ? ( s_Ceiling / peak ) : 1.0f;
+	const long holdSize = static_cast<long>( m_HoldQueue.size() );
+	while ( ( m_HoldCount > 0 ) && ( m_HoldQueue[ ( m_HoldFront + m_HoldCount - 1 ) % holdSize ].first >= required ) ) {
+		--m_HoldCount;
+	}
+	m_HoldQueue[ ( m_HoldFront + m_HoldCount ) % holdSize ] = { required, m_SamplePosition };
+	++m_HoldCount;
+	while ( m_HoldQueue[ m_HoldFront ].second < ( m_SamplePosition - m_LookAhead ) ) {
+		m_HoldFront = ( m_HoldFront + 1 ) % holdSize;
+		--m_HoldCount;
+	}
+	const float held = m_HoldQueue[ m_HoldFront ].first;
+
+	// Average the held gain over the look-ahead period, so that the gain reduction is fully applied by the time each peak is output.
+	m_SmoothingSum += held - m_SmoothingValues[ m_SmoothingPosition ];
+	m_SmoothingValues[ m_SmoothingPosition ] = held;
+	if ( ++m_SmoothingPosition == m_LookAhead ) {
+		m_SmoothingPosition = 0;
+	}
+	const float smoothed = static_cast<float>( m_SmoothingSum / m_LookAhead );
+
+	if ( smoothed < m_Gain ) {
+		m_Gain = smoothed;
+	} else {
+		m_Gain += ( smoothed - m_Gain ) * releaseCoefficient;
+	}
+	++m_SamplePosition;
+	return m_Gain;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "DSPNode.h"
+
+#include <memory>
+#include <vector>
+
+// Look-ahead brickwall limiter, which keeps the true peak level of sample data below a ceiling just under full scale.
+// True peaks are detected by 4x oversampling with a polyphase interpolation filter, processed using SIMD instructions.
+// The gain reduction ramps in over the look-ahead period ahead of each peak, and recovers over the release time afterwards.
+class Limiter : public DSPNode
+{
+public:
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	// 'release' - release time, in seconds.
+	Limiter( const long sampleRate, const long channels, const float release );
+
+	virtual ~Limiter();
+
+	// Limiter shared pointer type.
+	typedef std::shared_ptr<Limiter> Ptr;
+
+	// Returns the channel count.
+	long GetChannels() const override;
+
+	// Returns the number of samples by which the limited output is delayed.
+	long GetLatency() const override;
+
+	// Sets the 'release' time, in seconds.
+	void SetRelease( const float release );
+
+	// Limits 'sampleCount' samples of interleaved sample data in 'buffer' (the output is delayed by the latency).
+	void Process( float* buffer, const long sampleCount ) override;
+
+private:
+	// Detects the true peaks of the 'count' samples of interleaved sample data in 'buffer', storing the results in the peak buffer.
+	void DetectPeaks( const float* buffer, const long count );
+
+	// Returns the gain to apply to the next output sample, given the 'peak' level of the next input sample.
+	// 'releaseCoefficient' - fraction of the remaining gain difference to recover.
+	float GetGain( const float peak, const float releaseCoefficient );
+
+	// Returns the release coefficient for the 'release' time, in seconds.
+	float GetReleaseCoefficient( const float release ) const;
+
+	// Sample rate.
+	const long m_SampleRate;
+
+	// Channel count.
+	const long m_Channels;
+
+	// Look-ahead period, in samples.
+	const long m_LookAhead;
+
+	// Output delay, in samples.
+	const long m_Latency;
+
+	// Fraction of the remaining gain difference recovered at each sample.
+	float m_ReleaseCoefficient;
+
+	// Pending release coefficient.
+	DSPParameter<float> m_PendingRelease;
+
+	// Interpolation filter coefficients for each oversampled phase between the samples, with each coefficient repeated four times.
+	std::vector<float> m_Coefficients;
+
+	// Input history for the interpolation filter, for each channel.
+	std::vector<float> m_History;
+
+	// True peak levels of the current block of input samples, over all channels.
+	std::vector<float> m_Peaks;
+
+	// Interleaved delay line.
+	std::vector<float> m_Delay;
+
+	// Current delay line position.
+	long m_DelayPosition;
+
+	// Queue of ascending gain values (with their sample positions), for tracking the minimum required gain over the look-ahead period.
+	std::vector<std::pair<float,long long>> m_HoldQueue;
+
+	// Position of the front of the hold queue.
+	long m_HoldFront;
+
+	// Number of values in the hold queue.
+	long m_HoldCount;
+
+	// Held gain values over the look-ahead period, for smoothing.
+	std::vector<float> m_SmoothingValues;
+
+	// Current smoothing position.
+	long m_SmoothingPosition;
+
+	// Sum of the held gain values.
+	double m_SmoothingSum;
+
+	// Current gain.
+	float m_Gain;
+
+	// Number of samples processed.
+	long long m_SamplePosition;
+};
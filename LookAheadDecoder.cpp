@@ -0,0 +1,100 @@
+#include "LookAheadDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+LookAheadDecoder::LookAheadDecoder( const Decoder::Ptr decoder, const size_t blockCount, const long blockSize ) :
+	Decoder(),
+	m_Decoder( decoder ),
+	m_BlockSize( blockSize ),
+	m_Blocks( blockCount ),
+	m_FreeQueue(),
+	m_DecodedQueue(),
+	m_CurrentBlock( nullptr ),
+	m_Ended( false ),
+	m_DecodeThread()
+{
+	SetDuration( m_Decoder->GetDuration() );
+	SetSampleRate( m_Decoder->GetSampleRate() );
+	SetChannels( m_Decoder->GetChannels() );
+	SetBPS( m_Decoder->GetBPS() );
+	for ( auto& block : m_Blocks ) {
+		block.Samples.resize( static_cast<size_t>( m_BlockSize * GetChannels() ) );
+	}
+	Start();
+}
+
+LookAheadDecoder::~LookAheadDecoder()
+{
+	Stop();
+}
+
+void LookAheadDecoder::Start()
+{
+	// Queues cannot be reopened once closed or cancelled, so new queues are created each time decoding is started.
+	m_FreeQueue.reset( new SampleQueue( m_Blocks.size() ) );
+	m_DecodedQueue.reset( new SampleQueue( m_Blocks.size() ) );
+	for ( auto& block : m_Blocks ) {
+		block.Offset = 0;
+		block.Count = 0;
+		m_FreeQueue->Push( &block );
+	}
+	m_CurrentBlock = nullptr;
+	m_Ended = false;
+	m_DecodeThread = std::thread( &LookAheadDecoder::DecodeHandler, this );
+}
+
+void LookAheadDecoder::Stop()
+{
+	if ( m_DecodeThread.joinable() ) {
+		m_FreeQueue->Cancel();
+		m_DecodedQueue->Cancel();
+		m_DecodeThread.join();
+	}
+}
+
+void LookAheadDecoder::DecodeHandler()
+{
+	SampleQueue::Block* block = m_FreeQueue->Pop();
+	while ( nullptr != block ) {
+		block->Offset = 0;
+		block->Count = m_Decoder->Read( block->Samples.data(), m_BlockSize );
+		if ( block->Count <= 0 ) {
+			break;
+		}
+		block = m_DecodedQueue->Push( block ) ? m_FreeQueue->Pop() : nullptr;
+	}
+	m_DecodedQueue->Close();
+}
+
+long LookAheadDecoder::Read( float* buffer, const long sampleCount )
+{
+	const long channels = GetChannels();
+	long samplesRead = 0;
+	while ( !m_Ended && ( samplesRead < sampleCount ) ) {
+		if ( nullptr == m_CurrentBlock ) {
+			m_CurrentBlock = m_DecodedQueue->Pop();
+			m_Ended = ( nullptr == m_CurrentBlock );
+		}
+		if ( nullptr != m_CurrentBlock ) {
+			// The block offset is used to hold the number of samples already read from the block.
+			const long count = ( std::min )( sampleCount - samplesRead, m_CurrentBlock->Count - m_CurrentBlock->Offset );
+			std::memcpy( buffer + samplesRead * channels, m_CurrentBlock->Samples.data() + m_CurrentBlock->Offset * channels, static_cast<size_t>( count * channels ) * sizeof( float ) );
+			samplesRead += count;
+			m_CurrentBlock->Offset += count;
+			if ( m_CurrentBlock->Offset == m_CurrentBlock->Count ) {
+				m_FreeQueue->Push( m_CurrentBlock );
+				m_CurrentBlock = nullptr;
+			}
+		}
+	}
+	return samplesRead;
+}
+
+float LookAheadDecoder::Seek( const float position )
+{
+	Stop();
+	const float newPosition = m_Decoder->Seek( position );
+	Start();
+	return newPosition;
+}
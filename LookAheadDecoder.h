@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Decoder.h"
+#include "SampleQueue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Decodes ahead of the reader on a background thread, holding the decoded sample data in a bounded queue of blocks.
+// This allows the (possibly expensive) decoding and conversion of an upcoming track to run in parallel with the processing of the current track.
+class LookAheadDecoder : public Decoder
+{
+public:
+	// 'decoder' - the decoder to read ahead from.
+	// 'blockCount' - maximum number of blocks to decode ahead of the reader.
+	// 'blockSize' - number of samples in each block.
+	LookAheadDecoder( const Decoder::Ptr decoder, const size_t blockCount, const long blockSize );
+
+	virtual ~LookAheadDecoder();
+
+	// Reads sample data.
+	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
+	// 'sampleCount' - number of samples to read.
+	// Returns the number of samples read, or zero if the stream has ended.
+	long Read( float* buffer, const long sampleCount ) override;
+
+	// Seeks to a 'position' in the stream, in seconds.
+	// Returns the new position in seconds.
+	float Seek( const float position ) override;
+
+private:
+	// Starts decoding ahead.
+	void Start();
+
+	// Stops decoding ahead, discarding any decoded sample data.
+	void Stop();
+
+	// Decode thread handler.
+	void DecodeHandler();
+
+	// The decoder to read ahead from.
+	Decoder::Ptr m_Decoder;
+
+	// Number of samples in each block.
+	const long m_BlockSize;
+
+	// Sample blocks.
+	std::vector<SampleQueue::Block> m_Blocks;
+
+	// Blocks available to the decode thread.
+	std::unique_ptr<SampleQueue> m_FreeQueue;
+
+	// Blocks of decoded sample data, available to the reader.
+	std::unique_ptr<SampleQueue> m_DecodedQueue;
+
+	// The block currently being read from, or nullptr if a block needs to be fetched from the decoded queue.
+	SampleQueue::Block* m_CurrentBlock;
+
+	// Indicates whether the decode thread has reached the end of the stream (and the decoded queue has been drained).
+	bool m_Ended;
+
+	// Decode thread.
+	std::thread m_DecodeThread;
+};
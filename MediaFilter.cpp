@@ -0,0 +1,422 @@
+#include "MediaFilter.h"
+
+#include "Utility.h"
+
+#include <cmath>
+#include <map>
+#include <sstream>
+
+// Maps a filterable library column to its name, and whether it is a text column.
+static const std::map<Library::Column,std::pair<std::string,bool>> s_FilterColumns = {
+	{ Library::Column::Filename,			{ "Filename", true } },
+	{ Library::Column::Filetime,			{ "Filetime", false } },
+	{ Library::Column::Filesize,			{ "Filesize", false } },
+	{ Library::Column::Duration,			{ "Duration", false } },
+	{ Library::Column::SampleRate,		{ "SampleRate", false } },
+	{ Library::Column::BitsPerSample,	{ "BitsPerSample", false } },
+	{ Library::Column::Channels,			{ "Channels", false } },
+	{ Library::Column::Artist,				{ "Artist", true } },
+	{ Library::Column::Title,					{ "Title", true } },
+	{ Library::Column::Album,					{ "Album", true } },
+	{ Library::Column::Genre,					{ "Genre", true } },
+	{ Library::Column::Year,					{ "Year", false } },
+	{ Library::Column::Comment,				{ "Comment", true } },
+	{ Library::Column::Track,					{ "Track", false } },
+	{ Library::Column::Version,				{ "Version", true } },
+	{ Library::Column::GainTrack,			{ "GainTrack", false } },
+	{ Library::Column::GainAlbum,			{ "GainAlbum", false } }
+};
+
+// Maps a comparison operator to its SQL (and filter expression) representation.
+static const std::map<MediaFilter::Operator,std::string> s_FilterOperators = {
+	{ MediaFilter::Operator::Equal,					"=" },
+	{ MediaFilter::Operator::NotEqual,			"!=" },
+	{ MediaFilter::Operator::Less,					"<" },
+	{ MediaFilter::Operator::LessEqual,			"<=" },
+	{ MediaFilter::Operator::Greater,				">" },
+	{ MediaFilter::Operator::GreaterEqual,	">=" }
+};
+
+// Returns the result of comparing 'value1' with 'value2' using 'op'.
+template<typename T>
+static bool Compare( const T& value1, const MediaFilter::Operator op, const T& value2 )
+{
+	bool result = false;
+	switch ( op ) {
+		case MediaFilter::Operator::Equal : {
+			result = ( value1 == value2 );
+			break;
+		}
+		case MediaFilter::Operator::NotEqual : {
+			result = ( value1 != value2 );
+			break;
+		}
+		case MediaFilter::Operator::Less : {
+			result = ( value1 < value2 );
+			break;
+		}
+		case MediaFilter::Operator::LessEqual : {
+			result = ( value1 <= value2 );
+			break;
+		}
+		case MediaFilter::Operator::Greater : {
+			result = ( value1 > value2 );
+			break;
+		}
+		case MediaFilter::Operator::GreaterEqual : {
+			result = ( value1 >= value2 );
+			break;
+		}
+	}
+	return result;
+}
+
+MediaFilter::MediaFilter() :
+	m_Groups()
+{
+}
+
+MediaFilter::~MediaFilter()
+{
+}
+
+MediaFilter::Ptr MediaFilter::Parse( const std::wstring& expression )
+{
+	Ptr filter = std::make_shared<MediaFilter>();
+	const size_t length = expression.size();
+	size_t pos = 0;
+
+	auto skipWhitespace = [ &expression, &pos, length ] ()
+	{
+		while ( ( pos < length ) && iswspace( expression[ pos ] ) ) {
+			++pos;
+		}
+	};
+
+	bool expectCondition = true;
+	skipWhitespace();
+	while ( pos < length ) {
+		if ( expectCondition ) {
+			// Column name.
+			const size_t nameStart = pos;
+			while ( ( pos < length ) && iswalnum( expression[ pos ] ) ) {
+				++pos;
+			}
+			const std::string name = WideStringToUTF8( expression.substr( nameStart, pos - nameStart ) );
+			const auto column = std::find_if( s_FilterColumns.begin(), s_FilterColumns.end(), [ &name ] ( const auto& entry )
+			{
+				return ( 0 == _stricmp( entry.second.first.c_str(), name.c_str() ) );
+			} );
+			if ( s_FilterColumns.end() == column ) {
+				return nullptr;
+			}
+
+			// Operator.
+			skipWhitespace();
+			std::wstring opText;
+			while ( ( pos < length ) && ( nullptr != wcschr( L"=!<>", expression[ pos ] ) ) ) {
+				opText += expression[ pos++ ];
+			}
+			Operator op = Operator::Equal;
+			if ( ( L"=" == opText ) || ( L"==" == opText ) ) {
+				op = Operator::Equal;
+			} else if ( ( L"!=" == opText ) || ( L"<>" == opText ) ) {
+				op = Operator::NotEqual;
+			} else if ( L"<" == opText ) {
+				op = Operator::Less;
+			} else if ( L"<=" == opText ) {
+				op = Operator::LessEqual;
+			} else if ( L">" == opText ) {
+				op = Operator::Greater;
+			} else if ( L">=" == opText ) {
+				op = Operator::GreaterEqual;
+			} else {
+				return nullptr;
+			}
+
+			// Value, which is either quoted (with embedded quotes doubled up) or runs to the next whitespace.
+			skipWhitespace();
+			std::wstring value;
+			if ( ( pos < length ) && ( '"' == expression[ pos ] ) ) {
+				bool closed = false;
+				++pos;
+				while ( ( pos < length ) && !closed ) {
+					if ( '"' == expression[ pos ] ) {
+						if ( ( ( pos + 1 ) < length ) && ( '"' == expression[ pos + 1 ] ) ) {
+							value += '"';
+							pos += 2;
+						} else {
+							closed = true;
+							++pos;
+						}
+					} else {
+						value += expression[ pos++ ];
+					}
+				}
+				if ( !closed ) {
+					return nullptr;
+				}
+			} else {
+				while ( ( pos < length ) && !iswspace( expression[ pos ] ) ) {
+					value += expression[ pos++ ];
+				}
+			}
+
+			const bool isText = column->second.second;
+			if ( isText ) {
+				filter->AddCondition( column->first, op, value );
+			} else {
+				try {
+					size_t converted = 0;
+					const double number = std::stod( value, &converted );
+					if ( converted != value.size() ) {
+						return nullptr;
+					}
+					filter->AddCondition( column->first, op, number );
+				} catch ( ... ) {
+					return nullptr;
+				}
+			}
+			expectCondition = false;
+		} else {
+			// Logical operator.
+			const size_t keywordStart = pos;
+			while ( ( pos < length ) && iswalpha( expression[ pos ] ) ) {
+				++pos;
+			}
+			const std::wstring keyword = WideStringToUpper( expression.substr( keywordStart, pos - keywordStart ) );
+			if ( L"OR" == keyword ) {
+				filter->AddOr();
+			} else if ( L"AND" != keyword ) {
+				return nullptr;
+			}
+			expectCondition = true;
+		}
+		skipWhitespace();
+	}
+	if ( expectCondition && !filter->IsEmpty() ) {
+		// Dangling logical operator.
+		return nullptr;
+	}
+	return filter;
+}
+
+bool MediaFilter::GetColumnType( const Library::Column column, bool& isText )
+{
+	const auto iter = s_FilterColumns.find( column );
+	const bool valid = ( s_FilterColumns.end() != iter );
+	isText = valid && iter->second.second;
+	return valid;
+}
+
+bool MediaFilter::AddCondition( const Library::Column column, const Operator op, const std::wstring& value )
+{
+	bool isText = false;
+	const bool added = GetColumnType( column, isText ) && isText;
+	if ( added ) {
+		if ( m_Groups.empty() ) {
+			m_Groups.push_back( Conditions() );
+		}
+		m_Groups.back().push_back( { column, op, value, 0 } );
+	}
+	return added;
+}
+
+bool MediaFilter::AddCondition( const Library::Column column, const Operator op, const double value )
+{
+	bool isText = false;
+	const bool added = GetColumnType( column, isText ) && !isText;
+	if ( added ) {
+		if ( m_Groups.empty() ) {
+			m_Groups.push_back( Conditions() );
+		}
+		m_Groups.back().push_back( { column, op, std::wstring(), value } );
+	}
+	return added;
+}
+
+void MediaFilter::AddOr()
+{
+	if ( !m_Groups.empty() && !m_Groups.back().empty() ) {
+		m_Groups.push_back( Conditions() );
+	}
+}
+
+bool MediaFilter::IsEmpty() const
+{
+	return m_Groups.empty() || m_Groups.front().empty();
+}
+
+bool MediaFilter::Matches( const MediaInfo& mediaInfo ) const
+{
+	bool matches = IsEmpty();
+	for ( auto group = m_Groups.begin(); !matches && ( m_Groups.end() != group ); group++ ) {
+		if ( !group->empty() ) {
+			matches = true;
+			for ( auto condition = group->begin(); matches && ( group->end() != condition ); condition++ ) {
+				matches = Matches( mediaInfo, *condition );
+			}
+		}
+	}
+	return matches;
+}
+
+bool MediaFilter::Matches( const MediaInfo& mediaInfo, const Condition& condition )
+{
+	bool matches = false;
+	switch ( condition.Column ) {
+		case Library::Column::Filename : {
+			matches = Compare( mediaInfo.GetFilename(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Artist : {
+			matches = Compare( mediaInfo.GetArtist(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Title : {
+			matches = Compare( mediaInfo.GetTitle(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Album : {
+			matches = Compare( mediaInfo.GetAlbum(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Genre : {
+			matches = Compare( mediaInfo.GetGenre(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Comment : {
+			matches = Compare( mediaInfo.GetComment(), condition.Op, condition.Text );
+			break;
+		}
+		case Library::Column::Version : {
+			matches = Compare( mediaInfo.GetVersion(), condition.Op, condition.Text );
+			break;
+		}
+		default : {
+			double value = NAN;
+			switch ( condition.Column ) {
+				case Library::Column::Filetime : {
+					value = static_cast<double>( mediaInfo.GetFiletime() );
+					break;
+				}
+				case Library::Column::Filesize : {
+					value = static_cast<double>( mediaInfo.GetFilesize() );
+					break;
+				}
+				case Library::Column::Duration : {
+					value = mediaInfo.GetDuration();
+					break;
+				}
+				case Library::Column::SampleRate : {
+					value = mediaInfo.GetSampleRate();
+					break;
+				}
+				case Library::Column::BitsPerSample : {
+					value = mediaInfo.GetBitsPerSample();
+					break;
+				}
+				case Library::Column::Channels : {
+					value = mediaInfo.GetChannels();
+					break;
+				}
+				case Library::Column::Year : {
+					value = mediaInfo.GetYear();
+					break;
+				}
+				case Library::Column::Track : {
+					value = mediaInfo.GetTrack();
+					break;
+				}
+				case Library::Column::GainTrack : {
+					value = mediaInfo.GetGainTrack();
+					break;
+				}
+				case Library::Column::GainAlbum : {
+					value = mediaInfo.GetGainAlbum();
+					break;
+				}
+				default : {
+					break;
+				}
+			}
+			// Missing values (stored as NULL in the media library) never match, consistent with SQL comparison semantics.
+			matches = !std::isnan( value ) && Compare( value, condition.Op, condition.Number );
+			break;
+		}
+	}
+	return matches;
+}
+
+std::string MediaFilter::GetSQL() const
+{
+	std::string sql;
+	int param = 0;
+	for ( const auto& group : m_Groups ) {
+		if ( !group.empty() ) {
+			std::string groupSQL;
+			for ( const auto& condition : group ) {
+				if ( !groupSQL.empty() ) {
+					groupSQL += " AND ";
+				}
+				groupSQL += s_FilterColumns.at( condition.Column ).first + s_FilterOperators.at( condition.Op ) + "?" + std::to_string( ++param );
+			}
+			if ( !sql.empty() ) {
+				sql += " OR ";
+			}
+			sql += "(" + groupSQL + ")";
+		}
+	}
+	if ( sql.empty() ) {
+		sql = "1";
+	}
+	return sql;
+}
+
+bool MediaFilter::Bind( sqlite3_stmt* stmt ) const
+{
+	bool success = ( nullptr != stmt );
+	int param = 0;
+	for ( auto group = m_Groups.begin(); success && ( m_Groups.end() != group ); group++ ) {
+		for ( auto condition = group->begin(); success && ( group->end() != condition ); condition++ ) {
+			bool isText = false;
+			GetColumnType( condition->Column, isText );
+			success = isText ?
+				( SQLITE_OK == sqlite3_bind_text( stmt, ++param, WideStringToUTF8( condition->Text ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT ) ) :
+				( SQLITE_OK == sqlite3_bind_double( stmt, ++param, condition->Number ) );
+		}
+	}
+	return success;
+}
+
+std::wstring MediaFilter::GetExpression() const
+{
+	std::wstring expression;
+	for ( const auto& group : m_Groups ) {
+		if ( !group.empty() ) {
+			std::wstring groupExpression;
+			for ( const auto& condition : group ) {
+				if ( !groupExpression.empty() ) {
+					groupExpression += L" AND ";
+				}
+				groupExpression += UTF8ToWideString( s_FilterColumns.at( condition.Column ).first + s_FilterOperators.at( condition.Op ) );
+				bool isText = false;
+				GetColumnType( condition.Column, isText );
+				if ( isText ) {
+					std::wstring value = condition.Text;
+					WideStringReplace( value, L"\"", L"\"\"" );
+					groupExpression += L"\"" + value + L"\"";
+				} else {
+					std::wstringstream stream;
+					stream << condition.Number;
+					groupExpression += stream.str();
+				}
+			}
+			if ( !expression.empty() ) {
+				expression += L" OR ";
+			}
+			expression += groupExpression;
+		}
+	}
+	return expression;
+}
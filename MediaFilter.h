@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Library.h"
+
+#include <list>
+#include <memory>
+#include <string>
+
+// Media filter, a predicate over media library columns, used to define smart playlists.
+// A filter can be evaluated in memory against media information, or compiled to SQL to query the media library.
+// Filter expressions consist of conditions joined by AND/OR (AND taking precedence), e.g. 'Genre=Jazz AND Year>=1990 AND Duration<600'.
+// Each condition compares a column with a value using one of: = != < <= > >=
+// Text values containing spaces or operators should be quoted, e.g. 'Artist="Miles Davis"'.
+class MediaFilter
+{
+public:
+	// Media filter shared pointer type.
+	typedef std::shared_ptr<MediaFilter> Ptr;
+
+	// Comparison operator.
+	enum class Operator {
+		Equal,
+		NotEqual,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual
+	};
+
+	// Creates an empty filter, which matches all media.
+	MediaFilter();
+
+	virtual ~MediaFilter();
+
+	// Parses a filter 'expression'.
+	// Returns the filter, or nullptr if the expression is not valid.
+	static Ptr Parse( const std::wstring& expression );
+
+	// Adds a text condition, which is ANDed with the preceding conditions.
+	// 'column' - library column.
+	// 'op' - comparison operator.
+	// 'value' - value to compare against.
+	// Returns false if the column is not a text column that can be filtered.
+	bool AddCondition( const Library::Column column, const Operator op, const std::wstring& value );
+
+	// Adds a numeric condition, which is ANDed with the preceding conditions.
+	// 'column' - library column.
+	// 'op' - comparison operator.
+	// 'value' - value to compare against.
+	// Returns false if the column is not a numeric column that can be filtered.
+	bool AddCondition( const Library::Column column, const Operator op, const double value );
+
+	// Starts a new group of conditions, which is ORed with the preceding groups.
+	void AddOr();
+
+	// Returns whether the filter has no conditions (and so matches all media).
+	bool IsEmpty() const;
+
+	// Returns whether the 'mediaInfo' matches the filter.
+	bool Matches( const MediaInfo& mediaInfo ) const;
+
+	// Returns the SQL expression for the filter, suitable for use in a WHERE clause, with parameters numbered from 1.
+	std::string GetSQL() const;
+
+	// Binds the filter parameters to a SQLite 'stmt' prepared from a query containing the GetSQL expression.
+	// Returns true if all parameters were bound.
+	bool Bind( sqlite3_stmt* stmt ) const;
+
+	// Returns the filter expression.
+	std::wstring GetExpression() const;
+
+private:
+	// Filter condition.
+	struct Condition {
+		Library::Column Column;	// Library column.
+		Operator Op;						// Comparison operator.
+		std::wstring Text;			// Text value (for text columns).
+		double Number;					// Numeric value (for numeric columns).
+	};
+
+	// A group of conditions which must all match.
+	typedef std::list<Condition> Conditions;
+
+	// Groups of conditions, any of which must match.
+	typedef std::list<Conditions> Groups;
+
+	// Returns whether a 'column' can be filtered, and whether it is a text column.
+	static bool GetColumnType( const Library::Column column, bool& isText );
+
+	// Returns whether the 'mediaInfo' matches a 'condition'.
+	static bool Matches( const MediaInfo& mediaInfo, const Condition& condition );
+
+	// Condition groups.
+	Groups m_Groups;
+};
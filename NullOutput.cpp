@@ -0,0 +1,81 @@
+#include "NullOutput.h"
+
+#include <chrono>
+#include <vector>
+
+// Number of samples read from the decoder at a time.
+static const long s_BlockSize = 1024;
+
+NullOutput::NullOutput() :
+	m_Thread(),
+	m_Stop( false ),
+	m_Playing( false ),
+	m_SamplesPlayed( 0 ),
+	m_SampleRate( 0 )
+{
+}
+
+NullOutput::~NullOutput()
+{
+	Stop();
+}
+
+bool NullOutput::Play( const Decoder::Ptr decoder, const DSPChain::Ptr dspChain, const bool realtime )
+{
+	Stop();
+	const bool success = decoder && ( decoder->GetChannels() > 0 ) && ( decoder->GetSampleRate() > 0 ) && ( !dspChain || ( dspChain->GetChannels() == decoder->GetChannels() ) );
+	if ( success ) {
+		m_Stop = false;
+		m_Playing = true;
+		m_SamplesPlayed = 0;
+		m_SampleRate = decoder->GetSampleRate();
+		m_Thread = std::thread( &NullOutput::PlaybackHandler, this, decoder, dspChain, realtime );
+	}
+	return success;
+}
+
+void NullOutput::Stop()
+{
+	m_Stop = true;
+	Wait();
+}
+
+void NullOutput::Wait()
+{
+	if ( m_Thread.joinable() ) {
+		m_Thread.join();
+	}
+}
+
+bool NullOutput::IsPlaying() const
+{
+	return m_Playing;
+}
+
+float NullOutput::GetPosition() const
+{
+	const long sampleRate = m_SampleRate;
+	const float position = ( sampleRate > 0 ) ? ( static_cast<float>( m_SamplesPlayed ) / sampleRate ) : 0;
+	return position;
+}
+
+void NullOutput::PlaybackHandler( const Decoder::Ptr decoder, const DSPChain::Ptr dspChain, const bool realtime )
+{
+	const long sampleRate = decoder->GetSampleRate();
+	std::vector<float> buffer( static_cast<size_t>( s_BlockSize * decoder->GetChannels() ) );
+	const auto startTime = std::chrono::steady_clock::now();
+	long long samplesPlayed = 0;
+	long samplesRead = m_Stop ? 0 : decoder->Read( buffer.data(), s_BlockSize );
+	while ( samplesRead > 0 ) {
+		if ( dspChain ) {
+			dspChain->Process( buffer.data(), samplesRead );
+		}
+		samplesPlayed += samplesRead;
+		m_SamplesPlayed = samplesPlayed;
+		if ( realtime ) {
+			std::this_thread::sleep_until( startTime + std::chrono::microseconds( samplesPlayed * 1000000 / sampleRate ) );
+		}
+		samplesRead = m_Stop ? 0 : decoder->Read( buffer.data(), s_BlockSize );
+	}
+	m_Playing = false;
+}
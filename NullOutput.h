@@ -0,0 +1,60 @@
+#pragma once
+
+#include "DSPChain.h"
+#include "Decoder.h"
+
+#include <atomic>
+#include <thread>
+
+// Playback backend without an audio device, used by the portable core where BASS output is not available.
+// Sample data is read from the decoder and passed through the DSP chain, then discarded.
+class NullOutput
+{
+public:
+	NullOutput();
+
+	virtual ~NullOutput();
+
+	NullOutput( const NullOutput& ) = delete;
+	NullOutput& operator=( const NullOutput& ) = delete;
+
+	// Starts playing the 'decoder', stopping any current playback.
+	// 'dspChain' - DSP chain through which sample data is passed, or nullptr.
+	// 'realtime' - true to consume sample data at the rate it would be played, false to consume it as fast as possible.
+	// Returns true if playback started.
+	bool Play( const Decoder::Ptr decoder, const DSPChain::Ptr dspChain, const bool realtime );
+
+	// Stops playback.
+	void Stop();
+
+	// Waits for playback to finish.
+	void Wait();
+
+	// Returns whether playback is in progress.
+	bool IsPlaying() const;
+
+	// Returns the playback position, in seconds.
+	float GetPosition() const;
+
+private:
+	// Playback thread handler.
+	// 'decoder' - decoder to play.
+	// 'dspChain' - DSP chain through which sample data is passed, or nullptr.
+	// 'realtime' - true to consume sample data at the rate it would be played.
+	void PlaybackHandler( const Decoder::Ptr decoder, const DSPChain::Ptr dspChain, const bool realtime );
+
+	// Playback thread.
+	std::thread m_Thread;
+
+	// Indicates that playback is to stop.
+	std::atomic<bool> m_Stop;
+
+	// Indicates whether playback is in progress.
+	std::atomic<bool> m_Playing;
+
+	// Number of samples played.
+	std::atomic<long long> m_SamplesPlayed;
+
+	// Sample rate of the current decoder.
+	std::atomic<long> m_SampleRate;
+};
@@ -13,6 +13,21 @@ std::vector<std::pair<Settings::OutputMode,int>> OptionsGeneral::s_OutputModes =
 	std::make_pair( Settings::OutputMode::ASIO, IDS_OPTIONS_MODE_ASIO )
 };
 
+std::vector<std::pair<Settings::DitherMode,int>> OptionsGeneral::s_DitherModes = {
+	std::make_pair( Settings::DitherMode::None, IDS_DITHER_NONE ),
+	std::make_pair( Settings::DitherMode::Triangular, IDS_DITHER_TRIANGULAR ),
+	std::make_pair( Settings::DitherMode::NoiseShaped, IDS_DITHER_SHAPED ),
+	std::make_pair( Settings::DitherMode::WeightedNoiseShaped, IDS_DITHER_WEIGHTED )
+};
+
+std::vector<std::pair<Settings::ResampleMode,int>> OptionsGeneral::s_ResampleModes = {
+	std::make_pair( Settings::ResampleMode::Never, IDS_RESAMPLE_NEVER ),
+	std::make_pair( Settings::ResampleMode::WhenNeeded, IDS_RESAMPLE_WHENNEEDED ),
+	std::make_pair( Settings::ResampleMode::Always, IDS_RESAMPLE_ALWAYS )
+};
+
+std::vector<long> OptionsGeneral::s_ResampleRates = { 44100, 48000, 88200, 96000, 176400, 192000 };
+
 OptionsGeneral::OptionsGeneral( HINSTANCE instance, Settings& settings, Output& output ) :
 	Options( instance, settings, output )
 {
@@ -54,6 +69,55 @@ void OptionsGeneral::OnInit( const HWND hwnd )
 	}
 	RefreshOutputDeviceList( hwnd );
 
+	HWND hwndDither = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_DITHER );
+	if ( nullptr != hwndDither ) {
+		const Settings::DitherMode ditherMode = GetSettings().GetDitherMode();
+		const int bufferSize = MAX_PATH;
+		WCHAR buffer[ bufferSize ];
+		const HINSTANCE instance = GetInstanceHandle();
+		for ( const auto& mode : s_DitherModes ) {
+			LoadString( instance, mode.second, buffer, bufferSize );
+			ComboBox_AddString( hwndDither, buffer );
+			ComboBox_SetItemData( hwndDither, ComboBox_GetCount( hwndDither ) - 1, static_cast<LPARAM>( mode.first ) );
+			if ( mode.first == ditherMode ) {
+				ComboBox_SetCurSel( hwndDither, ComboBox_GetCount( hwndDither ) - 1 );
+			}
+		}
+	}
+
+	// Resample settings
+	Settings::ResampleMode resampleMode = Settings::ResampleMode::WhenNeeded;
+	long resampleRate = 0;
+	GetSettings().GetResampleSettings( resampleMode, resampleRate );
+	HWND hwndResample = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLE );
+	if ( nullptr != hwndResample ) {
+		const int bufferSize = MAX_PATH;
+		WCHAR buffer[ bufferSize ];
+		const HINSTANCE instance = GetInstanceHandle();
+		for ( const auto& mode : s_ResampleModes ) {
+			LoadString( instance, mode.second, buffer, bufferSize );
+			ComboBox_AddString( hwndResample, buffer );
+			ComboBox_SetItemData( hwndResample, ComboBox_GetCount( hwndResample ) - 1, static_cast<LPARAM>( mode.first ) );
+			if ( mode.first == resampleMode ) {
+				ComboBox_SetCurSel( hwndResample, ComboBox_GetCount( hwndResample ) - 1 );
+			}
+		}
+	}
+	HWND hwndResampleRate = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLERATE );
+	if ( nullptr != hwndResampleRate ) {
+		for ( const auto& rate : s_ResampleRates ) {
+			ComboBox_AddString( hwndResampleRate, std::to_wstring( rate ).c_str() );
+			ComboBox_SetItemData( hwndResampleRate, ComboBox_GetCount( hwndResampleRate ) - 1, static_cast<LPARAM>( rate ) );
+			if ( rate == resampleRate ) {
+				ComboBox_SetCurSel( hwndResampleRate, ComboBox_GetCount( hwndResampleRate ) - 1 );
+			}
+		}
+		if ( -1 == ComboBox_GetCurSel( hwndResampleRate ) ) {
+			ComboBox_SetCurSel( hwndResampleRate, 1 );
+		}
+	}
+	RefreshResampleRate( hwnd );
+
 	// Miscellaneous settings
 	VUPlayer* vuplayer = VUPlayer::Get();
 
@@ -122,6 +186,23 @@ void OptionsGeneral::OnSave( const HWND hwnd )
 	const std::wstring device = GetSelectedDeviceName( hwnd );
 	GetSettings().SetOutputSettings( device, mode );
 
+	const HWND hwndDither = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_DITHER );
+	const int ditherIndex = ComboBox_GetCurSel( hwndDither );
+	if ( -1 != ditherIndex ) {
+		GetSettings().SetDitherMode( static_cast<Settings::DitherMode>( ComboBox_GetItemData( hwndDither, ditherIndex ) ) );
+	}
+
+	// Resample settings
+	const HWND hwndResample = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLE );
+	const HWND hwndResampleRate = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLERATE );
+	const int resampleIndex = ComboBox_GetCurSel( hwndResample );
+	const int resampleRateIndex = ComboBox_GetCurSel( hwndResampleRate );
+	if ( ( -1 != resampleIndex ) && ( -1 != resampleRateIndex ) ) {
+		const Settings::ResampleMode resampleMode = static_cast<Settings::ResampleMode>( ComboBox_GetItemData( hwndResample, resampleIndex ) );
+		const long resampleRate = static_cast<long>( ComboBox_GetItemData( hwndResampleRate, resampleRateIndex ) );
+		GetSettings().SetResampleSettings( resampleMode, resampleRate );
+	}
+
 	// Miscellaneous settings
 	const bool mergeDuplicates = ( BST_CHECKED == Button_GetCheck( GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_HIDEDUPLICATES ) ) );
 	GetSettings().SetMergeDuplicates( mergeDuplicates );
@@ -143,6 +224,8 @@ void OptionsGeneral::OnCommand( const HWND hwnd, const WPARAM wParam, const LPAR
 	if ( CBN_SELCHANGE == notificationCode ) {
 		if ( IDC_OPTIONS_GENERAL_MODE == controlID ) {
 			RefreshOutputDeviceList( hwnd );
+		} else if ( IDC_OPTIONS_GENERAL_RESAMPLE == controlID ) {
+			RefreshResampleRate( hwnd );
 		}
 	} else if ( ( BN_CLICKED == notificationCode ) && ( IDC_OPTIONS_MODE_ADVANCED == controlID ) ) {
 		const Settings::OutputMode mode = GetSelectedMode( hwnd );
@@ -255,3 +338,14 @@ std::wstring OptionsGeneral::GetSelectedDeviceName( const HWND hwnd ) const
 	}
 	return device;
 }
+
+void OptionsGeneral::RefreshResampleRate( const HWND hwnd )
+{
+	const HWND hwndResample = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLE );
+	const HWND hwndResampleRate = GetDlgItem( hwnd, IDC_OPTIONS_GENERAL_RESAMPLERATE );
+	if ( ( nullptr != hwndResample ) && ( nullptr != hwndResampleRate ) ) {
+		const int resampleIndex = ComboBox_GetCurSel( hwndResample );
+		const bool enable = ( -1 != resampleIndex ) && ( Settings::ResampleMode::Always == static_cast<Settings::ResampleMode>( ComboBox_GetItemData( hwndResample, resampleIndex ) ) );
+		EnableWindow( hwndResampleRate, enable ? TRUE : FALSE );
+	}
+}
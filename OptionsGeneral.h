@@ -43,6 +43,19 @@ private:
 	// Returns the currently selected device name.
 	std::wstring GetSelectedDeviceName( const HWND hwnd ) const;
 
+	// Enables the resample rate control if the currently selected resample mode uses it.
+	// 'hwnd' - dialog window handle.
+	void RefreshResampleRate( const HWND hwnd );
+
 	// Available output modes, paired with the resource ID of the description.
 	static std::vector<std::pair<Settings::OutputMode,int>> s_OutputModes;
+
+	// Available dither modes, paired with the resource ID of the description.
+	static std::vector<std::pair<Settings::DitherMode,int>> s_DitherModes;
+
+	// Available resample modes, paired with the resource ID of the description.
+	static std::vector<std::pair<Settings::ResampleMode,int>> s_ResampleModes;
+
+	// Available resample rates.
+	static std::vector<long> s_ResampleRates;
 };
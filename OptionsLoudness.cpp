@@ -26,6 +26,19 @@ static const std::map<int,int> sPreampValues = {
 	{ 18, -6 }
 };
 
+// Maps an index to a true peak limiter release time in milliseconds.
+static const std::map<int,long> sReleaseValues = {
+	{ 0,	25 },
+	{ 1,	50 },
+	{ 2,	100 },
+	{ 3,	200 },
+	{ 4,	500 },
+	{ 5,	1000 }
+};
+
+// Index of the true peak limit option in the clipping prevention list.
+static const int sTruePeakIndex = 1;
+
 OptionsLoudness::OptionsLoudness( HINSTANCE instance, Settings& settings, Output& output ) :
 	Options( instance, settings, output )
 {
@@ -50,6 +63,8 @@ void OptionsLoudness::OnInit( const HWND hwnd )
 			EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_PREAMP ), FALSE );
 			EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIPLABEL ), FALSE );
 			EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), FALSE );
+			EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), FALSE );
+			EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), FALSE );
 			break;
 		}
 		case Settings::GainMode::Track : {
@@ -82,24 +97,33 @@ void OptionsLoudness::OnInit( const HWND hwnd )
 	HWND hwndClip = GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP );
 	LoadString( GetInstanceHandle(), IDS_CLIPPREVENT_NONE, buf, bufSize );
 	ComboBox_AddString( hwndClip, buf );
-	LoadString( GetInstanceHandle(), IDS_CLIPPREVENT_HARDLIMIT, buf, bufSize );
-	ComboBox_AddString( hwndClip, buf );
-	LoadString( GetInstanceHandle(), IDS_CLIPPREVENT_SOFTLIMIT, buf, bufSize );
+	LoadString( GetInstanceHandle(), IDS_CLIPPREVENT_TRUEPEAK, buf, bufSize );
 	ComboBox_AddString( hwndClip, buf );
 	switch ( limitMode ) {
 		case Settings::LimitMode::None : {
 			ComboBox_SetCurSel( hwndClip, 0 );
 			break;
 		}
-		case Settings::LimitMode::Hard : {
-			ComboBox_SetCurSel( hwndClip, 1 );
+		case Settings::LimitMode::TruePeak : {
+			ComboBox_SetCurSel( hwndClip, sTruePeakIndex );
 			break;
 		}
-		case Settings::LimitMode::Soft : {
-			ComboBox_SetCurSel( hwndClip, 2 );
-			break;
+	}
+
+	const long release = GetSettings().GetLimiterRelease();
+	HWND hwndRelease = GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE );
+	LoadString( GetInstanceHandle(), IDS_UNITS_MILLISECONDS, buf, bufSize );
+	for ( const auto& iter : sReleaseValues ) {
+		const std::wstring releaseStr = std::to_wstring( iter.second ) + L" " + buf;
+		const int itemIndex = ComboBox_AddString( hwndRelease, releaseStr.c_str() );
+		if ( ( iter.second <= release ) || ( 0 == itemIndex ) ) {
+			ComboBox_SetCurSel( hwndRelease, itemIndex );
 		}
 	}
+	if ( ( Settings::GainMode::Disabled != gainMode ) && ( Settings::LimitMode::TruePeak != limitMode ) ) {
+		EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), FALSE );
+		EnableWindow( hwndRelease, FALSE );
+	}
 }
 
 void OptionsLoudness::OnSave( const HWND hwnd )
@@ -129,22 +153,27 @@ void OptionsLoudness::OnSave( const HWND hwnd )
 			limitMode = Settings::LimitMode::None;
 			break;
 		}
-		case 1 : {
-			limitMode = Settings::LimitMode::Hard;
-			break;
-		}
-		case 2 : {
-			limitMode = Settings::LimitMode::Soft;
+		case sTruePeakIndex : {
+			limitMode = Settings::LimitMode::TruePeak;
 			break;
 		}
 	}
 	GetSettings().SetGainSettings( gainMode, limitMode, preamp );
+
+	const auto releaseIter = sReleaseValues.find( ComboBox_GetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ) ) );
+	if ( sReleaseValues.end() != releaseIter ) {
+		GetSettings().SetLimiterRelease( releaseIter->second );
+	}
 }
 
 void OptionsLoudness::OnCommand( const HWND hwnd, const WPARAM wParam, const LPARAM /*lParam*/ )
 {
 	const WORD notificationCode = HIWORD( wParam );
-	if ( BN_CLICKED == notificationCode ) {
+	if ( ( CBN_SELCHANGE == notificationCode ) && ( IDC_OPTIONS_GAIN_CLIP == LOWORD( wParam ) ) ) {
+		const BOOL enable = ( sTruePeakIndex == ComboBox_GetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ) ) );
+		EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), enable );
+		EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), enable );
+	} else if ( BN_CLICKED == notificationCode ) {
 		const WORD controlID = LOWORD( wParam );
 		switch ( controlID ) {
 			case IDC_OPTIONS_GAIN_DISABLE : {
@@ -155,6 +184,8 @@ void OptionsLoudness::OnCommand( const HWND hwnd, const WPARAM wParam, const LPA
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_PREAMP ), FALSE );
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIPLABEL ), FALSE );
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), FALSE );
+					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), FALSE );
+					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), FALSE );
 				}
 				break;
 			}
@@ -166,6 +197,9 @@ void OptionsLoudness::OnCommand( const HWND hwnd, const WPARAM wParam, const LPA
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_PREAMP ), TRUE );
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIPLABEL ), TRUE );
 					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), TRUE );
+					const BOOL enableRelease = ( sTruePeakIndex == ComboBox_GetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ) ) );
+					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), enableRelease );
+					EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), enableRelease );
 				}
 				break;
 			}
@@ -205,12 +239,14 @@ void OptionsLoudness::OnCommand( const HWND hwnd, const WPARAM wParam, const LPA
 						ComboBox_SetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), 0 );
 						break;
 					}
-					case Settings::LimitMode::Hard : {
-						ComboBox_SetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), 1 );
+					case Settings::LimitMode::TruePeak : {
+						ComboBox_SetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), sTruePeakIndex );
 						break;
 					}
-					case Settings::LimitMode::Soft : {
-						ComboBox_SetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), 2 );
+				}
+				for ( const auto& iter : sReleaseValues ) {
+					if ( 100 == iter.second ) {
+						ComboBox_SetCurSel( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), iter.first );
 						break;
 					}
 				}
@@ -220,6 +256,9 @@ void OptionsLoudness::OnCommand( const HWND hwnd, const WPARAM wParam, const LPA
 				EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_PREAMP ), enable );
 				EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIPLABEL ), enable );
 				EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_CLIP ), enable );
+				const BOOL enableRelease = enable && ( Settings::LimitMode::TruePeak == limitMode );
+				EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASELABEL ), enableRelease );
+				EnableWindow( GetDlgItem( hwnd, IDC_OPTIONS_GAIN_RELEASE ), enableRelease );
 				break;
 			}
 			default : {
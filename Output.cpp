@@ -2,10 +2,9 @@
 
 #include "Bling.h"
 #include "GainCalculator.h"
+#include "Resampler.h"
 #include "Utility.h"
 
-#include "opus.h"
-
 #include "bassasio.h"
 #include "bassmix.h"
 #include "basswasapi.h"
@@ -42,6 +41,9 @@ static const long s_ItemIsFadingToNext = -1;
 // The fade out duration when stopping a track (in standard mode), in milliseconds.
 static const DWORD s_StopFadeDuration = 20;
 
+// The number of upcoming tracks to prefetch.
+static const size_t s_PrefetchCount = 3;
+
 DWORD CALLBACK Output::StreamProc( HSTREAM handle, void *buf, DWORD length, void *user )
 {
 	DWORD bytesRead = 0;
@@ -52,7 +54,7 @@ DWORD CALLBACK Output::StreamProc( HSTREAM handle, void *buf, DWORD length, void
 		length -= bytesRead;
 		if ( length > 0 ) {
 			sampleBuffer += bytesRead / 4;
-			bytesRead += output->ReadSampleData( sampleBuffer, length, handle );
+			bytesRead += output->ReadOutputData( sampleBuffer, length, handle );
 			if ( 0 == bytesRead ) {
 				bytesRead = BASS_STREAMPROC_END;
 			}
@@ -151,7 +153,6 @@ Output::Output( const HWND hwnd, const Handlers& handlers, Settings& settings, c
 	m_Settings( settings ),
 	m_Playlist(),
 	m_CurrentItemDecoding( {} ),
-	m_SoftClipStateDecoding(),
 	m_DecoderStream(),
 	m_DecoderSampleRate( 0 ),
 	m_OutputStream( 0 ),
@@ -170,6 +171,7 @@ Output::Output( const HWND hwnd, const Handlers& handlers, Settings& settings, c
 	m_GainMode( Settings::GainMode::Disabled ),
 	m_LimitMode( Settings::LimitMode::None ),
 	m_GainPreamp( 0 ),
+	m_LimiterRelease( 0 ),
 	m_StopAtTrackEnd( false ),
 	m_Muted( false ),
 	m_FadeOut( false ),
@@ -186,12 +188,11 @@ Output::Output( const HWND hwnd, const Handlers& handlers, Settings& settings, c
 	m_CrossfadingStream(),
 	m_CrossfadingStreamMutex(),
 	m_CurrentItemCrossfading( {} ),
-	m_SoftClipStateCrossfading(),
 	m_CrossfadeSeekOffset( 0 ),
 	m_GainEstimateMap(),
 	m_BlingMap(),
 	m_CurrentEQ( m_Settings.GetEQSettings() ),
-	m_FX(),
+	m_Equaliser(),
 	m_EQEnabled( m_CurrentEQ.Enabled ),
 	m_EQPreamp( m_CurrentEQ.Preamp ),
 	m_OutputMode( Settings::OutputMode::Standard ),
@@ -199,14 +200,31 @@ Output::Output( const HWND hwnd, const Handlers& handlers, Settings& settings, c
 	m_WASAPIFailed( false ),
 	m_WASAPIPaused( false ),
 	m_ResetASIO( false ),
-	m_LeadInSeconds( 0 )
+	m_LeadInSeconds( 0 ),
+	m_RandomItems(),
+	m_Prefetcher( [ this ] () { return GetPrefetchFilenames(); } ),
+	m_ResampleMode( Settings::ResampleMode::WhenNeeded ),
+	m_ResampleRate( 0 ),
+	m_PitchMode( m_Settings.GetPitchMode() ),
+	m_TimeStretch(),
+	m_Convolver(),
+	m_ImpulseResponse(),
+	m_ImpulseChannels( 0 ),
+	m_ImpulseFilename(),
+	m_ImpulseSampleRate( 0 ),
+	m_Limiter(),
+	m_DSPChain(),
+	m_PendingDSPChain(),
+	m_OutputDSPChain()
 {
 	InitialiseBass();
 	SetVolume( initialVolume );
 	SetPitch( m_Pitch );
 
 	m_Settings.GetGainSettings( m_GainMode, m_LimitMode, m_GainPreamp );
+	m_LimiterRelease = m_Settings.GetLimiterRelease();
 	m_Settings.GetPlaybackSettings( m_RandomPlay, m_RepeatTrack, m_RepeatPlaylist, m_Crossfade );
+	m_Settings.GetResampleSettings( m_ResampleMode, m_ResampleRate );
 }
 
 Output::~Output()
@@ -253,7 +271,27 @@ bool Output::Play( const long playlistID, const float seek )
 			item.Info.SetDuration( m_DecoderStream->GetDuration() );
 			item.Info.SetSampleRate( m_DecoderStream->GetSampleRate() );
 
+			if ( ( Settings::ResampleMode::Always == m_ResampleMode ) && ( m_ResampleRate != m_DecoderStream->GetSampleRate() ) ) {
+				const Decoder::Ptr resampler = ConvertDecoder( m_DecoderStream, m_ResampleRate, m_DecoderStream->GetChannels() );
+				if ( resampler ) {
+					m_DecoderStream = resampler;
+				}
+			}
+
+			// The decoding item holds the output format, which can differ from the item format when resampling.
+			Playlist::Item decodingItem = item;
+			decodingItem.Info.SetSampleRate( m_DecoderStream->GetSampleRate() );
+
 			m_DecoderSampleRate = m_DecoderStream->GetSampleRate();
+			// The time stretch (and its resampling filter) is reused from the previous stream if it is in the same format.
+			if ( !m_TimeStretch || ( m_TimeStretch->GetSampleRate() != m_DecoderSampleRate ) || ( m_TimeStretch->GetChannels() != decodingItem.Info.GetChannels() ) ) {
+				m_TimeStretch = std::make_shared<TimeStretch>( m_DecoderSampleRate, decodingItem.Info.GetChannels() );
+			}
+			UpdateTimeStretch();
+			m_Equaliser = std::make_shared<Equaliser>( m_DecoderSampleRate, decodingItem.Info.GetChannels() );
+			m_Convolver = CreateConvolver( m_DecoderSampleRate, decodingItem.Info.GetChannels() );
+			m_Limiter = CreateLimiter( m_DecoderSampleRate, decodingItem.Info.GetChannels() );
+			UpdateDSPChain();
 			const DWORD freq = static_cast<DWORD>( m_DecoderSampleRate );
 			float seekPosition = seek;
 			if ( 0.0f != seekPosition ) {
@@ -268,8 +306,8 @@ bool Output::Play( const long playlistID, const float seek )
 				m_DecoderStream->SkipSilence();
 			}
 
-			if ( CreateOutputStream( item.Info ) ) {
-				m_CurrentItemDecoding = item;
+			if ( CreateOutputStream( decodingItem.Info ) ) {
+				m_CurrentItemDecoding = decodingItem;
 				UpdateOutputVolume();
 				if ( 1.0f != m_Pitch ) {
 					BASS_ChannelSetAttribute( m_OutputStream, BASS_ATTRIB_FREQ, freq * m_Pitch );
@@ -285,6 +323,7 @@ bool Output::Play( const long playlistID, const float seek )
 						CalculateCrossfadePoint( item, seekPosition );
 					}
 					StartLoudnessPrecalcThread();
+					RefreshPrefetch();
 				} else {
 					Stop();
 				}
@@ -342,14 +381,18 @@ void Output::Stop()
 		}
 	}
 
-	m_FX.clear();
 	m_DecoderSampleRate = 0;
 	m_DecoderStream.reset();
+	if ( m_TimeStretch ) {
+		m_TimeStretch->Reset();
+	}
+	m_Equaliser.reset();
+	m_Convolver.reset();
+	m_Limiter.reset();
+	UpdateDSPChain();
 	m_CrossfadingStream.reset();
 	m_CurrentItemDecoding = {};
-	m_SoftClipStateDecoding.clear();
 	m_CurrentItemCrossfading = {};
-	m_SoftClipStateCrossfading.clear();
 	m_RestartItemID = 0;
 	SetOutputQueue( Queue() );
 	m_FadeOut = false;
@@ -428,7 +471,8 @@ void Output::Next()
 		const Playlist::Item currentItem = outputItem.PlaylistItem;
 		Playlist::Item nextItem = {};
 		if ( GetRandomPlay() ) {
-			nextItem = m_Playlist->GetRandomItem();
+			std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+			nextItem = GetNextRandomItem( true /*consume*/ );
 		} else {
 			m_Playlist->GetNextItem( currentItem, nextItem );
 		}
@@ -443,6 +487,7 @@ void Output::SetPlaylist( const Playlist::Ptr playlist )
 	std::lock_guard<std::mutex> lock( m_PlaylistMutex );
 	if ( m_Playlist != playlist ) {
 		m_Playlist = playlist;
+		m_RandomItems.clear();
 	}
 }
 
@@ -536,7 +581,7 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 					Playlist::Item nextItem = {};
 					if ( m_Playlist ) {
 						if ( GetRandomPlay() ) {
-							nextItem = m_Playlist->GetRandomItem();
+							nextItem = GetNextRandomItem( false /*consume*/ );
 						} else if ( GetRepeatTrack() ) {
 							nextItem = m_CurrentItemDecoding;
 						} else {
@@ -558,7 +603,6 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 									std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
 									m_CrossfadingStream = m_DecoderStream;
 									m_CurrentItemCrossfading = m_CurrentItemDecoding;
-									m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
 								}
 							}
 						}
@@ -571,7 +615,6 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 				m_CrossfadingStream = m_DecoderStream;
 				m_CurrentItemCrossfading = m_CurrentItemDecoding;
 				m_CurrentItemCrossfading.ID = s_ItemIsFadingToNext;
-				m_SoftClipStateCrossfading = m_SoftClipStateDecoding;
 			}
 
 			bytesRead = static_cast<DWORD>( m_DecoderStream->Read( buffer, samplesToRead ) * channels * 4 );
@@ -593,7 +636,7 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 			Playlist::Item nextItem = {};
 			if ( m_Playlist ) {
 				if ( GetRandomPlay() ) {
-					nextItem = m_Playlist->GetRandomItem();
+					nextItem = GetNextRandomItem( true /*consume*/ );
 				} else if ( GetRepeatTrack() ) {
 					nextItem = m_CurrentItemDecoding;
 				} else {
@@ -603,7 +646,13 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 					EstimateGain( nextItem );
 					const long channels = m_DecoderStream->GetChannels();
 					const long sampleRate = m_DecoderStream->GetSampleRate();
+					const bool prefetched = m_Prefetcher.IsPrefetched( nextItem.Info.GetFilename() );
+					const LONGLONG openTick = GetTick();
 					m_DecoderStream = OpenDecoder( nextItem );
+					if ( m_DecoderStream && IsConversionRequired( m_CurrentItemDecoding, nextItem ) ) {
+						// Convert the next track to the current output format, so that playback continues without a gap.
+						m_DecoderStream = ConvertDecoder( m_DecoderStream, sampleRate, channels );
+					}
 					if ( m_DecoderStream && ( m_DecoderStream->GetChannels() == channels ) && ( m_DecoderStream->GetSampleRate() == sampleRate ) ) {
 						if ( GetCrossfade() || GetFadeToNext() ) {
 							m_DecoderStream->SkipSilence();
@@ -611,11 +660,15 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 
 						const long sampleCount = static_cast<long>( byteCount ) / ( channels * 4 );
 						bytesRead = static_cast<DWORD>( m_DecoderStream->Read( buffer, sampleCount ) * channels * 4 );
+						m_Prefetcher.AddTransition( prefetched, GetInterval( openTick, GetTick() ) );
 						m_CurrentItemDecoding = nextItem;
+						m_CurrentItemDecoding.Info.SetChannels( channels );
+						m_CurrentItemDecoding.Info.SetSampleRate( sampleRate );
+						m_Prefetcher.RequestUpdate();
 
 						m_LastTransitionPosition = GetDecodePosition() - m_LeadInSeconds;
 						Queue queue = GetOutputQueue();
-						queue.push_back( { m_CurrentItemDecoding, m_LastTransitionPosition } );
+						queue.push_back( { nextItem, m_LastTransitionPosition } );
 						SetOutputQueue( queue );
 
 						if ( GetCrossfade() && ( 0 != bytesRead ) ) {
@@ -634,7 +687,6 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 				if ( m_CrossfadingStream ) {
 					m_CrossfadingStream.reset();
 					m_CurrentItemCrossfading = {};
-					m_SoftClipStateCrossfading.clear();
 				}
 			}
 		}
@@ -643,7 +695,7 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 	if ( 0 != bytesRead ) {
 		const long currentDecodingChannels = m_CurrentItemDecoding.Info.GetChannels();
 		if ( currentDecodingChannels > 0 ) {
-			ApplyGain( buffer, static_cast<long>( bytesRead / ( currentDecodingChannels * 4 ) ), m_CurrentItemDecoding, m_SoftClipStateDecoding );
+			ApplyGain( buffer, static_cast<long>( bytesRead / ( currentDecodingChannels * 4 ) ), m_CurrentItemDecoding );
 		}
 
 		std::lock_guard<std::mutex> crossfadingStreamLock( m_CrossfadingStreamMutex );
@@ -655,7 +707,7 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 				const long samplesToRead = static_cast<long>( bytesRead ) / ( channels * 4 );
 				std::vector<float> crossfadingBuffer( bytesRead / 4 );
 				const long crossfadingBytesRead = m_CrossfadingStream->Read( &crossfadingBuffer[ 0 ], samplesToRead ) * channels * 4;
-				ApplyGain( &crossfadingBuffer[ 0 ], crossfadingBytesRead / ( channels * 4 ), m_CurrentItemCrossfading, m_SoftClipStateCrossfading );
+				ApplyGain( &crossfadingBuffer[ 0 ], crossfadingBytesRead / ( channels * 4 ), m_CurrentItemCrossfading );
 				if ( crossfadingBytesRead <= static_cast<long>( bytesRead ) ) {
 					long crossfadingSamplesRead = crossfadingBytesRead / ( channels * 4 );
 
@@ -701,7 +753,6 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 					if ( 0 == crossfadingSamplesRead ) {
 						m_CrossfadingStream.reset();
 						m_CurrentItemCrossfading = {};
-						m_SoftClipStateCrossfading.clear();
 					} else {
 						for ( long sample = 0; sample < crossfadingSamplesRead * channels; sample++ ) {
 							buffer[ sample ] += crossfadingBuffer[ sample ];
@@ -747,6 +798,88 @@ DWORD Output::ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM hand
 	return bytesRead;
 }
 
+DWORD Output::ReadOutputData( float* buffer, const DWORD byteCount, HSTREAM handle )
+{
+	DWORD bytesRead = 0;
+	const TimeStretch::Ptr timeStretch = m_TimeStretch;
+	if ( timeStretch && timeStretch->IsActive() ) {
+		const long sampleSize = timeStretch->GetChannels() * 4;
+		const long samplesRead = timeStretch->Read( buffer, static_cast<long>( byteCount / sampleSize ), [ this, handle, sampleSize ] ( float* sampleBuffer, const long sampleCount ) -> long
+		{
+			return static_cast<long>( ReadSampleData( sampleBuffer, static_cast<DWORD>( sampleCount * sampleSize ), handle ) / sampleSize );
+		} );
+		bytesRead = static_cast<DWORD>( samplesRead * sampleSize );
+	} else {
+		bytesRead = ReadSampleData( buffer, byteCount, handle );
+	}
+
+	// Any chain replaced here is handed back to the thread which rebuilt the chain, so that freeing it (and any convolver worker thread) never blocks the output.
+	m_PendingDSPChain.Get( m_OutputDSPChain );
+	if ( m_OutputDSPChain ) {
+		m_OutputDSPChain->Process( buffer, static_cast<long>( bytesRead / ( m_OutputDSPChain->GetChannels() * 4 ) ) );
+	}
+	return bytesRead;
+}
+
+void Output::UpdateDSPChain()
+{
+	DSPChain::Ptr dspChain;
+	if ( m_Equaliser ) {
+		dspChain = std::make_shared<DSPChain>( m_Equaliser->GetChannels() );
+		dspChain->AddNode( m_Equaliser );
+		dspChain->AddNode( m_Convolver );
+		// The limiter keeps peaks caused by applying gain or EQ within range, so it is not needed otherwise.
+		if ( ( Settings::GainMode::Disabled != m_GainMode ) || m_EQEnabled ) {
+			dspChain->AddNode( m_Limiter );
+		}
+	}
+	std::atomic_store( &m_DSPChain, dspChain );
+	m_PendingDSPChain.Set( dspChain );
+}
+
+Limiter::Ptr Output::CreateLimiter( const long sampleRate, const long channels ) const
+{
+	Limiter::Ptr limiter;
+	if ( ( Settings::LimitMode::TruePeak == m_LimitMode ) && ( sampleRate > 0 ) && ( channels > 0 ) ) {
+		limiter = std::make_shared<Limiter>( sampleRate, channels, m_LimiterRelease / 1000.0f );
+	}
+	return limiter;
+}
+
+Convolver::Ptr Output::CreateConvolver( const long sampleRate, const long channels )
+{
+	Convolver::Ptr convolver;
+	bool enabled = false;
+	std::wstring filename;
+	long partitionSize = 0;
+	m_Settings.GetConvolutionSettings( enabled, filename, partitionSize );
+	if ( enabled && !filename.empty() && ( sampleRate > 0 ) && ( channels > 0 ) ) {
+		// Keep hold of the impulse response, so that it only needs to be reloaded when the filter or sample rate changes.
+		if ( ( filename != m_ImpulseFilename ) || ( sampleRate != m_ImpulseSampleRate ) ) {
+			m_ImpulseFilename = filename;
+			m_ImpulseSampleRate = sampleRate;
+			Convolver::LoadImpulseResponse( m_Handlers, filename, sampleRate, m_ImpulseResponse, m_ImpulseChannels );
+		}
+		if ( !m_ImpulseResponse.empty() ) {
+			convolver = std::make_shared<Convolver>( m_ImpulseResponse, m_ImpulseChannels, sampleRate, channels, partitionSize );
+		}
+	}
+	return convolver;
+}
+
+void Output::UpdateConvolution()
+{
+	m_Convolver = m_Equaliser ? CreateConvolver( m_DecoderSampleRate, m_Equaliser->GetChannels() ) : nullptr;
+	UpdateDSPChain();
+}
+
+Convolver::Statistics Output::GetConvolutionStatistics() const
+{
+	const Convolver::Ptr convolver = m_Convolver;
+	const Convolver::Statistics statistics = convolver ? convolver->GetStatistics() : Convolver::Statistics {};
+	return statistics;
+}
+
 float Output::GetVolume() const
 {
 	return m_Volume;
@@ -783,6 +916,37 @@ void Output::SetPitch( const float pitch )
 		if ( ( 0 != sampleRate ) && ( 0 != m_OutputStream ) ) {
 			BASS_ChannelSetAttribute( m_OutputStream, BASS_ATTRIB_FREQ, sampleRate * m_Pitch );
 		}
+		UpdateTimeStretch();
+	}
+}
+
+Settings::PitchMode Output::GetPitchMode() const
+{
+	return m_PitchMode;
+}
+
+void Output::SetPitchMode( const Settings::PitchMode mode )
+{
+	if ( mode != m_PitchMode ) {
+		m_PitchMode = mode;
+		m_Settings.SetPitchMode( mode );
+		UpdateTimeStretch();
+	}
+}
+
+float Output::GetTimeStretchLoad() const
+{
+	const float load = m_TimeStretch ? m_TimeStretch->GetLoad() : 0;
+	return load;
+}
+
+void Output::UpdateTimeStretch()
+{
+	// In tempo mode, the playback rate adjustment is still applied to the output stream, so that stream positions are unaffected,
+	// and the sample data is pitch shifted by the inverse of the adjustment to restore the original pitch.
+	if ( m_TimeStretch ) {
+		const float pitch = ( Settings::PitchMode::Tempo == m_PitchMode ) ? ( 1.0f / m_Pitch ) : 1.0f;
+		m_TimeStretch->SetPitch( pitch );
 	}
 }
 
@@ -914,6 +1078,7 @@ void Output::SetRandomPlay( const bool enabled )
 	if ( m_RandomPlay ) {
 		m_RepeatTrack = m_RepeatPlaylist = false;
 	}
+	RefreshPrefetch();
 }
 
 bool Output::GetRepeatTrack() const
@@ -927,6 +1092,7 @@ void Output::SetRepeatTrack( const bool enabled )
 	if ( m_RepeatTrack ) {
 		m_RandomPlay = m_RepeatPlaylist = false;
 	}
+	RefreshPrefetch();
 }
 
 bool Output::GetRepeatPlaylist() const
@@ -940,6 +1106,7 @@ void Output::SetRepeatPlaylist( const bool enabled )
 	if ( m_RepeatPlaylist ) {
 		m_RandomPlay = m_RepeatTrack = false;
 	}
+	RefreshPrefetch();
 }
 
 bool Output::GetCrossfade() const
@@ -1071,15 +1238,29 @@ void Output::SettingsChanged()
 	Settings::LimitMode limitMode = Settings::LimitMode::None;
 	float gainPreamp = 0;
 	m_Settings.GetGainSettings( gainMode, limitMode, gainPreamp );
+	const long limiterRelease = m_Settings.GetLimiterRelease();
+	const bool limiterChanged = ( limitMode != m_LimitMode ) || ( limiterRelease != m_LimiterRelease );
 	if ( ( gainMode != m_GainMode ) || ( limitMode != m_LimitMode ) || ( gainPreamp != m_GainPreamp ) ) {
 		m_GainMode = gainMode;
 		m_LimitMode = limitMode;
 		m_GainPreamp = gainPreamp;
+		UpdateDSPChain();
 		EstimateGain( m_CurrentItemDecoding );
 		if ( State::Stopped != GetState() ) {
 			StartLoudnessPrecalcThread();
 		}
 	}
+	if ( limiterChanged ) {
+		m_LimiterRelease = limiterRelease;
+		if ( m_Limiter && ( Settings::LimitMode::TruePeak == m_LimitMode ) ) {
+			m_Limiter->SetRelease( m_LimiterRelease / 1000.0f );
+		} else {
+			m_Limiter = m_Equaliser ? CreateLimiter( m_DecoderSampleRate, m_Equaliser->GetChannels() ) : nullptr;
+			UpdateDSPChain();
+		}
+	}
+
+	m_Settings.GetResampleSettings( m_ResampleMode, m_ResampleRate );
 
 	m_Handlers.SettingsChanged( m_Settings );
 }
@@ -1142,7 +1323,7 @@ void Output::EstimateGain( Playlist::Item& item )
 			if ( m_GainEstimateMap.end() != estimateIter ) {
 				item.Info.SetGainTrack( estimateIter->second );
 			} else {
-				Decoder::Ptr tempDecoder = OpenDecoder( item );
+				Decoder::Ptr tempDecoder = OpenDecoder( item, Decoder::Context::Temporary );
 				if ( tempDecoder ) {
 					const float trackGain = tempDecoder->CalculateTrackGain( s_GainPrecalcTime );
 					item.Info.SetGainTrack( trackGain );
@@ -1288,7 +1469,6 @@ void Output::ToggleFadeToNext()
 		if ( m_CrossfadingStream ) {
 			m_CrossfadingStream.reset();
 			m_CurrentItemCrossfading = {};
-			m_SoftClipStateCrossfading.clear();
 		}
 	}
 }
@@ -1298,7 +1478,7 @@ bool Output::GetFadeToNext() const
 	return m_FadeToNext;
 }
 
-void Output::ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState )
+void Output::ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item )
 {
 	const bool eqEnabled = m_EQEnabled;
 	const long channels = item.Info.GetChannels();
@@ -1327,28 +1507,6 @@ void Output::ApplyGain( float* buffer, const long sampleCount, const Playlist::I
 			for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
 				buffer[ sampleIndex ] *= scale;
 			}
-			switch ( m_LimitMode ) {
-				case Settings::LimitMode::Hard : {
-					for ( long sampleIndex = 0; sampleIndex < totalSamples; sampleIndex++ ) {
-						if ( buffer[ sampleIndex ] < -1.0f ) {
-							buffer[ sampleIndex ] = -1.0f;
-						} else if ( buffer[ sampleIndex ] > 1.0f ) {
-							buffer[ sampleIndex ] = 1.0f;
-						}
-					}
-					break;
-				}
-				case Settings::LimitMode::Soft : {
-					if ( softClipState.size() != static_cast<size_t>( channels ) ) {
-						softClipState.resize( channels, 0 );
-					}
-					opus_pcm_soft_clip( buffer, sampleCount, channels, &softClipState[ 0 ] );
-					break;
-				}
-				default : {
-					break;
-				}
-			}
 		}
 	}
 }
@@ -1419,67 +1577,59 @@ void Output::Bling( const int blingID )
 
 void Output::UpdateEQ( const Settings::EQ& eq )
 {
+	const bool eqEnabledChanged = ( eq.Enabled != m_EQEnabled );
 	m_EQEnabled = eq.Enabled;
 	m_EQPreamp = eq.Preamp;
+	if ( eqEnabledChanged ) {
+		UpdateDSPChain();
+	}
 
 	m_CurrentEQ = eq;
-	if ( 0 != m_OutputStream ) {
-		if ( eq.Enabled ) {	
-			if ( m_FX.empty() ) {
-				// Add FX to current output stream.
-				BASS_DX8_PARAMEQ params = {};
-				params.fBandwidth = eq.Bandwidth;
-				for ( const auto& setting : eq.Gains ) {
-					const int freq = setting.first;
-					const HFX fx = BASS_ChannelSetFX( m_OutputStream, BASS_FX_DX8_PARAMEQ, 100 /*priority*/ );
-					if ( 0 != fx ) {
-						params.fCenter = static_cast<float>( freq );
-						params.fGain = setting.second;
-						BASS_FXSetParameters( fx, &params );
-
-						BASS_FXGetParameters( fx, &params );
-						if ( static_cast<int>( params.fCenter ) != freq ) {
-							// The centre frequency was too high for the stream, so remove the FX.
-							BASS_ChannelRemoveFX( m_OutputStream, fx );
-						} else {
-							m_FX.push_back( fx );
-						}
-					}
-				}
-			} else {
-				// Modify FX on the current output stream.
-				for ( const auto& fx : m_FX ) {
-					BASS_DX8_PARAMEQ params = {};
-					if ( BASS_FXGetParameters( fx, &params ) ) {
-						const int freq = static_cast<int>( params.fCenter );
-						const auto setting = eq.Gains.find( freq );
-						if ( eq.Gains.end() != setting ) {
-							const float gain = setting->second;
-							if ( gain != params.fGain ) {
-								params.fGain = gain;
-								BASS_FXSetParameters( fx, &params );
-							}
-						}
-					}
-				}
-			}
-		} else {
-			// Disable EQ.
-			for ( const auto& fx : m_FX ) {
-				BASS_ChannelRemoveFX( m_OutputStream, fx );
-			}
-			m_FX.clear();
+	if ( m_Equaliser ) {
+		m_Equaliser->SetEQ( eq );
+	}
+}
+
+Decoder::Ptr Output::ConvertDecoder( const Decoder::Ptr decoder, const long sampleRate, const long channels ) const
+{
+	Decoder::Ptr converted = decoder;
+	if ( decoder && ( ( decoder->GetSampleRate() != sampleRate ) || ( decoder->GetChannels() != channels ) ) ) {
+		try {
+			converted = std::make_shared<Resampler>( decoder, sampleRate, channels );
+		} catch ( const std::runtime_error& ) {
+			converted.reset();
 		}
 	}
+	return converted;
 }
 
-Decoder::Ptr Output::OpenDecoder( const Playlist::Item& item ) const
+bool Output::IsConversionRequired( const Playlist::Item& currentItem, const Playlist::Item& nextItem ) const
 {
-	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename() );
+	bool conversionRequired = false;
+	switch ( m_ResampleMode ) {
+		case Settings::ResampleMode::Always : {
+			conversionRequired = true;
+			break;
+		}
+		case Settings::ResampleMode::WhenNeeded : {
+			const std::wstring& album = currentItem.Info.GetAlbum();
+			conversionRequired = GetCrossfade() || GetFadeToNext() || ( !album.empty() && ( album == nextItem.Info.GetAlbum() ) );
+			break;
+		}
+		default : {
+			break;
+		}
+	}
+	return conversionRequired;
+}
+
+Decoder::Ptr Output::OpenDecoder( const Playlist::Item& item, const Decoder::Context context ) const
+{
+	Decoder::Ptr decoder = m_Handlers.OpenDecoder( item.Info.GetFilename(), context );
 	if ( !decoder ) {
 		auto duplicate = item.Duplicates.begin();
 		while ( !decoder && ( item.Duplicates.end() != duplicate ) ) {
-			decoder = m_Handlers.OpenDecoder( *duplicate );
+			decoder = m_Handlers.OpenDecoder( *duplicate, context );
 			++duplicate;
 		}
 	}
@@ -1546,12 +1696,21 @@ float Output::GetOutputPosition() const
 		case Settings::OutputMode::ASIO : {
 			const QWORD bytePos = BASS_Mixer_ChannelGetPosition( m_OutputStream, BASS_POS_BYTE );
 			seconds = static_cast<float>( BASS_ChannelBytes2Seconds( m_OutputStream, bytePos ) ) - m_LeadInSeconds;
-			if ( seconds < 0 ) {
-				seconds = 0;
-			}
 			break;
 		}
 	}
+
+	// Sample data passed through the DSP chain is delayed by the chain latency.
+	const DSPChain::Ptr dspChain = std::atomic_load( &m_DSPChain );
+	if ( dspChain ) {
+		BASS_CHANNELINFO channelInfo = {};
+		if ( ( TRUE == BASS_ChannelGetInfo( m_OutputStream, &channelInfo ) ) && ( channelInfo.freq > 0 ) ) {
+			seconds -= static_cast<float>( dspChain->GetLatency() ) / channelInfo.freq;
+		}
+	}
+	if ( seconds < 0 ) {
+		seconds = 0;
+	}
 	return seconds;
 }
 
@@ -1610,6 +1769,10 @@ bool Output::CreateOutputStream( const MediaInfo& mediaInfo )
 				DWORD outputChannels = useMixFormat ? 0 : channels;
 
 				DWORD flags = BASS_WASAPI_EXCLUSIVE | BASS_WASAPI_BUFFER | BASS_WASAPI_EVENT;
+				if ( Settings::DitherMode::None != m_Settings.GetDitherMode() ) {
+					// Apply dither when the device format is integer (noise shaping is not available on the device output).
+					flags |= BASS_WASAPI_DITHER;
+				}
 				const float period = 0;
 				float buffer = static_cast<float>( bufferMilliseconds ) / 1000;
 				if ( flags & BASS_WASAPI_EVENT ) {
@@ -1700,6 +1863,13 @@ bool Output::CreateOutputStream( const MediaInfo& mediaInfo )
 									success = ( TRUE == BASS_ASIO_SetRate( outputSamplerate ) );
 									if ( success ) {
 										success = ( TRUE == BASS_ASIO_ChannelEnableBASS( FALSE /*input*/, 0 /*channel*/, m_MixerStream, TRUE /*join*/ ) );
+										if ( success && ( Settings::DitherMode::None != m_Settings.GetDitherMode() ) ) {
+											// Apply dither when the device format is integer (noise shaping is not available on the device output).
+											const DWORD format = BASS_ASIO_ChannelGetFormat( FALSE /*input*/, 0 /*channel*/ );
+											if ( -1 != format ) {
+												BASS_ASIO_ChannelSetFormat( FALSE /*input*/, 0 /*channel*/, format | BASS_ASIO_FORMAT_DITHER );
+											}
+										}
 									}
 								}
 							}
@@ -1859,3 +2029,73 @@ void Output::StopLoudnessPrecalcThread()
 		m_LoudnessPrecalcThread = nullptr;
 	}
 }
+
+Prefetcher::Statistics Output::GetPrefetchStatistics()
+{
+	return m_Prefetcher.GetStatistics();
+}
+
+Playlist::Item Output::GetNextRandomItem( const bool consume )
+{
+	Playlist::Item item = {};
+	if ( m_Playlist ) {
+		// Discard any upcoming items that have since been removed from the playlist.
+		while ( !m_RandomItems.empty() && !m_Playlist->GetItem( m_RandomItems.front() ) ) {
+			m_RandomItems.pop_front();
+		}
+		if ( m_RandomItems.empty() ) {
+			const Playlist::Item randomItem = m_Playlist->GetRandomItem();
+			if ( randomItem.ID > 0 ) {
+				m_RandomItems.push_back( randomItem );
+			}
+		}
+		if ( !m_RandomItems.empty() ) {
+			item = m_RandomItems.front();
+			if ( consume ) {
+				m_RandomItems.pop_front();
+			}
+		}
+	}
+	return item;
+}
+
+std::vector<std::wstring> Output::GetPrefetchFilenames()
+{
+	std::vector<std::wstring> filenames;
+	std::lock_guard<std::mutex> lock( m_PlaylistMutex );
+	const Playlist::Item currentItem = m_CurrentItemDecoding;
+	if ( m_Playlist && ( currentItem.ID > 0 ) ) {
+		std::list<Playlist::Item> upcomingItems;
+		if ( GetRandomPlay() ) {
+			while ( m_RandomItems.size() < s_PrefetchCount ) {
+				const Playlist::Item randomItem = m_Playlist->GetRandomItem();
+				if ( 0 == randomItem.ID ) {
+					break;
+				}
+				m_RandomItems.push_back( randomItem );
+			}
+			upcomingItems = m_RandomItems;
+		} else if ( !GetRepeatTrack() ) {
+			Playlist::Item item = currentItem;
+			while ( upcomingItems.size() < s_PrefetchCount ) {
+				Playlist::Item nextItem = {};
+				if ( !m_Playlist->GetNextItem( item, nextItem, GetRepeatPlaylist() /*wrap*/ ) || ( nextItem.ID == currentItem.ID ) ) {
+					break;
+				}
+				upcomingItems.push_back( nextItem );
+				item = nextItem;
+			}
+		}
+		for ( const auto& item : upcomingItems ) {
+			if ( ( MediaInfo::Source::File == item.Info.GetSource() ) && ( item.ID != currentItem.ID ) ) {
+				filenames.push_back( item.Info.GetFilename() );
+			}
+		}
+	}
+	return filenames;
+}
+
+void Output::RefreshPrefetch()
+{
+	m_Prefetcher.RequestUpdate();
+}
@@ -1,9 +1,15 @@
 #pragma once
 
 #include "bass.h"
+#include "Convolver.h"
+#include "DSPChain.h"
+#include "Equaliser.h"
 #include "Handlers.h"
+#include "Limiter.h"
 #include "Playlist.h"
+#include "Prefetcher.h"
 #include "Settings.h"
+#include "TimeStretch.h"
 
 #include <atomic>
 
@@ -83,6 +89,21 @@ public:
 	// Sets the pitch adjustment factor, with 1.0 representing no adjustment.
 	void SetPitch( const float pitch );
 
+	// Returns the pitch adjustment mode.
+	Settings::PitchMode GetPitchMode() const;
+
+	// Sets the pitch adjustment 'mode'.
+	void SetPitchMode( const Settings::PitchMode mode );
+
+	// Returns the processing cost of preserving the pitch in tempo mode, as a fraction of the duration of the sample data processed.
+	float GetTimeStretchLoad() const;
+
+	// Applies the current convolution settings, rebuilding the convolver for the current track if playing.
+	void UpdateConvolution();
+
+	// Returns the convolution statistics (all zero if convolution is not active).
+	Convolver::Statistics GetConvolutionStatistics() const;
+
 	// Gets the channel levels for visualisation.
 	// 'left' - out, left channel level in the range 0.0 to 1.0.
 	// 'right' - out, right channel level in the range 0.0 to 1.0.
@@ -176,6 +197,9 @@ public:
 	// Updates the EQ settings.
 	void UpdateEQ( const Settings::EQ& eq );
 
+	// Returns the statistics for prefetching upcoming tracks.
+	Prefetcher::Statistics GetPrefetchStatistics();
+
 private:
 	// Output queue.
 	typedef std::vector<Item> Queue;
@@ -186,9 +210,6 @@ private:
 	// Maps an ID to a stream handle.
 	typedef std::map<int,HSTREAM> StreamMap;
 
-	// A list of FX.
-	typedef std::list<HFX> FXList;
-
 	// BASS stream callback.
 	static DWORD CALLBACK StreamProc( HSTREAM handle, void *buf, DWORD len, void *user );
 
@@ -226,6 +247,25 @@ private:
 	// Returns the number of bytes read.
 	DWORD ReadSampleData( float* buffer, const DWORD byteCount, HSTREAM handle );
 
+	// Reads sample data from the current decoder, pitch shifted when adjusting the tempo, and with EQ applied.
+	// 'buffer' - sample buffer.
+	// 'byteCount' - number of bytes to read.
+	// 'handle' - stream handle.
+	// Returns the number of bytes read.
+	DWORD ReadOutputData( float* buffer, const DWORD byteCount, HSTREAM handle );
+
+	// Creates a convolver for the 'sampleRate' & 'channels', if convolution is enabled and the filter can be loaded.
+	Convolver::Ptr CreateConvolver( const long sampleRate, const long channels );
+
+	// Creates a true peak limiter for the 'sampleRate' & 'channels', if the true peak limit mode is selected.
+	Limiter::Ptr CreateLimiter( const long sampleRate, const long channels ) const;
+
+	// Rebuilds the output stream DSP chain from the current EQ, convolution and limiter nodes.
+	void UpdateDSPChain();
+
+	// Updates the time stretch pitch shift factor, from the pitch adjustment factor and mode.
+	void UpdateTimeStretch();
+
 	// Called when playback has ended.
 	void OnSyncEnd();
 
@@ -254,8 +294,9 @@ private:
 	// Sets the crossfade 'position' for the current track, in seconds.
 	void SetCrossfadePosition( const float position );
 
-	// Applies gain (and EQ preamp) to an output 'buffer' containing 'sampleCount' samples, using 'item' information and 'softClipState'.
-	void ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item, std::vector<float>& softClipState );
+	// Applies gain (and EQ preamp) to an output 'buffer' containing 'sampleCount' samples, using 'item' information.
+	// Any resulting peaks above full scale are handled by the true peak limiter on the final output.
+	void ApplyGain( float* buffer, const long sampleCount, const Playlist::Item& item );
 
 	// Gets the output queue.
 	Queue GetOutputQueue();
@@ -264,7 +305,16 @@ private:
 	void SetOutputQueue( const Queue& queue );
 
 	// Returns a decoder for the 'item', or nullptr if a decoder could not be opened.
-	Decoder::Ptr OpenDecoder( const Playlist::Item& item ) const;
+	// 'context' - context in which the decoder is used.
+	Decoder::Ptr OpenDecoder( const Playlist::Item& item, const Decoder::Context context = Decoder::Context::Input ) const;
+
+	// Returns the 'decoder' converted to the 'sampleRate' & number of 'channels' (or the 'decoder' itself if no conversion is needed).
+	// Returns nullptr if the conversion is not supported.
+	Decoder::Ptr ConvertDecoder( const Decoder::Ptr decoder, const long sampleRate, const long channels ) const;
+
+	// Returns whether the 'nextItem' should be converted to the output format of the 'currentItem' when switching between them.
+	// When resampling only as needed, tracks are converted only when crossfading or when continuing the same album, otherwise the output is restarted in the native format of the next track.
+	bool IsConversionRequired( const Playlist::Item& currentItem, const Playlist::Item& nextItem ) const;
 
 	// Starts the output and returns the output state.
 	State StartOutput();
@@ -304,6 +354,17 @@ private:
 	// Stops the loudness precalculation thread.
 	void StopLoudnessPrecalcThread();
 
+	// Returns the next random item to play, choosing one if necessary (the playlist mutex must be held).
+	// 'consume' - true to take the item from the upcoming random items, false to leave it as the next random item.
+	Playlist::Item GetNextRandomItem( const bool consume );
+
+	// Returns the files to prefetch, from the items expected to be played after the currently decoding item.
+	// This is called from the prefetch thread, so that the output stream callback never walks the playlist.
+	std::vector<std::wstring> GetPrefetchFilenames();
+
+	// Requests that the files to prefetch are updated, from the items expected to be played after the currently decoding item.
+	void RefreshPrefetch();
+
 	// Parent window handle.
 	HWND m_Parent;
 
@@ -319,9 +380,6 @@ private:
 	// The currently decoding playlist item.
 	Playlist::Item m_CurrentItemDecoding;
 
-	// The soft-clip state for the currently decoding item.
-	std::vector<float> m_SoftClipStateDecoding;
-
 	// The currently decoding stream.
 	Decoder::Ptr m_DecoderStream;
 
@@ -376,6 +434,9 @@ private:
 	// Gain preamp in dB.
 	float m_GainPreamp;
 
+	// True peak limiter release time, in milliseconds.
+	long m_LimiterRelease;
+
 	// Indicates whether to stop playback at the end of the current track.
 	bool m_StopAtTrackEnd;
 
@@ -424,9 +485,6 @@ private:
 	// The item that is being faded out during a crossfade.
 	Playlist::Item m_CurrentItemCrossfading;
 
-	// The soft-clip state for the currently crossfading item.
-	std::vector<float> m_SoftClipStateCrossfading;
-
 	// Indicates an offset to subtract from the crossfade calculation, in seconds.
 	float m_CrossfadeSeekOffset;
 
@@ -439,8 +497,8 @@ private:
 	// Current EQ settings.
 	Settings::EQ m_CurrentEQ;
 
-	// EQ FX handles.
-	FXList m_FX;
+	// Applies EQ to the output stream.
+	Equaliser::Ptr m_Equaliser;
 
 	// Indicates whether EQ is enabled.
 	bool m_EQEnabled;
@@ -465,4 +523,50 @@ private:
 
 	// When starting playback in non-standard output mode, the lead-in length before passing through actual sample data.
 	float m_LeadInSeconds;
+
+	// The upcoming items when random play is enabled, chosen in advance so that they can be prefetched.
+	std::list<Playlist::Item> m_RandomItems;
+
+	// Prefetches the start of upcoming files.
+	Prefetcher m_Prefetcher;
+
+	// Resampling mode.
+	Settings::ResampleMode m_ResampleMode;
+
+	// Output sample rate, when always resampling.
+	long m_ResampleRate;
+
+	// Pitch adjustment mode.
+	Settings::PitchMode m_PitchMode;
+
+	// Pitch shifts the output stream in tempo mode, to compensate for the playback rate adjustment.
+	TimeStretch::Ptr m_TimeStretch;
+
+	// Applies room correction or headphone filters to the output stream.
+	Convolver::Ptr m_Convolver;
+
+	// The most recently loaded convolution filter impulse response.
+	std::vector<float> m_ImpulseResponse;
+
+	// Convolution filter impulse response channel count.
+	long m_ImpulseChannels;
+
+	// Convolution filter impulse response filename.
+	std::wstring m_ImpulseFilename;
+
+	// Convolution filter impulse response sample rate.
+	long m_ImpulseSampleRate;
+
+	// Limits the true peak level of the output stream.
+	Limiter::Ptr m_Limiter;
+
+	// Output stream DSP chain, as last built (only accessed atomically, as it can be read from other threads while being rebuilt during playback).
+	DSPChain::Ptr m_DSPChain;
+
+	// Passes a rebuilt DSP chain to the output stream.
+	// Replaced chains are handed back, so that they (and their nodes) are never freed from the output stream callback.
+	DSPParameter<DSPChain::Ptr> m_PendingDSPChain;
+
+	// DSP chain in use by the output stream (only accessed from the output stream callback).
+	DSPChain::Ptr m_OutputDSPChain;
 };
@@ -0,0 +1,53 @@
+#include "PipelineThread.h"
+
+PipelineThread::PipelineThread() :
+	m_Mutex(),
+	m_Condition(),
+	m_Task(),
+	m_Stop( false ),
+	m_Thread( &PipelineThread::Handler, this )
+{
+}
+
+PipelineThread::~PipelineThread()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+	m_Thread.join();
+}
+
+void PipelineThread::Start( const std::function<void()>& task )
+{
+	{
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		m_Condition.wait( lock, [ this ] () { return !m_Task; } );
+		m_Task = task;
+	}
+	m_Condition.notify_all();
+}
+
+void PipelineThread::Wait()
+{
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	m_Condition.wait( lock, [ this ] () { return !m_Task; } );
+}
+
+void PipelineThread::Handler()
+{
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	while ( true ) {
+		m_Condition.wait( lock, [ this ] () { return m_Stop || m_Task; } );
+		if ( !m_Task ) {
+			break;
+		}
+		const std::function<void()> task = m_Task;
+		lock.unlock();
+		task();
+		lock.lock();
+		m_Task = nullptr;
+		m_Condition.notify_all();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// A thread which runs one task at a time, and is kept running so that it can be reused for a series of tasks (such as a conversion pipeline stage for each track).
+class PipelineThread
+{
+public:
+	PipelineThread();
+
+	virtual ~PipelineThread();
+
+	PipelineThread( const PipelineThread& ) = delete;
+	PipelineThread& operator=( const PipelineThread& ) = delete;
+
+	// Runs the 'task' on the thread, once any previous task has finished.
+	void Start( const std::function<void()>& task );
+
+	// Waits for the current task, if any, to finish.
+	void Wait();
+
+private:
+	// Thread handler, which runs each task in turn.
+	void Handler();
+
+	// Mutex protecting the current task & stop flag.
+	std::mutex m_Mutex;
+
+	// Signalled when a task is started or finished, or the thread is to stop.
+	std::condition_variable m_Condition;
+
+	// The current task, or empty if the thread is idle.
+	std::function<void()> m_Task;
+
+	// Indicates that the thread is to stop.
+	bool m_Stop;
+
+	// The thread (started once the other members have been initialised).
+	std::thread m_Thread;
+};
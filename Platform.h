@@ -0,0 +1,71 @@
+#pragma once
+
+// Definitions standing in for the Windows headers, when building the portable core on other platforms.
+// Only the types & functions used by the portable core sources are provided.
+
+#ifndef _WIN32
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef int BOOL;
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+// Wave format tags.
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+
+// File sharing mode (files are not locked on other platforms).
+#define _SH_DENYRW 0x10
+
+// Returns the wide 'text' (UTF-32) as a UTF-8 string.
+inline std::string PlatformToUTF8( const wchar_t* text )
+{
+	std::string utf8;
+	for ( const wchar_t* character = text; 0 != *character; character++ ) {
+		const uint32_t codePoint = static_cast<uint32_t>( *character );
+		if ( codePoint < 0x80 ) {
+			utf8 += static_cast<char>( codePoint );
+		} else if ( codePoint < 0x800 ) {
+			utf8 += static_cast<char>( 0xc0 | ( codePoint >> 6 ) );
+			utf8 += static_cast<char>( 0x80 | ( codePoint & 0x3f ) );
+		} else if ( codePoint < 0x10000 ) {
+			utf8 += static_cast<char>( 0xe0 | ( codePoint >> 12 ) );
+			utf8 += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3f ) );
+			utf8 += static_cast<char>( 0x80 | ( codePoint & 0x3f ) );
+		} else {
+			utf8 += static_cast<char>( 0xf0 | ( codePoint >> 18 ) );
+			utf8 += static_cast<char>( 0x80 | ( ( codePoint >> 12 ) & 0x3f ) );
+			utf8 += static_cast<char>( 0x80 | ( ( codePoint >> 6 ) & 0x3f ) );
+			utf8 += static_cast<char>( 0x80 | ( codePoint & 0x3f ) );
+		}
+	}
+	return utf8;
+}
+
+// Opens the file 'filename' with the 'mode', returning the file stream, or nullptr if the file could not be opened.
+// 'shareFlag' - ignored.
+inline FILE* _wfsopen( const wchar_t* filename, const wchar_t* mode, const int /*shareFlag*/ )
+{
+	FILE* file = fopen( PlatformToUTF8( filename ).c_str(), PlatformToUTF8( mode ).c_str() );
+	return file;
+}
+
+#endif
@@ -4,10 +4,14 @@
 #include "VUPlayer.h"
 
 #include <fstream>
+#include <thread>
 
 // Next available playlist item ID.
 long Playlist::s_NextItemID = 0;
 
+// Maximum number of pending files to process as a single batch.
+const size_t Playlist::s_PendingBatchSize = 256;
+
 DWORD WINAPI Playlist::PendingThreadProc( LPVOID lpParam )
 {
 	Playlist* playlist = reinterpret_cast<Playlist*>( lpParam );
@@ -24,17 +28,33 @@ Playlist::Playlist( Library& library, const std::string& id, const Type& type )
 	m_Name(),
 	m_Playlist(),
 	m_Pending(),
+	m_PendingImport(),
 	m_MutexPlaylist(),
 	m_MutexPending(),
+	m_MutexImport(),
 	m_PendingThread( NULL ),
 	m_PendingStopEvent( NULL ),
 	m_PendingWakeEvent( NULL ),
 	m_RestartPendingThread( false ),
+	m_ScanThreads(),
+	m_MutexScan(),
+	m_ScanWake(),
+	m_ScanDone(),
+	m_ScanFiles( nullptr ),
+	m_ScanNextIndex( 0 ),
+	m_ScanActiveCount( 0 ),
+	m_ScanStop( false ),
 	m_Library( library ),
 	m_SortColumn( ( Type::Folder == type ) ? Column::Filename : Column::_Undefined ),
 	m_SortAscending( ( Type::Folder == type ) ? true : false ),
 	m_Type( type ),
-	m_MergeDuplicates( false )
+	m_MergeDuplicates( false ),
+	m_JournalEnabled( ( Type::User == type ) || ( Type::Favourites == type ) ),
+	m_JournalValid( true ),
+	m_Journal(),
+	m_PositionKeys(),
+	m_Filter(),
+	m_Statistics()
 {
 }
 
@@ -82,6 +102,31 @@ std::list<std::wstring> Playlist::GetPending()
 	return m_Pending;
 }
 
+void Playlist::ReadPendingImport( const size_t maxCount )
+{
+	std::lock_guard<std::mutex> importLock( m_MutexImport );
+	PlaylistImporter::Ptr importer;
+	{
+		std::lock_guard<std::mutex> lock( m_MutexPending );
+		importer = m_PendingImport;
+	}
+	if ( importer ) {
+		std::list<std::wstring> entries;
+		std::vector<std::wstring> filenames;
+		bool moreEntries = true;
+		do {
+			moreEntries = importer->Read( filenames, ( 0 == maxCount ) ? s_PendingBatchSize : maxCount );
+			entries.insert( entries.end(), filenames.begin(), filenames.end() );
+		} while ( moreEntries && ( 0 == maxCount ) );
+
+		std::lock_guard<std::mutex> lock( m_MutexPending );
+		m_Pending.splice( m_Pending.end(), entries );
+		if ( !moreEntries && ( importer == m_PendingImport ) ) {
+			m_PendingImport.reset();
+		}
+	}
+}
+
 int Playlist::GetPendingCount()
 {
 	std::lock_guard<std::mutex> lock( m_MutexPending );
@@ -190,7 +235,21 @@ Playlist::Item Playlist::AddItem( const MediaInfo& mediaInfo )
 Playlist::Item Playlist::AddItem( const MediaInfo& mediaInfo, int& position, bool& addedAsDuplicate )
 {
 	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+	const Item item = InsertItem( mediaInfo, position, addedAsDuplicate, nullptr /*positionKey*/ );
+	return item;
+}
+
+Playlist::Item Playlist::AddPersistedItem( const MediaInfo& mediaInfo, const double positionKey )
+{
+	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+	int position = 0;
+	bool addedAsDuplicate = false;
+	const Item item = InsertItem( mediaInfo, position, addedAsDuplicate, &positionKey );
+	return item;
+}
 
+Playlist::Item Playlist::InsertItem( const MediaInfo& mediaInfo, int& position, bool& addedAsDuplicate, const double* positionKey )
+{
 	Item item = {};
 	position = 0;
 	addedAsDuplicate = false;
@@ -211,13 +270,18 @@ Playlist::Item Playlist::AddItem( const MediaInfo& mediaInfo, int& position, boo
 		}
 	}
 
-	if ( !addedAsDuplicate ) {
+	if ( addedAsDuplicate ) {
+		if ( ( nullptr != positionKey ) && m_JournalEnabled && m_JournalValid ) {
+			// The persisted entry is now represented by an existing item.
+			m_Journal.push_back( { JournalType::Remove, *positionKey, mediaInfo.GetFilename() } );
+		}
+	} else {
 		item = { ++s_NextItemID, mediaInfo };
+		auto insertIter = m_Playlist.end();
 		if ( Column::_Undefined == m_SortColumn ) {
 			position = static_cast<int>( m_Playlist.size() );
-			m_Playlist.push_back( item );
 		} else {
-			auto insertIter = m_Playlist.begin();
+			insertIter = m_Playlist.begin();
 			while ( insertIter != m_Playlist.end() ) {
 				if ( m_SortAscending ? LessThan( item, *insertIter, m_SortColumn ) : GreaterThan( item, *insertIter, m_SortColumn ) ) {
 					break;
@@ -226,7 +290,13 @@ Playlist::Item Playlist::AddItem( const MediaInfo& mediaInfo, int& position, boo
 					++position;
 				}
 			}
-			m_Playlist.insert( insertIter, item );
+		}
+		const auto insertedIter = m_Playlist.insert( insertIter, item );
+		AddStatistics( mediaInfo );
+		if ( nullptr == positionKey ) {
+			JournalInsert( insertedIter );
+		} else if ( m_JournalEnabled ) {
+			m_PositionKeys[ item.ID ] = *positionKey;
 		}
 	}
 	return item;
@@ -250,10 +320,13 @@ void Playlist::OnPendingThreadHandler()
 	HANDLE eventHandles[ 2 ] = { m_PendingStopEvent, m_PendingWakeEvent };
 
 	while ( WaitForMultipleObjects( 2, eventHandles, FALSE /*waitAll*/, timeout ) != WAIT_OBJECT_0 ) {
-		std::wstring filename;
+		std::vector<std::wstring> filenames;
+		bool importPending = false;
 		{
 			std::lock_guard<std::mutex> lock( m_MutexPending );
-			if ( m_Pending.empty() ) {
+			if ( m_Pending.empty() && m_PendingImport ) {
+				importPending = true;
+			} else if ( m_Pending.empty() ) {
 				if ( WAIT_OBJECT_0 == WaitForSingleObject( m_PendingWakeEvent, 0 ) ) {
 					// Hang around for additional pending files.
 					ResetEvent( m_PendingWakeEvent );
@@ -263,35 +336,188 @@ void Playlist::OnPendingThreadHandler()
 					break;
 				}
 			} else {
-				filename = m_Pending.front();
-				m_Pending.pop_front();
+				filenames.reserve( min( m_Pending.size(), s_PendingBatchSize ) );
+				while ( !m_Pending.empty() && ( filenames.size() < s_PendingBatchSize ) ) {
+					filenames.push_back( m_Pending.front() );
+					m_Pending.pop_front();
+				}
 			}
 		}
 
-		if ( !filename.empty() ) {
-			bool addItem = true;
-			const Type type = GetType();
-			if ( ( Type::All == type ) || ( Type::Favourites == type ) || ( Type::Folder == type ) ) {
-				addItem = !ContainsFilename( filename );
+		if ( importPending ) {
+			// Read the next batch of entries from the playlist file being imported, to be processed on the next pass.
+			ReadPendingImport( s_PendingBatchSize );
+		} else if ( !filenames.empty() ) {
+			AddPendingBatch( filenames );
+		}
+	}
+	StopScanThreads();
+}
+
+void Playlist::ScanPendingFiles( std::vector<PendingFile>& pendingFiles )
+{
+	std::unique_lock<std::mutex> lock( m_MutexScan );
+	if ( m_ScanThreads.empty() ) {
+		m_ScanStop = false;
+		const size_t threadCount = max( 1, static_cast<size_t>( std::thread::hardware_concurrency() ) );
+		for ( size_t threadIndex = 0; threadIndex < threadCount; threadIndex++ ) {
+			m_ScanThreads.push_back( std::thread( &Playlist::OnScanThreadHandler, this ) );
+		}
+	}
+	m_ScanFiles = &pendingFiles;
+	m_ScanNextIndex = 0;
+	m_ScanWake.notify_all();
+	m_ScanDone.wait( lock, [ this ] ()
+	{
+		return ( 0 == m_ScanActiveCount ) && ( ( m_ScanNextIndex >= m_ScanFiles->size() ) || ( WAIT_OBJECT_0 == WaitForSingleObject( m_PendingStopEvent, 0 ) ) );
+	} );
+	m_ScanFiles = nullptr;
+}
+
+void Playlist::StopScanThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_MutexScan );
+		m_ScanStop = true;
+	}
+	m_ScanWake.notify_all();
+	for ( auto& thread : m_ScanThreads ) {
+		thread.join();
+	}
+	m_ScanThreads.clear();
+}
+
+void Playlist::OnScanThreadHandler()
+{
+	CoInitializeEx( NULL /*reserved*/, COINIT_APARTMENTTHREADED );
+	std::unique_lock<std::mutex> lock( m_MutexScan );
+	while ( !m_ScanStop ) {
+		if ( ( nullptr != m_ScanFiles ) && ( m_ScanNextIndex < m_ScanFiles->size() ) && ( WAIT_OBJECT_0 != WaitForSingleObject( m_PendingStopEvent, 0 ) ) ) {
+			PendingFile& pendingFile = ( *m_ScanFiles )[ m_ScanNextIndex++ ];
+			++m_ScanActiveCount;
+			lock.unlock();
+			pendingFile.Valid = m_Library.ScanMediaInfo( pendingFile.Info, pendingFile.InLibrary, pendingFile.Scanned );
+			pendingFile.Processed = true;
+			lock.lock();
+			--m_ScanActiveCount;
+			m_ScanDone.notify_all();
+		} else {
+			// Nothing (more) to scan, so let the pending thread know before waiting for the next batch.
+			m_ScanDone.notify_all();
+			m_ScanWake.wait( lock );
+		}
+	}
+	lock.unlock();
+	CoUninitialize();
+}
+
+void Playlist::AddPendingBatch( std::vector<std::wstring>& filenames )
+{
+	const Type type = GetType();
+	if ( ( Type::All == type ) || ( Type::Favourites == type ) || ( Type::Folder == type ) ) {
+		// Skip any files which are already in the playlist, or which occur earlier in the batch.
+		std::set<std::wstring> uniqueFilenames;
+		filenames.erase( std::remove_if( filenames.begin(), filenames.end(), [ &uniqueFilenames ] ( const std::wstring& filename )
+		{
+			return !uniqueFilenames.insert( filename ).second;
+		} ), filenames.end() );
+		{
+			std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+			for ( auto item = m_Playlist.begin(); ( m_Playlist.end() != item ) && !uniqueFilenames.empty(); item++ ) {
+				uniqueFilenames.erase( item->Info.GetFilename() );
 			}
-			if ( addItem ) {
-				MediaInfo mediaInfo( filename );
-				if ( m_Library.GetMediaInfo( mediaInfo ) ) {
-					int position = 0;
-					bool addedAsDuplicate = false;
-					const Item item = AddItem( mediaInfo, position, addedAsDuplicate );
-					VUPlayer* vuplayer = VUPlayer::Get();
-					if ( nullptr != vuplayer ) {
-						if ( addedAsDuplicate ) {
-							vuplayer->OnPlaylistItemUpdated( this, item );
-						} else {
-							vuplayer->OnPlaylistItemAdded( this, item, position );
-						}
-					}
+		}
+		filenames.erase( std::remove_if( filenames.begin(), filenames.end(), [ &uniqueFilenames ] ( const std::wstring& filename )
+		{
+			return ( uniqueFilenames.end() == uniqueFilenames.find( filename ) );
+		} ), filenames.end() );
+	}
+
+	if ( filenames.empty() ) {
+		return;
+	}
+
+	// Resolve the whole batch against the media library up front, so that only unknown files need to be scanned.
+	const std::map<std::wstring,MediaInfo> libraryMedia = m_Library.GetMediaInfo( filenames );
+	std::vector<PendingFile> pendingFiles;
+	pendingFiles.reserve( filenames.size() );
+	for ( const auto& filename : filenames ) {
+		const auto libraryInfo = libraryMedia.find( filename );
+		if ( libraryMedia.end() != libraryInfo ) {
+			pendingFiles.push_back( { libraryInfo->second, true /*inLibrary*/, false /*processed*/, false /*valid*/, false /*scanned*/ } );
+		} else {
+			pendingFiles.push_back( { MediaInfo( filename ), false /*inLibrary*/, false /*processed*/, false /*valid*/, false /*scanned*/ } );
+		}
+	}
+
+	// Scan the files concurrently.
+	ScanPendingFiles( pendingFiles );
+
+	// Only the leading run of processed files can be added without disturbing the file order.
+	const auto firstUnprocessed = std::find_if( pendingFiles.begin(), pendingFiles.end(), [] ( const PendingFile& pendingFile )
+	{
+		return !pendingFile.Processed;
+	} );
+	if ( pendingFiles.end() != firstUnprocessed ) {
+		std::lock_guard<std::mutex> lock( m_MutexPending );
+		for ( auto pendingFile = pendingFiles.rbegin(); pendingFile.base() != firstUnprocessed; pendingFile++ ) {
+			m_Pending.push_front( pendingFile->Info.GetFilename() );
+		}
+	}
+
+	// Write any newly scanned files to the media library.
+	MediaInfo::List scannedMedia;
+	for ( auto pendingFile = pendingFiles.begin(); firstUnprocessed != pendingFile; pendingFile++ ) {
+		if ( pendingFile->Valid && pendingFile->Scanned ) {
+			scannedMedia.push_back( pendingFile->Info );
+		}
+	}
+	m_Library.AddToLibrary( scannedMedia );
+
+	// Add the items to the playlist, in the original order.
+	VUPlayer* vuplayer = VUPlayer::Get();
+	ItemPositionList addedItems;
+	for ( auto pendingFile = pendingFiles.begin(); firstUnprocessed != pendingFile; pendingFile++ ) {
+		if ( pendingFile->Valid ) {
+			int position = 0;
+			bool addedAsDuplicate = false;
+			const Item item = AddItem( pendingFile->Info, position, addedAsDuplicate );
+			if ( addedAsDuplicate ) {
+				// Flush any added items first, as the duplicate might refer to one of them.
+				NotifyItemsAdded( addedItems );
+				if ( nullptr != vuplayer ) {
+					vuplayer->OnPlaylistItemUpdated( this, item );
 				}
+			} else {
+				addedItems.push_back( ItemPositionList::value_type( item, position ) );
 			}
 		}
 	}
+	NotifyItemsAdded( addedItems );
+}
+
+void Playlist::NotifyItemsAdded( ItemPositionList& addedItems )
+{
+	if ( !addedItems.empty() ) {
+		VUPlayer* vuplayer = VUPlayer::Get();
+		if ( nullptr != vuplayer ) {
+			vuplayer->OnPlaylistItemsAdded( this, addedItems );
+		}
+		addedItems.clear();
+	}
+}
+
+void Playlist::AddPendingImport( const PlaylistImporter::Ptr importer, const bool startPendingThread )
+{
+	if ( importer && importer->IsOpen() ) {
+		{
+			std::lock_guard<std::mutex> lock( m_MutexPending );
+			m_PendingImport = importer;
+		}
+		if ( startPendingThread ) {
+			StartPendingThread();
+		}
+	}
 }
 
 void Playlist::StartPendingThread()
@@ -354,6 +580,8 @@ bool Playlist::RemoveItem( const Item& item )
 	bool removed = false;
 	for ( auto iter = m_Playlist.begin(); iter != m_Playlist.end(); iter++ ) {
 		if ( iter->ID == item.ID ) {
+			JournalRemove( *iter );
+			RemoveStatistics( iter->Info );
 			m_Playlist.erase( iter );
 			VUPlayer* vuplayer = VUPlayer::Get();
 			if ( nullptr != vuplayer ) {
@@ -375,6 +603,8 @@ bool Playlist::RemoveItem( const MediaInfo& mediaInfo )
 		if ( iter->Info.GetFilename() == mediaInfo.GetFilename() ) {
 			if ( iter->Duplicates.empty() ) {
 				const Item item = *iter;
+				JournalRemove( item );
+				RemoveStatistics( item.Info );
 				m_Playlist.erase( iter );
 				VUPlayer* vuplayer = VUPlayer::Get();
 				if ( nullptr != vuplayer ) {
@@ -382,8 +612,12 @@ bool Playlist::RemoveItem( const MediaInfo& mediaInfo )
 				}
 				removed = true;
 			} else {
+				JournalRemove( *iter );
+				RemoveStatistics( iter->Info );
 				iter->Info.SetFilename( iter->Duplicates.front() );
 				iter->Duplicates.pop_front();
+				AddStatistics( iter->Info );
+				JournalInsert( iter );
 			}
 			break;
 		} else if ( !iter->Duplicates.empty() ) {
@@ -405,23 +639,47 @@ long Playlist::GetCount()
 float Playlist::GetDuration()
 {
 	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
-	float duration = 0;
-	for ( const auto& iter : m_Playlist ) {
-		const MediaInfo& mediaInfo = iter.Info;
-		duration += mediaInfo.GetDuration();
-	}
-	return duration;
+	return static_cast<float>( m_Statistics.Duration );
 }
 
 long long Playlist::GetFilesize()
 {
 	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
-	long long filesize = 0;
-	for ( const auto& iter : m_Playlist ) {
-		const MediaInfo& mediaInfo = iter.Info;
-		filesize += mediaInfo.GetFilesize();
+	return m_Statistics.Filesize;
+}
+
+Library::Statistics Playlist::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+	return m_Statistics;
+}
+
+void Playlist::AddStatistics( const MediaInfo& mediaInfo )
+{
+	++m_Statistics.Count;
+	m_Statistics.Duration += mediaInfo.GetDuration();
+	m_Statistics.Filesize += mediaInfo.GetFilesize();
+	++m_Statistics.Types[ mediaInfo.GetType() ];
+	++m_Statistics.SampleRates[ mediaInfo.GetSampleRate() ];
+}
+
+void Playlist::RemoveStatistics( const MediaInfo& mediaInfo )
+{
+	--m_Statistics.Count;
+	m_Statistics.Duration -= mediaInfo.GetDuration();
+	m_Statistics.Filesize -= mediaInfo.GetFilesize();
+	const auto type = m_Statistics.Types.find( mediaInfo.GetType() );
+	if ( ( m_Statistics.Types.end() != type ) && ( --type->second <= 0 ) ) {
+		m_Statistics.Types.erase( type );
+	}
+	const auto sampleRate = m_Statistics.SampleRates.find( mediaInfo.GetSampleRate() );
+	if ( ( m_Statistics.SampleRates.end() != sampleRate ) && ( --sampleRate->second <= 0 ) ) {
+		m_Statistics.SampleRates.erase( sampleRate );
+	}
+	if ( 0 == m_Statistics.Count ) {
+		// Reset any accumulated rounding error.
+		m_Statistics.Duration = 0;
 	}
-	return filesize;
 }
 
 void Playlist::GetSort( Column& column, bool& ascending ) const
@@ -440,6 +698,7 @@ void Playlist::Sort( const Column column )
 	}
 	if ( Column::_Undefined != m_SortColumn ) {
 		std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+		InvalidateJournal();
 		m_Playlist.sort( [ = ] ( const Item& item1, const Item& item2 ) -> bool
 		{
 			return m_SortAscending ? LessThan( item1, item2, m_SortColumn ) : GreaterThan( item1, item2, m_SortColumn );
@@ -542,7 +801,9 @@ bool Playlist::OnUpdatedMedia( const MediaInfo& mediaInfo )
 		std::lock_guard<std::mutex> lock( m_MutexPlaylist );
 		for ( auto& item : m_Playlist ) {
 			if ( item.Info.GetFilename() == mediaInfo.GetFilename() ) {
+				RemoveStatistics( item.Info );
 				item.Info = mediaInfo;
+				AddStatistics( item.Info );
 				updated = true;
 
 				if ( m_MergeDuplicates ) {
@@ -611,6 +872,53 @@ bool Playlist::OnUpdatedMedia( const MediaInfo& mediaInfo )
 	return updated;
 }
 
+bool Playlist::OnUpdatedMedia( const MediaInfo& previousMediaInfo, const MediaInfo& updatedMediaInfo )
+{
+	bool updated = false;
+	if ( m_Filter ) {
+		// Membership is determined by the filter, so there is no need to search the playlist unless the media matches (or used to match).
+		if ( m_Filter->Matches( updatedMediaInfo ) ) {
+			updated = OnUpdatedMedia( updatedMediaInfo );
+			if ( !updated ) {
+				int position = 0;
+				bool addedAsDuplicate = false;
+				const Item item = AddItem( updatedMediaInfo, position, addedAsDuplicate );
+				VUPlayer* vuplayer = VUPlayer::Get();
+				if ( nullptr != vuplayer ) {
+					if ( addedAsDuplicate ) {
+						vuplayer->OnPlaylistItemUpdated( this, item );
+					} else {
+						vuplayer->OnPlaylistItemAdded( this, item, position );
+					}
+				}
+				updated = true;
+			}
+		} else if ( m_Filter->Matches( previousMediaInfo ) ) {
+			RemoveItem( previousMediaInfo );
+			updated = true;
+		}
+	} else {
+		updated = OnUpdatedMedia( updatedMediaInfo );
+	}
+	return updated;
+}
+
+MediaFilter::Ptr Playlist::GetFilter() const
+{
+	return m_Filter;
+}
+
+void Playlist::SetFilter( const MediaFilter::Ptr filter )
+{
+	m_Filter = filter;
+	if ( m_Filter ) {
+		const MediaInfo::List mediaList = m_Library.GetMediaByFilter( *m_Filter );
+		for ( const auto& mediaInfo : mediaList ) {
+			AddItem( mediaInfo );
+		}
+	}
+}
+
 bool Playlist::MoveItems( const int position, const std::list<long>& items )
 {
 	bool changed = false;
@@ -647,6 +955,7 @@ bool Playlist::MoveItems( const int position, const std::list<long>& items )
 	if ( changed ) {
 		m_SortColumn = Column::_Undefined;
 		m_SortAscending = false;
+		InvalidateJournal();
 	}
 	return changed;
 }
@@ -656,18 +965,6 @@ Playlist::Type Playlist::GetType() const
 	return m_Type;
 }
 
-bool Playlist::ContainsFilename( const std::wstring& filename )
-{
-	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
-	bool containsFilename = false;
-	auto iter = m_Playlist.begin();
-	while ( !containsFilename && ( m_Playlist.end() != iter ) ) {
-		containsFilename = ( filename == iter->Info.GetFilename() );
-		++iter;
-	}
-	return containsFilename;
-}
-
 void Playlist::SetMergeDuplicates( const bool merge )
 {
 	if ( merge != m_MergeDuplicates ) {
@@ -693,6 +990,8 @@ void Playlist::MergeDuplicates()
 		while ( m_Playlist.end() != secondItem ) {
 			if ( firstItem->Info.IsDuplicate( secondItem->Info ) ) {
 				itemsRemoved.push_back( *secondItem );
+				JournalRemove( *secondItem );
+				RemoveStatistics( secondItem->Info );
 				const auto foundDuplicate = std::find( firstItem->Duplicates.begin(), firstItem->Duplicates.end(), secondItem->Info.GetFilename() );
 				if ( firstItem->Duplicates.end() == foundDuplicate ) {
 					firstItem->Duplicates.push_back( secondItem->Info.GetFilename() );
@@ -773,6 +1072,79 @@ void Playlist::UpdateItem( const Item& item )
 		return ( item.ID == entry.ID );
 	} );
 	if ( m_Playlist.end() != foundItem ) {
+		RemoveStatistics( foundItem->Info );
 		*foundItem = item;
+		AddStatistics( foundItem->Info );
 	}
 }
+
+bool Playlist::TakeJournal( Journal& journal, ItemList& items )
+{
+	std::lock_guard<std::mutex> lock( m_MutexPlaylist );
+	journal.clear();
+	items.clear();
+	const bool incremental = m_JournalValid;
+	if ( incremental ) {
+		journal.swap( m_Journal );
+	} else {
+		double positionKey = 0;
+		for ( const auto& item : m_Playlist ) {
+			m_PositionKeys[ item.ID ] = ++positionKey;
+		}
+		items = m_Playlist;
+		m_JournalValid = true;
+	}
+	return incremental;
+}
+
+void Playlist::JournalInsert( const ItemList::const_iterator item )
+{
+	if ( m_JournalEnabled && ( m_Playlist.end() != item ) ) {
+		// Position keys are fractional, so that an item can be inserted between any two others without renumbering.
+		auto getPositionKey = [ this ] ( const ItemList::const_iterator iter ) -> double
+		{
+			const auto positionKey = m_PositionKeys.find( iter->ID );
+			return ( m_PositionKeys.end() != positionKey ) ? positionKey->second : 0;
+		};
+		const auto nextItem = std::next( item );
+		const bool hasPrevious = ( m_Playlist.begin() != item );
+		const bool hasNext = ( m_Playlist.end() != nextItem );
+		double positionKey = 1;
+		if ( hasPrevious && hasNext ) {
+			const double previousKey = getPositionKey( std::prev( item ) );
+			const double nextKey = getPositionKey( nextItem );
+			positionKey = previousKey + ( nextKey - previousKey ) / 2;
+			if ( ( positionKey <= previousKey ) || ( positionKey >= nextKey ) ) {
+				// No more room between the neighbouring keys, so the playlist needs to be renumbered when next saved.
+				InvalidateJournal();
+			}
+		} else if ( hasPrevious ) {
+			positionKey = getPositionKey( std::prev( item ) ) + 1;
+		} else if ( hasNext ) {
+			positionKey = getPositionKey( nextItem ) - 1;
+		}
+		m_PositionKeys[ item->ID ] = positionKey;
+		if ( m_JournalValid ) {
+			m_Journal.push_back( { JournalType::Insert, positionKey, item->Info.GetFilename() } );
+		}
+	}
+}
+
+void Playlist::JournalRemove( const Item& item )
+{
+	if ( m_JournalEnabled ) {
+		const auto positionKey = m_PositionKeys.find( item.ID );
+		if ( m_PositionKeys.end() != positionKey ) {
+			if ( m_JournalValid ) {
+				m_Journal.push_back( { JournalType::Remove, positionKey->second, item.Info.GetFilename() } );
+			}
+			m_PositionKeys.erase( positionKey );
+		}
+	}
+}
+
+void Playlist::InvalidateJournal()
+{
+	m_JournalValid = false;
+	m_Journal.clear();
+}
@@ -3,11 +3,17 @@
 #include "stdafx.h"
 
 #include "Library.h"
+#include "MediaFilter.h"
+#include "PlaylistImporter.h"
 
 #include <atomic>
+#include <condition_variable>
 #include <list>
+#include <map>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 class Playlist
 {
@@ -77,6 +83,25 @@ public:
 	// List of playlist items.
 	typedef std::list<Item> ItemList;
 
+	// List of playlist items, paired with their (0-based) playlist position.
+	typedef std::list<std::pair<Item,int>> ItemPositionList;
+
+	// Edit journal entry type.
+	enum class JournalType {
+		Insert,
+		Remove
+	};
+
+	// Edit journal entry, recording a change to be persisted.
+	struct JournalEntry {
+		JournalType Type;				// Change type.
+		double PositionKey;			// Persisted position key of the inserted or removed item.
+		std::wstring Filename;	// Filename of the inserted or removed item.
+	};
+
+	// Edit journal.
+	typedef std::list<JournalEntry> Journal;
+
 	// Playlist shared pointer type.
 	typedef std::shared_ptr<Playlist> Ptr;
 
@@ -95,9 +120,13 @@ public:
 	// Returns the playlist items.
 	ItemList GetItems();
 
-	// Returns the pending files.
+	// Returns the pending files (call ReadPendingImport first for these to include all entries of any playlist file being imported).
 	std::list<std::wstring> GetPending();
 
+	// Reads entries of any playlist file being imported, appending them to the pending files.
+	// 'maxCount' - maximum number of entries to read, or zero to read all remaining entries.
+	void ReadPendingImport( const size_t maxCount = 0 );
+
 	// Returns the number of pending files.
 	int GetPendingCount();
 
@@ -137,10 +166,20 @@ public:
 	// 'addedAsDuplicate' - out, whether the item was added as a duplicate of an existing item (which is returned).
 	Item AddItem( const MediaInfo& mediaInfo, int& position, bool& addedAsDuplicate );
 
+	// Adds previously persisted 'mediaInfo' to the playlist, returning the added item.
+	// 'positionKey' - persisted position key of the item.
+	// The addition is not recorded in the edit journal, as the item already exists in the persisted playlist.
+	Item AddPersistedItem( const MediaInfo& mediaInfo, const double positionKey );
+
 	// Adds 'filename' to the list of pending files to be added to the playlist.
 	// 'startPendingThread' - whether to start the background thread to process pending files.
 	void AddPending( const std::wstring& filename, const bool startPendingThread = true );
 
+	// Adds the entries of a playlist file to the list of pending files, reading the playlist file in batches on the pending file thread.
+	// 'importer' - playlist importer.
+	// 'startPendingThread' - whether to start the background thread to process pending files.
+	void AddPendingImport( const PlaylistImporter::Ptr importer, const bool startPendingThread = true );
+
 	// Starts the thread for adding pending files to the playlist.
 	void StartPendingThread();
 
@@ -171,6 +210,10 @@ public:
 	// Returns the total playlist file size, in bytes.
 	long long GetFilesize();
 
+	// Returns a snapshot of the playlist statistics, which are maintained as items are added, updated & removed.
+	// Statistics are for the top level playlist items (merged duplicates are not included).
+	Library::Statistics GetStatistics();
+
 	// Gets the current playlist sort information.
 	// 'column' - out, sort type (or 'undefined' if not sorted).
 	// 'ascending' - out, true if sorted in ascending order, false if in descending order (only valid if sorted).
@@ -184,6 +227,18 @@ public:
 	// Returns true if any playlist items matched the 'mediaInfo' filename, and were updated.
 	bool OnUpdatedMedia( const MediaInfo& mediaInfo );
 
+	// Updates the playlist media information, and for a smart playlist, updates the playlist membership according to the filter.
+	// 'previousMediaInfo' - previous media information.
+	// 'updatedMediaInfo' - updated media information.
+	// Returns true if the playlist was updated.
+	bool OnUpdatedMedia( const MediaInfo& previousMediaInfo, const MediaInfo& updatedMediaInfo );
+
+	// Returns the filter which defines the playlist contents, or nullptr if this is not a smart playlist.
+	MediaFilter::Ptr GetFilter() const;
+
+	// Sets the 'filter' which defines the playlist contents, and fills the playlist from the media library.
+	void SetFilter( const MediaFilter::Ptr filter );
+
 	// Moves 'items' to a 'position' in the playlist.
 	// Returns whether any items have effectively moved position.
 	bool MoveItems( const int position, const std::list<long>& items );
@@ -197,7 +252,22 @@ public:
 	// Updates the 'item' in the playlist.
 	void UpdateItem( const Item& item );
 
+	// Takes the changes to be persisted since the playlist was last saved, and resets the edit journal.
+	// 'journal' - out, item insertions and removals in the order they were made, if the playlist can be saved incrementally.
+	// 'items' - out, all playlist items, if the playlist must be saved in full (position keys are renumbered sequentially from 1).
+	// Returns true if the playlist can be saved incrementally from the 'journal', false if it must be saved in full from the 'items'.
+	bool TakeJournal( Journal& journal, ItemList& items );
+
 private:
+	// Pending file scan state.
+	struct PendingFile {
+		MediaInfo Info;		// Media information.
+		bool InLibrary;		// Whether the file is already in the media library.
+		bool Processed;		// Whether the file has been processed.
+		bool Valid;				// Whether the file is a valid media file.
+		bool Scanned;			// Whether the file was scanned (rather than being up to date in the media library).
+	};
+
 	// Pending file thread proc.
 	static DWORD WINAPI PendingThreadProc( LPVOID lpParam );
 
@@ -210,11 +280,49 @@ private:
 	// Next available playlist item ID.
 	static long s_NextItemID;
 
+	// Maximum number of pending files to process as a single batch.
+	static const size_t s_PendingBatchSize;
+
 	// Thread handler for processing the list of pending files.
 	void OnPendingThreadHandler();
 
-	// Returns whether the playlist contains 'filename'.
-	bool ContainsFilename( const std::wstring& filename );
+	// Adds 'mediaInfo' to the playlist, returning the added item (the playlist mutex must be held).
+	// 'position' - out, 0-based index of the added item position.
+	// 'addedAsDuplicate' - out, whether the item was added as a duplicate of an existing item (which is returned).
+	// 'positionKey' - persisted position key of the item, or nullptr to assign a new key and record the insertion in the edit journal.
+	Item InsertItem( const MediaInfo& mediaInfo, int& position, bool& addedAsDuplicate, const double* positionKey );
+
+	// Assigns a position key to the newly inserted 'item', and records the insertion in the edit journal (the playlist mutex must be held).
+	void JournalInsert( const ItemList::const_iterator item );
+
+	// Records the removal of 'item' in the edit journal (the playlist mutex must be held).
+	void JournalRemove( const Item& item );
+
+	// Discards the edit journal, so that the playlist will next be saved in full (the playlist mutex must be held).
+	void InvalidateJournal();
+
+	// Adds 'mediaInfo' to the playlist statistics (the playlist mutex must be held).
+	void AddStatistics( const MediaInfo& mediaInfo );
+
+	// Removes 'mediaInfo' from the playlist statistics (the playlist mutex must be held).
+	void RemoveStatistics( const MediaInfo& mediaInfo );
+
+	// Adds a batch of pending files to the playlist, preserving the order of the 'filenames'.
+	// Files are scanned concurrently, the media library is updated in a single transaction, and added items are notified as a single chunk.
+	// Any files which could not be processed, because the pending thread is stopping, are returned to the front of the pending list.
+	void AddPendingBatch( std::vector<std::wstring>& filenames );
+
+	// Scans the 'pendingFiles' using the pool of scan threads, returning once all files have been processed (or the pending thread is stopping).
+	void ScanPendingFiles( std::vector<PendingFile>& pendingFiles );
+
+	// Stops the pool of scan threads.
+	void StopScanThreads();
+
+	// Thread handler for scanning pending files.
+	void OnScanThreadHandler();
+
+	// Notifies the main app of a chunk of 'addedItems', then clears the list.
+	void NotifyItemsAdded( ItemPositionList& addedItems );
 
 	// Merges any duplicate items.
 	void MergeDuplicates();
@@ -237,12 +345,18 @@ private:
 	// Pending files to be added to the playlist.
 	std::list<std::wstring> m_Pending;
 
+	// Playlist file being imported, whose remaining entries are to be added to the playlist once the pending files have been processed.
+	PlaylistImporter::Ptr m_PendingImport;
+
 	// Playlist mutex.
 	std::mutex m_MutexPlaylist;
 
 	// Pending files mutex.
 	std::mutex m_MutexPending;
 
+	// Serialises reading from the playlist file being imported, which is done without holding the pending files mutex.
+	std::mutex m_MutexImport;
+
 	// The thread for adding pending files to the playlist.
 	HANDLE m_PendingThread;
 
@@ -255,6 +369,30 @@ private:
 	// Indicates whether the pending files thread should be restarted.
 	std::atomic<bool> m_RestartPendingThread;
 
+	// Pool of threads for scanning pending files, which persists for the lifetime of the pending file thread.
+	std::vector<std::thread> m_ScanThreads;
+
+	// Scan thread mutex.
+	std::mutex m_MutexScan;
+
+	// Signalled when there are pending files to scan, or when the scan threads should stop.
+	std::condition_variable m_ScanWake;
+
+	// Signalled when a scan thread has finished with a pending file.
+	std::condition_variable m_ScanDone;
+
+	// Pending files currently being scanned, or nullptr if there are none.
+	std::vector<PendingFile>* m_ScanFiles;
+
+	// Index of the next pending file to scan.
+	size_t m_ScanNextIndex;
+
+	// Number of pending files currently being scanned.
+	size_t m_ScanActiveCount;
+
+	// Indicates whether the scan threads should stop.
+	bool m_ScanStop;
+
 	// Media library.
 	Library& m_Library;
 
@@ -269,6 +407,24 @@ private:
 
 	// Whether duplicate items should be merged into a single playlist entry.
 	bool m_MergeDuplicates;
+
+	// Whether changes are recorded in the edit journal (only for playlists which are persisted).
+	const bool m_JournalEnabled;
+
+	// Whether the edit journal is valid, or whether the playlist must be saved in full.
+	bool m_JournalValid;
+
+	// Changes to be persisted since the playlist was last saved.
+	Journal m_Journal;
+
+	// Maps a playlist item ID to its persisted position key.
+	std::map<long,double> m_PositionKeys;
+
+	// Filter which defines the contents of a smart playlist.
+	MediaFilter::Ptr m_Filter;
+
+	// Playlist statistics.
+	Library::Statistics m_Statistics;
 };
 
 // A list of playlists.
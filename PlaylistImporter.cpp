@@ -0,0 +1,153 @@
+#include "PlaylistImporter.h"
+
+#include <Shlwapi.h>
+
+#include "Utility.h"
+
+PlaylistImporter::PlaylistImporter( const std::wstring& filename ) :
+	m_Stream(),
+	m_Format( Format::VPL ),
+	m_PlaylistPath(),
+	m_UTF8( false )
+{
+	const std::wstring fileExt = GetFileExtension( filename );
+	if ( L"vpl" == fileExt ) {
+		m_Format = Format::VPL;
+	} else if ( ( L"m3u" == fileExt ) || ( L"m3u8" == fileExt ) ) {
+		m_Format = Format::M3U;
+		m_UTF8 = ( L"m3u8" == fileExt );
+	} else if ( L"pls" == fileExt ) {
+		m_Format = Format::PLS;
+	}
+
+	const size_t pathDelimiter = filename.find_last_of( L"/\\" );
+	if ( std::wstring::npos != pathDelimiter ) {
+		m_PlaylistPath = filename.substr( 0 /*offset*/, pathDelimiter );
+	}
+
+	if ( IsSupported( filename ) ) {
+		try {
+			m_Stream.open( filename, ( Format::VPL == m_Format ) ? ( std::ios::binary | std::ios::in ) : std::ios::in );
+			if ( m_Stream.is_open() && ( Format::VPL != m_Format ) ) {
+				// Skip any UTF-8 byte order mark.
+				char bom[ 3 ] = {};
+				m_Stream.read( bom, 3 );
+				if ( ( 3 == m_Stream.gcount() ) && ( '\xEF' == bom[ 0 ] ) && ( '\xBB' == bom[ 1 ] ) && ( '\xBF' == bom[ 2 ] ) ) {
+					m_UTF8 = true;
+				} else {
+					m_Stream.clear();
+					m_Stream.seekg( 0 );
+				}
+			}
+		} catch ( ... ) {
+		}
+	}
+}
+
+PlaylistImporter::~PlaylistImporter()
+{
+	try {
+		if ( m_Stream.is_open() ) {
+			m_Stream.close();
+		}
+	} catch ( ... ) {
+	}
+}
+
+bool PlaylistImporter::IsSupported( const std::wstring& filename )
+{
+	const std::wstring fileExt = GetFileExtension( filename );
+	const bool supported = ( L"vpl" == fileExt ) || ( L"m3u" == fileExt ) || ( L"m3u8" == fileExt ) || ( L"pls" == fileExt );
+	return supported;
+}
+
+bool PlaylistImporter::IsOpen() const
+{
+	return m_Stream.is_open();
+}
+
+bool PlaylistImporter::Read( std::vector<std::wstring>& filenames, const size_t maxCount )
+{
+	filenames.clear();
+	bool moreEntries = false;
+	try {
+		if ( m_Stream.is_open() ) {
+			std::string line;
+			while ( ( filenames.size() < maxCount ) && std::getline( m_Stream, line ) ) {
+				const std::wstring filename = ParseLine( line );
+				if ( !filename.empty() ) {
+					filenames.push_back( filename );
+				}
+			}
+			moreEntries = m_Stream.good();
+		}
+	} catch ( ... ) {
+	}
+	return moreEntries;
+}
+
+std::wstring PlaylistImporter::ParseLine( const std::string& line ) const
+{
+	std::string entry;
+	switch ( m_Format ) {
+		case Format::VPL : {
+			const size_t delimiter = line.find_first_of( 0x01 );
+			if ( std::string::npos != delimiter ) {
+				entry = line.substr( 0 /*offset*/, delimiter /*count*/ );
+			}
+			break;
+		}
+		case Format::M3U : {
+			if ( !line.empty() && ( '#' != line.front() ) ) {
+				entry = line;
+			}
+			break;
+		}
+		case Format::PLS : {
+			const size_t fileEntry = line.find( "File" );
+			const size_t delimiter = line.find_first_of( '=' );
+			if ( ( 0 == fileEntry ) && ( std::string::npos != delimiter ) ) {
+				entry = line.substr( delimiter + 1 );
+			}
+			break;
+		}
+	}
+
+	std::wstring filename;
+	if ( Format::VPL == m_Format ) {
+		filename = AnsiCodePageToWideString( entry );
+	} else {
+		const size_t entryEnd = entry.find_last_not_of( " \t\r\n" );
+		entry = ( std::string::npos != entryEnd ) ? entry.substr( 0 /*offset*/, entryEnd + 1 ) : std::string();
+		if ( !entry.empty() ) {
+			filename = NormalisePath( m_UTF8 ? UTF8ToWideString( entry ) : AnsiCodePageToWideString( entry ) );
+		}
+	}
+	return filename;
+}
+
+std::wstring PlaylistImporter::NormalisePath( const std::wstring& filename ) const
+{
+	std::wstring path( filename );
+	WCHAR buffer[ MAX_PATH + 1 ] = {};
+	if ( 0 != ExpandEnvironmentStrings( path.c_str(), buffer, MAX_PATH ) ) {
+		path = buffer;
+	}
+	if ( TRUE == PathIsURL( path.c_str() ) ) {
+		DWORD bufferSize = MAX_PATH;
+		if ( SUCCEEDED( PathCreateFromUrl( path.c_str(), buffer, &bufferSize, 0 /*reserved*/ ) ) ) {
+			path = buffer;
+		}
+	}
+	if ( TRUE == PathIsRelative( path.c_str() ) ) {
+		if ( !m_PlaylistPath.empty() ) {
+			// Use legacy PathCombine function to maintain Windows 7 support.
+			if ( nullptr != PathCombine( buffer, m_PlaylistPath.c_str(), path.c_str() ) ) {
+				path = buffer;
+			}
+		}
+	} else if ( FALSE != PathCanonicalize( buffer, path.c_str() ) ) {
+		path = buffer;
+	}
+	return path;
+}
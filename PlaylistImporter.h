@@ -0,0 +1,59 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reads the entries of a VPL, M3U or PLS playlist file incrementally, so that large playlists can be imported in batches.
+class PlaylistImporter
+{
+public:
+	// Playlist importer shared pointer type.
+	typedef std::shared_ptr<PlaylistImporter> Ptr;
+
+	// 'filename' - playlist filename.
+	PlaylistImporter( const std::wstring& filename );
+
+	virtual ~PlaylistImporter();
+
+	// Returns whether 'filename' is a playlist file format that can be imported.
+	static bool IsSupported( const std::wstring& filename );
+
+	// Returns whether the playlist file was opened.
+	bool IsOpen() const;
+
+	// Reads the next batch of entries from the playlist file.
+	// 'filenames' - out, absolute filenames of the entries read (which have not been checked for existence).
+	// 'maxCount' - maximum number of entries to read.
+	// Returns true if there might be further entries to read, false if the end of the playlist file has been reached.
+	bool Read( std::vector<std::wstring>& filenames, const size_t maxCount );
+
+private:
+	// Playlist file format.
+	enum class Format {
+		VPL,
+		M3U,
+		PLS
+	};
+
+	// Returns the entry filename from a playlist file 'line', or an empty string if the line is not an entry.
+	std::wstring ParseLine( const std::string& line ) const;
+
+	// Returns the absolute, canonical form of an entry 'filename'.
+	std::wstring NormalisePath( const std::wstring& filename ) const;
+
+	// Playlist file stream.
+	std::ifstream m_Stream;
+
+	// Playlist file format.
+	Format m_Format;
+
+	// Folder containing the playlist file, against which relative entries are resolved.
+	std::wstring m_PlaylistPath;
+
+	// Whether the playlist file is UTF-8 encoded.
+	bool m_UTF8;
+};
@@ -0,0 +1,220 @@
+#include "Prefetcher.h"
+
+#include <algorithm>
+
+// Number of bytes to prefetch from the start of each file.
+static const DWORD s_HeadSize = 0x400000;
+
+// Maximum number of bytes of prefetched data to hold in memory.
+static const size_t s_MemoryBudget = 0x1000000;
+
+Prefetcher* Prefetcher::s_Prefetcher = nullptr;
+
+std::mutex Prefetcher::s_PrefetcherMutex;
+
+DWORD WINAPI Prefetcher::PrefetchThreadProc( LPVOID lpParam )
+{
+	Prefetcher* prefetcher = static_cast<Prefetcher*>( lpParam );
+	if ( nullptr != prefetcher ) {
+		prefetcher->PrefetchHandler();
+	}
+	return 0;
+}
+
+Prefetcher::Prefetcher( UpcomingCallback upcomingCallback ) :
+	m_UpcomingCallback( upcomingCallback ),
+	m_Filenames(),
+	m_Generation( 0 ),
+	m_Heads(),
+	m_Statistics( {} ),
+	m_Mutex(),
+	m_Thread( nullptr ),
+	m_StopEvent( CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
+	m_WakeEvent( CreateEvent( NULL /*attributes*/, FALSE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
+	m_UpdateEvent( CreateEvent( NULL /*attributes*/, TRUE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) )
+{
+	m_Thread = CreateThread( NULL /*attributes*/, 0 /*stackSize*/, PrefetchThreadProc, reinterpret_cast<LPVOID>( this ), 0 /*flags*/, NULL /*threadId*/ );
+	std::lock_guard<std::mutex> lock( s_PrefetcherMutex );
+	if ( nullptr == s_Prefetcher ) {
+		s_Prefetcher = this;
+	}
+}
+
+Prefetcher::~Prefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock( s_PrefetcherMutex );
+		if ( this == s_Prefetcher ) {
+			s_Prefetcher = nullptr;
+		}
+	}
+	if ( nullptr != m_Thread ) {
+		SetEvent( m_StopEvent );
+		WaitForSingleObject( m_Thread, INFINITE );
+		CloseHandle( m_Thread );
+	}
+	CloseHandle( m_StopEvent );
+	CloseHandle( m_WakeEvent );
+	CloseHandle( m_UpdateEvent );
+}
+
+void Prefetcher::SetFilenames( const std::vector<std::wstring>& filenames )
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	if ( filenames != m_Filenames ) {
+		m_Filenames = filenames;
+		++m_Generation;
+		for ( auto head = m_Heads.begin(); m_Heads.end() != head; ) {
+			if ( m_Filenames.end() == std::find( m_Filenames.begin(), m_Filenames.end(), head->first ) ) {
+				head = m_Heads.erase( head );
+			} else {
+				++head;
+			}
+		}
+		SetEvent( m_WakeEvent );
+	}
+}
+
+void Prefetcher::RequestUpdate()
+{
+	SetEvent( m_UpdateEvent );
+}
+
+bool Prefetcher::IsPrefetched( const std::wstring& filename )
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	const bool prefetched = ( m_Heads.end() != m_Heads.find( filename ) );
+	return prefetched;
+}
+
+void Prefetcher::AddTransition( const bool prefetched, const float timeToFirstSample )
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	const long previousCount = m_Statistics.Hits + m_Statistics.Misses;
+	if ( prefetched ) {
+		++m_Statistics.Hits;
+	} else {
+		++m_Statistics.Misses;
+	}
+	m_Statistics.LastTimeToFirstSample = timeToFirstSample;
+	m_Statistics.AverageTimeToFirstSample = ( m_Statistics.AverageTimeToFirstSample * previousCount + timeToFirstSample ) / ( previousCount + 1 );
+}
+
+Prefetcher::Statistics Prefetcher::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock( m_Mutex );
+	return m_Statistics;
+}
+
+Prefetcher::Head Prefetcher::GetHead( const std::wstring& filename, const long long fileSize, const long long lastWriteTime )
+{
+	Head head;
+	std::lock_guard<std::mutex> prefetcherLock( s_PrefetcherMutex );
+	if ( nullptr != s_Prefetcher ) {
+		std::lock_guard<std::mutex> lock( s_Prefetcher->m_Mutex );
+		const auto iter = s_Prefetcher->m_Heads.find( filename );
+		if ( s_Prefetcher->m_Heads.end() != iter ) {
+			if ( ( fileSize == iter->second.FileSize ) && ( lastWriteTime == iter->second.LastWriteTime ) ) {
+				head = iter->second.Data;
+			} else {
+				// The file has been modified (e.g. by a tag update) since it was prefetched.
+				s_Prefetcher->m_Heads.erase( iter );
+			}
+		}
+	}
+	return head;
+}
+
+bool Prefetcher::IsInterrupted() const
+{
+	const HANDLE events[ 2 ] = { m_StopEvent, m_UpdateEvent };
+	const bool interrupted = ( WAIT_TIMEOUT != WaitForMultipleObjects( 2 /*count*/, events, FALSE /*waitAll*/, 0 /*milliseconds*/ ) );
+	return interrupted;
+}
+
+void Prefetcher::PrefetchHandler()
+{
+	// Update requests take priority over prefetching, as the upcoming filenames may have changed.
+	const HANDLE events[ 3 ] = { m_StopEvent, m_UpdateEvent, m_WakeEvent };
+	DWORD result = WaitForMultipleObjects( 3 /*count*/, events, FALSE /*waitAll*/, INFINITE );
+	while ( ( ( WAIT_OBJECT_0 + 1 ) == result ) || ( ( WAIT_OBJECT_0 + 2 ) == result ) ) {
+		if ( ( WAIT_OBJECT_0 + 1 ) == result ) {
+			ResetEvent( m_UpdateEvent );
+			if ( m_UpcomingCallback ) {
+				SetFilenames( m_UpcomingCallback() );
+			}
+		} else {
+			Prefetch();
+		}
+		result = WaitForMultipleObjects( 3 /*count*/, events, FALSE /*waitAll*/, INFINITE );
+	}
+}
+
+void Prefetcher::Prefetch()
+{
+	std::vector<std::wstring> filenames;
+	long generation = 0;
+	{
+		std::lock_guard<std::mutex> lock( m_Mutex );
+		filenames = m_Filenames;
+		generation = m_Generation;
+	}
+
+	for ( const auto& filename : filenames ) {
+		if ( IsInterrupted() ) {
+			break;
+		}
+
+		// Files are prefetched in the order they are expected to be played, so stop once the memory budget has been used.
+		bool prefetch = false;
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			if ( generation != m_Generation ) {
+				break;
+			}
+			if ( m_Heads.end() == m_Heads.find( filename ) ) {
+				size_t memoryUsed = 0;
+				for ( const auto& head : m_Heads ) {
+					memoryUsed += head.second.Data->size();
+				}
+				if ( ( memoryUsed + s_HeadSize ) > s_MemoryBudget ) {
+					break;
+				}
+				prefetch = true;
+			}
+		}
+
+		if ( prefetch ) {
+			PrefetchedHead head = {};
+			if ( ReadHead( filename, head ) ) {
+				std::lock_guard<std::mutex> lock( m_Mutex );
+				if ( generation == m_Generation ) {
+					m_Heads.insert( HeadMap::value_type( filename, head ) );
+				}
+			}
+		}
+	}
+}
+
+bool Prefetcher::ReadHead( const std::wstring& filename, PrefetchedHead& head ) const
+{
+	bool success = false;
+	const HANDLE handle = CreateFile( filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL /*security*/, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL /*template*/ );
+	if ( INVALID_HANDLE_VALUE != handle ) {
+		LARGE_INTEGER fileSize = {};
+		FILETIME lastWriteTime = {};
+		if ( ( FALSE != GetFileSizeEx( handle, &fileSize ) ) && ( fileSize.QuadPart > 0 ) && ( FALSE != GetFileTime( handle, NULL /*creationTime*/, NULL /*lastAccessTime*/, &lastWriteTime ) ) ) {
+			std::shared_ptr<std::vector<BYTE>> buffer = std::make_shared<std::vector<BYTE>>( static_cast<size_t>( (std::min)( fileSize.QuadPart, static_cast<LONGLONG>( s_HeadSize ) ) ) );
+			DWORD bytesRead = 0;
+			if ( ( FALSE != ReadFile( handle, buffer->data(), static_cast<DWORD>( buffer->size() ), &bytesRead, NULL /*overlapped*/ ) ) && ( bytesRead > 0 ) ) {
+				buffer->resize( bytesRead );
+				head.Data = buffer;
+				head.FileSize = fileSize.QuadPart;
+				head.LastWriteTime = ( static_cast<long long>( lastWriteTime.dwHighDateTime ) << 32 ) + lastWriteTime.dwLowDateTime;
+				success = true;
+			}
+		}
+		CloseHandle( handle );
+	}
+	return success;
+}
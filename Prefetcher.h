@@ -0,0 +1,121 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Prefetches the start of upcoming files on a background thread, holding the data in memory so that opening the next track does not block on a spun-down disk or a network round trip.
+class Prefetcher
+{
+public:
+	// Data from the start of a file.
+	typedef std::shared_ptr<const std::vector<BYTE>> Head;
+
+	// Returns the upcoming filenames, in the order they are expected to be played (called from the prefetch thread).
+	typedef std::function<std::vector<std::wstring>()> UpcomingCallback;
+
+	// Prefetch statistics.
+	struct Statistics {
+		long Hits;												// Number of track transitions where the file had been prefetched.
+		long Misses;											// Number of track transitions where the file had not been prefetched.
+		float LastTimeToFirstSample;			// Time from opening the last track to decoding its first samples, in seconds.
+		float AverageTimeToFirstSample;		// Average time from opening a track to decoding its first samples, in seconds.
+	};
+
+	// 'upcomingCallback' - returns the upcoming filenames, when an update is requested.
+	Prefetcher( UpcomingCallback upcomingCallback );
+
+	virtual ~Prefetcher();
+
+	// Sets the upcoming 'filenames', in the order they are expected to be played.
+	// Prefetched data for any file not in the list is released.
+	void SetFilenames( const std::vector<std::wstring>& filenames );
+
+	// Requests that the upcoming filenames are updated, via the upcoming callback on the prefetch thread.
+	// This neither blocks nor allocates, so it can be called from the output stream callback.
+	void RequestUpdate();
+
+	// Returns whether the start of 'filename' has been prefetched.
+	bool IsPrefetched( const std::wstring& filename );
+
+	// Records a track transition.
+	// 'prefetched' - whether the start of the file had been prefetched.
+	// 'timeToFirstSample' - time from opening the track to decoding its first samples, in seconds.
+	void AddTransition( const bool prefetched, const float timeToFirstSample );
+
+	// Returns the prefetch statistics.
+	Statistics GetStatistics();
+
+	// Returns the prefetched data for the start of 'filename', or nullptr if the file has not been prefetched.
+	// 'fileSize' - current file size, in bytes.
+	// 'lastWriteTime' - current last write time of the file.
+	// Prefetched data is discarded if the file has changed since it was prefetched.
+	static Head GetHead( const std::wstring& filename, const long long fileSize, const long long lastWriteTime );
+
+private:
+	// Prefetch thread procedure.
+	static DWORD WINAPI PrefetchThreadProc( LPVOID lpParam );
+
+	// Prefetch thread handler.
+	void PrefetchHandler();
+
+	// Prefetches the heads of the upcoming files, within the memory budget.
+	void Prefetch();
+
+	// Returns whether the prefetch thread should stop, or has an update request to handle, in which case prefetching is interrupted.
+	bool IsInterrupted() const;
+
+	// Data from the start of a file, along with the state of the file when it was read.
+	struct PrefetchedHead {
+		Head Data;								// Data from the start of the file.
+		long long FileSize;				// File size, in bytes.
+		long long LastWriteTime;	// Last write time of the file.
+	};
+
+	// Reads the start of 'filename' into 'head', returning false if the file could not be read.
+	bool ReadHead( const std::wstring& filename, PrefetchedHead& head ) const;
+
+	// Maps a filename to the data from the start of the file.
+	typedef std::map<std::wstring,PrefetchedHead> HeadMap;
+
+	// The prefetcher whose data is made available to input sources.
+	static Prefetcher* s_Prefetcher;
+
+	// Prefetcher instance mutex.
+	static std::mutex s_PrefetcherMutex;
+
+	// Returns the upcoming filenames, when an update is requested.
+	UpcomingCallback m_UpcomingCallback;
+
+	// Upcoming filenames.
+	std::vector<std::wstring> m_Filenames;
+
+	// Incremented whenever the upcoming filenames change.
+	long m_Generation;
+
+	// Prefetched data.
+	HeadMap m_Heads;
+
+	// Prefetch statistics.
+	Statistics m_Statistics;
+
+	// Mutex protecting the upcoming filenames, prefetched data and statistics.
+	std::mutex m_Mutex;
+
+	// Prefetch thread handle.
+	HANDLE m_Thread;
+
+	// Event signalled when the prefetch thread should stop.
+	HANDLE m_StopEvent;
+
+	// Event signalled when the upcoming filenames change.
+	HANDLE m_WakeEvent;
+
+	// Event signalled when an update of the upcoming filenames is requested.
+	HANDLE m_UpdateEvent;
+};
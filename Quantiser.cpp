@@ -0,0 +1,241 @@
+#include "Quantiser.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Maximum noise shaping filter order.
+static const long s_MaxOrder = 5;
+
+// Weighted noise shaping filter coefficients (Lipshitz et al. E-weighted filter), which are only suitable for sample rates up to 48kHz.
+static const float s_WeightedCoefficients[ s_MaxOrder ] = { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f };
+
+// Maximum sample rate for weighted noise shaping, above which first order noise shaping is used instead.
+static const long s_MaxWeightedSampleRate = 48000;
+
+// Initial random number generator state (any non-zero values).
+static const uint32_t s_RandomSeed[ 8 ] = { 0x9E3779B9, 0x7F4A7C15, 0xF39CC060, 0x5CEDC834, 0x1B873593, 0xCC9E2D51, 0x85EBCA6B, 0xC2B2AE35 };
+
+// Advances the four xorshift random number generators in 'state', returning the new state.
+static __m128i NextRandom( __m128i state )
+{
+	state = _mm_xor_si128( state, _mm_slli_epi32( state, 13 ) );
+	state = _mm_xor_si128( state, _mm_srli_epi32( state, 17 ) );
+	state = _mm_xor_si128( state, _mm_slli_epi32( state, 5 ) );
+	return state;
+}
+
+// Returns four triangular (TPDF) dither values in the range -1 to +1, as the difference between the two 16-bit halves of each 'random' value.
+static __m128 GetTriangularDither( const __m128i random )
+{
+	const __m128 low = _mm_cvtepi32_ps( _mm_and_si128( random, _mm_set1_epi32( 0xFFFF ) ) );
+	const __m128 high = _mm_cvtepi32_ps( _mm_srli_epi32( random, 16 ) );
+	return _mm_mul_ps( _mm_sub_ps( low, high ), _mm_set1_ps( 1.0f / 65536.0f ) );
+}
+
+// Loads 'laneCount' (1 to 4) values from 'values', with any unused lanes set to zero.
+static __m128 LoadLanes( const float* values, const long laneCount )
+{
+	switch ( laneCount ) {
+		case 1 : {
+			return _mm_load_ss( values );
+		}
+		case 2 : {
+			return _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>( values ) ) );
+		}
+		case 3 : {
+			return _mm_setr_ps( values[ 0 ], values[ 1 ], values[ 2 ], 0.0f );
+		}
+		default : {
+			return _mm_loadu_ps( values );
+		}
+	}
+}
+
+// Stores 'laneCount' (1 to 4) values from 'lanes' to 'values'.
+static void StoreLanes( float* values, const __m128 lanes, const long laneCount )
+{
+	switch ( laneCount ) {
+		case 1 : {
+			_mm_store_ss( values, lanes );
+			break;
+		}
+		case 2 : {
+			_mm_store_sd( reinterpret_cast<double*>( values ), _mm_castps_pd( lanes ) );
+			break;
+		}
+		case 3 : {
+			_mm_store_sd( reinterpret_cast<double*>( values ), _mm_castps_pd( lanes ) );
+			_mm_store_ss( values + 2, _mm_movehl_ps( lanes, lanes ) );
+			break;
+		}
+		default : {
+			_mm_storeu_ps( values, lanes );
+			break;
+		}
+	}
+}
+
+Quantiser::Quantiser( const long sampleRate, const long channels, const long bitsPerSample, const DitherMode mode ) :
+	m_Channels( channels ),
+	m_Mode( mode ),
+	m_Scale( static_cast<float>( 1l << ( std::clamp( bitsPerSample, 8l, 24l ) - 1 ) ) ),
+	m_Minimum( -m_Scale ),
+	m_Maximum( m_Scale - 1 ),
+	m_Coefficients( s_MaxOrder, 0.0f ),
+	m_ErrorHistory( static_cast<size_t>( s_MaxOrder * 4 * ( ( channels + 3 ) / 4 ) ), 0.0f ),
+	m_RandomState()
+{
+	if ( DitherMode::WeightedNoiseShaped == m_Mode ) {
+		if ( sampleRate <= s_MaxWeightedSampleRate ) {
+			std::copy( s_WeightedCoefficients, s_WeightedCoefficients + s_MaxOrder, m_Coefficients.begin() );
+		} else {
+			m_Coefficients[ 0 ] = 1.0f;
+		}
+	} else if ( DitherMode::NoiseShaped == m_Mode ) {
+		m_Coefficients[ 0 ] = 1.0f;
+	}
+	std::copy( s_RandomSeed, s_RandomSeed + 8, m_RandomState );
+}
+
+Quantiser::~Quantiser()
+{
+}
+
+bool Quantiser::IsRequired( const long bitsPerSample, const DitherMode mode )
+{
+	const bool required = ( DitherMode::None != mode ) && ( bitsPerSample >= 8 ) && ( bitsPerSample <= 24 );
+	return required;
+}
+
+long Quantiser::GetChannels() const
+{
+	return m_Channels;
+}
+
+void Quantiser::Process( float* buffer, const long sampleCount )
+{
+	const size_t count = static_cast<size_t>( sampleCount * m_Channels );
+	if ( ( count > 0 ) && !IsQuantised( buffer, count ) ) {
+		if ( DitherMode::Triangular == m_Mode ) {
+			ProcessTriangular( buffer, count );
+		} else {
+			ProcessNoiseShaped( buffer, sampleCount );
+		}
+	} else {
+		std::fill( m_ErrorHistory.begin(), m_ErrorHistory.end(), 0.0f );
+	}
+}
+
+bool Quantiser::IsQuantised( const float* buffer, const size_t count ) const
+{
+	bool quantised = true;
+	const __m128 scale = _mm_set1_ps( m_Scale );
+	size_t index = 0;
+	for ( ; quantised && ( ( index + 4 ) <= count ); index += 4 ) {
+		const __m128 value = _mm_mul_ps( _mm_loadu_ps( buffer + index ), scale );
+		const __m128 rounded = _mm_cvtepi32_ps( _mm_cvtps_epi32( value ) );
+		quantised = ( 0 == _mm_movemask_ps( _mm_cmpneq_ps( value, rounded ) ) );
+	}
+	for ( ; quantised && ( index < count ); index++ ) {
+		const float value = buffer[ index ] * m_Scale;
+		quantised = ( value == _mm_cvtss_f32( _mm_cvtepi32_ps( _mm_cvtps_epi32( _mm_set_ss( value ) ) ) ) );
+	}
+	return quantised;
+}
+
+void Quantiser::ProcessTriangular( float* buffer, const size_t count )
+{
+	const __m128 scale = _mm_set1_ps( m_Scale );
+	const __m128 inverseScale = _mm_set1_ps( 1.0f / m_Scale );
+	const __m128 minimum = _mm_set1_ps( m_Minimum );
+	const __m128 maximum = _mm_set1_ps( m_Maximum );
+	__m128i random1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( m_RandomState ) );
+	__m128i random2 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( m_RandomState + 4 ) );
+
+	// The final partial group of values is processed via a temporary buffer.
+	float remainder[ 8 ] = {};
+	const size_t remainderCount = count % 8;
+	const size_t wholeCount = count - remainderCount;
+	for ( size_t index = 0; index < count; index += 8 ) {
+		float* values = ( index < wholeCount ) ? ( buffer + index ) : remainder;
+		if ( values == remainder ) {
+			std::memcpy( remainder, buffer + index, remainderCount * sizeof( float ) );
+		}
+
+		// Two independent sets of generators are used, so that their latencies overlap.
+		random1 = NextRandom( random1 );
+		random2 = NextRandom( random2 );
+		const __m128 value1 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( values ), scale ), GetTriangularDither( random1 ) );
+		const __m128 value2 = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( values + 4 ), scale ), GetTriangularDither( random2 ) );
+		const __m128 quantised1 = _mm_cvtepi32_ps( _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( value1, minimum ), maximum ) ) );
+		const __m128 quantised2 = _mm_cvtepi32_ps( _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( value2, minimum ), maximum ) ) );
+		_mm_storeu_ps( values, _mm_mul_ps( quantised1, inverseScale ) );
+		_mm_storeu_ps( values + 4, _mm_mul_ps( quantised2, inverseScale ) );
+
+		if ( values == remainder ) {
+			std::memcpy( buffer + index, remainder, remainderCount * sizeof( float ) );
+		}
+	}
+
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( m_RandomState ), random1 );
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( m_RandomState + 4 ), random2 );
+}
+
+void Quantiser::ProcessNoiseShaped( float* buffer, const long sampleCount )
+{
+	const __m128 scale = _mm_set1_ps( m_Scale );
+	const __m128 inverseScale = _mm_set1_ps( 1.0f / m_Scale );
+	const __m128 minimum = _mm_set1_ps( m_Minimum );
+	const __m128 maximum = _mm_set1_ps( m_Maximum );
+	__m128 coefficients[ s_MaxOrder ] = {};
+	for ( long order = 0; order < s_MaxOrder; order++ ) {
+		coefficients[ order ] = _mm_set1_ps( m_Coefficients[ order ] );
+	}
+	__m128i random = _mm_loadu_si128( reinterpret_cast<const __m128i*>( m_RandomState ) );
+	const bool unitCoefficient = ( 1.0f == m_Coefficients[ 0 ] );
+
+	// Each group of up to four channels is processed in turn, with one channel per SIMD lane, and the error history held in registers.
+	// Frames cannot share a SIMD vector, as each frame depends on the rounding error of the previous one, so the speed is limited by the latency of the feedback path.
+	const long groupCount = ( m_Channels + 3 ) / 4;
+	for ( long group = 0; group < groupCount; group++ ) {
+		const long firstChannel = group * 4;
+		const long laneCount = ( std::min )( 4l, m_Channels - firstChannel );
+		float* history = m_ErrorHistory.data() + group * s_MaxOrder * 4;
+		__m128 error[ s_MaxOrder ] = {};
+		for ( long order = 0; order < s_MaxOrder; order++ ) {
+			error[ order ] = _mm_loadu_ps( history + order * 4 );
+		}
+
+		// The input is clamped, and only the rounding error (excluding any clipping) is fed back, which keeps the filter stable.
+		// The most recent error is split into its rounding and dither parts, and everything other than the rounding part is calculated first,
+		// leaving only the first filter tap (omitted when unity), the rounding and a subtraction on the feedback path from one sample to the next.
+		__m128 dither = _mm_setzero_ps();
+		__m128 rounding = error[ 0 ];
+		float* values = buffer + firstChannel;
+		for ( long sample = 0; sample < sampleCount; sample++, values += m_Channels ) {
+			__m128 shaping = _mm_mul_ps( coefficients[ 0 ], dither );
+			for ( long order = s_MaxOrder - 1; order > 0; order-- ) {
+				shaping = _mm_add_ps( shaping, _mm_mul_ps( coefficients[ order ], error[ order ] ) );
+			}
+			random = NextRandom( random );
+			dither = GetTriangularDither( random );
+			const __m128 input = _mm_sub_ps( _mm_add_ps( _mm_min_ps( _mm_max_ps( _mm_mul_ps( LoadLanes( values, laneCount ), scale ), minimum ), maximum ), dither ), shaping );
+			const __m128 value = _mm_sub_ps( input, unitCoefficient ? rounding : _mm_mul_ps( coefficients[ 0 ], rounding ) );
+			const __m128 rounded = _mm_cvtepi32_ps( _mm_cvtps_epi32( value ) );
+			rounding = _mm_sub_ps( rounded, value );
+			for ( long order = s_MaxOrder - 1; order > 0; order-- ) {
+				error[ order ] = error[ order - 1 ];
+			}
+			error[ 0 ] = _mm_add_ps( rounding, dither );
+			StoreLanes( values, _mm_mul_ps( _mm_min_ps( _mm_max_ps( rounded, minimum ), maximum ), inverseScale ), laneCount );
+		}
+
+		for ( long order = 0; order < s_MaxOrder; order++ ) {
+			_mm_storeu_ps( history + order * 4, error[ order ] );
+		}
+	}
+
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( m_RandomState ), random );
+}
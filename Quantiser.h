@@ -0,0 +1,68 @@
+#pragma once
+
+#include "DSPNode.h"
+#include "DitherMode.h"
+
+#include <memory>
+#include <vector>
+
+// Quantises floating point sample data to the grid of an integer output format, with triangular (TPDF) dither and optional noise shaping.
+// The output remains in floating point format, but holds exact integer sample values, so that a subsequent conversion to the integer format is lossless.
+// Blocks of sample data which are already quantised (such as lossless sources, or digital silence) are passed through unchanged.
+class Quantiser : public DSPNode
+{
+public:
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	// 'bitsPerSample' - resolution of the integer output format (8 to 24).
+	// 'mode' - dither mode.
+	Quantiser( const long sampleRate, const long channels, const long bitsPerSample, const DitherMode mode );
+
+	virtual ~Quantiser();
+
+	// Quantiser shared pointer type.
+	typedef std::shared_ptr<Quantiser> Ptr;
+
+	// Returns whether an integer output format of 'bitsPerSample' resolution should be quantised, using the dither 'mode'.
+	static bool IsRequired( const long bitsPerSample, const DitherMode mode );
+
+	// Returns the channel count.
+	long GetChannels() const override;
+
+	// Quantises 'sampleCount' samples of interleaved sample data in 'buffer', in place.
+	void Process( float* buffer, const long sampleCount ) override;
+
+private:
+	// Returns whether the 'count' values in 'buffer' already lie on the quantisation grid.
+	bool IsQuantised( const float* buffer, const size_t count ) const;
+
+	// Quantises the 'count' values in 'buffer' with triangular dither.
+	void ProcessTriangular( float* buffer, const size_t count );
+
+	// Quantises 'sampleCount' samples of interleaved sample data in 'buffer' with triangular dither and noise shaping.
+	void ProcessNoiseShaped( float* buffer, const long sampleCount );
+
+	// Channel count.
+	const long m_Channels;
+
+	// Dither mode.
+	const DitherMode m_Mode;
+
+	// Scale factor from floating point values to integer sample values.
+	const float m_Scale;
+
+	// Minimum integer sample value.
+	const float m_Minimum;
+
+	// Maximum integer sample value.
+	const float m_Maximum;
+
+	// Noise shaping filter coefficients, applied to the quantisation error of the most recent samples first.
+	std::vector<float> m_Coefficients;
+
+	// Quantisation error history for the noise shaping filter, with the channels in groups of four (most recent samples first).
+	std::vector<float> m_ErrorHistory;
+
+	// Random number generator state, for two sets of four independent generators.
+	uint32_t m_RandomState[ 8 ];
+};
@@ -0,0 +1,422 @@
+#include "Resampler.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Number of filter taps (must be a multiple of 4).
+static const long s_Taps = 128;
+
+// Maximum number of filter phases (conversions needing more phases use the nearest ratio with this many phases).
+static const long s_MaxPhases = 1024;
+
+// Filter cutoff, as a fraction of the Nyquist frequency (of the lower of the input and output sample rates).
+static const double s_Cutoff = 0.95;
+
+// Kaiser window beta parameter (giving a stopband attenuation of around 90dB).
+static const double s_KaiserBeta = 9.0;
+
+// Number of samples read from the decoder in one go.
+static const long s_ChunkSize = 1024;
+
+// Maximum number of channels supported for channel mixing.
+static const long s_MaxChannels = 8;
+
+// Speaker positions.
+enum class Speaker {
+	FrontLeft,
+	FrontRight,
+	FrontCentre,
+	LFE,
+	RearLeft,
+	RearRight,
+	RearCentre,
+	SideLeft,
+	SideRight
+};
+
+// Returns the speaker layout for a 'channels' count, using BASS channel ordering.
+static std::vector<Speaker> GetSpeakerLayout( const long channels )
+{
+	switch ( channels ) {
+		case 1 : {
+			return { Speaker::FrontCentre };
+		}
+		case 2 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight };
+		}
+		case 3 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCentre };
+		}
+		case 4 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::RearLeft, Speaker::RearRight };
+		}
+		case 5 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCentre, Speaker::RearLeft, Speaker::RearRight };
+		}
+		case 6 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCentre, Speaker::LFE, Speaker::RearLeft, Speaker::RearRight };
+		}
+		case 7 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCentre, Speaker::LFE, Speaker::RearCentre, Speaker::SideLeft, Speaker::SideRight };
+		}
+		case 8 : {
+			return { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCentre, Speaker::LFE, Speaker::RearLeft, Speaker::RearRight, Speaker::SideLeft, Speaker::SideRight };
+		}
+		default : {
+			return {};
+		}
+	}
+}
+
+// Returns the channel mixing matrix (in output channel order) to convert from 'inputChannels' to 'outputChannels'.
+static std::vector<float> GetMixMatrix( const long inputChannels, const long outputChannels )
+{
+	const std::vector<Speaker> inputLayout = GetSpeakerLayout( inputChannels );
+	const std::vector<Speaker> outputLayout = GetSpeakerLayout( outputChannels );
+	std::vector<float> matrix( static_cast<size_t>( inputChannels * outputChannels ), 0.0f );
+
+	// Adds the input channel to an output speaker, returning false if the output layout does not have the speaker.
+	auto addTo = [ &matrix, &outputLayout, inputChannels ] ( const long inputChannel, const Speaker speaker, const float gain ) -> bool
+	{
+		const auto position = std::find( outputLayout.begin(), outputLayout.end(), speaker );
+		const bool found = ( outputLayout.end() != position );
+		if ( found ) {
+			const long outputChannel = static_cast<long>( position - outputLayout.begin() );
+			matrix[ outputChannel * inputChannels + inputChannel ] += gain;
+		}
+		return found;
+	};
+
+	const float halfPower = static_cast<float>( M_SQRT1_2 );
+	for ( long inputChannel = 0; inputChannel < inputChannels; inputChannel++ ) {
+		const Speaker speaker = inputLayout[ inputChannel ];
+		if ( addTo( inputChannel, speaker, 1.0f ) ) {
+			continue;
+		}
+		switch ( speaker ) {
+			case Speaker::FrontCentre : {
+				// Mono sources are played at full level on both front speakers.
+				const float gain = ( 1 == inputChannels ) ? 1.0f : halfPower;
+				addTo( inputChannel, Speaker::FrontLeft, gain );
+				addTo( inputChannel, Speaker::FrontRight, gain );
+				break;
+			}
+			case Speaker::FrontLeft :
+			case Speaker::FrontRight : {
+				addTo( inputChannel, Speaker::FrontCentre, halfPower );
+				break;
+			}
+			case Speaker::RearLeft :
+			case Speaker::SideLeft : {
+				if ( !addTo( inputChannel, ( Speaker::RearLeft == speaker ) ? Speaker::SideLeft : Speaker::RearLeft, 1.0f ) ) {
+					if ( !addTo( inputChannel, Speaker::FrontLeft, halfPower ) ) {
+						addTo( inputChannel, Speaker::FrontCentre, 0.5f );
+					}
+				}
+				break;
+			}
+			case Speaker::RearRight :
+			case Speaker::SideRight : {
+				if ( !addTo( inputChannel, ( Speaker::RearRight == speaker ) ? Speaker::SideRight : Speaker::RearRight, 1.0f ) ) {
+					if ( !addTo( inputChannel, Speaker::FrontRight, halfPower ) ) {
+						addTo( inputChannel, Speaker::FrontCentre, 0.5f );
+					}
+				}
+				break;
+			}
+			case Speaker::RearCentre : {
+				if ( !( addTo( inputChannel, Speaker::RearLeft, halfPower ) && addTo( inputChannel, Speaker::RearRight, halfPower ) ) ) {
+					if ( !( addTo( inputChannel, Speaker::SideLeft, halfPower ) && addTo( inputChannel, Speaker::SideRight, halfPower ) ) ) {
+						if ( !( addTo( inputChannel, Speaker::FrontLeft, 0.5f ) && addTo( inputChannel, Speaker::FrontRight, 0.5f ) ) ) {
+							addTo( inputChannel, Speaker::FrontCentre, halfPower );
+						}
+					}
+				}
+				break;
+			}
+			case Speaker::LFE : {
+				// The LFE channel is dropped if the output has no LFE speaker.
+				break;
+			}
+		}
+	}
+
+	// Scale down any output channel that would otherwise clip when downmixing.
+	for ( long outputChannel = 0; outputChannel < outputChannels; outputChannel++ ) {
+		float* row = matrix.data() + outputChannel * inputChannels;
+		const float total = std::accumulate( row, row + inputChannels, 0.0f );
+		if ( total > 1.0f ) {
+			std::transform( row, row + inputChannels, row, [ total ] ( const float gain ) { return gain / total; } );
+		}
+	}
+	return matrix;
+}
+
+// Returns the zeroth order modified Bessel function of the first kind, for 'x'.
+static double BesselI0( const double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	const double halfX = x / 2;
+	for ( int k = 1; k < 50; k++ ) {
+		term *= ( halfX / k ) * ( halfX / k );
+		sum += term;
+		if ( term < ( sum * 1e-12 ) ) {
+			break;
+		}
+	}
+	return sum;
+}
+
+// Returns the dot product of 'count' values (a multiple of 4) from 'a' & 'b'.
+static float DotProduct( const float* a, const float* b, const long count )
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	long index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a + index ), _mm_loadu_ps( b + index ) ) );
+		sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( a + index + 4 ), _mm_loadu_ps( b + index + 4 ) ) );
+	}
+	for ( ; index < count; index += 4 ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a + index ), _mm_loadu_ps( b + index ) ) );
+	}
+	sum0 = _mm_add_ps( sum0, sum1 );
+	sum0 = _mm_add_ps( sum0, _mm_movehl_ps( sum0, sum0 ) );
+	sum0 = _mm_add_ss( sum0, _mm_shuffle_ps( sum0, sum0, 1 ) );
+	return _mm_cvtss_f32( sum0 );
+}
+
+Resampler::Resampler( const Decoder::Ptr decoder, const long sampleRate, const long channels ) :
+	Decoder(),
+	m_Decoder( decoder ),
+	m_MixMatrix(),
+	m_Interpolation( 0 ),
+	m_Decimation( 0 ),
+	m_Coefficients(),
+	m_DecoderBuffer(),
+	m_MixBuffer(),
+	m_History(),
+	m_HistorySize( 0 ),
+	m_HistoryPosition( 0 ),
+	m_Phase( 0 ),
+	m_DecoderEnded( false )
+{
+	const long inputRate = m_Decoder ? m_Decoder->GetSampleRate() : 0;
+	const long inputChannels = m_Decoder ? m_Decoder->GetChannels() : 0;
+	if ( ( inputRate <= 0 ) || ( inputChannels <= 0 ) || ( sampleRate <= 0 ) || ( channels <= 0 ) ) {
+		throw std::runtime_error( "Resampler invalid format" );
+	}
+
+	if ( inputChannels != channels ) {
+		if ( ( inputChannels > s_MaxChannels ) || ( channels > s_MaxChannels ) ) {
+			throw std::runtime_error( "Resampler unsupported channel count" );
+		}
+		m_MixMatrix = GetMixMatrix( inputChannels, channels );
+		m_MixBuffer.resize( static_cast<size_t>( s_ChunkSize * channels ) );
+	}
+	m_DecoderBuffer.resize( static_cast<size_t>( s_ChunkSize * inputChannels ) );
+
+	if ( inputRate != sampleRate ) {
+		SetRatio( inputRate, sampleRate );
+		m_History.resize( static_cast<size_t>( channels ) );
+		Reset();
+	}
+
+	SetSampleRate( sampleRate );
+	SetChannels( channels );
+	SetBPS( m_Decoder->GetBPS() );
+	SetDuration( m_Decoder->GetDuration() );
+	SetInputSource( m_Decoder->GetInputSource() );
+}
+
+Resampler::~Resampler()
+{
+}
+
+long Resampler::Read( float* buffer, const long sampleCount )
+{
+	long samplesRead = 0;
+	const long channels = GetChannels();
+	if ( 0 == m_Interpolation ) {
+		if ( m_MixMatrix.empty() ) {
+			samplesRead = m_Decoder->Read( buffer, sampleCount );
+		} else {
+			while ( samplesRead < sampleCount ) {
+				const long decoderSamples = m_Decoder->Read( m_DecoderBuffer.data(), (std::min)( s_ChunkSize, sampleCount - samplesRead ) );
+				if ( 0 == decoderSamples ) {
+					break;
+				}
+				MixChannels( m_DecoderBuffer.data(), buffer + samplesRead * channels, decoderSamples );
+				samplesRead += decoderSamples;
+			}
+		}
+	} else {
+		while ( samplesRead < sampleCount ) {
+			if ( ( m_HistoryPosition + s_Taps ) > m_HistorySize ) {
+				if ( !FillHistory() ) {
+					break;
+				}
+				continue;
+			}
+			const float* coefficients = m_Coefficients.data() + m_Phase * s_Taps;
+			float* output = buffer + samplesRead * channels;
+			for ( long channel = 0; channel < channels; channel++ ) {
+				output[ channel ] = DotProduct( m_History[ channel ].data() + m_HistoryPosition, coefficients, s_Taps );
+			}
+			++samplesRead;
+
+			m_Phase += m_Decimation;
+			m_HistoryPosition += static_cast<size_t>( m_Phase / m_Interpolation );
+			m_Phase %= m_Interpolation;
+		}
+	}
+	return samplesRead;
+}
+
+float Resampler::Seek( const float position )
+{
+	const float seekPosition = m_Decoder->Seek( position );
+	if ( 0 != m_Interpolation ) {
+		Reset();
+	}
+	return seekPosition;
+}
+
+void Resampler::SetInputRate( const long inputRate )
+{
+	if ( inputRate > 0 ) {
+		const long previousInterpolation = m_Interpolation;
+		SetRatio( inputRate, GetSampleRate() );
+		if ( 0 == previousInterpolation ) {
+			// Start filtering from the next decoder sample.
+			m_History.resize( static_cast<size_t>( GetChannels() ) );
+			Reset();
+		} else {
+			m_Phase = static_cast<long>( static_cast<long long>( m_Phase ) * m_Interpolation / previousInterpolation );
+		}
+	}
+}
+
+void Resampler::SetRatio( const long inputRate, const long sampleRate )
+{
+	// The filter is still applied when the rates match, so that the history is preserved if the rates then differ again.
+	const long divisor = std::gcd( inputRate, sampleRate );
+	m_Interpolation = sampleRate / divisor;
+	m_Decimation = inputRate / divisor;
+	if ( m_Interpolation > s_MaxPhases ) {
+		m_Interpolation = s_MaxPhases;
+		m_Decimation = static_cast<long>( std::lround( static_cast<double>( inputRate ) * s_MaxPhases / sampleRate ) );
+	}
+	CalculateCoefficients();
+}
+
+void Resampler::MixChannels( const float* input, float* output, const long sampleCount ) const
+{
+	const long inputChannels = m_Decoder->GetChannels();
+	const long outputChannels = GetChannels();
+	for ( long sample = 0; sample < sampleCount; sample++, input += inputChannels, output += outputChannels ) {
+		const float* gains = m_MixMatrix.data();
+		for ( long outputChannel = 0; outputChannel < outputChannels; outputChannel++, gains += inputChannels ) {
+			float value = 0;
+			for ( long inputChannel = 0; inputChannel < inputChannels; inputChannel++ ) {
+				value += gains[ inputChannel ] * input[ inputChannel ];
+			}
+			output[ outputChannel ] = value;
+		}
+	}
+}
+
+bool Resampler::FillHistory()
+{
+	if ( m_DecoderEnded ) {
+		return false;
+	}
+
+	// Discard the history that is no longer needed.
+	if ( m_HistoryPosition > 0 ) {
+		for ( auto& history : m_History ) {
+			std::copy( history.begin() + m_HistoryPosition, history.begin() + m_HistorySize, history.begin() );
+		}
+		m_HistorySize -= m_HistoryPosition;
+		m_HistoryPosition = 0;
+	}
+
+	const long channels = GetChannels();
+	long samplesRead = m_Decoder->Read( m_DecoderBuffer.data(), s_ChunkSize );
+	const float* samples = m_DecoderBuffer.data();
+	if ( samplesRead > 0 ) {
+		if ( !m_MixMatrix.empty() ) {
+			MixChannels( m_DecoderBuffer.data(), m_MixBuffer.data(), samplesRead );
+			samples = m_MixBuffer.data();
+		}
+	} else {
+		// Flush the filter with trailing silence.
+		m_DecoderEnded = true;
+		samplesRead = s_Taps / 2;
+		samples = nullptr;
+	}
+
+	for ( long channel = 0; channel < channels; channel++ ) {
+		std::vector<float>& history = m_History[ channel ];
+		if ( history.size() < ( m_HistorySize + samplesRead ) ) {
+			history.resize( m_HistorySize + samplesRead );
+		}
+		float* output = history.data() + m_HistorySize;
+		if ( nullptr == samples ) {
+			std::fill( output, output + samplesRead, 0.0f );
+		} else {
+			for ( long sample = 0; sample < samplesRead; sample++ ) {
+				output[ sample ] = samples[ sample * channels + channel ];
+			}
+		}
+	}
+	m_HistorySize += samplesRead;
+	return true;
+}
+
+void Resampler::Reset()
+{
+	// Prime the history with leading silence, so that the filter is centred on the first input sample.
+	m_HistorySize = s_Taps / 2 - 1;
+	for ( auto& history : m_History ) {
+		history.assign( m_HistorySize, 0.0f );
+	}
+	m_HistoryPosition = 0;
+	m_Phase = 0;
+	m_DecoderEnded = false;
+}
+
+void Resampler::CalculateCoefficients()
+{
+	const double ratio = (std::min)( 1.0, static_cast<double>( m_Interpolation ) / m_Decimation );
+	const double cutoff = 0.5 * s_Cutoff * ratio;
+	const double halfLength = s_Taps / 2;
+	const double besselBeta = BesselI0( s_KaiserBeta );
+
+	m_Coefficients.resize( static_cast<size_t>( m_Interpolation * s_Taps ) );
+	for ( long phase = 0; phase < m_Interpolation; phase++ ) {
+		float* row = m_Coefficients.data() + phase * s_Taps;
+		const double fraction = static_cast<double>( phase ) / m_Interpolation;
+		double total = 0;
+		for ( long tap = 0; tap < s_Taps; tap++ ) {
+			const double distance = tap - halfLength + 1 - fraction;
+			const double x = 2 * cutoff * distance;
+			const double sinc = ( 0 == x ) ? 1.0 : ( sin( M_PI * x ) / ( M_PI * x ) );
+			const double windowPos = distance / halfLength;
+			const double window = ( fabs( windowPos ) < 1.0 ) ? ( BesselI0( s_KaiserBeta * sqrt( 1.0 - windowPos * windowPos ) ) / besselBeta ) : 0.0;
+			const double coefficient = 2 * cutoff * sinc * window;
+			row[ tap ] = static_cast<float>( coefficient );
+			total += coefficient;
+		}
+		// Normalise each phase to unity gain.
+		if ( 0 != total ) {
+			for ( long tap = 0; tap < s_Taps; tap++ ) {
+				row[ tap ] = static_cast<float>( row[ tap ] / total );
+			}
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Decoder.h"
+
+#include <vector>
+
+// Converts the output of a decoder to a different sample rate and/or channel count.
+// Sample rate conversion uses a polyphase windowed sinc filter, and channel conversion uses a fixed up/down-mix matrix.
+// Any stage that is not needed is bypassed, so that the samples pass through unaltered when the formats already match.
+class Resampler : public Decoder
+{
+public:
+	// 'decoder' - the decoder to convert.
+	// 'sampleRate' - output sample rate.
+	// 'channels' - output channel count.
+	// Throws a std::runtime_error exception if the conversion is not supported.
+	Resampler( const Decoder::Ptr decoder, const long sampleRate, const long channels );
+
+	virtual ~Resampler();
+
+	// Reads sample data.
+	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
+	// 'sampleCount' - number of samples to read.
+	// Returns the number of samples read, or zero if the stream has ended.
+	virtual long Read( float* buffer, const long sampleCount );
+
+	// Seeks to a 'position' in the stream, in seconds.
+	// Returns the new position in seconds.
+	virtual float Seek( const float position );
+
+	// Changes the input sample rate to 'inputRate', keeping the filter history so that the output continues without a gap.
+	void SetInputRate( const long inputRate );
+
+private:
+	// Sets the interpolation & decimation factors for converting from 'inputRate' to 'sampleRate', and calculates the filter coefficients.
+	void SetRatio( const long inputRate, const long sampleRate );
+
+	// Mixes 'sampleCount' samples of interleaved input, from the decoder's channel layout to the output channel layout.
+	// 'input' - input samples.
+	// 'output' - output samples.
+	void MixChannels( const float* input, float* output, const long sampleCount ) const;
+
+	// Reads from the decoder into the filter history, returning false if the stream has ended.
+	bool FillHistory();
+
+	// Resets the filter state.
+	void Reset();
+
+	// Calculates the filter coefficients.
+	void CalculateCoefficients();
+
+	// The decoder to convert.
+	Decoder::Ptr m_Decoder;
+
+	// Channel mixing matrix, in output channel order, or empty if channel mixing is not needed.
+	std::vector<float> m_MixMatrix;
+
+	// Interpolation factor (the number of filter phases), or zero if resampling is not needed.
+	long m_Interpolation;
+
+	// Decimation factor.
+	long m_Decimation;
+
+	// Filter coefficients, one row of taps per filter phase.
+	std::vector<float> m_Coefficients;
+
+	// Decoder output buffer.
+	std::vector<float> m_DecoderBuffer;
+
+	// Channel mixing output buffer.
+	std::vector<float> m_MixBuffer;
+
+	// Filter history, one buffer per output channel.
+	std::vector<std::vector<float>> m_History;
+
+	// Number of valid samples in each filter history buffer.
+	size_t m_HistorySize;
+
+	// Position in the filter history of the first tap for the next output sample.
+	size_t m_HistoryPosition;
+
+	// Current filter phase.
+	long m_Phase;
+
+	// Indicates whether the decoder has reached the end of the stream.
+	bool m_DecoderEnded;
+};
@@ -0,0 +1,527 @@
+#include "SampleConversion.h"
+
+// The SSE2 & AVX2 kernels are only available on x86 & x64 platforms, with the scalar kernels used elsewhere.
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __i386__ ) || defined( __x86_64__ )
+#define SAMPLECONVERSION_X86
+
+#include <immintrin.h>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+// Number of samples converted in one go via intermediate 32-bit samples (for packed 24-bit & 8-bit formats).
+static const size_t s_ChunkSize = 1024;
+
+// Conversion kernels for a particular instruction set.
+struct ConversionKernels {
+	// Converts 32-bit container samples to floating point, multiplying by 'scale'.
+	void ( *Int32ToFloat )( const int32_t* input, float* output, const size_t count, const float scale );
+
+	// Converts signed 16-bit samples to floating point.
+	void ( *Int16ToFloat )( const int16_t* input, float* output, const size_t count );
+
+	// Converts planar stereo 32-bit container samples to interleaved floating point, multiplying by 'scale'.
+	void ( *StereoInt32ToFloat )( const int32_t* left, const int32_t* right, float* output, const size_t samples, const float scale );
+
+	// Converts floating point samples to 32-bit container samples, multiplying by 'scale' and clamping between 'minimum' & 'maximum'.
+	void ( *FloatToInt32 )( const float* input, int32_t* output, const size_t count, const float scale, const float minimum, const float maximum );
+
+	// Converts floating point samples to signed 16-bit.
+	void ( *FloatToInt16 )( const float* input, int16_t* output, const size_t count );
+
+	// Converts interleaved floating point samples to planar stereo 32-bit container samples, multiplying by 'scale' and clamping between 'minimum' & 'maximum'.
+	void ( *FloatToStereoInt32 )( const float* input, int32_t* left, int32_t* right, const size_t samples, const float scale, const float minimum, const float maximum );
+};
+
+// Returns the scale factor to convert integer samples of 'bitsPerSample' resolution to floating point.
+static float GetIntegerToFloatScale( const int bitsPerSample )
+{
+	const int bits = std::clamp( bitsPerSample, 8, 32 );
+	return 1.0f / static_cast<float>( 1ull << ( bits - 1 ) );
+}
+
+// Gets the scale factor and clamping range to convert floating point samples to integer samples of 'bitsPerSample' resolution.
+static void GetFloatToIntegerScale( const int bitsPerSample, float& scale, float& minimum, float& maximum )
+{
+	const int bits = std::clamp( bitsPerSample, 8, 32 );
+	scale = static_cast<float>( 1ull << ( bits - 1 ) );
+	minimum = -scale;
+	// The maximum integer value is not representable as a float above 24-bit, so use the largest float below the scale factor.
+	maximum = ( bits <= 24 ) ? ( scale - 1 ) : std::nextafter( scale, 0.0f );
+}
+
+// Rounds a (clamped) floating point 'value' to the nearest integer.
+static int32_t Round( const float value )
+{
+	return static_cast<int32_t>( std::lrint( value ) );
+}
+
+// Scalar kernels.
+
+static void ScalarInt32ToFloat( const int32_t* input, float* output, const size_t count, const float scale )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<float>( input[ index ] ) * scale;
+	}
+}
+
+static void ScalarInt16ToFloat( const int16_t* input, float* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<float>( input[ index ] ) / 32768.0f;
+	}
+}
+
+static void ScalarStereoInt32ToFloat( const int32_t* left, const int32_t* right, float* output, const size_t samples, const float scale )
+{
+	for ( size_t sample = 0; sample < samples; sample++ ) {
+		*output++ = static_cast<float>( left[ sample ] ) * scale;
+		*output++ = static_cast<float>( right[ sample ] ) * scale;
+	}
+}
+
+static void ScalarFloatToInt32( const float* input, int32_t* output, const size_t count, const float scale, const float minimum, const float maximum )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = Round( std::clamp( input[ index ] * scale, minimum, maximum ) );
+	}
+}
+
+static void ScalarFloatToInt16( const float* input, int16_t* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = static_cast<int16_t>( Round( std::clamp( input[ index ] * 32768.0f, -32768.0f, 32767.0f ) ) );
+	}
+}
+
+static void ScalarFloatToStereoInt32( const float* input, int32_t* left, int32_t* right, const size_t samples, const float scale, const float minimum, const float maximum )
+{
+	for ( size_t sample = 0; sample < samples; sample++ ) {
+		left[ sample ] = Round( std::clamp( *input++ * scale, minimum, maximum ) );
+		right[ sample ] = Round( std::clamp( *input++ * scale, minimum, maximum ) );
+	}
+}
+
+#if defined( SAMPLECONVERSION_X86 )
+
+// SSE2 kernels.
+
+static void SSE2Int32ToFloat( const int32_t* input, float* output, const size_t count, const float scale )
+{
+	const __m128 scale4 = _mm_set1_ps( scale );
+	size_t index = 0;
+	for ( ; ( index + 4 ) <= count; index += 4 ) {
+		const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) );
+		_mm_storeu_ps( output + index, _mm_mul_ps( _mm_cvtepi32_ps( value ), scale4 ) );
+	}
+	ScalarInt32ToFloat( input + index, output + index, count - index, scale );
+}
+
+static void SSE2Int16ToFloat( const int16_t* input, float* output, const size_t count )
+{
+	const __m128 scale4 = _mm_set1_ps( 1.0f / 32768.0f );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) );
+		const __m128i low = _mm_srai_epi32( _mm_unpacklo_epi16( value, value ), 16 );
+		const __m128i high = _mm_srai_epi32( _mm_unpackhi_epi16( value, value ), 16 );
+		_mm_storeu_ps( output + index, _mm_mul_ps( _mm_cvtepi32_ps( low ), scale4 ) );
+		_mm_storeu_ps( output + index + 4, _mm_mul_ps( _mm_cvtepi32_ps( high ), scale4 ) );
+	}
+	ScalarInt16ToFloat( input + index, output + index, count - index );
+}
+
+static void SSE2StereoInt32ToFloat( const int32_t* left, const int32_t* right, float* output, const size_t samples, const float scale )
+{
+	const __m128 scale4 = _mm_set1_ps( scale );
+	size_t sample = 0;
+	for ( ; ( sample + 4 ) <= samples; sample += 4, output += 8 ) {
+		const __m128 l = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( left + sample ) ) ), scale4 );
+		const __m128 r = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( right + sample ) ) ), scale4 );
+		_mm_storeu_ps( output, _mm_unpacklo_ps( l, r ) );
+		_mm_storeu_ps( output + 4, _mm_unpackhi_ps( l, r ) );
+	}
+	ScalarStereoInt32ToFloat( left + sample, right + sample, output, samples - sample, scale );
+}
+
+static void SSE2FloatToInt32( const float* input, int32_t* output, const size_t count, const float scale, const float minimum, const float maximum )
+{
+	const __m128 scale4 = _mm_set1_ps( scale );
+	const __m128 minimum4 = _mm_set1_ps( minimum );
+	const __m128 maximum4 = _mm_set1_ps( maximum );
+	size_t index = 0;
+	for ( ; ( index + 4 ) <= count; index += 4 ) {
+		const __m128 value = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( input + index ), scale4 ), minimum4 ), maximum4 );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( output + index ), _mm_cvtps_epi32( value ) );
+	}
+	ScalarFloatToInt32( input + index, output + index, count - index, scale, minimum, maximum );
+}
+
+static void SSE2FloatToInt16( const float* input, int16_t* output, const size_t count )
+{
+	const __m128 scale4 = _mm_set1_ps( 32768.0f );
+	const __m128 minimum4 = _mm_set1_ps( -32768.0f );
+	const __m128 maximum4 = _mm_set1_ps( 32767.0f );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m128i low = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( input + index ), scale4 ), minimum4 ), maximum4 ) );
+		const __m128i high = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( input + index + 4 ), scale4 ), minimum4 ), maximum4 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( output + index ), _mm_packs_epi32( low, high ) );
+	}
+	ScalarFloatToInt16( input + index, output + index, count - index );
+}
+
+static void SSE2FloatToStereoInt32( const float* input, int32_t* left, int32_t* right, const size_t samples, const float scale, const float minimum, const float maximum )
+{
+	const __m128 scale4 = _mm_set1_ps( scale );
+	const __m128 minimum4 = _mm_set1_ps( minimum );
+	const __m128 maximum4 = _mm_set1_ps( maximum );
+	size_t sample = 0;
+	for ( ; ( sample + 4 ) <= samples; sample += 4, input += 8 ) {
+		const __m128 first = _mm_loadu_ps( input );
+		const __m128 second = _mm_loadu_ps( input + 4 );
+		const __m128 l = _mm_shuffle_ps( first, second, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		const __m128 r = _mm_shuffle_ps( first, second, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( left + sample ), _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_mul_ps( l, scale4 ), minimum4 ), maximum4 ) ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( right + sample ), _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_mul_ps( r, scale4 ), minimum4 ), maximum4 ) ) );
+	}
+	ScalarFloatToStereoInt32( input, left + sample, right + sample, samples - sample, scale, minimum, maximum );
+}
+
+// AVX2 kernels.
+
+AVX2_TARGET static void AVX2Int32ToFloat( const int32_t* input, float* output, const size_t count, const float scale )
+{
+	const __m256 scale8 = _mm256_set1_ps( scale );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256i value = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + index ) );
+		_mm256_storeu_ps( output + index, _mm256_mul_ps( _mm256_cvtepi32_ps( value ), scale8 ) );
+	}
+	SSE2Int32ToFloat( input + index, output + index, count - index, scale );
+}
+
+AVX2_TARGET static void AVX2Int16ToFloat( const int16_t* input, float* output, const size_t count )
+{
+	const __m256 scale8 = _mm256_set1_ps( 1.0f / 32768.0f );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256i value = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + index ) ) );
+		_mm256_storeu_ps( output + index, _mm256_mul_ps( _mm256_cvtepi32_ps( value ), scale8 ) );
+	}
+	ScalarInt16ToFloat( input + index, output + index, count - index );
+}
+
+AVX2_TARGET static void AVX2StereoInt32ToFloat( const int32_t* left, const int32_t* right, float* output, const size_t samples, const float scale )
+{
+	const __m256 scale8 = _mm256_set1_ps( scale );
+	size_t sample = 0;
+	for ( ; ( sample + 8 ) <= samples; sample += 8, output += 16 ) {
+		const __m256 l = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( left + sample ) ) ), scale8 );
+		const __m256 r = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( right + sample ) ) ), scale8 );
+		// Unpacking operates within each 128-bit lane, so recombine the lanes to restore the sample order.
+		const __m256 low = _mm256_unpacklo_ps( l, r );
+		const __m256 high = _mm256_unpackhi_ps( l, r );
+		_mm256_storeu_ps( output, _mm256_permute2f128_ps( low, high, 0x20 ) );
+		_mm256_storeu_ps( output + 8, _mm256_permute2f128_ps( low, high, 0x31 ) );
+	}
+	SSE2StereoInt32ToFloat( left + sample, right + sample, output, samples - sample, scale );
+}
+
+AVX2_TARGET static void AVX2FloatToInt32( const float* input, int32_t* output, const size_t count, const float scale, const float minimum, const float maximum )
+{
+	const __m256 scale8 = _mm256_set1_ps( scale );
+	const __m256 minimum8 = _mm256_set1_ps( minimum );
+	const __m256 maximum8 = _mm256_set1_ps( maximum );
+	size_t index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		const __m256 value = _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( _mm256_loadu_ps( input + index ), scale8 ), minimum8 ), maximum8 );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( output + index ), _mm256_cvtps_epi32( value ) );
+	}
+	SSE2FloatToInt32( input + index, output + index, count - index, scale, minimum, maximum );
+}
+
+AVX2_TARGET static void AVX2FloatToInt16( const float* input, int16_t* output, const size_t count )
+{
+	const __m256 scale8 = _mm256_set1_ps( 32768.0f );
+	const __m256 minimum8 = _mm256_set1_ps( -32768.0f );
+	const __m256 maximum8 = _mm256_set1_ps( 32767.0f );
+	size_t index = 0;
+	for ( ; ( index + 16 ) <= count; index += 16 ) {
+		const __m256i low = _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( _mm256_loadu_ps( input + index ), scale8 ), minimum8 ), maximum8 ) );
+		const __m256i high = _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( _mm256_loadu_ps( input + index + 8 ), scale8 ), minimum8 ), maximum8 ) );
+		// Packing operates within each 128-bit lane, so reorder the 64-bit blocks to restore the sample order.
+		const __m256i packed = _mm256_permute4x64_epi64( _mm256_packs_epi32( low, high ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( output + index ), packed );
+	}
+	SSE2FloatToInt16( input + index, output + index, count - index );
+}
+
+// SSE2 conversion kernels.
+static const ConversionKernels s_SSE2Kernels = {
+	SSE2Int32ToFloat,
+	SSE2Int16ToFloat,
+	SSE2StereoInt32ToFloat,
+	SSE2FloatToInt32,
+	SSE2FloatToInt16,
+	SSE2FloatToStereoInt32
+};
+
+// AVX2 conversion kernels.
+static const ConversionKernels s_AVX2Kernels = {
+	AVX2Int32ToFloat,
+	AVX2Int16ToFloat,
+	AVX2StereoInt32ToFloat,
+	AVX2FloatToInt32,
+	AVX2FloatToInt16,
+	SSE2FloatToStereoInt32
+};
+
+// Returns whether the processor & operating system support AVX2.
+static bool IsAVX2Supported()
+{
+#if defined( _MSC_VER )
+	bool supported = false;
+	int info[ 4 ] = {};
+	__cpuid( info, 0 );
+	if ( info[ 0 ] >= 7 ) {
+		__cpuid( info, 1 );
+		const bool osxsave = ( 0 != ( info[ 2 ] & ( 1 << 27 ) ) );
+		const bool avx = ( 0 != ( info[ 2 ] & ( 1 << 28 ) ) );
+		if ( osxsave && avx && ( 6 == ( _xgetbv( 0 ) & 6 ) ) ) {
+			__cpuidex( info, 7, 0 );
+			supported = ( 0 != ( info[ 1 ] & ( 1 << 5 ) ) );
+		}
+	}
+	return supported;
+#else
+	return ( 0 != __builtin_cpu_supports( "avx2" ) );
+#endif
+}
+
+#endif
+
+// Scalar conversion kernels.
+static const ConversionKernels s_ScalarKernels = {
+	ScalarInt32ToFloat,
+	ScalarInt16ToFloat,
+	ScalarStereoInt32ToFloat,
+	ScalarFloatToInt32,
+	ScalarFloatToInt16,
+	ScalarFloatToStereoInt32
+};
+
+// Returns the conversion kernels to use.
+static const ConversionKernels& GetKernels()
+{
+#if defined( SAMPLECONVERSION_X86 )
+	// SSE2 is always available on x86 & x64 platforms.
+	static const ConversionKernels& kernels = IsAVX2Supported() ? s_AVX2Kernels : s_SSE2Kernels;
+#else
+	static const ConversionKernels& kernels = s_ScalarKernels;
+#endif
+	return kernels;
+}
+
+void ConvertUnsigned8ToFloat( const uint8_t* input, float* output, const size_t count )
+{
+	for ( size_t index = 0; index < count; index++ ) {
+		output[ index ] = ( static_cast<float>( input[ index ] ) - 128.0f ) / 128.0f;
+	}
+}
+
+void Convert16ToFloat( const int16_t* input, float* output, const size_t count )
+{
+	GetKernels().Int16ToFloat( input, output, count );
+}
+
+void ConvertPacked24ToFloat( const uint8_t* input, float* output, const size_t count )
+{
+	int32_t buffer[ s_ChunkSize ];
+	for ( size_t offset = 0; offset < count; offset += s_ChunkSize ) {
+		const size_t chunkSize = std::min( s_ChunkSize, count - offset );
+		for ( size_t index = 0; index < chunkSize; index++, input += 3 ) {
+			buffer[ index ] = static_cast<int32_t>( ( static_cast<uint32_t>( input[ 0 ] ) << 8 ) | ( static_cast<uint32_t>( input[ 1 ] ) << 16 ) | ( static_cast<uint32_t>( input[ 2 ] ) << 24 ) ) >> 8;
+		}
+		GetKernels().Int32ToFloat( buffer, output + offset, chunkSize, GetIntegerToFloatScale( 24 ) );
+	}
+}
+
+void Convert32ToFloat( const int32_t* input, float* output, const size_t count, const int bitsPerSample )
+{
+	GetKernels().Int32ToFloat( input, output, count, GetIntegerToFloatScale( bitsPerSample ) );
+}
+
+void ConvertPlanar32ToFloat( const int32_t* const input[], const size_t channels, const size_t samples, const int bitsPerSample, float* output )
+{
+	const float scale = GetIntegerToFloatScale( bitsPerSample );
+	switch ( channels ) {
+		case 1 : {
+			GetKernels().Int32ToFloat( input[ 0 ], output, samples, scale );
+			break;
+		}
+		case 2 : {
+			GetKernels().StereoInt32ToFloat( input[ 0 ], input[ 1 ], output, samples, scale );
+			break;
+		}
+		default : {
+			for ( size_t channel = 0; channel < channels; channel++ ) {
+				const int32_t* channelInput = input[ channel ];
+				float* channelOutput = output + channel;
+				for ( size_t sample = 0; sample < samples; sample++, channelOutput += channels ) {
+					*channelOutput = static_cast<float>( channelInput[ sample ] ) * scale;
+				}
+			}
+			break;
+		}
+	}
+}
+
+void ConvertFloatToUnsigned8( const float* input, uint8_t* output, const size_t count )
+{
+	float scale = 0;
+	float minimum = 0;
+	float maximum = 0;
+	GetFloatToIntegerScale( 8, scale, minimum, maximum );
+	int32_t buffer[ s_ChunkSize ];
+	for ( size_t offset = 0; offset < count; offset += s_ChunkSize ) {
+		const size_t chunkSize = std::min( s_ChunkSize, count - offset );
+		GetKernels().FloatToInt32( input + offset, buffer, chunkSize, scale, minimum, maximum );
+		for ( size_t index = 0; index < chunkSize; index++ ) {
+			output[ offset + index ] = static_cast<uint8_t>( buffer[ index ] + 128 );
+		}
+	}
+}
+
+void ConvertFloatTo16( const float* input, int16_t* output, const size_t count )
+{
+	GetKernels().FloatToInt16( input, output, count );
+}
+
+void ConvertFloatToPacked24( const float* input, uint8_t* output, const size_t count )
+{
+	float scale = 0;
+	float minimum = 0;
+	float maximum = 0;
+	GetFloatToIntegerScale( 24, scale, minimum, maximum );
+	int32_t buffer[ s_ChunkSize ];
+	for ( size_t offset = 0; offset < count; offset += s_ChunkSize ) {
+		const size_t chunkSize = std::min( s_ChunkSize, count - offset );
+		GetKernels().FloatToInt32( input + offset, buffer, chunkSize, scale, minimum, maximum );
+		for ( size_t index = 0; index < chunkSize; index++ ) {
+			const uint32_t value = static_cast<uint32_t>( buffer[ index ] );
+			*output++ = static_cast<uint8_t>( value );
+			*output++ = static_cast<uint8_t>( value >> 8 );
+			*output++ = static_cast<uint8_t>( value >> 16 );
+		}
+	}
+}
+
+void ConvertFloatTo32( const float* input, int32_t* output, const size_t count, const int bitsPerSample )
+{
+	float scale = 0;
+	float minimum = 0;
+	float maximum = 0;
+	GetFloatToIntegerScale( bitsPerSample, scale, minimum, maximum );
+	GetKernels().FloatToInt32( input, output, count, scale, minimum, maximum );
+}
+
+void ConvertFloatToPlanar32( const float* input, const size_t channels, const size_t samples, const int bitsPerSample, int32_t* const output[] )
+{
+	float scale = 0;
+	float minimum = 0;
+	float maximum = 0;
+	GetFloatToIntegerScale( bitsPerSample, scale, minimum, maximum );
+	switch ( channels ) {
+		case 1 : {
+			GetKernels().FloatToInt32( input, output[ 0 ], samples, scale, minimum, maximum );
+			break;
+		}
+		case 2 : {
+			GetKernels().FloatToStereoInt32( input, output[ 0 ], output[ 1 ], samples, scale, minimum, maximum );
+			break;
+		}
+		default : {
+			for ( size_t channel = 0; channel < channels; channel++ ) {
+				const float* channelInput = input + channel;
+				int32_t* channelOutput = output[ channel ];
+				for ( size_t sample = 0; sample < samples; sample++, channelInput += channels ) {
+					channelOutput[ sample ] = Round( std::clamp( *channelInput * scale, minimum, maximum ) );
+				}
+			}
+			break;
+		}
+	}
+}
+
+std::vector<SampleConversionBenchmark> BenchmarkSampleConversion( const size_t count, const int iterations )
+{
+	std::vector<std::pair<const char*, const ConversionKernels*>> instructionSets = { { "Scalar", &s_ScalarKernels } };
+#if defined( SAMPLECONVERSION_X86 )
+	instructionSets.push_back( { "SSE2", &s_SSE2Kernels } );
+	if ( IsAVX2Supported() ) {
+		instructionSets.push_back( { "AVX2", &s_AVX2Kernels } );
+	}
+#endif
+
+	// Generate noise, with some values outside the +/-1.0 range so that clamping is exercised.
+	const size_t samples = count / 2;
+	std::vector<float> floats( count );
+	unsigned int seed = 1;
+	for ( auto& value : floats ) {
+		seed = seed * 1664525 + 1013904223;
+		value = 2.2f * ( static_cast<float>( seed >> 8 ) / 0x1000000 - 0.5f );
+	}
+	float scale = 0;
+	float minimum = 0;
+	float maximum = 0;
+	GetFloatToIntegerScale( 24, scale, minimum, maximum );
+	std::vector<int16_t> int16( count );
+	std::vector<int32_t> int32( count );
+	std::vector<int32_t> left( samples );
+	std::vector<int32_t> right( samples );
+	ScalarFloatToInt16( floats.data(), int16.data(), count );
+	ScalarFloatToInt32( floats.data(), int32.data(), count, scale, minimum, maximum );
+	ScalarFloatToStereoInt32( floats.data(), left.data(), right.data(), samples, scale, minimum, maximum );
+	std::vector<float> output( count );
+	std::vector<int16_t> output16( count );
+	std::vector<int32_t> output32( count );
+	std::vector<int32_t> outputLeft( samples );
+	std::vector<int32_t> outputRight( samples );
+
+	// Returns the time taken per value for the 'conversion', in nanoseconds.
+	const auto timeConversion = [ count, iterations ] ( const auto& conversion ) -> double
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		for ( int iteration = 0; iteration < iterations; iteration++ ) {
+			conversion();
+		}
+		const double nanoseconds = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - startTime ).count();
+		return ( ( count > 0 ) && ( iterations > 0 ) ) ? ( nanoseconds / ( static_cast<double>( count ) * iterations ) ) : 0;
+	};
+
+	const float scale24 = GetIntegerToFloatScale( 24 );
+	std::vector<SampleConversionBenchmark> results;
+	for ( const auto& [ name, kernels ] : instructionSets ) {
+		SampleConversionBenchmark result = {};
+		result.InstructionSet = name;
+		result.Int16ToFloat = timeConversion( [ & ] () { kernels->Int16ToFloat( int16.data(), output.data(), count ); } );
+		result.Int32ToFloat = timeConversion( [ & ] () { kernels->Int32ToFloat( int32.data(), output.data(), count, scale24 ); } );
+		result.StereoInt32ToFloat = timeConversion( [ & ] () { kernels->StereoInt32ToFloat( left.data(), right.data(), output.data(), samples, scale24 ); } );
+		result.FloatToInt16 = timeConversion( [ & ] () { kernels->FloatToInt16( floats.data(), output16.data(), count ); } );
+		result.FloatToInt32 = timeConversion( [ & ] () { kernels->FloatToInt32( floats.data(), output32.data(), count, scale, minimum, maximum ); } );
+		result.FloatToStereoInt32 = timeConversion( [ & ] () { kernels->FloatToStereoInt32( floats.data(), outputLeft.data(), outputRight.data(), samples, scale, minimum, maximum ); } );
+		results.push_back( result );
+	}
+	return results;
+}
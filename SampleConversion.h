@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sample format conversion between integer PCM and floating point samples (scaled to +/-1.0f).
+// Conversions are vectorised, using the best instruction set available at runtime (AVX2, SSE2, or scalar code).
+// Integer to floating point conversions are exact for up to 24-bit samples.
+// Floating point to integer conversions round to the nearest value, and clamp any value outside the range -1.0 to +1.0.
+// Counts are the total number of values converted (i.e. samples multiplied by channels), unless stated otherwise.
+
+// Converts unsigned 8-bit samples to floating point.
+void ConvertUnsigned8ToFloat( const uint8_t* input, float* output, const size_t count );
+
+// Converts signed 16-bit samples to floating point.
+void Convert16ToFloat( const int16_t* input, float* output, const size_t count );
+
+// Converts packed (3 byte, little endian) signed 24-bit samples to floating point.
+void ConvertPacked24ToFloat( const uint8_t* input, float* output, const size_t count );
+
+// Converts signed 32-bit container samples to floating point.
+// 'bitsPerSample' - the resolution of the samples held in the 32-bit container (8 to 32).
+// The 'input' and 'output' buffers may be the same (for in place conversion).
+void Convert32ToFloat( const int32_t* input, float* output, const size_t count, const int bitsPerSample );
+
+// Converts planar signed 32-bit container samples to interleaved floating point.
+// 'input' - planar input buffers, one per channel.
+// 'channels' - number of channels.
+// 'samples' - number of samples per channel.
+// 'bitsPerSample' - the resolution of the samples held in the 32-bit container (8 to 32).
+void ConvertPlanar32ToFloat( const int32_t* const input[], const size_t channels, const size_t samples, const int bitsPerSample, float* output );
+
+// Converts floating point samples to unsigned 8-bit.
+void ConvertFloatToUnsigned8( const float* input, uint8_t* output, const size_t count );
+
+// Converts floating point samples to signed 16-bit.
+void ConvertFloatTo16( const float* input, int16_t* output, const size_t count );
+
+// Converts floating point samples to packed (3 byte, little endian) signed 24-bit.
+void ConvertFloatToPacked24( const float* input, uint8_t* output, const size_t count );
+
+// Converts floating point samples to signed 32-bit container samples.
+// 'bitsPerSample' - the resolution of the samples to hold in the 32-bit container (8 to 32).
+void ConvertFloatTo32( const float* input, int32_t* output, const size_t count, const int bitsPerSample );
+
+// Converts interleaved floating point samples to planar signed 32-bit container samples.
+// 'output' - planar output buffers, one per channel.
+// 'channels' - number of channels.
+// 'samples' - number of samples per channel.
+// 'bitsPerSample' - the resolution of the samples to hold in the 32-bit container (8 to 32).
+void ConvertFloatToPlanar32( const float* input, const size_t channels, const size_t samples, const int bitsPerSample, int32_t* const output[] );
+
+// Sample conversion benchmark result for an instruction set, as the time taken to convert each value, in nanoseconds.
+struct SampleConversionBenchmark {
+	const char* InstructionSet;		// Instruction set name.
+	double Int16ToFloat;					// Signed 16-bit to floating point.
+	double Int32ToFloat;					// 32-bit container to floating point.
+	double StereoInt32ToFloat;		// Planar stereo 32-bit container to interleaved floating point.
+	double FloatToInt16;					// Floating point to signed 16-bit.
+	double FloatToInt32;					// Floating point to 32-bit container.
+	double FloatToStereoInt32;		// Interleaved floating point to planar stereo 32-bit container.
+};
+
+// Benchmarks the conversions for each instruction set supported by the processor (the instruction set in use is the last one listed).
+// 'count' - number of values to convert in one go.
+// 'iterations' - number of times to repeat each conversion.
+std::vector<SampleConversionBenchmark> BenchmarkSampleConversion( const size_t count, const int iterations );
@@ -0,0 +1,75 @@
+#include "SampleQueue.h"
+
+SampleQueue::SampleQueue( const size_t capacity ) :
+	m_Slots( 1 + capacity, nullptr ),
+	m_Head( 0 ),
+	m_Tail( 0 ),
+	m_Closed( false ),
+	m_Cancelled( false ),
+	m_NotEmptyEvent( CreateEvent( NULL /*attributes*/, FALSE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) ),
+	m_NotFullEvent( CreateEvent( NULL /*attributes*/, FALSE /*manualReset*/, FALSE /*initialState*/, L"" /*name*/ ) )
+{
+}
+
+SampleQueue::~SampleQueue()
+{
+	CloseHandle( m_NotEmptyEvent );
+	CloseHandle( m_NotFullEvent );
+}
+
+bool SampleQueue::Push( Block* block )
+{
+	const size_t tail = m_Tail.load( std::memory_order_relaxed );
+	const size_t nextTail = ( 1 + tail ) % m_Slots.size();
+	while ( !m_Cancelled && ( nextTail == m_Head.load( std::memory_order_acquire ) ) ) {
+		WaitForSingleObject( m_NotFullEvent, INFINITE );
+	}
+	if ( !m_Cancelled ) {
+		m_Slots[ tail ] = block;
+		m_Tail.store( nextTail, std::memory_order_release );
+		SetEvent( m_NotEmptyEvent );
+	}
+	return !m_Cancelled;
+}
+
+SampleQueue::Block* SampleQueue::Pop()
+{
+	Block* block = nullptr;
+	const size_t head = m_Head.load( std::memory_order_relaxed );
+	bool empty = true;
+	while ( empty && !m_Cancelled ) {
+		// The closed flag is read before checking for blocks, so that any block added before the queue was closed is not missed.
+		const bool closed = m_Closed;
+		empty = ( head == m_Tail.load( std::memory_order_acquire ) );
+		if ( empty ) {
+			if ( closed ) {
+				break;
+			}
+			WaitForSingleObject( m_NotEmptyEvent, INFINITE );
+		}
+	}
+	if ( !empty && !m_Cancelled ) {
+		block = m_Slots[ head ];
+		m_Head.store( ( 1 + head ) % m_Slots.size(), std::memory_order_release );
+		SetEvent( m_NotFullEvent );
+	}
+	return block;
+}
+
+void SampleQueue::Close()
+{
+	m_Closed = true;
+	SetEvent( m_NotEmptyEvent );
+}
+
+void SampleQueue::Cancel()
+{
+	m_Cancelled = true;
+	SetEvent( m_NotEmptyEvent );
+	SetEvent( m_NotFullEvent );
+}
+
+bool SampleQueue::IsCancelled() const
+{
+	return m_Cancelled;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <vector>
+
+// Bounded single producer, single consumer queue, for passing blocks of sample data between pipeline stages running on different threads.
+// Queue positions are updated without locking, and an event is only waited on when the queue is empty (or full).
+class SampleQueue
+{
+public:
+	// A block of interleaved sample data.
+	struct Block {
+		std::vector<float> Samples;		// Sample buffer.
+		long Offset;									// Number of samples to skip at the start of the buffer.
+		long Count;										// Number of samples in the buffer (including the skipped samples).
+	};
+
+	// 'capacity' - maximum number of blocks held by the queue.
+	SampleQueue( const size_t capacity );
+
+	virtual ~SampleQueue();
+
+	// Adds a 'block' to the queue, waiting while the queue is full.
+	// Returns false if the queue has been cancelled.
+	bool Push( Block* block );
+
+	// Removes a block from the queue, waiting while the queue is empty.
+	// Returns nullptr once the queue has been closed and all blocks removed, or if the queue has been cancelled.
+	Block* Pop();
+
+	// Closes the queue, to indicate that no more blocks will be added.
+	void Close();
+
+	// Cancels the queue, waking any waiting thread.
+	void Cancel();
+
+	// Returns whether the queue has been cancelled.
+	bool IsCancelled() const;
+
+private:
+	// Queue slots (one more than the capacity, so that a full queue can be distinguished from an empty one).
+	std::vector<Block*> m_Slots;
+
+	// Position of the next block to remove.
+	std::atomic<size_t> m_Head;
+
+	// Position at which to add the next block.
+	std::atomic<size_t> m_Tail;
+
+	// Indicates that no more blocks will be added.
+	std::atomic<bool> m_Closed;
+
+	// Indicates that the queue has been cancelled.
+	std::atomic<bool> m_Cancelled;
+
+	// Signalled when a block is added, or the queue is closed or cancelled.
+	HANDLE m_NotEmptyEvent;
+
+	// Signalled when a block is removed, or the queue is cancelled.
+	HANDLE m_NotFullEvent;
+};
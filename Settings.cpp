@@ -22,6 +22,13 @@ static const Settings::PitchRangeMap s_PitchRanges = {
 // Default conversion/extraction filename format.
 static const wchar_t s_DefaultExtractFilename[] = L"%A\\%D\\%N - %T";
 
+// Minimum/maximum output sample rates when joining tracks.
+static const long s_MinJoinSampleRate = 8000;
+static const long s_MaxJoinSampleRate = 384000;
+
+// Maximum output channel count when joining tracks.
+static const long s_MaxJoinChannels = 8;
+
 Settings::Settings( Database& database, Library& library, const std::string& settings ) :
 	m_Database( database ),
 	m_Library( library )
@@ -159,7 +166,7 @@ void Settings::UpdatePlaylistTable( const std::string& table )
 		// Create the playlists table (if necessary).
 		std::string createTableQuery = "CREATE TABLE IF NOT EXISTS \"";
 		createTableQuery += table;
-		createTableQuery += "\"(File,Pending);";
+		createTableQuery += "\"(File,Pending,Position);";
 		sqlite3_exec( database, createTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 
 		// Check the columns in the playlists table.
@@ -187,7 +194,19 @@ void Settings::UpdatePlaylistTable( const std::string& table )
 				dropTableQuery += table + "\";";
 				sqlite3_exec( database, dropTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 				sqlite3_exec( database, createTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+			} else if ( columns.find( "Position" ) == columns.end() ) {
+				// Add the position column, preserving the existing (insertion) order.
+				std::string addColumnQuery = "ALTER TABLE \"";
+				addColumnQuery += table + "\" ADD COLUMN Position;";
+				sqlite3_exec( database, addColumnQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+				std::string updatePositionQuery = "UPDATE \"";
+				updatePositionQuery += table + "\" SET Position=rowid;";
+				sqlite3_exec( database, updatePositionQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 			}
+
+			std::string positionIndexQuery = "CREATE INDEX IF NOT EXISTS \"";
+			positionIndexQuery += table + "_Position\" ON \"" + table + "\"(Position);";
+			sqlite3_exec( database, positionIndexQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 		}
 	}
 }
@@ -551,14 +570,20 @@ void Settings::ReadPlaylistFiles( Playlist& playlist )
 	if ( nullptr != database ) {
 		const std::string tableName = ( Playlist::Type::Favourites == playlist.GetType() ) ? "Favourites" : playlist.GetID();
 		if ( IsValidGUID( tableName ) || ( Playlist::Type::Favourites == playlist.GetType() ) ) {
+			UpdatePlaylistTable( tableName );
+
 			std::string query = "SELECT * FROM \"";
 			query += tableName;
-			query += "\" ORDER BY rowid ASC;";
+			query += "\" ORDER BY Position ASC, rowid ASC;";
+
+			// Position keys of persisted items which could not be added, and are now pending.
+			std::list<double> pendingPositions;
 
 			sqlite3_stmt* stmt = nullptr;
 			if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
 				while ( SQLITE_ROW == sqlite3_step( stmt ) ) {
 					bool pending = false;
+					double position = 0;
 					std::wstring filename;
 					const int columnCount = sqlite3_column_count( stmt );
 					for ( int columnIndex = 0; columnIndex < columnCount; columnIndex++ ) {
@@ -570,6 +595,8 @@ void Settings::ReadPlaylistFiles( Playlist& playlist )
 							}
 						} else if ( columnName == "Pending" ) {
 							pending = ( 0 != sqlite3_column_int( stmt, columnIndex ) );
+						} else if ( columnName == "Position" ) {
+							position = sqlite3_column_double( stmt, columnIndex );
 						}
 					}
 					if ( !filename.empty() ) {
@@ -578,15 +605,32 @@ void Settings::ReadPlaylistFiles( Playlist& playlist )
 						} else {
 							MediaInfo mediaInfo( filename );
 							if ( m_Library.GetMediaInfo( mediaInfo, false /*checkFileAttributes*/, false /*scanMedia*/ ) ) {
-								playlist.AddItem( mediaInfo );
+								playlist.AddPersistedItem( mediaInfo, position );
 							} else {
 								playlist.AddPending( filename, false /*startPendingThread*/ );
+								pendingPositions.push_back( position );
 							}
 						}
 					}
 				}
 				sqlite3_finalize( stmt );
 			}
+
+			if ( !pendingPositions.empty() ) {
+				// Flag the entries as pending, so that they are replaced by the pending list when the playlist is next saved.
+				sqlite3_exec( database, "BEGIN TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+				std::string updatePendingQuery = "UPDATE \"";
+				updatePendingQuery += tableName + "\" SET Pending=1 WHERE Position=?1;";
+				if ( SQLITE_OK == sqlite3_prepare_v2( database, updatePendingQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+					for ( const auto& position : pendingPositions ) {
+						sqlite3_bind_double( stmt, 1 /*param*/, position );
+						sqlite3_step( stmt );
+						sqlite3_reset( stmt );
+					}
+					sqlite3_finalize( stmt );
+				}
+				sqlite3_exec( database, "END TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+			}
 		}
 	}
 }
@@ -635,34 +679,76 @@ void Settings::SavePlaylist( Playlist& playlist )
 		if ( IsValidGUID( playlistID ) || ( Playlist::Type::Favourites == playlist.GetType() ) ) {
 			UpdatePlaylistTable( playlistID );
 
+			Playlist::Journal journal;
+			Playlist::ItemList itemList;
+			const bool incremental = playlist.TakeJournal( journal, itemList );
+
+			// Include all entries of any playlist file being imported with the pending files.
+			playlist.ReadPendingImport();
+
+			sqlite3_exec( database, "BEGIN TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
+
+			// Pending files are always rewritten, so clear them out (or clear out everything, if the playlist is being rewritten in full).
 			std::string clearTableQuery = "DELETE FROM \"";
-			clearTableQuery += playlistID + "\";";
+			clearTableQuery += playlistID + ( incremental ? "\" WHERE Pending<>0;" : "\";" );
 			sqlite3_exec( database, clearTableQuery.c_str(), NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 
-			sqlite3_exec( database, "BEGIN TRANSACTION;", NULL /*callback*/, NULL /*arg*/, NULL /*errMsg*/ );
 			std::string insertFileQuery = "INSERT INTO \"";
 			insertFileQuery += playlistID;
-			insertFileQuery += "\" (File, Pending) VALUES (?1,?2);";
+			insertFileQuery += "\" (File,Pending,Position) VALUES (?1,?2,?3);";
 			sqlite3_stmt* stmt = nullptr;
 			if ( SQLITE_OK == sqlite3_prepare_v2( database, insertFileQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
 				bool pending = false;
-				const Playlist::ItemList itemList = playlist.GetItems();
-				for ( const auto& iter : itemList ) {
-					const std::string filename = WideStringToUTF8( iter.Info.GetFilename() );
-					if ( !filename.empty() ) {
-						sqlite3_bind_text( stmt, 1 /*param*/, filename.c_str(), -1 /*strLen*/, SQLITE_STATIC );
-						sqlite3_bind_int( stmt, 2 /*param*/, static_cast<int>( pending ) );
-						sqlite3_step( stmt );
-						sqlite3_reset( stmt );
+				if ( incremental ) {
+					std::string removeFileQuery = "DELETE FROM \"";
+					removeFileQuery += playlistID + "\" WHERE Position=?1;";
+					sqlite3_stmt* removeStmt = nullptr;
+					if ( SQLITE_OK == sqlite3_prepare_v2( database, removeFileQuery.c_str(), -1 /*nByte*/, &removeStmt, nullptr /*tail*/ ) ) {
+						for ( const auto& entry : journal ) {
+							if ( Playlist::JournalType::Remove == entry.Type ) {
+								sqlite3_bind_double( removeStmt, 1 /*param*/, entry.PositionKey );
+								sqlite3_step( removeStmt );
+								sqlite3_reset( removeStmt );
+							} else {
+								const std::string filename = WideStringToUTF8( entry.Filename );
+								if ( !filename.empty() ) {
+									sqlite3_bind_text( stmt, 1 /*param*/, filename.c_str(), -1 /*strLen*/, SQLITE_STATIC );
+									sqlite3_bind_int( stmt, 2 /*param*/, static_cast<int>( pending ) );
+									sqlite3_bind_double( stmt, 3 /*param*/, entry.PositionKey );
+									sqlite3_step( stmt );
+									sqlite3_reset( stmt );
+								}
+							}
+						}
+						sqlite3_finalize( removeStmt );
+					}
+				} else {
+					double position = 0;
+					for ( const auto& iter : itemList ) {
+						++position;
+						const std::string filename = WideStringToUTF8( iter.Info.GetFilename() );
+						if ( !filename.empty() ) {
+							sqlite3_bind_text( stmt, 1 /*param*/, filename.c_str(), -1 /*strLen*/, SQLITE_STATIC );
+							sqlite3_bind_int( stmt, 2 /*param*/, static_cast<int>( pending ) );
+							sqlite3_bind_double( stmt, 3 /*param*/, position );
+							sqlite3_step( stmt );
+							sqlite3_reset( stmt );
+						}
 					}
 				}
-				pending = true;
+				sqlite3_finalize( stmt );
+			}
+
+			// Pending files follow on from the last item.
+			insertFileQuery = "INSERT INTO \"";
+			insertFileQuery += playlistID;
+			insertFileQuery += "\" (File,Pending,Position) VALUES (?1,1,(SELECT IFNULL(MAX(Position),0)+1 FROM \"" + playlistID + "\"));";
+			if ( SQLITE_OK == sqlite3_prepare_v2( database, insertFileQuery.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
 				const std::list<std::wstring> pendingList = playlist.GetPending();
 				for ( const auto& iter : pendingList ) {
 					const std::string filename = WideStringToUTF8( iter );
 					if ( !filename.empty() ) {
 						sqlite3_bind_text( stmt, 1 /*param*/, filename.c_str(), -1 /*strLen*/, SQLITE_STATIC );
-						sqlite3_bind_int( stmt, 2 /*param*/, static_cast<int>( pending ) );
 						sqlite3_step( stmt );
 						sqlite3_reset( stmt );
 					}
@@ -1431,7 +1517,7 @@ void Settings::SetMODSettings( const long long mod, const long long mtm, const l
 void Settings::GetDefaultGainSettings( GainMode& gainMode, LimitMode& limitMode, float& preamp )
 {
 	gainMode = GainMode::Disabled;
-	limitMode = LimitMode::Soft;
+	limitMode = LimitMode::TruePeak;
 	preamp = 4.0f;
 }
 
@@ -1464,8 +1550,10 @@ void Settings::GetGainSettings( GainMode& gainMode, LimitMode& limitMode, float&
 		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
 			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
 				const int value = sqlite3_column_int( stmt, 0 /*columnIndex*/ );
-				if ( ( value >= static_cast<int>( LimitMode::None ) ) && ( value <= static_cast<int>( LimitMode::Soft ) ) ) {
-					limitMode = static_cast<LimitMode>( value );
+				if ( static_cast<int>( LimitMode::None ) == value ) {
+					limitMode = LimitMode::None;
+				} else if ( ( value > static_cast<int>( LimitMode::None ) ) && ( value <= static_cast<int>( LimitMode::TruePeak ) ) ) {
+					limitMode = LimitMode::TruePeak;
 				}
 			}
 			sqlite3_finalize( stmt );
@@ -1501,6 +1589,42 @@ void Settings::SetGainSettings( const GainMode gainMode, const LimitMode limitMo
 	}
 }
 
+long Settings::GetLimiterRelease()
+{
+	long release = 100;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='LimiterRelease';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				const long value = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+				if ( ( value >= 10 ) && ( value <= 2000 ) ) {
+					release = value;
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return release;
+}
+
+void Settings::SetLimiterRelease( const long release )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "LimiterRelease", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( release ) );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+			stmt = nullptr;
+		}
+	}
+}
+
 void Settings::GetSystraySettings( bool& enable, SystrayCommand& singleClick, SystrayCommand& doubleClick )
 {
 	enable = false;
@@ -1774,6 +1898,198 @@ Settings::PitchRangeMap Settings::GetPitchRangeOptions() const
 	return s_PitchRanges;
 }
 
+Settings::PitchMode Settings::GetPitchMode()
+{
+	PitchMode mode = PitchMode::Speed;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='PitchMode';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				const int value = sqlite3_column_int( stmt, 0 /*columnIndex*/ );
+				if ( ( value >= static_cast<int>( PitchMode::Speed ) ) && ( value <= static_cast<int>( PitchMode::Tempo ) ) ) {
+					mode = static_cast<PitchMode>( value );
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return mode;
+}
+
+void Settings::SetPitchMode( const PitchMode mode )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "PitchMode", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( mode ) );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+Settings::DitherMode Settings::GetDitherMode()
+{
+	DitherMode mode = DitherMode::Triangular;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='DitherMode';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				const int value = sqlite3_column_int( stmt, 0 /*columnIndex*/ );
+				if ( ( value >= static_cast<int>( DitherMode::None ) ) && ( value <= static_cast<int>( DitherMode::WeightedNoiseShaped ) ) ) {
+					mode = static_cast<DitherMode>( value );
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return mode;
+}
+
+void Settings::SetDitherMode( const DitherMode mode )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "DitherMode", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( mode ) );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+void Settings::GetResampleSettings( ResampleMode& mode, long& sampleRate )
+{
+	mode = ResampleMode::WhenNeeded;
+	sampleRate = 48000;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		std::string query = "SELECT Value FROM Settings WHERE Setting='ResampleMode';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				const int value = sqlite3_column_int( stmt, 0 /*columnIndex*/ );
+				if ( ( value >= static_cast<int>( ResampleMode::Never ) ) && ( value <= static_cast<int>( ResampleMode::Always ) ) ) {
+					mode = static_cast<ResampleMode>( value );
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+		stmt = nullptr;
+		query = "SELECT Value FROM Settings WHERE Setting='ResampleRate';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				const long value = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+				if ( ( value >= 8000 ) && ( value <= 384000 ) ) {
+					sampleRate = value;
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+void Settings::SetResampleSettings( const ResampleMode mode, const long sampleRate )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ResampleMode", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( mode ) );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_bind_text( stmt, 1, "ResampleRate", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( sampleRate ) );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_finalize( stmt );
+			stmt = nullptr;
+		}
+	}
+}
+
+void Settings::GetConvolutionSettings( bool& enabled, std::wstring& filename, long& partitionSize )
+{
+	enabled = false;
+	filename.clear();
+	partitionSize = 512;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		std::string query = "SELECT Value FROM Settings WHERE Setting='ConvolutionEnabled';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				enabled = ( 0 != sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+		stmt = nullptr;
+		query = "SELECT Value FROM Settings WHERE Setting='ConvolutionFilter';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				const char* text = reinterpret_cast<const char*>( sqlite3_column_text( stmt, 0 /*columnIndex*/ ) );
+				if ( nullptr != text ) {
+					filename = UTF8ToWideString( text );
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+		stmt = nullptr;
+		query = "SELECT Value FROM Settings WHERE Setting='ConvolutionPartitionSize';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				const long value = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+				if ( ( value >= 64 ) && ( value <= 8192 ) && ( 0 == ( value & ( value - 1 ) ) ) ) {
+					partitionSize = value;
+				}
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+void Settings::SetConvolutionSettings( const bool enabled, const std::wstring& filename, const long partitionSize )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ConvolutionEnabled", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, enabled ? 1 : 0 );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_bind_text( stmt, 1, "ConvolutionFilter", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_text( stmt, 2, WideStringToUTF8( filename ).c_str(), -1 /*strLen*/, SQLITE_TRANSIENT );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_bind_text( stmt, 1, "ConvolutionPartitionSize", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( partitionSize ) );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_finalize( stmt );
+			stmt = nullptr;
+		}
+	}
+}
+
 int Settings::GetOutputControlType()
 {
 	int type = 0;
@@ -1806,6 +2122,155 @@ void Settings::SetOutputControlType( const int type )
 	}
 }
 
+bool Settings::GetConvertApplyEQ()
+{
+	bool apply = false;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='ConvertApplyEQ';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				apply = ( 0 != sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return apply;
+}
+
+void Settings::SetConvertApplyEQ( const bool apply )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ConvertApplyEQ", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, apply ? 1 : 0 );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+bool Settings::GetConvertParallel()
+{
+	bool parallel = false;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='ConvertParallel';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				parallel = ( 0 != sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return parallel;
+}
+
+void Settings::SetConvertParallel( const bool parallel )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ConvertParallel", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, parallel ? 1 : 0 );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+bool Settings::GetConvertPassthrough()
+{
+	bool passthrough = false;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "SELECT Value FROM Settings WHERE Setting='ConvertPassthrough';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( SQLITE_ROW == sqlite3_step( stmt ) ) {
+				passthrough = ( 0 != sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	return passthrough;
+}
+
+void Settings::SetConvertPassthrough( const bool passthrough )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		sqlite3_stmt* stmt = nullptr;
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ConvertPassthrough", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, passthrough ? 1 : 0 );
+			sqlite3_step( stmt );
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
+void Settings::GetConvertJoinFormat( long& sampleRate, long& channels )
+{
+	sampleRate = 0;
+	channels = 0;
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		std::string query = "SELECT Value FROM Settings WHERE Setting='ConvertJoinSampleRate';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				sampleRate = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+		stmt = nullptr;
+		query = "SELECT Value FROM Settings WHERE Setting='ConvertJoinChannels';";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			if ( ( SQLITE_ROW == sqlite3_step( stmt ) ) && ( 1 == sqlite3_column_count( stmt ) ) ) {
+				channels = static_cast<long>( sqlite3_column_int( stmt, 0 /*columnIndex*/ ) );
+			}
+			sqlite3_finalize( stmt );
+		}
+	}
+	if ( ( sampleRate < s_MinJoinSampleRate ) || ( sampleRate > s_MaxJoinSampleRate ) ) {
+		sampleRate = 0;
+	}
+	if ( ( channels < 1 ) || ( channels > s_MaxJoinChannels ) ) {
+		channels = 0;
+	}
+}
+
+void Settings::SetConvertJoinFormat( const long sampleRate, const long channels )
+{
+	sqlite3* database = m_Database.GetDatabase();
+	if ( nullptr != database ) {
+		sqlite3_stmt* stmt = nullptr;
+		const std::string query = "REPLACE INTO Settings (Setting,Value) VALUES (?1,?2);";
+		if ( SQLITE_OK == sqlite3_prepare_v2( database, query.c_str(), -1 /*nByte*/, &stmt, nullptr /*tail*/ ) ) {
+			sqlite3_bind_text( stmt, 1, "ConvertJoinSampleRate", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( sampleRate ) );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_bind_text( stmt, 1, "ConvertJoinChannels", -1 /*strLen*/, SQLITE_STATIC );
+			sqlite3_bind_int( stmt, 2, static_cast<int>( channels ) );
+			sqlite3_step( stmt );
+			sqlite3_reset( stmt );
+
+			sqlite3_finalize( stmt );
+		}
+	}
+}
+
 void Settings::GetExtractSettings( std::wstring& folder, std::wstring& filename, bool& addToLibrary, bool& joinTracks )
 {
 	folder.clear();
@@ -3,6 +3,7 @@
 #include <list>
 
 #include "Database.h"
+#include "DitherMode.h"
 #include "Library.h"
 #include "Playlist.h"
 
@@ -50,10 +51,10 @@ public:
 	};
 
 	// Limiter mode.
+	// The true peak limiter replaces the hard (1) & soft (2) clipping modes, which are read from older settings as the true peak limiter.
 	enum class LimitMode {
-		None,
-		Hard,
-		Soft
+		None = 0,
+		TruePeak = 3
 	};
 
 	// Notification area icon click commands.
@@ -73,6 +74,22 @@ public:
 		Large
 	};
 
+	// Pitch adjustment modes.
+	enum class PitchMode {
+		Speed = 0,		// Adjust the playback speed, which changes both tempo and pitch.
+		Tempo					// Adjust the tempo, preserving the pitch.
+	};
+
+	// Resampling modes, for playing tracks that differ in sample rate or channel count from the current output.
+	enum class ResampleMode {
+		Never = 0,		// Restart the output in the format of each track (which causes a gap between tracks).
+		WhenNeeded,		// Play bit-perfect when possible, converting a track only when it differs from the current output format.
+		Always				// Always resample to a fixed output sample rate.
+	};
+
+	// Dither modes, for reducing sample data to an integer format of 24-bit resolution or lower.
+	typedef ::DitherMode DitherMode;
+
 	// EQ settings.
 	struct EQ {
 		// Maps a centre frequency, in Hz, to a gain value.
@@ -334,6 +351,12 @@ public:
 	// 'preamp' - preamp in dB.
 	void SetGainSettings( const GainMode gainMode, const LimitMode limitMode, const float preamp );
 
+	// Returns the true peak limiter release time, in milliseconds.
+	long GetLimiterRelease();
+
+	// Sets the true peak limiter 'release' time, in milliseconds.
+	void SetLimiterRelease( const long release );
+
 	// Gets notification area settings.
 	// 'enable' - out, whether the notification area icon is shown.
 	// 'singleClick' - out, single click action.
@@ -379,6 +402,40 @@ public:
 	// Returns the available pitch range options.
 	PitchRangeMap GetPitchRangeOptions() const;
 
+	// Gets the pitch adjustment mode.
+	PitchMode GetPitchMode();
+
+	// Sets the pitch adjustment mode.
+	void SetPitchMode( const PitchMode mode );
+
+	// Gets the dither mode, used when writing integer sample data.
+	DitherMode GetDitherMode();
+
+	// Sets the dither 'mode', used when writing integer sample data.
+	void SetDitherMode( const DitherMode mode );
+
+	// Gets resampling settings.
+	// 'mode' - out, resampling mode.
+	// 'sampleRate' - out, output sample rate, when always resampling.
+	void GetResampleSettings( ResampleMode& mode, long& sampleRate );
+
+	// Sets resampling settings.
+	// 'mode' - resampling mode.
+	// 'sampleRate' - output sample rate, when always resampling.
+	void SetResampleSettings( const ResampleMode mode, const long sampleRate );
+
+	// Gets convolution (room correction) filter settings.
+	// 'enabled' - out, whether the filter is enabled.
+	// 'filename' - out, impulse response filename.
+	// 'partitionSize' - out, partition size, in samples.
+	void GetConvolutionSettings( bool& enabled, std::wstring& filename, long& partitionSize );
+
+	// Sets convolution (room correction) filter settings.
+	// 'enabled' - whether the filter is enabled.
+	// 'filename' - impulse response filename.
+	// 'partitionSize' - partition size, in samples.
+	void SetConvolutionSettings( const bool enabled, const std::wstring& filename, const long partitionSize );
+
 	// Gets the output control type (volume, pitch, etc).
 	int GetOutputControlType();
 
@@ -391,6 +448,34 @@ public:
 	// Sets the track conversion/extraction settings.
 	void SetExtractSettings( const std::wstring& folder, const std::wstring& filename, const bool addToLibrary, const bool joinTracks );
 
+	// Returns whether to apply the current EQ settings when converting tracks.
+	bool GetConvertApplyEQ();
+
+	// Sets whether to 'apply' the current EQ settings when converting tracks.
+	void SetConvertApplyEQ( const bool apply );
+
+	// Returns whether to convert tracks in parallel, when creating a separate file for each track.
+	bool GetConvertParallel();
+
+	// Sets whether to convert tracks in 'parallel', when creating a separate file for each track.
+	void SetConvertParallel( const bool parallel );
+
+	// Returns whether to copy tracks which are already in the output format, rather than re-encoding them, when creating a separate file for each track.
+	bool GetConvertPassthrough();
+
+	// Sets whether to 'passthrough' tracks which are already in the output format, rather than re-encoding them, when creating a separate file for each track.
+	void SetConvertPassthrough( const bool passthrough );
+
+	// Gets the output format to use when joining tracks into a single file (a zero value indicates the highest value of the tracks being joined).
+	// 'sampleRate' - out, output sample rate.
+	// 'channels' - out, output channel count.
+	void GetConvertJoinFormat( long& sampleRate, long& channels );
+
+	// Sets the output format to use when joining tracks into a single file (a zero value indicates the highest value of the tracks being joined).
+	// 'sampleRate' - output sample rate.
+	// 'channels' - output channel count.
+	void SetConvertJoinFormat( const long sampleRate, const long channels );
+
 	// Gets EQ settings.
 	EQ GetEQSettings();
 
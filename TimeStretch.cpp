@@ -0,0 +1,424 @@
+#include "TimeStretch.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Overlap length, in seconds.
+static const double s_OverlapSeconds = 0.012;
+
+// Maximum offset from the nominal frame position when searching for the best matching frame, in seconds.
+static const double s_SearchSeconds = 0.008;
+
+// Step size of the initial (coarse) search for the best matching frame, in samples.
+static const long s_CoarseStep = 4;
+
+// Number of samples read from the input in one go.
+static const long s_ChunkSize = 1024;
+
+// Number of unneeded samples to accumulate before they are discarded.
+static const long long s_DiscardThreshold = 8192;
+
+// Resolution of the pitch shift factor applied by the resampler (the resampler converts from the pitch multiplied by this value, to this value).
+static const long s_PitchSteps = 1000;
+
+// Provides time stretched samples as a decoder, so that they can be resampled.
+class StretchedDecoder : public Decoder
+{
+public:
+	// 'channels' - channel count.
+	// 'readCallback' - callback to read time stretched samples.
+	StretchedDecoder( const long channels, const TimeStretch::ReadCallback& readCallback ) :
+		Decoder(),
+		m_ReadCallback( readCallback )
+	{
+		SetSampleRate( s_PitchSteps );
+		SetChannels( channels );
+	}
+
+	virtual ~StretchedDecoder()
+	{
+	}
+
+	// Reads time stretched sample data.
+	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
+	// 'sampleCount' - number of samples to read.
+	// Returns the number of samples read, or zero if the stream has ended.
+	virtual long Read( float* buffer, const long sampleCount )
+	{
+		return m_ReadCallback( buffer, sampleCount );
+	}
+
+	// The position of the time stretched samples is managed by the time stretch, so this does nothing.
+	// Returns the 'position'.
+	virtual float Seek( const float position )
+	{
+		return position;
+	}
+
+private:
+	// Callback to read time stretched samples.
+	const TimeStretch::ReadCallback m_ReadCallback;
+};
+
+// Returns the dot product of 'count' floats from 'a' and 'b' ('count' must be a multiple of 4).
+static float DotProduct( const float* a, const float* b, const long count )
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	long index = 0;
+	for ( ; ( index + 8 ) <= count; index += 8 ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a + index ), _mm_loadu_ps( b + index ) ) );
+		sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( a + index + 4 ), _mm_loadu_ps( b + index + 4 ) ) );
+	}
+	for ( ; index < count; index += 4 ) {
+		sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( a + index ), _mm_loadu_ps( b + index ) ) );
+	}
+	sum0 = _mm_add_ps( sum0, sum1 );
+	sum0 = _mm_add_ps( sum0, _mm_movehl_ps( sum0, sum0 ) );
+	sum0 = _mm_add_ss( sum0, _mm_shuffle_ps( sum0, sum0, 1 ) );
+	return _mm_cvtss_f32( sum0 );
+}
+
+TimeStretch::TimeStretch( const long sampleRate, const long channels ) :
+	m_SampleRate( sampleRate ),
+	m_Channels( channels ),
+	m_Overlap( 4 * std::max( 1l, static_cast<long>( std::lround( sampleRate * s_OverlapSeconds / 4 ) ) ) ),
+	m_SearchRange( static_cast<long>( std::lround( sampleRate * s_SearchSeconds ) ) ),
+	m_Window( static_cast<size_t>( 2 * m_Overlap ) ),
+	m_Pitch( 1.0f ),
+	m_StretchPitch( 1.0 ),
+	m_Input(),
+	m_InputMono(),
+	m_InputStart( 0 ),
+	m_InputEnded( false ),
+	m_InputEnd( 0 ),
+	m_FramePosition( 0 ),
+	m_PreviousFrame( -1 ),
+	m_OverlapBuffer( static_cast<size_t>( m_Overlap * m_Channels ) ),
+	m_Stretched(),
+	m_StretchedStart( 0 ),
+	m_StretchedEnded( false ),
+	m_StretchedPosition( 0 ),
+	m_StretchedDecoder(),
+	m_Resampler(),
+	m_ReadCallback( nullptr ),
+	m_Active( false ),
+	m_ProcessingTime( 0 ),
+	m_ProcessedSamples( 0 ),
+	m_Load( 0 )
+{
+	// A periodic Hann window, so that the overlapping halves of consecutive windows sum to one.
+	const size_t windowSize = m_Window.size();
+	for ( size_t index = 0; index < windowSize; index++ ) {
+		m_Window[ index ] = static_cast<float>( 0.5 - 0.5 * std::cos( 2 * M_PI * index / windowSize ) );
+	}
+
+	m_StretchedDecoder = std::make_shared<StretchedDecoder>( m_Channels, [ this ] ( float* buffer, const long sampleCount ) -> long
+	{
+		return ReadStretched( buffer, sampleCount );
+	} );
+}
+
+TimeStretch::~TimeStretch()
+{
+}
+
+void TimeStretch::SetPitch( const float pitch )
+{
+	if ( pitch > 0 ) {
+		m_Pitch = pitch;
+	}
+}
+
+float TimeStretch::GetPitch() const
+{
+	return m_Pitch;
+}
+
+long TimeStretch::GetSampleRate() const
+{
+	return m_SampleRate;
+}
+
+long TimeStretch::GetChannels() const
+{
+	return m_Channels;
+}
+
+void TimeStretch::Reset()
+{
+	m_Input.clear();
+	m_InputMono.clear();
+	m_InputStart = 0;
+	m_InputEnded = false;
+	m_InputEnd = 0;
+	m_FramePosition = 0;
+	m_PreviousFrame = -1;
+	std::fill( m_OverlapBuffer.begin(), m_OverlapBuffer.end(), 0.0f );
+	m_Stretched.clear();
+	m_StretchedStart = 0;
+	m_StretchedEnded = false;
+	m_StretchedPosition = 0;
+	if ( m_Resampler ) {
+		// Clears the filter history, keeping the filter coefficients.
+		m_Resampler->Seek( 0 );
+	}
+	m_Active = false;
+	m_ProcessingTime = 0;
+	m_ProcessedSamples = 0;
+	m_Load = 0;
+}
+
+bool TimeStretch::IsActive() const
+{
+	const bool active = m_Active || ( 1.0f != m_Pitch );
+	return active;
+}
+
+long TimeStretch::Read( float* buffer, const long sampleCount, const ReadCallback& readCallback )
+{
+	const float pitch = m_Pitch;
+	if ( !m_Active ) {
+		if ( 1.0f == pitch ) {
+			// Pass through the input until a pitch shift is needed.
+			return readCallback( buffer, sampleCount );
+		}
+		m_Active = true;
+	}
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// The time stretched samples are resampled from the (quantised) pitch shift factor to unity.
+	const long resampleRate = std::max( 1l, std::lround( pitch * s_PitchSteps ) );
+	if ( !m_Resampler ) {
+		m_StretchedDecoder->SetSampleRate( resampleRate );
+		m_Resampler = std::make_shared<Resampler>( m_StretchedDecoder, s_PitchSteps, m_Channels );
+	} else if ( resampleRate != m_StretchedDecoder->GetSampleRate() ) {
+		m_StretchedDecoder->SetSampleRate( resampleRate );
+		m_Resampler->SetInputRate( resampleRate );
+	}
+	m_StretchPitch = static_cast<double>( resampleRate ) / s_PitchSteps;
+
+	m_ReadCallback = &readCallback;
+	const long samplesRead = m_Resampler->Read( buffer, sampleCount );
+	m_ReadCallback = nullptr;
+
+	DiscardSamples();
+
+	m_ProcessingTime += std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+	m_ProcessedSamples += samplesRead;
+	if ( m_ProcessedSamples > 0 ) {
+		m_Load = static_cast<float>( m_ProcessingTime * m_SampleRate / m_ProcessedSamples );
+	}
+
+	return samplesRead;
+}
+
+float TimeStretch::GetLoad() const
+{
+	return m_Load;
+}
+
+long TimeStretch::ReadStretched( float* buffer, const long sampleCount )
+{
+	long samplesRead = 0;
+	while ( samplesRead < sampleCount ) {
+		const long long stretchedEnd = m_StretchedStart + static_cast<long long>( m_Stretched.size() / m_Channels );
+		if ( m_StretchedPosition >= stretchedEnd ) {
+			if ( ( nullptr == m_ReadCallback ) || !AddFrame( *m_ReadCallback ) ) {
+				break;
+			}
+			continue;
+		}
+		const long count = static_cast<long>( std::min<long long>( sampleCount - samplesRead, stretchedEnd - m_StretchedPosition ) );
+		const float* stretched = m_Stretched.data() + static_cast<size_t>( m_StretchedPosition - m_StretchedStart ) * m_Channels;
+		std::copy( stretched, stretched + count * m_Channels, buffer + samplesRead * m_Channels );
+		samplesRead += count;
+		m_StretchedPosition += count;
+	}
+	return samplesRead;
+}
+
+bool TimeStretch::AddFrame( const ReadCallback& readCallback )
+{
+	if ( m_StretchedEnded ) {
+		return false;
+	}
+
+	const long long nominalFrame = std::llround( m_FramePosition );
+	if ( m_InputEnded && ( nominalFrame >= m_InputEnd ) ) {
+		// Flush the second half of the previous frame.
+		if ( m_PreviousFrame >= 0 ) {
+			m_Stretched.insert( m_Stretched.end(), m_OverlapBuffer.begin(), m_OverlapBuffer.end() );
+		}
+		m_StretchedEnded = true;
+		return true;
+	}
+
+	long long frame = nominalFrame;
+	if ( m_PreviousFrame < 0 ) {
+		ReadInput( frame + 2 * m_Overlap, readCallback );
+	} else {
+		ReadInput( std::max( nominalFrame + m_SearchRange, m_PreviousFrame + m_Overlap ) + 2 * m_Overlap, readCallback );
+		frame = FindBestFrame( nominalFrame );
+	}
+
+	// Overlap-add the first half of the frame, and hold on to the second half for the next frame.
+	const float* input = m_Input.data() + static_cast<size_t>( frame - m_InputStart ) * m_Channels;
+	const size_t overlapSize = m_OverlapBuffer.size();
+	const size_t stretchedSize = m_Stretched.size();
+	m_Stretched.resize( stretchedSize + overlapSize );
+	float* output = m_Stretched.data() + stretchedSize;
+	if ( m_PreviousFrame < 0 ) {
+		std::copy( input, input + overlapSize, output );
+	} else {
+		for ( long index = 0; index < m_Overlap; index++ ) {
+			const float window = m_Window[ index ];
+			for ( long channel = 0; channel < m_Channels; channel++ ) {
+				const size_t offset = static_cast<size_t>( index * m_Channels + channel );
+				output[ offset ] = m_OverlapBuffer[ offset ] + window * input[ offset ];
+			}
+		}
+	}
+	input += overlapSize;
+	for ( long index = 0; index < m_Overlap; index++ ) {
+		const float window = m_Window[ m_Overlap + index ];
+		for ( long channel = 0; channel < m_Channels; channel++ ) {
+			const size_t offset = static_cast<size_t>( index * m_Channels + channel );
+			m_OverlapBuffer[ offset ] = window * input[ offset ];
+		}
+	}
+
+	// The input frame step is scaled by the pitch shift factor, as the time stretched output is resampled by the same factor.
+	m_PreviousFrame = frame;
+	m_FramePosition += m_Overlap / m_StretchPitch;
+	return true;
+}
+
+bool TimeStretch::ReadInput( const long long position, const ReadCallback& readCallback )
+{
+	long long inputEnd = m_InputStart + static_cast<long long>( m_Input.size() / m_Channels );
+	while ( inputEnd < position ) {
+		const size_t inputSize = m_Input.size();
+		m_Input.resize( inputSize + s_ChunkSize * m_Channels );
+		const long samplesRead = m_InputEnded ? 0 : readCallback( m_Input.data() + inputSize, s_ChunkSize );
+		if ( samplesRead <= 0 ) {
+			// Pad with silence, so that the last frames can be completed.
+			if ( !m_InputEnded ) {
+				m_InputEnded = true;
+				m_InputEnd = inputEnd;
+			}
+			const long long padding = position - inputEnd;
+			m_Input.resize( inputSize + static_cast<size_t>( padding * m_Channels ), 0.0f );
+			m_InputMono.resize( m_InputMono.size() + static_cast<size_t>( padding ), 0.0f );
+			return false;
+		}
+		m_Input.resize( inputSize + samplesRead * m_Channels );
+
+		const float scale = 1.0f / m_Channels;
+		const float* input = m_Input.data() + inputSize;
+		for ( long index = 0; index < samplesRead; index++, input += m_Channels ) {
+			float mono = 0;
+			for ( long channel = 0; channel < m_Channels; channel++ ) {
+				mono += input[ channel ];
+			}
+			m_InputMono.push_back( mono * scale );
+		}
+		inputEnd += samplesRead;
+	}
+	return true;
+}
+
+long long TimeStretch::FindBestFrame( const long long position ) const
+{
+	const long long minPosition = std::max( position - m_SearchRange, m_InputStart );
+	const long long maxPosition = position + m_SearchRange;
+
+	long long bestPosition = std::clamp( position, minPosition, maxPosition );
+	float bestSimilarity = GetSimilarity( bestPosition );
+	for ( long long candidate = minPosition; candidate <= maxPosition; candidate += s_CoarseStep ) {
+		const float similarity = GetSimilarity( candidate );
+		if ( similarity > bestSimilarity ) {
+			bestSimilarity = similarity;
+			bestPosition = candidate;
+		}
+	}
+
+	const long long coarsePosition = bestPosition;
+	const long long fineStart = std::max( coarsePosition - s_CoarseStep + 1, minPosition );
+	const long long fineEnd = std::min( coarsePosition + s_CoarseStep - 1, maxPosition );
+	for ( long long candidate = fineStart; candidate <= fineEnd; candidate++ ) {
+		const float similarity = GetSimilarity( candidate );
+		if ( similarity > bestSimilarity ) {
+			bestSimilarity = similarity;
+			bestPosition = candidate;
+		}
+	}
+	return bestPosition;
+}
+
+float TimeStretch::GetSimilarity( const long long position ) const
+{
+	// Normalised cross correlation with the natural continuation of the previous frame.
+	const float* continuation = m_InputMono.data() + static_cast<size_t>( m_PreviousFrame + m_Overlap - m_InputStart );
+	const float* candidate = m_InputMono.data() + static_cast<size_t>( position - m_InputStart );
+	const float correlation = DotProduct( continuation, candidate, m_Overlap );
+	const float energy = DotProduct( candidate, candidate, m_Overlap );
+	const float similarity = correlation / std::sqrt( energy + 1e-9f );
+	return similarity;
+}
+
+void TimeStretch::DiscardSamples()
+{
+	const long long inputNeeded = std::min( m_PreviousFrame + m_Overlap, std::llround( m_FramePosition ) - m_SearchRange );
+	if ( ( inputNeeded - m_InputStart ) > s_DiscardThreshold ) {
+		const long long discard = inputNeeded - m_InputStart;
+		m_Input.erase( m_Input.begin(), m_Input.begin() + static_cast<size_t>( discard * m_Channels ) );
+		m_InputMono.erase( m_InputMono.begin(), m_InputMono.begin() + static_cast<size_t>( discard ) );
+		m_InputStart += discard;
+	}
+
+	const long long stretchedNeeded = m_StretchedPosition;
+	if ( ( stretchedNeeded - m_StretchedStart ) > s_DiscardThreshold ) {
+		const long long discard = stretchedNeeded - m_StretchedStart;
+		m_Stretched.erase( m_Stretched.begin(), m_Stretched.begin() + static_cast<size_t>( discard * m_Channels ) );
+		m_StretchedStart += discard;
+	}
+}
+
+float TimeStretch::Benchmark( const long sampleRate, const long channels, const float pitch, const float seconds )
+{
+	TimeStretch timeStretch( sampleRate, channels );
+	timeStretch.SetPitch( pitch );
+
+	// Generate a chord with some noise, so that the frame search has to do some work.
+	long long inputPosition = 0;
+	unsigned int seed = 1;
+	const ReadCallback readCallback = [ &inputPosition, &seed, sampleRate, channels ] ( float* buffer, const long sampleCount ) -> long
+	{
+		for ( long index = 0; index < sampleCount; index++, inputPosition++ ) {
+			const double time = static_cast<double>( inputPosition ) / sampleRate;
+			const float tone = static_cast<float>( 0.2 * std::sin( 2 * M_PI * 220 * time ) + 0.15 * std::sin( 2 * M_PI * 277.2 * time ) + 0.1 * std::sin( 2 * M_PI * 329.6 * time ) );
+			for ( long channel = 0; channel < channels; channel++ ) {
+				seed = seed * 1664525 + 1013904223;
+				const float noise = 0.05f * ( static_cast<float>( seed >> 8 ) / 0x1000000 - 0.5f );
+				*buffer++ = tone + noise;
+			}
+		}
+		return sampleCount;
+	};
+
+	const long long totalSamples = static_cast<long long>( seconds * sampleRate );
+	std::vector<float> buffer( static_cast<size_t>( s_ChunkSize * channels ) );
+	for ( long long samplesProcessed = 0; samplesProcessed < totalSamples; ) {
+		const long samplesRead = timeStretch.Read( buffer.data(), s_ChunkSize, readCallback );
+		if ( 0 == samplesRead ) {
+			break;
+		}
+		samplesProcessed += samplesRead;
+	}
+	return timeStretch.GetLoad();
+}
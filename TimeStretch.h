@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Resampler.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Pitch shifts sample data without changing its duration, so that a playback rate adjustment can change the tempo while preserving the pitch.
+// Samples are time stretched using WSOLA (waveform similarity overlap-add), and then resampled back to their original duration using the polyphase resampler.
+class TimeStretch
+{
+public:
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	TimeStretch( const long sampleRate, const long channels );
+
+	virtual ~TimeStretch();
+
+	// Time stretch shared pointer type.
+	typedef std::shared_ptr<TimeStretch> Ptr;
+
+	// Reads up to 'sampleCount' samples of interleaved input into 'buffer', returning the number of samples read (or zero at the end of the stream).
+	typedef std::function<long( float* buffer, const long sampleCount )> ReadCallback;
+
+	// Sets the 'pitch' shift factor, with 1.0 being no adjustment.
+	void SetPitch( const float pitch );
+
+	// Returns the pitch shift factor.
+	float GetPitch() const;
+
+	// Returns the sample rate.
+	long GetSampleRate() const;
+
+	// Returns the channel count.
+	long GetChannels() const;
+
+	// Discards any buffered samples and resets the processing cost, so that the time stretch can be reused for a new stream.
+	void Reset();
+
+	// Returns whether samples need to be processed (pitch shift is needed, or processing is under way).
+	bool IsActive() const;
+
+	// Reads pitch shifted sample data.
+	// 'buffer' - output buffer (floating point format scaled to +/-1.0f).
+	// 'sampleCount' - number of samples to read.
+	// 'readCallback' - callback to read input samples.
+	// Returns the number of samples read, or zero if the stream has ended.
+	long Read( float* buffer, const long sampleCount, const ReadCallback& readCallback );
+
+	// Returns the processing cost, as a fraction of the duration of the sample data processed (i.e. the proportion of one CPU core used).
+	float GetLoad() const;
+
+	// Measures the processing cost of pitch shifting, without needing any output.
+	// 'sampleRate' - sample rate.
+	// 'channels' - channel count.
+	// 'pitch' - pitch shift factor.
+	// 'seconds' - duration of (generated) sample data to process.
+	// Returns the processing cost, as a fraction of the duration of the sample data processed.
+	static float Benchmark( const long sampleRate, const long channels, const float pitch, const float seconds );
+
+private:
+	// Reads up to 'sampleCount' time stretched samples into 'buffer', adding frames as needed.
+	// Returns the number of samples read, or zero if the time stretched output has ended.
+	long ReadStretched( float* buffer, const long sampleCount );
+
+	// Adds the next frame to the time stretched output, reading input samples as needed.
+	// Returns false if there are no more frames, because the input has ended.
+	bool AddFrame( const ReadCallback& readCallback );
+
+	// Reads input samples, so that the input buffer extends to (but not including) 'position'.
+	// Any part of the buffer beyond the end of the input is padded with silence.
+	// Returns false if the input has ended before 'position'.
+	bool ReadInput( const long long position, const ReadCallback& readCallback );
+
+	// Returns the offset of the best matching frame near 'position', in relation to the natural continuation of the previous frame.
+	long long FindBestFrame( const long long position ) const;
+
+	// Returns the similarity of the frame at 'position' to the natural continuation of the previous frame.
+	float GetSimilarity( const long long position ) const;
+
+	// Discards buffered input and time stretched samples that are no longer needed.
+	void DiscardSamples();
+
+	// Sample rate.
+	const long m_SampleRate;
+
+	// Channel count.
+	const long m_Channels;
+
+	// Overlap length, which is also the frame step of the time stretched output, in samples.
+	const long m_Overlap;
+
+	// Maximum offset from the nominal frame position when searching for the best matching frame, in samples.
+	const long m_SearchRange;
+
+	// Overlap-add window, of twice the overlap length.
+	std::vector<float> m_Window;
+
+	// Pitch shift factor.
+	std::atomic<float> m_Pitch;
+
+	// Pitch shift factor applied by the resampler, which determines the input frame step.
+	double m_StretchPitch;
+
+	// Interleaved input samples.
+	std::vector<float> m_Input;
+
+	// Input samples mixed down to mono, for finding the best matching frame.
+	std::vector<float> m_InputMono;
+
+	// Position of the first buffered input sample.
+	long long m_InputStart;
+
+	// Indicates whether the input has ended.
+	bool m_InputEnded;
+
+	// Position at which the input ended.
+	long long m_InputEnd;
+
+	// Nominal position of the next input frame.
+	double m_FramePosition;
+
+	// Position of the previous input frame, or -1 if there is no previous frame.
+	long long m_PreviousFrame;
+
+	// Windowed second half of the previous frame, to be overlapped with the next frame.
+	std::vector<float> m_OverlapBuffer;
+
+	// Interleaved time stretched samples.
+	std::vector<float> m_Stretched;
+
+	// Position of the first buffered time stretched sample.
+	long long m_StretchedStart;
+
+	// Indicates whether the time stretched output has ended.
+	bool m_StretchedEnded;
+
+	// Position of the next time stretched sample to be resampled.
+	long long m_StretchedPosition;
+
+	// Provides the time stretched samples to the resampler.
+	Decoder::Ptr m_StretchedDecoder;
+
+	// Resamples the time stretched samples back to their original duration.
+	std::shared_ptr<Resampler> m_Resampler;
+
+	// Callback to read input samples, during a call to Read().
+	const ReadCallback* m_ReadCallback;
+
+	// Indicates whether processing is under way.
+	std::atomic<bool> m_Active;
+
+	// Total processing time, in seconds.
+	double m_ProcessingTime;
+
+	// Total number of samples output.
+	long long m_ProcessedSamples;
+
+	// Processing cost, as a fraction of the duration of the sample data processed.
+	std::atomic<float> m_Load;
+};
@@ -50,6 +50,9 @@ static const wchar_t s_Database[] = L"VUPlayerDebug.db";
 static const wchar_t s_Database[] = L"VUPlayer.db";
 #endif
 
+// Conversion report filename (replaced by each conversion).
+static const wchar_t s_ConversionReport[] = L"VUPlayer Conversion.json";
+
 VUPlayer* VUPlayer::Get()
 {
 	return s_VUPlayer;
@@ -70,7 +73,7 @@ VUPlayer::VUPlayer( const HINSTANCE instance, const HWND hwnd, const std::list<s
 	m_Scrobbler( m_Database, m_Settings, portable /*disable*/ ),
 	m_CDDAManager( m_hInst, m_hWnd, m_Library, m_Handlers ),
 	m_Rebar( m_hInst, m_hWnd, m_Settings ),
-	m_Status( m_hInst, m_hWnd ),
+	m_Status( m_hInst, m_hWnd, m_Library, m_Output ),
 	m_Tree( m_hInst, m_hWnd, m_Library, m_Settings, m_CDDAManager ),
 	m_Visual( m_hInst, m_hWnd, m_Rebar.GetWindowHandle(), m_Status.GetWindowHandle(), m_Settings, m_Output, m_Library ),
 	m_List( m_hInst, m_hWnd, m_Settings, m_Output ),
@@ -96,7 +99,8 @@ VUPlayer::VUPlayer( const HINSTANCE instance, const HWND hwnd, const std::list<s
 	m_Hotkeys( m_hWnd, m_Settings ),
 	m_LastSkipCount( {} ),
 	m_LastOutputStateChange( 0 ),
-	m_AddToPlaylistMenuMap()
+	m_AddToPlaylistMenuMap(),
+	m_Portable( portable )
 {
 	s_VUPlayer = this;
 
@@ -548,6 +552,31 @@ void VUPlayer::OnPlaylistItemAdded( Playlist* playlist, const Playlist::Item& it
 	}
 }
 
+void VUPlayer::OnPlaylistItemsAdded( Playlist* playlist, const Playlist::ItemPositionList& items )
+{
+	Playlist::ItemPositionList addedItems;
+	for ( const auto& item : items ) {
+		if ( item.first.ID > 0 ) {
+			addedItems.push_back( item );
+		}
+	}
+	if ( ( nullptr != playlist ) && !addedItems.empty() ) {
+		m_List.OnFilesAdded( playlist, addedItems );
+
+		if ( Playlist::Type::All != playlist->GetType() ) {
+			const Playlist::Ptr playlistAll = m_Tree.GetPlaylistAll();
+			if ( playlistAll ) {
+				for ( const auto& item : addedItems ) {
+					playlistAll->AddPending( item.first.Info.GetFilename(), false /*startPendingThread*/ );
+				}
+				playlistAll->StartPendingThread();
+			}
+		}
+
+		m_Status.Update( playlist );
+	}
+}
+
 void VUPlayer::OnPlaylistItemRemoved( Playlist* playlist, const Playlist::Item& item )
 {
 	m_List.OnFileRemoved( playlist, item );
@@ -798,6 +827,19 @@ void VUPlayer::OnCommand( const int commandID )
 			}
 			break;
 		}
+		case ID_CONTROL_PITCHMODE_SPEED : 
+		case ID_CONTROL_PITCHMODE_TEMPO : {
+			m_Output.SetPitchMode( ( ID_CONTROL_PITCHMODE_TEMPO == commandID ) ? Settings::PitchMode::Tempo : Settings::PitchMode::Speed );
+			break;
+		}
+		case ID_CONTROL_CONVOLUTION_ENABLE : {
+			OnConvolutionEnable();
+			break;
+		}
+		case ID_CONTROL_CONVOLUTION_CHOOSE : {
+			OnConvolutionChoose();
+			break;
+		}
 		case ID_CONTROL_CROSSFADE : {
 			m_Output.SetCrossfade( !m_Output.GetCrossfade() );
 			break;
@@ -1189,6 +1231,15 @@ void VUPlayer::OnInitMenu( const HMENU menu )
 		CheckMenuItem( menu, ID_CONTROL_PITCHRANGE_SMALL, ( Settings::PitchRange::Small == pitchRange ) ? MF_CHECKED : MF_UNCHECKED );
 		CheckMenuItem( menu, ID_CONTROL_PITCHRANGE_MEDIUM, ( Settings::PitchRange::Medium == pitchRange ) ? MF_CHECKED : MF_UNCHECKED );
 		CheckMenuItem( menu, ID_CONTROL_PITCHRANGE_LARGE, ( Settings::PitchRange::Large == pitchRange ) ? MF_CHECKED : MF_UNCHECKED );
+		const Settings::PitchMode pitchMode = m_Output.GetPitchMode();
+		CheckMenuItem( menu, ID_CONTROL_PITCHMODE_SPEED, ( Settings::PitchMode::Speed == pitchMode ) ? MF_CHECKED : MF_UNCHECKED );
+		CheckMenuItem( menu, ID_CONTROL_PITCHMODE_TEMPO, ( Settings::PitchMode::Tempo == pitchMode ) ? MF_CHECKED : MF_UNCHECKED );
+
+		bool convolutionEnabled = false;
+		std::wstring convolutionFilter;
+		long convolutionPartitionSize = 0;
+		m_Settings.GetConvolutionSettings( convolutionEnabled, convolutionFilter, convolutionPartitionSize );
+		CheckMenuItem( menu, ID_CONTROL_CONVOLUTION_ENABLE, ( convolutionEnabled && !convolutionFilter.empty() ) ? MF_CHECKED : MF_UNCHECKED );
 
 		const bool isStopAtTrackEnd = m_Output.GetStopAtTrackEnd();
 		const bool isMuted = m_Output.GetMuted();
@@ -1535,7 +1586,9 @@ void VUPlayer::OnConvert()
 				if ( Playlist::Type::CDDA == playlist->GetType() ) {
 					CDDAExtract extract( m_hInst, m_hWnd, m_Library, m_Settings, m_Handlers, m_CDDAManager, selectedItems, handler, joinFilename );
 				} else {
-					Converter converter( m_hInst, m_hWnd, m_Library, m_Settings, m_Handlers, selectedItems, handler, joinFilename );
+					// The conversion report is kept with the database, and is not written in portable mode.
+					const std::wstring reportFilename = m_Portable ? std::wstring() : ( DocumentsFolder() + s_ConversionReport );
+					Converter converter( m_hInst, m_hWnd, m_Library, m_Settings, m_Handlers, selectedItems, handler, joinFilename, reportFilename );
 				}
 			}
 		}
@@ -1722,3 +1775,77 @@ void VUPlayer::OnExportSettings()
 		}
 	}
 }
+
+void VUPlayer::OnConvolutionEnable()
+{
+	bool enabled = false;
+	std::wstring filename;
+	long partitionSize = 0;
+	m_Settings.GetConvolutionSettings( enabled, filename, partitionSize );
+	if ( filename.empty() ) {
+		OnConvolutionChoose();
+	} else {
+		m_Settings.SetConvolutionSettings( !enabled, filename, partitionSize );
+		m_Output.UpdateConvolution();
+	}
+}
+
+bool VUPlayer::OnConvolutionChoose()
+{
+	bool enabled = false;
+	std::wstring filename;
+	long partitionSize = 0;
+	m_Settings.GetConvolutionSettings( enabled, filename, partitionSize );
+
+	WCHAR title[ MAX_PATH ] = {};
+	LoadString( m_hInst, IDS_CONVOLUTION_TITLE, title, MAX_PATH );
+
+	WCHAR filter[ MAX_PATH ] = {};
+	LoadString( m_hInst, IDS_ADDFILES_FILTERAUDIO, filter, MAX_PATH );
+	const std::wstring filter1( filter );
+	const std::set<std::wstring> audioTypes = m_Output.GetAllSupportedFileExtensions();
+	std::wstring filter2;
+	for ( const auto& iter : audioTypes ) {
+		filter2 += L"*." + iter + L";";
+	}
+	if ( !filter2.empty() ) {
+		filter2.pop_back();
+	}
+	LoadString( m_hInst, IDS_CHOOSE_FILTERALL, filter, MAX_PATH );
+	const std::wstring filter3( filter );
+	const std::wstring filter4( L"*.*" );
+	std::vector<WCHAR> filterStr;
+	filterStr.reserve( MAX_PATH );
+	filterStr.insert( filterStr.end(), filter1.begin(), filter1.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter2.begin(), filter2.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter3.begin(), filter3.end() );
+	filterStr.push_back( 0 );
+	filterStr.insert( filterStr.end(), filter4.begin(), filter4.end() );
+	filterStr.push_back( 0 );
+	filterStr.push_back( 0 );
+
+	const std::string initialFolderSetting = "ConvolutionFilter";
+	const std::wstring initialFolder = m_Settings.GetLastFolder( initialFolderSetting );
+
+	WCHAR buffer[ MAX_PATH ] = {};
+	OPENFILENAME ofn = {};
+	ofn.lStructSize = sizeof( OPENFILENAME );
+	ofn.hwndOwner = m_hWnd;
+	ofn.lpstrTitle = title;
+	ofn.lpstrFilter = &filterStr[ 0 ];
+	ofn.nFilterIndex = 1;
+	ofn.Flags = OFN_FILEMUSTEXIST | OFN_EXPLORER;
+	ofn.lpstrFile = buffer;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.lpstrInitialDir = initialFolder.empty() ? nullptr : initialFolder.c_str();
+	const bool chosen = ( FALSE != GetOpenFileName( &ofn ) );
+	if ( chosen ) {
+		filename = ofn.lpstrFile;
+		m_Settings.SetLastFolder( initialFolderSetting, filename.substr( 0, ofn.nFileOffset ) );
+		m_Settings.SetConvolutionSettings( true /*enabled*/, filename, partitionSize );
+		m_Output.UpdateConvolution();
+	}
+	return chosen;
+}
@@ -101,6 +101,9 @@ public:
 	// Called when an 'item' is added to the 'playlist' at a (0-based) 'position'.
 	void OnPlaylistItemAdded( Playlist* playlist, const Playlist::Item& item, const int position );
 
+	// Called when a chunk of 'items' is added to the 'playlist', each item paired with its (0-based) position.
+	void OnPlaylistItemsAdded( Playlist* playlist, const Playlist::ItemPositionList& items );
+
 	// Called when an 'item' is removed from the 'playlist'.
 	void OnPlaylistItemRemoved( Playlist* playlist, const Playlist::Item& item );
 
@@ -177,6 +180,13 @@ public:
 	// Exports application settings, for use when running in 'portable' mode.
 	void OnExportSettings();
 
+	// Toggles room correction, choosing a convolution filter first if there is none.
+	void OnConvolutionEnable();
+
+	// Chooses a room correction convolution filter, and enables room correction.
+	// Returns true if a filter was chosen.
+	bool OnConvolutionChoose();
+
 private:
 	// Main application instance.
 	static VUPlayer* s_VUPlayer;
@@ -354,4 +364,7 @@ private:
 
 	// Maps a menu command ID to a playlist for the Add to Playlist sub menu.
 	PlaylistMenuMap m_AddToPlaylistMenuMap;
+
+	// Whether the application is running in 'portable' mode.
+	const bool m_Portable;
 };
\ No newline at end of file
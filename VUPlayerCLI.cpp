@@ -0,0 +1,634 @@
+// Console batch converter & analyser.
+// Converts, calculates track gain for, or verifies media files from the command line, processing files in parallel on all available cores.
+// Also benchmarks the processing stages, and checks that multithreaded FLAC encoding matches single threaded encoding.
+// No windows are created and there is no message loop, so the tool can be used from scripts and on build servers.
+
+#include "stdafx.h"
+
+#include "Database.h"
+#include "EncoderFlac.h"
+#include "GainCalculator.h"
+#include "Handlers.h"
+#include "InputSource.h"
+#include "Library.h"
+#include "SampleConversion.h"
+#include "Settings.h"
+#include "TimeStretch.h"
+#include "Utility.h"
+
+#include "bass.h"
+
+#include <fcntl.h>
+#include <io.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Number of samples read from a decoder in one go.
+static const long s_ReadSize = 16384;
+
+// Maximum difference between the decoded and reported durations of a file, in seconds, before a verification warning is given.
+static const double s_MaxDurationDifference = 1.0;
+
+// Number of values converted in one go when benchmarking sample conversion.
+static const size_t s_BenchmarkConversionCount = 16384;
+
+// Number of times each sample conversion is repeated when benchmarking.
+static const int s_BenchmarkConversionIterations = 2000;
+
+// Duration of sample data to pitch shift when benchmarking, in seconds.
+static const float s_BenchmarkTimeStretchSeconds = 20.0f;
+
+// Indicates that processing should stop (on Ctrl+C).
+static std::atomic<bool> s_Cancel( false );
+
+// Output filenames (in lowercase) reserved so far, so that source files with the same name in different folders do not overwrite each other.
+static std::set<std::wstring> s_OutputFilenames;
+
+// Output filenames mutex.
+static std::mutex s_OutputFilenamesMutex;
+
+// Batch command.
+enum class BatchCommand {
+	Convert,	// Convert files to another format.
+	Gain,			// Calculate track gain.
+	Verify,		// Decode files completely, checking for errors.
+	Benchmark,	// Benchmark the processing stages.
+	FlacCheck	// Check that multithreaded FLAC encoding gives the same output as single threaded encoding.
+};
+
+// Command line options.
+struct Options {
+	BatchCommand Command = BatchCommand::Verify;											// Batch command.
+	std::wstring Encoder;																							// Encoder name (a file extension or handler description).
+	std::string EncoderSettings;																			// Encoder settings.
+	std::wstring OutputFolder;																				// Output folder for converted files.
+	long Threads = 0;																									// Number of worker threads, or zero to use all available cores.
+	Settings::DitherMode DitherMode = Settings::DitherMode::Triangular;		// Dither mode, for integer output formats.
+	bool WriteGain = false;																						// Whether to write calculated track gain values to the file tags.
+	std::vector<std::wstring> Files;																	// Input files.
+};
+
+// Result of processing a single file.
+struct Result {
+	bool Success = false;								// Whether the file was processed successfully.
+	long long Samples = 0;							// Number of samples decoded.
+	double Duration = 0;								// Duration of the decoded audio, in seconds.
+	long long InputBytes = 0;						// Input file size, in bytes.
+	long long OutputBytes = 0;					// Output file size, in bytes.
+	double Seconds = 0;									// Processing time, in seconds.
+	float Gain = NAN;										// Calculated track gain, in dB.
+	std::wstring Message;								// Output file name, or error/warning message.
+};
+
+// Console control handler, which requests cancellation on Ctrl+C or Ctrl+Break.
+static BOOL WINAPI ConsoleHandler( DWORD controlType )
+{
+	BOOL handled = FALSE;
+	if ( ( CTRL_C_EVENT == controlType ) || ( CTRL_BREAK_EVENT == controlType ) ) {
+		s_Cancel = true;
+		handled = TRUE;
+	}
+	return handled;
+}
+
+// Displays the command line usage.
+static void ShowUsage()
+{
+	fwprintf( stderr,
+		L"Usage:\n"
+		L"  VUPlayerCLI convert -encoder <name> [-settings <settings>] [-output <folder>] [-dither <mode>] [-threads <count>] <files...>\n"
+		L"  VUPlayerCLI gain [-write] [-threads <count>] <files...>\n"
+		L"  VUPlayerCLI verify [-threads <count>] <files...>\n"
+		L"  VUPlayerCLI benchmark\n"
+		L"  VUPlayerCLI flaccheck [-settings <settings>] [-threads <count>] <files...>\n"
+		L"\n"
+		L"  -encoder   encoder file extension (e.g. flac, wav, mp3, opus) or description\n"
+		L"  -settings  encoder settings string (defaults to the encoder defaults)\n"
+		L"  -output    output folder (defaults to the current folder)\n"
+		L"  -dither    none, tpdf, shaped or weighted (defaults to tpdf)\n"
+		L"  -threads   number of files to process at once (defaults to all cores)\n"
+		L"  -write     write the calculated track gain to the file tags\n" );
+}
+
+// Parses the command line arguments ('argc' & 'argv') into 'options', returning whether the arguments were valid.
+static bool ParseArguments( const int argc, wchar_t* argv[], Options& options )
+{
+	bool valid = ( argc >= 2 );
+	if ( valid ) {
+		const std::wstring command = WideStringToLower( argv[ 1 ] );
+		if ( L"convert" == command ) {
+			options.Command = BatchCommand::Convert;
+		} else if ( L"gain" == command ) {
+			options.Command = BatchCommand::Gain;
+		} else if ( L"verify" == command ) {
+			options.Command = BatchCommand::Verify;
+		} else if ( L"benchmark" == command ) {
+			options.Command = BatchCommand::Benchmark;
+		} else if ( L"flaccheck" == command ) {
+			options.Command = BatchCommand::FlacCheck;
+		} else {
+			valid = false;
+		}
+	}
+	for ( int arg = 2; valid && ( arg < argc ); arg++ ) {
+		const std::wstring argument = argv[ arg ];
+		const std::wstring option = WideStringToLower( argument );
+		const bool hasValue = ( ( arg + 1 ) < argc );
+		if ( ( L"-encoder" == option ) && hasValue ) {
+			options.Encoder = argv[ ++arg ];
+		} else if ( ( L"-settings" == option ) && hasValue ) {
+			options.EncoderSettings = WideStringToUTF8( argv[ ++arg ] );
+		} else if ( ( L"-output" == option ) && hasValue ) {
+			options.OutputFolder = argv[ ++arg ];
+		} else if ( ( L"-threads" == option ) && hasValue ) {
+			options.Threads = std::wcstol( argv[ ++arg ], nullptr /*end*/, 10 /*base*/ );
+			valid = ( options.Threads > 0 );
+		} else if ( ( L"-dither" == option ) && hasValue ) {
+			const std::wstring mode = WideStringToLower( argv[ ++arg ] );
+			if ( L"none" == mode ) {
+				options.DitherMode = Settings::DitherMode::None;
+			} else if ( L"tpdf" == mode ) {
+				options.DitherMode = Settings::DitherMode::Triangular;
+			} else if ( L"shaped" == mode ) {
+				options.DitherMode = Settings::DitherMode::NoiseShaped;
+			} else if ( L"weighted" == mode ) {
+				options.DitherMode = Settings::DitherMode::WeightedNoiseShaped;
+			} else {
+				valid = false;
+			}
+		} else if ( L"-write" == option ) {
+			options.WriteGain = true;
+		} else if ( !argument.empty() && ( L'-' != argument.front() ) ) {
+			options.Files.push_back( argument );
+		} else {
+			valid = false;
+		}
+	}
+	if ( valid && ( BatchCommand::Benchmark != options.Command ) ) {
+		valid = !options.Files.empty() && ( ( BatchCommand::Convert != options.Command ) || !options.Encoder.empty() );
+	}
+	return valid;
+}
+
+// Returns the encoder handler matching the 'name' (a supported file extension, or the handler description), or nullptr if there is no match.
+static Handler::Ptr FindEncoder( const Handlers& handlers, const std::wstring& name )
+{
+	Handler::Ptr encoder;
+	const std::wstring lowerName = WideStringToLower( name );
+	const Handler::List encoders = handlers.GetEncoders();
+	for ( auto handler = encoders.begin(); !encoder && ( handler != encoders.end() ); handler++ ) {
+		const std::set<std::wstring> extensions = ( *handler )->GetSupportedFileExtensions();
+		if ( ( extensions.end() != extensions.find( lowerName ) ) || ( lowerName == WideStringToLower( ( *handler )->GetDescription() ) ) ) {
+			encoder = *handler;
+		}
+	}
+	return encoder;
+}
+
+// Returns the size of 'filename', in bytes, or zero if the size could not be determined.
+static long long GetFilesize( const std::wstring& filename )
+{
+	long long filesize = 0;
+	WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+	if ( FALSE != GetFileAttributesEx( filename.c_str(), GetFileExInfoStandard, &attributes ) ) {
+		filesize = ( static_cast<long long>( attributes.nFileSizeHigh ) << 32 ) + attributes.nFileSizeLow;
+	}
+	return filesize;
+}
+
+// Returns the full path of 'filename', or the 'filename' itself if the full path could not be determined.
+static std::wstring GetFullPath( const std::wstring& filename )
+{
+	std::wstring fullPath = filename;
+	const DWORD length = GetFullPathName( filename.c_str(), 0 /*bufferLength*/, nullptr /*buffer*/, nullptr /*filePart*/ );
+	if ( length > 0 ) {
+		std::vector<WCHAR> buffer( length );
+		if ( GetFullPathName( filename.c_str(), length, buffer.data(), nullptr /*filePart*/ ) > 0 ) {
+			fullPath = buffer.data();
+		}
+	}
+	return fullPath;
+}
+
+// Reserves the output 'filename' (excluding the extension), returning the filename with a numbered suffix if it has already been reserved.
+static std::wstring ReserveOutputFilename( const std::wstring& filename )
+{
+	std::wstring outputFilename = filename;
+	std::lock_guard<std::mutex> lock( s_OutputFilenamesMutex );
+	long suffix = 1;
+	while ( !s_OutputFilenames.insert( WideStringToLower( outputFilename ) ).second ) {
+		outputFilename = filename + L" (" + std::to_wstring( ++suffix ) + L")";
+	}
+	return outputFilename;
+}
+
+// Reads all the sample data from the 'decoder', passing it to an optional 'encoder', and adding the decoded sample count and duration to the 'result'.
+// Without an encoder, the sample data is checked for invalid values, and the decoded duration is checked against the reported duration.
+// Returns whether the sample data was decoded (and encoded) successfully.
+static bool Transcode( Decoder& decoder, Encoder* encoder, Result& result )
+{
+	const long channels = decoder.GetChannels();
+	const long sampleRate = decoder.GetSampleRate();
+	std::vector<float> buffer( static_cast<size_t>( s_ReadSize * channels ) );
+	bool finite = true;
+	bool success = true;
+	long samplesRead = decoder.Read( buffer.data(), s_ReadSize );
+	while ( success && ( samplesRead > 0 ) && !s_Cancel ) {
+		result.Samples += samplesRead;
+		if ( nullptr == encoder ) {
+			const auto end = buffer.begin() + samplesRead * channels;
+			finite = finite && ( end == std::find_if( buffer.begin(), end, []( const float value ) { return !std::isfinite( value ); } ) );
+		} else {
+			success = encoder->Write( buffer.data(), samplesRead );
+		}
+		samplesRead = decoder.Read( buffer.data(), s_ReadSize );
+	}
+	success = success && !s_Cancel;
+	result.Duration = ( sampleRate > 0 ) ? ( static_cast<double>( result.Samples ) / sampleRate ) : 0;
+
+	if ( success && ( nullptr == encoder ) ) {
+		if ( !finite ) {
+			result.Message = L"invalid sample values";
+			success = false;
+		} else if ( 0 == result.Samples ) {
+			result.Message = L"no sample data";
+			success = false;
+		} else if ( std::fabs( result.Duration - decoder.GetDuration() ) > s_MaxDurationDifference ) {
+			result.Message = L"decoded duration differs from the reported duration";
+		}
+	}
+	return success;
+}
+
+// Converts 'filename' using the 'encoderHandler', returning the result.
+static Result Convert( const Handlers& handlers, const Handler::Ptr& encoderHandler, const Options& options, const std::wstring& filename )
+{
+	Result result;
+	const std::wstring sourceFilename = GetFullPath( filename );
+	const std::wstring sourceFolder = sourceFilename.substr( 0, sourceFilename.find_last_of( L"\\/" ) + 1 );
+	std::wstring outputFolder = options.OutputFolder;
+	while ( !outputFolder.empty() && ( ( L'\\' == outputFolder.back() ) || ( L'/' == outputFolder.back() ) ) ) {
+		outputFolder.pop_back();
+	}
+	outputFolder = GetFullPath( ( outputFolder.empty() ? L"." : outputFolder ) + L"\\" );
+	if ( WideStringToLower( sourceFolder ) == WideStringToLower( outputFolder ) ) {
+		// Encoders overwrite any existing file, so never write to the source folder.
+		result.Message = L"output folder is the source folder";
+	} else {
+		const Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Input );
+		const Encoder::Ptr encoder = encoderHandler->OpenEncoder();
+		if ( decoder && encoder ) {
+			const size_t nameStart = sourceFolder.size();
+			const size_t extensionStart = sourceFilename.find_last_of( L'.' );
+			std::wstring outputFilename = ReserveOutputFilename( outputFolder + sourceFilename.substr( nameStart, ( ( std::wstring::npos == extensionStart ) || ( extensionStart < nameStart ) ) ? std::wstring::npos : ( extensionStart - nameStart ) ) );
+			if ( encoder->Open( outputFilename, decoder->GetSampleRate(), decoder->GetChannels(), decoder->GetBPS(), options.EncoderSettings ) ) {
+				result.Success = Transcode( *decoder, encoder.get(), result );
+				encoder->Close();
+				if ( result.Success ) {
+					Tags tags;
+					if ( handlers.GetTags( filename, tags ) && !tags.empty() ) {
+						encoderHandler->SetTags( outputFilename, tags );
+					}
+					result.OutputBytes = GetFilesize( outputFilename );
+					result.Message = outputFilename;
+				} else {
+					DeleteFile( outputFilename.c_str() );
+					if ( result.Message.empty() ) {
+						result.Message = s_Cancel ? L"cancelled" : L"encoding failed";
+					}
+				}
+			} else {
+				result.Message = L"could not open encoder";
+			}
+		} else {
+			result.Message = decoder ? L"could not create encoder" : L"could not open decoder";
+		}
+	}
+	return result;
+}
+
+// Calculates the track gain for 'filename', returning the result.
+static Result CalculateGain( const Handlers& handlers, const Options& options, const std::wstring& filename )
+{
+	Result result;
+	const Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Input );
+	if ( decoder ) {
+		result.Duration = decoder->GetDuration();
+		result.Samples = static_cast<long long>( result.Duration * decoder->GetSampleRate() );
+	}
+	result.Gain = GainCalculator::CalculateTrackGain( filename, handlers, []() { return !s_Cancel; } );
+	result.Success = !std::isnan( result.Gain );
+	if ( result.Success ) {
+		result.Message = UTF8ToWideString( GainToString( result.Gain ) );
+		if ( options.WriteGain ) {
+			const Tags tags = { { Tag::GainTrack, GainToString( result.Gain ) } };
+			if ( !handlers.SetTags( filename, tags ) ) {
+				result.Message += L" (tags not written)";
+			}
+		}
+	} else {
+		result.Message = s_Cancel ? L"cancelled" : L"could not calculate gain";
+	}
+	return result;
+}
+
+// Verifies that 'filename' can be decoded completely, returning the result.
+static Result Verify( const Handlers& handlers, const std::wstring& filename )
+{
+	Result result;
+	const Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Input );
+	if ( decoder ) {
+		result.Success = Transcode( *decoder, nullptr /*encoder*/, result );
+		if ( !result.Success && result.Message.empty() ) {
+			result.Message = s_Cancel ? L"cancelled" : L"decoding failed";
+		}
+	} else {
+		result.Message = L"could not open decoder";
+	}
+	return result;
+}
+
+// Encodes 'filename' to a temporary FLAC file, in single threaded or 'multithreaded' mode, using the compression level from the 'settings'.
+// Dither is not applied, so that both modes encode the same sample data.
+// Returns the output file name, or an empty string if the file could not be encoded.
+static std::wstring EncodeFlac( const Handlers& handlers, const std::string& settings, const bool multithreaded, const std::wstring& filename, Result& result )
+{
+	std::wstring outputFilename;
+	WCHAR pathName[ MAX_PATH ] = {};
+	const Decoder::Ptr decoder = handlers.OpenDecoder( filename, Decoder::Context::Input );
+	if ( decoder && ( 0 != GetTempPath( MAX_PATH, pathName ) ) ) {
+		EncoderFlac encoder( Settings::DitherMode::None );
+		std::wstring encoderFilename = pathName + UTF8ToWideString( GenerateGUIDString() );
+		if ( encoder.Open( encoderFilename, decoder->GetSampleRate(), decoder->GetChannels(), decoder->GetBPS(), EncoderFlac::GetSettings( EncoderFlac::GetCompressionLevel( settings ), false /*verify*/, multithreaded ) ) ) {
+			result.Samples = 0;
+			const bool success = Transcode( *decoder, &encoder, result );
+			encoder.Close();
+			if ( success ) {
+				outputFilename = encoderFilename;
+			} else {
+				DeleteFile( encoderFilename.c_str() );
+			}
+		}
+	}
+	return outputFilename;
+}
+
+// Reads the MD5 signature of the unencoded audio data from the stream information block of the FLAC 'filename' into 'md5'.
+// Returns whether the signature was read.
+static bool ReadFlacMD5( const std::wstring& filename, std::vector<BYTE>& md5 )
+{
+	// Stream marker, metadata block header, then the stream information block with the signature in its last 16 bytes.
+	bool success = false;
+	FILE* f = _wfsopen( filename.c_str(), L"rb", _SH_DENYWR );
+	if ( nullptr != f ) {
+		BYTE header[ 42 ] = {};
+		if ( ( sizeof( header ) == fread( header, 1, sizeof( header ), f ) ) && ( 0 == memcmp( header, "fLaC", 4 ) ) && ( 0 == ( header[ 4 ] & 0x7f ) ) ) {
+			md5.assign( header + 26, header + 42 );
+			success = true;
+		}
+		fclose( f );
+	}
+	return success;
+}
+
+// Encodes 'filename' to FLAC in both single threaded and multithreaded mode, then decodes both outputs and compares them, returning the result.
+// The check succeeds if the decoded sample data and the MD5 signatures in the stream information blocks are identical.
+static Result CheckFlac( const Handlers& handlers, const Options& options, const std::wstring& filename )
+{
+	Result result;
+	const std::wstring singleFilename = EncodeFlac( handlers, options.EncoderSettings, false /*multithreaded*/, filename, result );
+	const std::wstring multiFilename = singleFilename.empty() ? std::wstring() : EncodeFlac( handlers, options.EncoderSettings, true /*multithreaded*/, filename, result );
+	if ( !singleFilename.empty() && !multiFilename.empty() ) {
+		result.OutputBytes = GetFilesize( multiFilename );
+		const Decoder::Ptr singleDecoder = handlers.OpenDecoder( singleFilename, Decoder::Context::Input );
+		const Decoder::Ptr multiDecoder = handlers.OpenDecoder( multiFilename, Decoder::Context::Input );
+		if ( singleDecoder && multiDecoder && ( singleDecoder->GetChannels() == multiDecoder->GetChannels() ) ) {
+			const long channels = singleDecoder->GetChannels();
+			std::vector<float> singleBuffer( static_cast<size_t>( s_ReadSize * channels ) );
+			std::vector<float> multiBuffer( static_cast<size_t>( s_ReadSize * channels ) );
+			long long position = 0;
+			bool identical = true;
+			long samplesRead = 0;
+			do {
+				samplesRead = singleDecoder->Read( singleBuffer.data(), s_ReadSize );
+				identical = ( multiDecoder->Read( multiBuffer.data(), s_ReadSize ) == samplesRead ) && ( ( samplesRead <= 0 ) || ( 0 == memcmp( singleBuffer.data(), multiBuffer.data(), samplesRead * channels * sizeof( float ) ) ) );
+				if ( identical && ( samplesRead > 0 ) ) {
+					position += samplesRead;
+				}
+			} while ( identical && ( samplesRead > 0 ) && !s_Cancel );
+
+			std::vector<BYTE> singleMD5;
+			std::vector<BYTE> multiMD5;
+			if ( s_Cancel ) {
+				result.Message = L"cancelled";
+			} else if ( !identical ) {
+				result.Message = L"decoded sample data differs after sample " + std::to_wstring( position );
+			} else if ( !ReadFlacMD5( singleFilename, singleMD5 ) || !ReadFlacMD5( multiFilename, multiMD5 ) ) {
+				result.Message = L"could not read the MD5 signatures";
+			} else if ( singleMD5 != multiMD5 ) {
+				result.Message = L"MD5 signatures differ";
+			} else if ( std::vector<BYTE>( singleMD5.size(), 0 ) == singleMD5 ) {
+				result.Message = L"no MD5 signature";
+			} else {
+				result.Success = true;
+				result.Message = L"identical";
+			}
+		} else {
+			result.Message = L"could not decode the encoded files";
+		}
+	} else {
+		result.Message = s_Cancel ? L"cancelled" : L"encoding failed";
+	}
+	if ( !singleFilename.empty() ) {
+		DeleteFile( singleFilename.c_str() );
+	}
+	if ( !multiFilename.empty() ) {
+		DeleteFile( multiFilename.c_str() );
+	}
+	return result;
+}
+
+// Returns the 'seconds' of audio processed per second of 'elapsed' time, as a string.
+static std::wstring RealtimeToString( const double seconds, const double elapsed )
+{
+	WCHAR buffer[ 32 ] = {};
+	swprintf_s( buffer, L"%.1fx", ( elapsed > 0 ) ? ( seconds / elapsed ) : 0.0 );
+	return buffer;
+}
+
+// Benchmarks the processing stages, printing the results.
+// Returns the process exit code.
+static int Benchmark()
+{
+	fwprintf( stdout, L"Sample conversion (ns per value):\n" );
+	fwprintf( stdout, L"  %-8s %10s %10s %10s %10s %10s %10s\n", L"", L"16>float", L"32>float", L"2x32>float", L"float>16", L"float>32", L"float>2x32" );
+	const std::vector<SampleConversionBenchmark> results = BenchmarkSampleConversion( s_BenchmarkConversionCount, s_BenchmarkConversionIterations );
+	for ( const auto& result : results ) {
+		fwprintf( stdout, L"  %-8S %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f%s\n", result.InstructionSet, result.Int16ToFloat, result.Int32ToFloat, result.StereoInt32ToFloat,
+			result.FloatToInt16, result.FloatToInt32, result.FloatToStereoInt32, ( &result == &results.back() ) ? L"  (in use)" : L"" );
+	}
+
+	fwprintf( stdout, L"Pitch shift, stereo (%% of one core):\n" );
+	fwprintf( stdout, L"  %-8s %10s %10s\n", L"", L"-20%", L"+25%" );
+	for ( const long sampleRate : { 44100, 48000, 96000 } ) {
+		const float loadDown = TimeStretch::Benchmark( sampleRate, 2 /*channels*/, 0.8f /*pitch*/, s_BenchmarkTimeStretchSeconds );
+		const float loadUp = TimeStretch::Benchmark( sampleRate, 2 /*channels*/, 1.25f /*pitch*/, s_BenchmarkTimeStretchSeconds );
+		fwprintf( stdout, L"  %-8ld %10.2f %10.2f\n", sampleRate, 100 * loadDown, 100 * loadUp );
+	}
+	return 0;
+}
+
+// Processes the files according to the 'options', printing the result for each file followed by a summary of the throughput.
+// Returns the process exit code.
+static int ProcessFiles( const Options& options )
+{
+	int exitCode = 1;
+
+	// A pure in-memory database holds the settings, so the application database is left untouched.
+	Handlers handlers;
+	Database database( std::wstring(), Database::Mode::Memory );
+	Library library( database, handlers );
+	Settings settings( database, library );
+	settings.SetDitherMode( options.DitherMode );
+	handlers.Init( settings );
+
+	const Handler::Ptr encoderHandler = ( BatchCommand::Convert == options.Command ) ? FindEncoder( handlers, options.Encoder ) : nullptr;
+	if ( ( BatchCommand::Convert == options.Command ) && !encoderHandler ) {
+		fwprintf( stderr, L"Unknown encoder '%s', available encoders:\n", options.Encoder.c_str() );
+		for ( const auto& handler : handlers.GetEncoders() ) {
+			const std::set<std::wstring> extensions = handler->GetSupportedFileExtensions();
+			fwprintf( stderr, L"  %-6s %s\n", extensions.empty() ? L"" : extensions.begin()->c_str(), handler->GetDescription().c_str() );
+		}
+	} else {
+		if ( !options.OutputFolder.empty() ) {
+			SHCreateDirectoryEx( NULL /*hwnd*/, GetFullPath( options.OutputFolder ).c_str(), NULL /*attributes*/ );
+		}
+
+		const long fileCount = static_cast<long>( options.Files.size() );
+		const long threadCount = std::clamp( ( options.Threads > 0 ) ? options.Threads : static_cast<long>( std::thread::hardware_concurrency() ), 1l, fileCount );
+		std::vector<Result> results( options.Files.size() );
+		std::atomic<long> nextFile( 0 );
+		long completedFiles = 0;
+		std::mutex outputMutex;
+
+		const auto startTime = std::chrono::steady_clock::now();
+		std::list<std::thread> workers;
+		for ( long worker = 0; worker < threadCount; worker++ ) {
+			workers.push_back( std::thread( [ & ]() {
+				CoInitializeEx( NULL /*reserved*/, COINIT_APARTMENTTHREADED );
+				long fileIndex = nextFile++;
+				while ( ( fileIndex < fileCount ) && !s_Cancel ) {
+					const std::wstring& filename = options.Files[ fileIndex ];
+					const auto fileStartTime = std::chrono::steady_clock::now();
+					Result result;
+					switch ( options.Command ) {
+						case BatchCommand::Convert : {
+							result = Convert( handlers, encoderHandler, options, filename );
+							break;
+						}
+						case BatchCommand::Gain : {
+							result = CalculateGain( handlers, options, filename );
+							break;
+						}
+						case BatchCommand::FlacCheck : {
+							result = CheckFlac( handlers, options, filename );
+							break;
+						}
+						case BatchCommand::Verify :
+						default : {
+							result = Verify( handlers, filename );
+							break;
+						}
+					}
+					result.InputBytes = GetFilesize( filename );
+					result.Seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - fileStartTime ).count();
+					results[ fileIndex ] = result;
+
+					{
+						std::lock_guard<std::mutex> lock( outputMutex );
+						fwprintf( stdout, L"[%ld/%ld] %s %7s %7.2fs  %s%s%s\n", ++completedFiles, fileCount, result.Success ? L"OK  " : L"FAIL",
+							RealtimeToString( result.Duration, result.Seconds ).c_str(), result.Seconds, filename.c_str(),
+							result.Message.empty() ? L"" : L" -> ", result.Message.c_str() );
+						fflush( stdout );
+					}
+
+					fileIndex = nextFile++;
+				}
+				CoUninitialize();
+			} ) );
+		}
+		for ( auto& worker : workers ) {
+			worker.join();
+		}
+		const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+		// Summary of the throughput over all files.
+		long succeeded = 0;
+		double duration = 0;
+		long long samples = 0;
+		long long inputBytes = 0;
+		long long outputBytes = 0;
+		for ( const auto& result : results ) {
+			if ( result.Success ) {
+				++succeeded;
+				duration += result.Duration;
+				samples += result.Samples;
+				inputBytes += result.InputBytes;
+				outputBytes += result.OutputBytes;
+			}
+		}
+		const double megabyte = 1024.0 * 1024.0;
+		fwprintf( stdout, L"\n%ld of %ld files processed successfully%s, using %ld threads\n", succeeded, fileCount, s_Cancel ? L" (cancelled)" : L"", threadCount );
+		fwprintf( stdout, L"Audio duration: %.1fs, elapsed time: %.2fs, speed: %s realtime\n", duration, elapsed, RealtimeToString( duration, elapsed ).c_str() );
+		if ( elapsed > 0 ) {
+			fwprintf( stdout, L"Throughput: %.0f samples/s, read %.1f MB/s, written %.1f MB/s\n", samples / elapsed, inputBytes / megabyte / elapsed, outputBytes / megabyte / elapsed );
+		}
+		const InputSource::Counters counters = InputSource::GetTotalCounters();
+		fwprintf( stdout, L"File input: %.1f MB read in %lld system calls\n", counters.BytesRead / megabyte, counters.SystemCalls );
+		exitCode = ( succeeded == fileCount ) ? 0 : 2;
+	}
+	return exitCode;
+}
+
+// Initialises BASS and processes the files according to the 'options'.
+// Returns the process exit code.
+static int Run( const Options& options )
+{
+	int exitCode = 1;
+
+	// The 'no sound' device is sufficient for decoding via BASS.
+	if ( FALSE != BASS_Init( 0 /*device*/, 48000 /*freq*/, 0 /*flags*/, NULL /*hwnd*/, NULL /*dsGUID*/ ) ) {
+		exitCode = ProcessFiles( options );
+		BASS_Free();
+	} else {
+		fwprintf( stderr, L"Could not initialise BASS (error code %d)\n", BASS_ErrorGetCode() );
+	}
+	return exitCode;
+}
+
+int wmain( int argc, wchar_t* argv[] )
+{
+	int exitCode = 1;
+	_setmode( _fileno( stdout ), _O_U8TEXT );
+	_setmode( _fileno( stderr ), _O_U8TEXT );
+
+	Options options;
+	if ( ParseArguments( argc, argv, options ) ) {
+		CoInitializeEx( NULL /*reserved*/, COINIT_APARTMENTTHREADED );
+		SetConsoleCtrlHandler( ConsoleHandler, TRUE /*add*/ );
+		exitCode = ( BatchCommand::Benchmark == options.Command ) ? Benchmark() : Run( options );
+		CoUninitialize();
+	} else {
+		ShowUsage();
+	}
+	return exitCode;
+}
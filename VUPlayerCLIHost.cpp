@@ -0,0 +1,35 @@
+// Application singleton for the console batch converter & analyser.
+// The shared library, playlist & decoder code notifies the main application via VUPlayer::Get(), which checks for a null instance.
+// There is no main application in the console tool, so these definitions stand in for VUPlayer.cpp, allowing the user interface sources to be left out of the build.
+
+#include "VUPlayer.h"
+
+VUPlayer* VUPlayer::Get()
+{
+	return nullptr;
+}
+
+void VUPlayer::OnPlaylistItemAdded( Playlist* /*playlist*/, const Playlist::Item& /*item*/, const int /*position*/ )
+{
+}
+
+void VUPlayer::OnPlaylistItemsAdded( Playlist* /*playlist*/, const Playlist::ItemPositionList& /*items*/ )
+{
+}
+
+void VUPlayer::OnPlaylistItemRemoved( Playlist* /*playlist*/, const Playlist::Item& /*item*/ )
+{
+}
+
+void VUPlayer::OnPlaylistItemUpdated( Playlist* /*playlist*/, const Playlist::Item& /*item*/ )
+{
+}
+
+void VUPlayer::OnMediaUpdated( const MediaInfo& /*previousMediaInfo*/, const MediaInfo& /*updatedMediaInfo*/ )
+{
+}
+
+Settings& VUPlayer::GetApplicationSettings()
+{
+	return m_Settings;
+}
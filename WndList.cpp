@@ -50,6 +50,9 @@ static const UINT MSG_REORDERDUMMY = WM_APP + 102;
 // Item updated message ID.
 static const UINT MSG_ITEMUPDATED = WM_APP + 103;
 
+// Files added message ID.
+static const UINT MSG_FILESADDED = WM_APP + 104;
+
 // Drag timer ID.
 static const UINT_PTR s_DragTimerID = 1010;
 
@@ -76,6 +79,12 @@ LRESULT CALLBACK WndList::ListProc( HWND hwnd, UINT message, WPARAM wParam, LPAR
 				delete addedItem;
 				break;
 			}
+			case MSG_FILESADDED : {
+				AddedItems* addedItems = reinterpret_cast<AddedItems*>( wParam );
+				wndList->AddFilesHandler( addedItems );
+				delete addedItems;
+				break;
+			}
 			case MSG_FILEREMOVED : {
 				const long removedItemID = static_cast<long>( wParam );
 				wndList->RemoveFileHandler( removedItemID );
@@ -959,6 +968,29 @@ void WndList::AddFileHandler( const AddedItem* addedItem )
 	}
 }
 
+void WndList::OnFilesAdded( Playlist* playlist, const Playlist::ItemPositionList& items )
+{
+	if ( ( nullptr != playlist ) && ( m_Playlist.get() == playlist ) && !items.empty() ) {
+		AddedItems* addedItems = new AddedItems();
+		for ( const auto& item : items ) {
+			addedItems->push_back( { playlist, item.first, item.second } );
+		}
+		PostMessage( m_hWnd, MSG_FILESADDED, reinterpret_cast<WPARAM>( addedItems ), 0 /*lParam*/ );
+	}
+}
+
+void WndList::AddFilesHandler( const AddedItems* addedItems )
+{
+	if ( nullptr != addedItems ) {
+		SendMessage( m_hWnd, WM_SETREDRAW, FALSE, 0 );
+		for ( const auto& addedItem : *addedItems ) {
+			AddFileHandler( &addedItem );
+		}
+		SendMessage( m_hWnd, WM_SETREDRAW, TRUE, 0 );
+		RedrawWindow( m_hWnd, NULL /*rect*/, NULL /*rgn*/, RDW_ERASE | RDW_FRAME | RDW_INVALIDATE | RDW_ALLCHILDREN );
+	}
+}
+
 void WndList::OnFileRemoved( Playlist* playlist, const Playlist::Item& item )
 {
 	if ( playlist == m_Playlist.get() ) {
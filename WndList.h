@@ -55,6 +55,9 @@ public:
 	// Called when an 'item' is added to the 'playlist' at a (0-based) 'position'.
 	void OnFileAdded( Playlist* playlist, const Playlist::Item& item, const int position );
 
+	// Called when a chunk of 'items' is added to the 'playlist', each item paired with its (0-based) position.
+	void OnFilesAdded( Playlist* playlist, const Playlist::ItemPositionList& items );
+
 	// Called when an 'item' is removed from the 'playlist'.
 	void OnFileRemoved( Playlist* playlist, const Playlist::Item& item );
 
@@ -174,6 +177,9 @@ private:
 		int Position;					// Added item position (0-based).
 	};
 
+	// A list of added items.
+	typedef std::list<AddedItem> AddedItems;
+
 	// Window procedure
 	static LRESULT CALLBACK ListProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam );
 
@@ -241,6 +247,10 @@ private:
 	// 'addedItem' - added item information.
 	void AddFileHandler( const AddedItem* addedItem );
 
+	// Adds a chunk of playlist items to the list control.
+	// 'addedItems' - added items information.
+	void AddFilesHandler( const AddedItems* addedItems );
+
 	// Removes a playlist item from the list control.
 	// 'removedItemID' - removed item ID.
 	void RemoveFileHandler( const long removedItemID );
@@ -2,8 +2,10 @@
 
 #include "resource.h"
 
+#include "InputSource.h"
 #include "Utility.h"
 
+#include <cmath>
 #include <sstream>
 #include <vector>
 
@@ -19,6 +21,9 @@ static const int s_PartWidth = 110;
 // File added message ID.
 static const UINT MSG_UPDATESTATUS = WM_APP + 147;
 
+// Maximum tooltip width.
+static const int s_TooltipWidth = 400;
+
 LRESULT CALLBACK WndStatus::StatusProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
 {
 	WndStatus* wndStatus = reinterpret_cast<WndStatus*>( GetWindowLongPtr( hwnd, GWLP_USERDATA ) );
@@ -34,15 +39,28 @@ LRESULT CALLBACK WndStatus::StatusProc( HWND hwnd, UINT message, WPARAM wParam,
 				wndStatus->Refresh();
 				break;
 			}
+			case WM_NOTIFY : {
+				LPNMHDR nmhdr = reinterpret_cast<LPNMHDR>( lParam );
+				if ( ( nullptr != nmhdr ) && ( nmhdr->code == TTN_GETDISPINFO ) ) {
+					LPNMTTDISPINFO info = reinterpret_cast<LPNMTTDISPINFO>( lParam );
+					info->hinst = 0;
+					info->lpszText = const_cast<LPWSTR>( wndStatus->GetTooltipText().c_str() );
+				}
+				break;
+			}
 		}
 	}
 	return CallWindowProc( wndStatus->GetDefaultWndProc(), hwnd, message, wParam, lParam );
 }
 
-WndStatus::WndStatus( HINSTANCE instance, HWND parent ) :
+WndStatus::WndStatus( HINSTANCE instance, HWND parent, Library& library, Output& output ) :
 	m_hInst( instance ),
 	m_hWnd( NULL ),
 	m_DefaultWndProc( NULL ),
+	m_Library( library ),
+	m_Output( output ),
+	m_hWndTooltip( NULL ),
+	m_Tooltip(),
 	m_Playlist(),
 	m_GainStatusCount( -1 ),
 	m_LibraryStatusCount( -1 ),
@@ -63,6 +81,17 @@ WndStatus::WndStatus( HINSTANCE instance, HWND parent ) :
 	SetWindowLongPtr( m_hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>( this ) );
 	m_DefaultWndProc = reinterpret_cast<WNDPROC>( SetWindowLongPtr( m_hWnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>( StatusProc ) ) );
 
+	m_hWndTooltip = CreateWindowEx( WS_EX_TOPMOST, TOOLTIPS_CLASS, 0, WS_POPUP | TTS_ALWAYSTIP, 0, 0, 0, 0, m_hWnd, 0 /*menu*/, m_hInst, 0 /*param*/ );
+	TOOLINFO toolInfo = {};
+	toolInfo.cbSize = sizeof( TOOLINFO );
+	toolInfo.hwnd = m_hWnd;
+	toolInfo.hinst = m_hInst;
+	toolInfo.uFlags = TTF_SUBCLASS;
+	toolInfo.uId = s_WndStatusID;
+	toolInfo.lpszText = LPSTR_TEXTCALLBACK;
+	SendMessage( m_hWndTooltip, TTM_ADDTOOL, 0, reinterpret_cast<LPARAM>( &toolInfo ) );
+	SendMessage( m_hWndTooltip, TTM_SETMAXTIPWIDTH, 0, static_cast<LPARAM>( GetDPIScaling() * s_TooltipWidth ) );
+
 	RECT rect;
 	GetWindowRect( m_hWnd, &rect );
 	const int initialWidth = rect.right - rect.left;
@@ -93,6 +122,15 @@ void WndStatus::Resize( const int width )
 	const int partWidth = static_cast<int>( GetDPIScaling() * s_PartWidth );
 	int parts[ s_PartCount ] = { rightmost - 3 * partWidth, rightmost - 2 * partWidth, rightmost - partWidth, rightmost };
 	SendMessage( m_hWnd, SB_SETPARTS, s_PartCount, reinterpret_cast<LPARAM>( parts ) );
+
+	// The tooltip covers the first part.
+	TOOLINFO toolInfo = {};
+	toolInfo.cbSize = sizeof( TOOLINFO );
+	toolInfo.hwnd = m_hWnd;
+	toolInfo.uId = s_WndStatusID;
+	toolInfo.rect = rect;
+	toolInfo.rect.right = parts[ 0 ];
+	SendMessage( m_hWndTooltip, TTM_NEWTOOLRECT, 0, reinterpret_cast<LPARAM>( &toolInfo ) );
 }
 
 void WndStatus::SetPlaylist( const Playlist::Ptr playlist )
@@ -105,7 +143,8 @@ void WndStatus::SetPlaylist( const Playlist::Ptr playlist )
 
 void WndStatus::Update( Playlist* playlist )
 {
-	if ( playlist == m_Playlist.get() ) {
+	// Any playlist update might also have changed the library, so refresh the library statistics if they are being displayed.
+	if ( ( playlist == m_Playlist.get() ) || !m_Playlist ) {
 		PostMessage( m_hWnd, MSG_UPDATESTATUS, 0, 0 );
 	}
 }
@@ -136,6 +175,9 @@ void WndStatus::Update( const GainCalculator& gainCalculator, const LibraryMaint
 			}
 		}
 		SendMessage( m_hWnd, SB_SETTEXT, 0, reinterpret_cast<LPARAM>( idleText.c_str() ) );
+		if ( !m_Playlist && ( pendingLibrary != m_LibraryStatusCount ) ) {
+			Refresh();
+		}
 		m_GainStatusCount = pendingGain;
 		m_LibraryStatusCount = pendingLibrary;
 	}
@@ -147,28 +189,24 @@ void WndStatus::Refresh()
 	std::wstring part3;
 	std::wstring part4;
 
-	if ( m_Playlist ) {
-		const long trackCount = m_Playlist->GetCount();
-		if ( trackCount > 0 ) {
-			std::wstringstream ss;
-			const int bufSize = 16;
-			WCHAR buf[ bufSize ] = {};
-			LoadString( m_hInst, ( trackCount == 1 ) ? IDS_STATUS_TRACK : IDS_STATUS_TRACKS, buf, bufSize );
-			ss << L"\t" << trackCount << L" " << buf;
-			part2 = ss.str();
-		}
+	// When there is no current playlist (e.g. a library category is selected), display the statistics for the whole library.
+	const Library::Statistics statistics = m_Playlist ? m_Playlist->GetStatistics() : m_Library.GetStatistics();
+	const long trackCount = statistics.Count;
+	if ( trackCount > 0 ) {
+		std::wstringstream ss;
+		const int bufSize = 16;
+		WCHAR buf[ bufSize ] = {};
+		LoadString( m_hInst, ( trackCount == 1 ) ? IDS_STATUS_TRACK : IDS_STATUS_TRACKS, buf, bufSize );
+		ss << L"\t" << trackCount << L" " << buf;
+		part2 = ss.str();
 	}
 
-	if ( m_Playlist ) {
-		const long long filesize = m_Playlist->GetFilesize();
-		part3 = L"\t" + FilesizeToString( m_hInst, filesize );
-	}
+	const long long filesize = statistics.Filesize;
+	part3 = L"\t" + FilesizeToString( m_hInst, filesize );
 
-	if ( m_Playlist ) {
-		const float duration = m_Playlist->GetDuration();
-		if ( duration > 0 ) {
-			part4 = L"\t" + DurationToString( m_hInst, duration, false /*colonDelimited*/ );
-		}
+	const float duration = static_cast<float>( statistics.Duration );
+	if ( duration > 0 ) {
+		part4 = L"\t" + DurationToString( m_hInst, duration, false /*colonDelimited*/ );
 	}
 
 	std::wstring previous1;
@@ -214,3 +252,33 @@ void WndStatus::Refresh()
 		SendMessage( m_hWnd, SB_SETTEXT, 3, reinterpret_cast<LPARAM>( part4.c_str() ) );
 	}
 }
+
+const std::wstring& WndStatus::GetTooltipText()
+{
+	const int bufSize = 128;
+	WCHAR buf[ bufSize ] = {};
+
+	const Prefetcher::Statistics statistics = m_Output.GetPrefetchStatistics();
+	LoadString( m_hInst, IDS_STATUS_PREFETCH, buf, bufSize );
+	m_Tooltip = buf;
+	WideStringReplace( m_Tooltip, L"%1", std::to_wstring( statistics.Hits ) );
+	WideStringReplace( m_Tooltip, L"%2", std::to_wstring( statistics.Hits + statistics.Misses ) );
+
+	if ( ( statistics.Hits + statistics.Misses ) > 0 ) {
+		LoadString( m_hInst, IDS_STATUS_FIRSTSAMPLE, buf, bufSize );
+		std::wstring firstSample( buf );
+		WideStringReplace( firstSample, L"%1", std::to_wstring( std::lround( 1000 * statistics.LastTimeToFirstSample ) ) );
+		WideStringReplace( firstSample, L"%2", std::to_wstring( std::lround( 1000 * statistics.AverageTimeToFirstSample ) ) );
+		m_Tooltip += L"\r\n" + firstSample;
+	}
+
+	const InputSource::Counters counters = InputSource::GetTotalCounters();
+	LoadString( m_hInst, IDS_STATUS_INPUT, buf, bufSize );
+	std::wstring input( buf );
+	WideStringReplace( input, L"%1", FilesizeToString( m_hInst, counters.BytesRead ) );
+	WideStringReplace( input, L"%2", FilesizeToString( m_hInst, counters.BytesCached ) );
+	WideStringReplace( input, L"%3", std::to_wstring( counters.SystemCalls ) );
+	m_Tooltip += L"\r\n" + input;
+
+	return m_Tooltip;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "LibraryMaintainer.h"
+#include "Output.h"
 #include "Playlist.h"
 #include "GainCalculator.h"
 
@@ -9,7 +10,9 @@ class WndStatus
 public:
 	// 'instance' - module instance handle.
 	// 'parent' - parent window handle.
-	WndStatus( HINSTANCE instance, HWND parent );
+	// 'library' - media library.
+	// 'output' - output object.
+	WndStatus( HINSTANCE instance, HWND parent, Library& library, Output& output );
 
 	virtual ~WndStatus();
 
@@ -22,7 +25,7 @@ public:
 	// Called when the control is resized to a new 'width'.
 	void Resize( const int width );
 
-	// Sets the current playlist.
+	// Sets the current playlist (library statistics are displayed when there is no current playlist).
 	void SetPlaylist( const Playlist::Ptr playlist );
 
 	// Called when an 'playlist' is updated.
@@ -34,6 +37,9 @@ public:
 	// Refreshes the status bar contents.
 	void Refresh();
 
+	// Returns the tooltip text for the first status bar part, showing the file input & prefetch statistics.
+	const std::wstring& GetTooltipText();
+
 private:
 	// Window procedure
 	static LRESULT CALLBACK StatusProc( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam );
@@ -47,6 +53,18 @@ private:
 	// Default window procedure.
 	WNDPROC m_DefaultWndProc;
 
+	// Media library.
+	Library& m_Library;
+
+	// Output object.
+	Output& m_Output;
+
+	// Tooltip window handle.
+	HWND m_hWndTooltip;
+
+	// Tooltip text.
+	std::wstring m_Tooltip;
+
 	// Playlist.
 	Playlist::Ptr m_Playlist;
 
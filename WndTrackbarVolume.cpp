@@ -1,8 +1,10 @@
 #include "WndTrackbarVolume.h"
 
 #include "resource.h"
+#include "Utility.h"
 #include "VUPlayer.h"
 
+#include <cmath>
 #include <iomanip>
 #include <sstream>
 
@@ -41,6 +43,13 @@ const std::wstring& WndTrackbarVolume::GetTooltipText()
 			LoadString( GetInstanceHandle(), IDS_PITCH, buf, bufSize );
 			std::wstringstream ss;
 			ss << buf << L": " << std::fixed << std::setprecision( 1 ) << std::showpos << value << L"%";
+			const float load = GetOutput().GetTimeStretchLoad();
+			if ( load > 0 ) {
+				LoadString( GetInstanceHandle(), IDS_PITCH_LOAD, buf, bufSize );
+				std::wstring loadText = buf;
+				WideStringReplace( loadText, L"%1", std::to_wstring( static_cast<int>( std::lround( 100 * load ) ) ) );
+				ss << L" (" << loadText << L")";
+			}
 			m_Tooltip = ss.str();
 			break;
 		}
@@ -187,6 +196,10 @@ void WndTrackbarVolume::OnContextMenu( const POINT& position )
 			CheckMenuItem( menu, ID_CONTROL_PITCHRANGE_MEDIUM, ( Settings::PitchRange::Medium == pitchRange ) ? MF_CHECKED : MF_UNCHECKED );
 			CheckMenuItem( menu, ID_CONTROL_PITCHRANGE_LARGE, ( Settings::PitchRange::Large == pitchRange ) ? MF_CHECKED : MF_UNCHECKED );
 
+			const Settings::PitchMode pitchMode = GetOutput().GetPitchMode();
+			CheckMenuItem( menu, ID_CONTROL_PITCHMODE_SPEED, ( Settings::PitchMode::Speed == pitchMode ) ? MF_CHECKED : MF_UNCHECKED );
+			CheckMenuItem( menu, ID_CONTROL_PITCHMODE_TEMPO, ( Settings::PitchMode::Tempo == pitchMode ) ? MF_CHECKED : MF_UNCHECKED );
+
 			const UINT flags = TPM_RIGHTBUTTON | TPM_NONOTIFY | TPM_RETURNCMD;
 			const UINT command = TrackPopupMenu( trackbarMenu, flags, position.x, position.y, 0 /*reserved*/, GetWindowHandle(), NULL /*rect*/ );
 			switch ( command ) {
@@ -201,7 +214,9 @@ void WndTrackbarVolume::OnContextMenu( const POINT& position )
 				case ID_CONTROL_PITCHRESET :
 				case ID_CONTROL_PITCHRANGE_SMALL :
 				case ID_CONTROL_PITCHRANGE_MEDIUM :
-				case ID_CONTROL_PITCHRANGE_LARGE : {
+				case ID_CONTROL_PITCHRANGE_LARGE :
+				case ID_CONTROL_PITCHMODE_SPEED :
+				case ID_CONTROL_PITCHMODE_TEMPO : {
 					VUPlayer* vuplayer = VUPlayer::Get();
 					if ( nullptr != vuplayer ) {
 						vuplayer->OnCommand( command );
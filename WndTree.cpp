@@ -618,11 +618,9 @@ Playlist::Ptr WndTree::GetPlaylist( const HTREEITEM node )
 				playlist = std::make_shared<Playlist::Ptr::element_type>( m_Library, type, m_MergeDuplicates );
 				m_ArtistMap.insert( PlaylistMap::value_type( node, playlist ) );
 
-				const std::wstring artist = GetItemLabel( node );
-				const MediaInfo::List mediaList = m_Library.GetMediaByArtist( artist );
-				for ( const auto& mediaInfo : mediaList ) {
-					playlist->AddItem( mediaInfo );
-				}
+				const MediaFilter::Ptr filter = std::make_shared<MediaFilter>();
+				filter->AddCondition( Library::Column::Artist, MediaFilter::Operator::Equal, GetItemLabel( node ) );
+				playlist->SetFilter( filter );
 			}
 			break;
 		}
@@ -634,21 +632,14 @@ Playlist::Ptr WndTree::GetPlaylist( const HTREEITEM node )
 				playlist = std::make_shared<Playlist::Ptr::element_type>( m_Library, type, m_MergeDuplicates );
 				m_AlbumMap.insert( PlaylistMap::value_type( node, playlist ) );
 
-				MediaInfo::List mediaList;
+				const MediaFilter::Ptr filter = std::make_shared<MediaFilter>();
 				const HTREEITEM parentNode = TreeView_GetParent( m_hWnd, node );
 				const Playlist::Type parentType = GetItemType( parentNode );
 				if ( Playlist::Type::Artist == parentType ) {
-					const std::wstring artist = GetItemLabel( parentNode );
-					const std::wstring album = GetItemLabel( node );
-					mediaList = m_Library.GetMediaByArtistAndAlbum( artist, album );
-				} else {
-					const std::wstring album = GetItemLabel( node );
-					mediaList = m_Library.GetMediaByAlbum( album );
-				}
-
-				for ( const auto& mediaInfo : mediaList ) {
-					playlist->AddItem( mediaInfo );
+					filter->AddCondition( Library::Column::Artist, MediaFilter::Operator::Equal, GetItemLabel( parentNode ) );
 				}
+				filter->AddCondition( Library::Column::Album, MediaFilter::Operator::Equal, GetItemLabel( node ) );
+				playlist->SetFilter( filter );
 			}
 			break;
 		}
@@ -660,11 +651,9 @@ Playlist::Ptr WndTree::GetPlaylist( const HTREEITEM node )
 				playlist = std::make_shared<Playlist::Ptr::element_type>( m_Library, type, m_MergeDuplicates );
 				m_GenreMap.insert( PlaylistMap::value_type( node, playlist ) );
 
-				const std::wstring genre = GetItemLabel( node );
-				const MediaInfo::List mediaList = m_Library.GetMediaByGenre( genre );
-				for ( const auto& mediaInfo : mediaList ) {
-					playlist->AddItem( mediaInfo );
-				}
+				const MediaFilter::Ptr filter = std::make_shared<MediaFilter>();
+				filter->AddCondition( Library::Column::Genre, MediaFilter::Operator::Equal, GetItemLabel( node ) );
+				playlist->SetFilter( filter );
 			}
 			break;
 		}
@@ -678,10 +667,9 @@ Playlist::Ptr WndTree::GetPlaylist( const HTREEITEM node )
 
 				try {
 					const long year = std::stol( GetItemLabel( node ) );
-					const MediaInfo::List mediaList = m_Library.GetMediaByYear( year );
-					for ( const auto& mediaInfo : mediaList ) {
-						playlist->AddItem( mediaInfo );
-					}
+					const MediaFilter::Ptr filter = std::make_shared<MediaFilter>();
+					filter->AddCondition( Library::Column::Year, MediaFilter::Operator::Equal, static_cast<double>( year ) );
+					playlist->SetFilter( filter );
 				} catch ( ... ) {
 				}
 			}
@@ -853,7 +841,7 @@ void WndTree::ImportPlaylist( const std::wstring& filename )
 		WCHAR filter[ MAX_PATH ] = {};
 		LoadString( m_hInst, IDS_IMPORTPLAYLIST_FILTERPLAYLISTS, filter, MAX_PATH );
 		const std::wstring filter1( filter );
-		const std::wstring filter2( L"*.vpl;*.m3u;*.pls" );
+		const std::wstring filter2( L"*.vpl;*.m3u;*.m3u8;*.pls" );
 		LoadString( m_hInst, IDS_CHOOSE_FILTERALL, filter, MAX_PATH );
 		const std::wstring filter3( filter );
 		const std::wstring filter4( L"*.*" );
@@ -888,129 +876,23 @@ void WndTree::ImportPlaylist( const std::wstring& filename )
 		}
 	}
 
-	if ( !playlistFilename.empty() ) {
-		const std::wstring fileExt = GetFileExtension( playlistFilename );
-		Playlist::Ptr playlist;
-		if ( L"vpl" == fileExt ) {
-			playlist = ImportPlaylistVPL( playlistFilename );
-		} else if ( L"m3u" == fileExt ) {
-			playlist = ImportPlaylistM3U( playlistFilename );
-		} else if ( L"pls" == fileExt ) {
-			playlist = ImportPlaylistPLS( playlistFilename );
-		}
-		if ( playlist ) {
+	if ( !playlistFilename.empty() && PlaylistImporter::IsSupported( playlistFilename ) ) {
+		// The playlist file is read, and its entries resolved, on the playlist's pending file thread.
+		const PlaylistImporter::Ptr importer = std::make_shared<PlaylistImporter>( playlistFilename );
+		if ( importer->IsOpen() ) {
+			Playlist::Ptr playlist( new Playlist( m_Library, Playlist::Type::User ) );
+			playlist->AddPendingImport( importer, false /*startPendingThread*/ );
 			const size_t nameDelimiter = playlistFilename.find_last_of( L"/\\" );
 			const size_t extDelimiter = playlistFilename.rfind( '.' );
 			if ( ( std::wstring::npos != nameDelimiter ) && ( extDelimiter > nameDelimiter ) ) {
 				playlist->SetName( playlistFilename.substr( nameDelimiter + 1, extDelimiter - nameDelimiter - 1 ) );
 			}
 			AddPlaylist( playlist );
+			playlist->StartPendingThread();
 		}
 	}
 }
 
-Playlist::Ptr WndTree::ImportPlaylistVPL( const std::wstring& filename )
-{
-	Playlist::Ptr playlist( new Playlist( m_Library, Playlist::Type::User ) );
-	try {
-		std::ifstream stream;
-		stream.open( filename, std::ios::binary | std::ios::in );
-		if ( stream.is_open() ) {
-			do {
-				std::string line;
-				std::getline( stream, line );
-				const size_t delimiter = line.find_first_of( 0x01 );
-				if ( std::string::npos != delimiter ) {
-					const std::string name = line.substr( 0 /*offset*/, delimiter /*count*/ );			
-					playlist->AddPending( AnsiCodePageToWideString( name ), false /*startPendingThread*/ );
-				}
-			} while ( !stream.eof() );
-			stream.close();
-		}
-	} catch ( ... ) {
-	}
-	return playlist;
-}
-
-Playlist::Ptr WndTree::ImportPlaylistM3U( const std::wstring& filename )
-{
-	Playlist::Ptr playlist( new Playlist( m_Library, Playlist::Type::User ) );
-	try {
-		std::ifstream stream;
-		stream.open( filename, std::ios::in );
-		if ( stream.is_open() ) {
-			const size_t pathDelimiter = filename.find_last_of( L"/\\" );
-			const std::wstring playlistPath = filename.substr( 0 /*offset*/, pathDelimiter );
-			if ( std::wstring::npos != pathDelimiter ) {
-				do {
-					std::string line;
-					std::getline( stream, line );
-					if ( !line.empty() ) {
-						std::wstring wFilename = AnsiCodePageToWideString( line );
-						WCHAR buffer[ MAX_PATH + 1 ] = {};
-						if ( 0 != ExpandEnvironmentStrings( wFilename.c_str(), buffer, MAX_PATH ) ) {
-							wFilename = buffer;
-						}
-						if ( TRUE == PathIsRelative( wFilename.c_str() ) ) {
-							// Use legacy PathCombine function to maintain Windows 7 support.
-							if ( nullptr != PathCombine( buffer, playlistPath.c_str(), wFilename.c_str() ) ) {
-								wFilename = buffer;
-							}
-						}
-						if ( TRUE == PathFileExists( wFilename.c_str() ) ) {
-							playlist->AddPending( wFilename, false /*startPendingThread*/ );
-						}
-					}
-				} while ( !stream.eof() );
-			}
-			stream.close();
-		}
-	} catch ( ... ) {
-	}
-	return playlist;
-}
-
-Playlist::Ptr WndTree::ImportPlaylistPLS( const std::wstring& filename )
-{
-	Playlist::Ptr playlist( new Playlist( m_Library, Playlist::Type::User ) );
-	try {
-		std::ifstream stream;
-		stream.open( filename, std::ios::in );
-		if ( stream.is_open() ) {
-			const size_t pathDelimiter = filename.find_last_of( L"/\\" );
-			const std::wstring playlistPath = filename.substr( 0 /*offset*/, pathDelimiter );
-			if ( std::wstring::npos != pathDelimiter ) {
-				do {
-					std::string line;
-					std::getline( stream, line );
-					const size_t fileEntry = line.find( "File" );
-					const size_t delimiter = line.find_first_of( '=' );
-					if ( ( 0 == fileEntry ) && ( std::string::npos != delimiter ) ) {
-						const std::string name = line.substr( delimiter + 1 );
-						std::wstring wFilename = AnsiCodePageToWideString( name );
-						WCHAR buffer[ MAX_PATH + 1 ] = {};
-						if ( 0 != ExpandEnvironmentStrings( wFilename.c_str(), buffer, MAX_PATH ) ) {
-							wFilename = buffer;
-						}
-						if ( TRUE == PathIsRelative( wFilename.c_str() ) ) {
-							// Use legacy PathCombine function to maintain Windows 7 support.
-							if ( nullptr != PathCombine( buffer, playlistPath.c_str(), wFilename.c_str() ) ) {
-								wFilename = buffer;
-							}
-						}
-						if ( TRUE == PathFileExists( wFilename.c_str() ) ) {
-							playlist->AddPending( wFilename, false /*startPendingThread*/ );
-						}
-					}
-				} while ( !stream.eof() );
-			}
-			stream.close();
-		}
-	} catch ( ... ) {
-	}
-	return playlist;
-}
-
 void WndTree::ExportSelectedPlaylist()
 {
 	const Playlist::Ptr playlist = GetSelectedPlaylist();
@@ -1609,7 +1491,7 @@ Playlist::Set WndTree::OnUpdatedMedia( const MediaInfo& previousMediaInfo, const
 		UpdateAlbums( m_NodeAlbums, previousMediaInfo, updatedMediaInfo, updatedPlaylists );
 		UpdateGenres( previousMediaInfo, updatedMediaInfo, updatedPlaylists );
 		UpdateYears( previousMediaInfo, updatedMediaInfo, updatedPlaylists );
-		UpdatePlaylists( updatedMediaInfo, updatedPlaylists );
+		UpdatePlaylists( previousMediaInfo, updatedMediaInfo, updatedPlaylists );
 	}
 	return updatedPlaylists;
 }
@@ -1753,29 +1635,29 @@ void WndTree::OnMediaLibraryRefreshed()
 	}
 }
 
-void WndTree::UpdatePlaylists( const MediaInfo& updatedMediaInfo, Playlist::Set& updatedPlaylists )
+void WndTree::UpdatePlaylists( const MediaInfo& previousMediaInfo, const MediaInfo& updatedMediaInfo, Playlist::Set& updatedPlaylists )
 {
 	for ( const auto& playlistIter : m_ArtistMap ) {
 		const Playlist::Ptr playlist = playlistIter.second;
-		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( updatedMediaInfo ) ) {
+		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( previousMediaInfo, updatedMediaInfo ) ) {
 			updatedPlaylists.insert( playlist );
 		}
 	}
 	for ( const auto& playlistIter : m_AlbumMap ) {
 		const Playlist::Ptr playlist = playlistIter.second;
-		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( updatedMediaInfo ) ) {
+		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( previousMediaInfo, updatedMediaInfo ) ) {
 			updatedPlaylists.insert( playlist );
 		}
 	}
 	for ( const auto& playlistIter : m_GenreMap ) {
 		const Playlist::Ptr playlist = playlistIter.second;
-		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( updatedMediaInfo ) ) {
+		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( previousMediaInfo, updatedMediaInfo ) ) {
 			updatedPlaylists.insert( playlist );
 		}
 	}
 	for ( const auto& playlistIter : m_YearMap ) {
 		const Playlist::Ptr playlist = playlistIter.second;
-		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( updatedMediaInfo ) ) {
+		if ( ( updatedPlaylists.end() == updatedPlaylists.find( playlist ) ) && playlist && playlist->OnUpdatedMedia( previousMediaInfo, updatedMediaInfo ) ) {
 			updatedPlaylists.insert( playlist );
 		}
 	}
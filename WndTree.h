@@ -236,15 +236,6 @@ private:
 	// Loads playlists
 	void LoadPlaylists();
 
-	// Imports a VPL playlist from 'filename', returning the playlist.
-	Playlist::Ptr ImportPlaylistVPL( const std::wstring& filename );
-	
-	// Imports an M3U playlist from 'filename', returning the playlist.
-	Playlist::Ptr ImportPlaylistM3U( const std::wstring& filename );
-
-	// Imports a PLS playlist from 'filename', returning the playlist.
-	Playlist::Ptr ImportPlaylistPLS( const std::wstring& filename );
-
 	// Gets the current tree control font.
 	LOGFONT GetFont();
 
@@ -349,9 +340,10 @@ private:
 	void UpdateYears( const MediaInfo& previousMediaInfo, const MediaInfo& updatedMediaInfo, Playlist::Set& updatedPlaylists );
 
 	// Updates playlists when media information has been updated.
+	// 'previousMediaInfo' - previous media information.
 	// 'updatedMediaInfo' - updated media information.
 	// 'updatedPlaylists' - in/out, the playlists that have been updated.
-	void UpdatePlaylists( const MediaInfo& updatedMediaInfo, Playlist::Set& updatedPlaylists );
+	void UpdatePlaylists( const MediaInfo& previousMediaInfo, const MediaInfo& updatedMediaInfo, Playlist::Set& updatedPlaylists );
 
 	// Updates CD audio playlists when CD audio information has been updated.
 	// 'updatedMediaInfo' - updated media information.
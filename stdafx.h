@@ -5,6 +5,8 @@
 
 #pragma once
 
+#ifdef _WIN32
+
 #pragma comment(linker,"\"/manifestdependency:type='win32' name='Microsoft.Windows.Common-Controls' version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' language='*'\"")
 
 #include "targetver.h"
@@ -24,3 +26,10 @@
 #include <malloc.h>
 #include <memory.h>
 #include <tchar.h>
+
+#else
+
+// The portable core is built without the Windows headers (see CMakeLists.txt).
+#include "Platform.h"
+
+#endif